@@ -17,11 +17,18 @@
 #include <board.h>
 
 #include <components.h>
+#ifdef RT_USING_MTD_NFTL
+#include <rtdevice.h>
+#endif
 
 void rt_init_thread_entry(void *parameter)
 {
 #ifdef RT_USING_LWIP
+#ifdef _WIN32
     pcap_netif_hw_init();
+#else
+    tap_netif_hw_init();
+#endif
 #endif
 
     /* initialization RT-Thread Components */
@@ -53,6 +60,15 @@ void rt_init_thread_entry(void *parameter)
             rt_kprintf("fatfs initialized!\n");
         else
             rt_kprintf("fatfs initialization failed!\n");
+
+#ifdef RT_USING_MTD_NFTL
+        /* mount fatfs on the flash translation layer of nand flash */
+        if (rt_mtd_nftl_attach("nand1", "nftl0") == RT_EOK &&
+            dfs_mount("nftl0", "/disk/nftl", "elm", 0, 0) == 0)
+            rt_kprintf("nftl fatfs initialized!\n");
+        else
+            rt_kprintf("nftl fatfs initialization failed, try mkfs(\"elm\", \"nftl0\")!\n");
+#endif
 #endif
 
 #ifdef RT_USING_DFS_UFFS
@@ -24,6 +24,9 @@
 
 static unsigned char block_data[BLOCK_SIZE];
 static struct rt_mtd_nand_device _nanddrv_file_device;
+#ifdef RT_USING_MTD_NFTL
+static struct rt_mtd_nand_device _nanddrv_file_nftl;
+#endif
 static FILE *file = NULL;
 
 static rt_uint8_t CountBitsInByte(rt_uint8_t byte)
@@ -192,8 +195,10 @@ static rt_err_t nanddrv_file_read_page(struct rt_mtd_nand_device *device,
                                        rt_uint8_t *spare, rt_uint32_t spare_len)
 {
     rt_uint32_t offset;
+#ifndef RT_USING_MTD_ECC
     rt_uint8_t oob_ecc [ECC_SIZE];
     rt_uint8_t ecc [ECC_SIZE];
+#endif
 
     page = page + device->block_start * device->pages_per_block;
 
@@ -208,6 +213,7 @@ static rt_err_t nanddrv_file_read_page(struct rt_mtd_nand_device *device,
     {
         fseek(file, offset, SEEK_SET);
         fread(data, data_len, 1, file);
+#ifndef RT_USING_MTD_ECC
         if (data_len == PAGE_DATA_SIZE)
         {
             /* read ecc size */
@@ -218,6 +224,7 @@ static rt_err_t nanddrv_file_read_page(struct rt_mtd_nand_device *device,
             if (memcmp(&oob_ecc[0], &ecc[0], ECC_SIZE) != 0)
                 return -RT_MTD_EECC;
         }
+#endif
     }
 
     if (spare != NULL && spare_len)
@@ -236,7 +243,9 @@ static rt_err_t nanddrv_file_write_page(struct rt_mtd_nand_device *device,
                                         const rt_uint8_t *oob, rt_uint32_t spare_len)
 {
     rt_uint32_t offset;
+#ifndef RT_USING_MTD_ECC
     rt_uint8_t ecc[ECC_SIZE];
+#endif
 
     page = page + device->block_start * device->pages_per_block;
     if (page / device->pages_per_block > device->block_end)
@@ -251,6 +260,15 @@ static rt_err_t nanddrv_file_write_page(struct rt_mtd_nand_device *device,
         fseek(file, offset, SEEK_SET);
         fwrite(data, data_len, 1, file);
 
+#ifdef RT_USING_MTD_ECC
+        /* the ECC is placed in spare by MTD layer, write it with the page data */
+        if (data_len == PAGE_DATA_SIZE && oob != RT_NULL && spare_len != 0)
+        {
+            fwrite(oob, spare_len, 1, file);
+
+            return RT_EOK;
+        }
+#else
         if (data_len == PAGE_DATA_SIZE)
         {
             /*write the ecc information */
@@ -258,9 +276,10 @@ static rt_err_t nanddrv_file_write_page(struct rt_mtd_nand_device *device,
 
             fwrite(ecc, ECC_SIZE, 1, file);
         }
+#endif
     }
 
-    if (oob != RT_NULL && spare_len != 0)
+    if (oob != RT_NULL && spare_len > ECC_SIZE)
     {
         offset = page * PAGE_SIZE + PAGE_DATA_SIZE + ECC_SIZE;
         fseek(file, offset, SEEK_SET);
@@ -316,10 +335,82 @@ static rt_err_t nanddrv_file_move_page(struct rt_mtd_nand_device *device, rt_off
     return RT_EOK;
 }
 
+/* read/write the sequential pages like read cache and cache program */
+static rt_err_t nanddrv_file_read_pages(struct rt_mtd_nand_device *device,
+                                        rt_off_t page, rt_uint32_t count,
+                                        rt_uint8_t *data, rt_uint8_t *spare)
+{
+    rt_uint32_t index;
+    rt_uint8_t oob[OOB_SIZE];
+#ifndef RT_USING_MTD_ECC
+    rt_uint8_t ecc[ECC_SIZE];
+#endif
+
+    page = page + device->block_start * device->pages_per_block;
+    if ((page + count - 1) / device->pages_per_block > device->block_end)
+    {
+        return -RT_EIO;
+    }
+
+    fseek(file, page * PAGE_SIZE, SEEK_SET);
+    for (index = 0; index < count; index ++)
+    {
+        fread(data + index * PAGE_DATA_SIZE, PAGE_DATA_SIZE, 1, file);
+        fread(oob, OOB_SIZE, 1, file);
+#ifndef RT_USING_MTD_ECC
+        /* verify ECC */
+        ecc_hamming_compute256x(data + index * PAGE_DATA_SIZE, PAGE_DATA_SIZE, ecc);
+        if (memcmp(oob, ecc, ECC_SIZE) != 0)
+            return -RT_MTD_EECC;
+#endif
+        if (spare != RT_NULL)
+            memcpy(spare + index * OOB_SIZE, oob, OOB_SIZE);
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t nanddrv_file_write_pages(struct rt_mtd_nand_device *device,
+                                         rt_off_t page, rt_uint32_t count,
+                                         const rt_uint8_t *data, const rt_uint8_t *spare)
+{
+    rt_uint32_t index;
+#ifndef RT_USING_MTD_ECC
+    rt_uint8_t ecc[ECC_SIZE];
+#endif
+
+    page = page + device->block_start * device->pages_per_block;
+    if ((page + count - 1) / device->pages_per_block > device->block_end)
+    {
+        return -RT_EIO;
+    }
+
+    fseek(file, page * PAGE_SIZE, SEEK_SET);
+    for (index = 0; index < count; index ++)
+    {
+        fwrite(data + index * PAGE_DATA_SIZE, PAGE_DATA_SIZE, 1, file);
+#ifdef RT_USING_MTD_ECC
+        if (spare != RT_NULL)
+            fwrite(spare + index * OOB_SIZE, OOB_SIZE, 1, file);
+        else
+            fseek(file, OOB_SIZE, SEEK_CUR);
+#else
+        ecc_hamming_compute256x(data + index * PAGE_DATA_SIZE, PAGE_DATA_SIZE, ecc);
+        fwrite(ecc, ECC_SIZE, 1, file);
+        if (spare != RT_NULL)
+            fwrite(spare + index * OOB_SIZE + ECC_SIZE, OOB_SIZE - ECC_SIZE, 1, file);
+        else
+            fseek(file, OOB_SIZE - ECC_SIZE, SEEK_CUR);
+#endif
+    }
+
+    return RT_EOK;
+}
+
 /* erase block */
 static rt_err_t nanddrv_file_erase_block(struct rt_mtd_nand_device *device, rt_uint32_t block)
 {
-    if (block > BLOCK_NUM) return -RT_EIO;
+    if (block >= device->block_total) return -RT_EIO;
 
     /* add the start blocks */
     block = block + device->block_start;
@@ -330,6 +421,23 @@ static rt_err_t nanddrv_file_erase_block(struct rt_mtd_nand_device *device, rt_u
     return RT_EOK;
 }
 
+/* erase the blocks in each plane */
+static rt_err_t nanddrv_file_erase_planes(struct rt_mtd_nand_device *device, rt_uint32_t block)
+{
+    rt_uint32_t index;
+
+    /* all of the blocks of planes shall be in this device */
+    if (block + device->plane_num > device->block_total) return -RT_EIO;
+
+    block = block + device->block_start;
+
+    fseek(file, block * BLOCK_SIZE, SEEK_SET);
+    for (index = 0; index < device->plane_num; index ++)
+        fwrite(block_data, sizeof(block_data), 1, file);
+
+    return RT_EOK;
+}
+
 const static struct rt_mtd_nand_driver_ops _ops =
 {
     nanddrv_file_read_id,
@@ -339,6 +447,10 @@ const static struct rt_mtd_nand_driver_ops _ops =
     nanddrv_file_erase_block,
     RT_NULL,
     RT_NULL,
+    nanddrv_file_read_pages,
+    nanddrv_file_write_pages,
+    RT_NULL,
+    nanddrv_file_erase_planes,
 };
 
 void nand_eraseall(void);
@@ -381,7 +493,27 @@ void rt_hw_mtd_nand_init(void)
     _nanddrv_file_device.block_total = _nanddrv_file_device.block_end - _nanddrv_file_device.block_start;
     _nanddrv_file_device.ops = &_ops;
 
+#ifdef RT_USING_MTD_ECC
+    /* the ECC of nand flash is done by MTD layer */
+    rt_mtd_nand_ecc_setup(&_nanddrv_file_device, RT_MTD_ECC_HAMMING_256);
+#endif
+
     rt_mtd_nand_register_device("nand0", &_nanddrv_file_device);
+
+#ifdef RT_USING_MTD_NFTL
+    /* the second half of nand flash is used by flash translation layer */
+    _nanddrv_file_nftl = _nanddrv_file_device;
+    _nanddrv_file_nftl.block_start = BLOCK_NUM / 2 + 1;
+    _nanddrv_file_nftl.block_end = BLOCK_NUM - 1;
+    _nanddrv_file_nftl.block_total = _nanddrv_file_nftl.block_end - _nanddrv_file_nftl.block_start;
+#ifdef RT_USING_MTD_ECC
+    /* the ECC buffers are not shared with nand0 */
+    _nanddrv_file_nftl.ecc = RT_NULL;
+    rt_mtd_nand_ecc_setup(&_nanddrv_file_nftl, RT_MTD_ECC_HAMMING_256);
+#endif
+
+    rt_mtd_nand_register_device("nand1", &_nanddrv_file_nftl);
+#endif
 }
 
 #if defined(RT_USING_FINSH)
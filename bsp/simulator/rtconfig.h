@@ -89,10 +89,16 @@
 
 /* SECTION: component options */
 #define RT_USING_COMPONENTS_INIT
+/* the worker threads to initialize independent components concurrently */
+#define RT_COMPONENTS_INIT_WORKERS	2
 
 /* SECTION: MTD interface options */
 /* using mtd nand flash */
 #define RT_USING_MTD_NAND
+/* using flash translation layer on nand flash */
+#define RT_USING_MTD_NFTL
+/* using software ECC of mtd nand flash */
+#define RT_USING_MTD_ECC
 /* using mtd nor flash */
 #define RT_USING_MTD_NOR
 
@@ -116,7 +122,7 @@
 /* #define RT_DFS_ELM_USE_LFN			1 */
 #define RT_DFS_ELM_MAX_LFN			255
 /* Maximum sector size to be handled. */
-#define RT_DFS_ELM_MAX_SECTOR_SIZE  512
+#define RT_DFS_ELM_MAX_SECTOR_SIZE  2048
 
 /* DFS: network file system options */
 /* #define RT_USING_DFS_NFS */
@@ -0,0 +1,234 @@
+/*
+ * File      : tap_netif.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-16     Bernard      the first version
+ */
+
+/*
+ * Linux TAP network interface for simulator, which uses the descriptor ring
+ * interface of ethernetif: the frame is read into the posted pbuf and the pbuf
+ * chain is written to TAP device without copy.
+ *
+ * Create the TAP device on host before running simulator:
+ *   ip tuntap add dev tap0 mode tap user $USER
+ *   ip addr add 192.168.126.1/24 dev tap0
+ *   ip link set tap0 up
+ * then the simulator (192.168.126.30 by default) can be reached from host,
+ * for example, the throughput is measured by the netio application.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+#include <rtthread.h>
+#include <netif/ethernetif.h>
+
+#ifndef TAP_IFNAME
+#define TAP_IFNAME          "tap0"
+#endif
+
+#define MAX_ADDR_LEN        6
+#define TAP_RX_RING_SIZE    16
+#define TAP_TX_RING_SIZE    16
+#define TAP_TX_IOV_MAX      16
+
+struct tap_netif
+{
+    /* inherit from ethernet device */
+    struct eth_device parent;
+
+    int fd;
+    /* interface address info. */
+    rt_uint8_t dev_addr[MAX_ADDR_LEN];      /* hw address   */
+
+    /* rx descriptor ring, which holds the buffers posted by ethernetif */
+    struct pbuf *rx_ring[TAP_RX_RING_SIZE];
+    rt_uint16_t rx_head, rx_tail;
+};
+static struct tap_netif tap_netif_device;
+
+static rt_err_t tap_netif_rx_post(struct eth_device *dev, struct pbuf *p)
+{
+    struct tap_netif *tap = (struct tap_netif *)dev;
+
+    if ((rt_uint16_t)(tap->rx_head - tap->rx_tail) >= TAP_RX_RING_SIZE)
+        return -RT_EFULL;
+
+    tap->rx_ring[tap->rx_head % TAP_RX_RING_SIZE] = p;
+    tap->rx_head ++;
+
+    return RT_EOK;
+}
+
+static rt_err_t tap_netif_tx_post(struct eth_device *dev, struct pbuf *p)
+{
+    struct tap_netif *tap = (struct tap_netif *)dev;
+    struct iovec iov[TAP_TX_IOV_MAX];
+    struct pbuf *q;
+    int count;
+
+    /* gather the pbuf chain, skip the padding before ethernet header */
+    iov[0].iov_base = (rt_uint8_t *)p->payload + ETH_PAD_SIZE;
+    iov[0].iov_len  = p->len - ETH_PAD_SIZE;
+    for (q = p->next, count = 1; q != RT_NULL && count < TAP_TX_IOV_MAX; q = q->next, count ++)
+    {
+        iov[count].iov_base = q->payload;
+        iov[count].iov_len  = q->len;
+    }
+
+    /* the write of TAP device is finished at once, so the frame is done */
+    if (q != RT_NULL || writev(tap->fd, iov, count) < 0)
+        rt_kprintf("tap: transmit frame failed\n");
+    eth_device_tx_done(dev, 1);
+
+    return RT_EOK;
+}
+
+static const struct eth_ring_ops tap_netif_ring_ops =
+{
+    tap_netif_rx_post,
+    tap_netif_tx_post,
+};
+
+/* the thread acts as the rx DMA of device */
+static void tap_thread_entry(void *parameter)
+{
+    struct tap_netif *tap = (struct tap_netif *)parameter;
+    struct pollfd pfd;
+    struct pbuf *p;
+    int length;
+
+    pfd.fd = tap->fd;
+    pfd.events = POLLIN;
+
+    while (1)
+    {
+        /* no buffer posted or no frame arrived, yield to others */
+        if (tap->rx_tail == tap->rx_head || poll(&pfd, 1, 0) <= 0)
+        {
+            rt_thread_delay(1);
+            continue;
+        }
+
+        p = tap->rx_ring[tap->rx_tail % TAP_RX_RING_SIZE];
+        length = read(tap->fd, (rt_uint8_t *)p->payload + ETH_PAD_SIZE,
+                      ETH_RX_BUF_SIZE - ETH_PAD_SIZE);
+        if (length < 0 && errno == EAGAIN)
+            continue;
+
+        tap->rx_tail ++;
+        eth_device_rx_done(&(tap->parent), length > 0 ? length : 0);
+    }
+}
+
+static rt_err_t tap_netif_init(rt_device_t dev)
+{
+    struct tap_netif *tap = (struct tap_netif *)dev;
+    struct ifreq ifr;
+    rt_thread_t tid;
+
+    tap->fd = open("/dev/net/tun", O_RDWR);
+    if (tap->fd < 0)
+    {
+        rt_kprintf("tap: open /dev/net/tun failed\n");
+        return -RT_ERROR;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, TAP_IFNAME, IFNAMSIZ - 1);
+    if (ioctl(tap->fd, TUNSETIFF, &ifr) < 0)
+    {
+        rt_kprintf("tap: attach to %s failed\n", TAP_IFNAME);
+        close(tap->fd);
+        return -RT_ERROR;
+    }
+    fcntl(tap->fd, F_SETFL, fcntl(tap->fd, F_GETFL) | O_NONBLOCK);
+
+    tid = rt_thread_create("tap", tap_thread_entry, tap,
+                           2048, RT_THREAD_PRIORITY_MAX - 2, 10);
+    if (tid != RT_NULL)
+        rt_thread_startup(tid);
+
+    rt_kprintf("Select (%s) as network interface\n", TAP_IFNAME);
+    return RT_EOK;
+}
+
+static rt_err_t tap_netif_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    return RT_EOK;
+}
+
+static rt_err_t tap_netif_close(rt_device_t dev)
+{
+    struct tap_netif *tap = (struct tap_netif *)dev;
+
+    close(tap->fd);
+    return RT_EOK;
+}
+
+static rt_size_t tap_netif_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    rt_set_errno(-RT_ENOSYS);
+    return 0;
+}
+
+static rt_size_t tap_netif_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    rt_set_errno(-RT_ENOSYS);
+    return 0;
+}
+
+static rt_err_t tap_netif_control(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+    switch (cmd)
+    {
+    case NIOCTL_GADDR:
+        /* get mac address */
+        if (args) rt_memcpy(args, tap_netif_device.dev_addr, 6);
+        else return -RT_ERROR;
+        break;
+
+    default :
+        break;
+    }
+
+    return RT_EOK;
+}
+
+void tap_netif_hw_init(void)
+{
+    tap_netif_device.dev_addr[0] = 0x00;
+    tap_netif_device.dev_addr[1] = 0x60;
+    tap_netif_device.dev_addr[2] = 0x37;
+    /* set mac address: (only for test) */
+    tap_netif_device.dev_addr[3] = 0x12;
+    tap_netif_device.dev_addr[4] = 0x34;
+    tap_netif_device.dev_addr[5] = 0x56;
+
+    tap_netif_device.parent.parent.init       = tap_netif_init;
+    tap_netif_device.parent.parent.open       = tap_netif_open;
+    tap_netif_device.parent.parent.close      = tap_netif_close;
+    tap_netif_device.parent.parent.read       = tap_netif_read;
+    tap_netif_device.parent.parent.write      = tap_netif_write;
+    tap_netif_device.parent.parent.control    = tap_netif_control;
+    tap_netif_device.parent.parent.user_data  = RT_NULL;
+
+    eth_device_init_ring(&(tap_netif_device.parent), "e0", &tap_netif_ring_ops,
+                         TAP_RX_RING_SIZE, TAP_TX_RING_SIZE);
+}
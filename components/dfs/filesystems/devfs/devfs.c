@@ -71,6 +71,24 @@ int dfs_device_fs_write(struct dfs_fd *file, const void *buf, rt_size_t count)
 	return result;
 }
 
+#ifdef RT_USING_POLL
+int dfs_device_fs_poll(struct dfs_fd *file, struct rt_pollreq *req)
+{
+	rt_device_t dev_id;
+
+	RT_ASSERT(file != RT_NULL);
+
+	if (file->type == FT_DIRECTORY)
+		return POLLIN | POLLOUT;
+
+	/* get device handler */
+	dev_id = (rt_device_t)file->data;
+	RT_ASSERT(dev_id != RT_NULL);
+
+	return rt_device_poll(dev_id, req);
+}
+#endif
+
 int dfs_device_fs_close(struct dfs_fd *file)
 {
 	rt_err_t result;
@@ -268,6 +286,9 @@ static const struct dfs_filesystem_operation _device_fs =
 	RT_NULL,
 	dfs_device_fs_stat,
 	RT_NULL,
+#ifdef RT_USING_POLL
+	dfs_device_fs_poll,
+#endif
 };
 
 int devfs_init(void)
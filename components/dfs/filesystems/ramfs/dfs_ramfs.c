@@ -10,6 +10,7 @@
  * 2013-04-15     Bernard      the first version
  * 2013-05-05     Bernard      remove CRC for ramfs persistence
  * 2013-05-22     Bernard      fix the no entry issue.
+ * 2013-06-02     Bernard      add DFS_F_GETADDR ioctl for sendfile.
  */
 
 #include <rtthread.h>
@@ -56,6 +57,24 @@ int dfs_ramfs_statfs(struct dfs_filesystem *fs, struct statfs *buf)
 
 int dfs_ramfs_ioctl(struct dfs_fd *file, int cmd, void *args)
 {
+    struct ramfs_dirent *dirent;
+    struct dfs_file_mem *mem;
+
+    if (cmd == DFS_F_GETADDR)
+    {
+        dirent = (struct ramfs_dirent *)file->data;
+        if (dirent == RT_NULL)
+            return -DFS_STATUS_EINVAL;
+
+        /* the data may be moved by the writing of realloc */
+        mem = (struct dfs_file_mem *)args;
+        mem->addr = dirent->data;
+        mem->size = dirent->size;
+        mem->stable = RT_FALSE;
+
+        return DFS_STATUS_OK;
+    }
+
     return -DFS_STATUS_EIO;
 }
 
@@ -9,6 +9,7 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2013-06-02     Bernard      add DFS_F_GETADDR ioctl for sendfile.
  */
 
 #include <rtthread.h>
@@ -36,6 +37,24 @@ int dfs_romfs_unmount(struct dfs_filesystem *fs)
 
 int dfs_romfs_ioctl(struct dfs_fd *file, int cmd, void *args)
 {
+	struct romfs_dirent *dirent;
+	struct dfs_file_mem *mem;
+
+	if (cmd == DFS_F_GETADDR)
+	{
+		dirent = (struct romfs_dirent *)file->data;
+		if (dirent == RT_NULL || dirent->type != ROMFS_DIRENT_FILE)
+			return -DFS_STATUS_EINVAL;
+
+		/* the data of romfs is in ROM, it never moves */
+		mem = (struct dfs_file_mem *)args;
+		mem->addr = dirent->data;
+		mem->size = file->size;
+		mem->stable = RT_TRUE;
+
+		return DFS_STATUS_OK;
+	}
+
 	return -DFS_STATUS_EIO;
 }
 
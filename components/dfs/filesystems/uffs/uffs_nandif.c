@@ -259,15 +259,16 @@ static URET ReadPageWithLayout(
 
 	res = rt_mtd_nand_read(RT_MTD_NAND_DEVICE(dev->_private),
 	                   	   page, data, data_len, spare, spare_len);
-	if (res == 0)
-		res = UFFS_FLASH_NO_ERR;
-	else if (res == -1)
+	if (res == RT_EOK)
 	{
-		//TODO ecc correct, add code to use hardware do ecc correct
-		res = UFFS_FLASH_ECC_OK;
+		/* the bit flips are corrected by ECC of MTD layer */
+		res = RT_MTD_NAND_DEVICE(dev->_private)->bitflips ?
+			  UFFS_FLASH_ECC_OK : UFFS_FLASH_NO_ERR;
 	}
-	else
+	else if (res == -RT_MTD_EECC)
 		res = UFFS_FLASH_ECC_FAIL;
+	else
+		res = UFFS_FLASH_IO_ERR;
 
 	if (ts != RT_NULL)
 	{
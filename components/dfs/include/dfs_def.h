@@ -12,6 +12,7 @@
  * 2004-10-01     Beranard     The first version.
  * 2004-10-14     Beranard     Clean up the code.
  * 2005-01-22     Beranard     Clean up the code, port to MinGW
+ * 2013-06-02     Bernard      Add DFS_F_GETADDR ioctl command.
  */
  
 #ifndef __DFS_DEF_H__
@@ -34,6 +35,21 @@
 #define DFS_F_EOF                0x04000000
 #define DFS_F_ERR                0x08000000
 
+/*
+ * File ioctl command, get the file data which is already in memory. The args
+ * is a pointer to struct dfs_file_mem. The data may be sent out directly
+ * without copying only when it is stable, which will not be moved or freed
+ * while the file is opened.
+ */
+#define DFS_F_GETADDR            0x4000
+
+struct dfs_file_mem
+{
+    const void *addr;
+    rt_size_t   size;
+    rt_bool_t   stable;
+};
+
 #ifndef DFS_PATH_MAX
 #define DFS_PATH_MAX             256
 #endif
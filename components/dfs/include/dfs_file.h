@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2005-01-26     Bernard      The first version.
+ * 2013-06-10     Bernard      Add dfs_file_poll.
  */
 
 #ifndef __DFS_FILE_H__
@@ -29,6 +30,9 @@ int dfs_file_write(struct dfs_fd *fd, const void *buf, rt_size_t len);
 int dfs_file_lseek(struct dfs_fd *fd, rt_off_t offset);
 int dfs_file_stat(const char *path, struct stat *buf);
 int dfs_file_rename(const char *oldpath, const char *newpath);
+#ifdef RT_USING_POLL
+int dfs_file_poll(struct dfs_fd *fd, struct rt_pollreq *req);
+#endif
 
 #endif
 
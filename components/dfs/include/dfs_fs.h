@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2005-02-22     Bernard      The first version.
+ * 2013-06-10     Bernard      Add poll operation.
  */
  
 #ifndef __DFS_FS_H__
@@ -50,6 +51,11 @@ struct dfs_filesystem_operation
     int (*unlink)   (struct dfs_filesystem *fs, const char *pathname);
     int (*stat)     (struct dfs_filesystem *fs, const char *filename, struct stat *buf);
     int (*rename)   (struct dfs_filesystem *fs, const char *oldpath, const char *newpath);
+
+#ifdef RT_USING_POLL
+    /* get the ready events and add the poll request on the wait queue */
+    int (*poll)     (struct dfs_fd *fd, struct rt_pollreq *req);
+#endif
 };
 
 /* Mounted file system */
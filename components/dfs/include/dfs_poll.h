@@ -0,0 +1,47 @@
+/*
+ * File      : dfs_poll.h
+ * This file is part of Device File System in RT-Thread RTOS
+ * COPYRIGHT (C) 2004-2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE.
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-10     Bernard      The first version.
+ */
+
+#ifndef __DFS_POLL_H__
+#define __DFS_POLL_H__
+
+#include <rtthread.h>
+
+#ifdef RT_USING_POLL
+
+/* the nodes on the stack of poll, more nodes are allocated from heap */
+#ifndef DFS_POLL_STACK_NODES
+#define DFS_POLL_STACK_NODES    8
+#endif
+
+typedef unsigned int nfds_t;
+
+struct pollfd
+{
+    int   fd;                   /* file descriptor of DFS or socket of lwIP */
+    short events;               /* requested events */
+    short revents;              /* returned events */
+};
+
+/*
+ * The descriptors are the file descriptors of DFS, which include the devices
+ * of devfs, or the sockets of lwIP, which are numbered after the file
+ * descriptors. The timeout is in milliseconds, -1 for waiting forever.
+ *
+ * The select() over the same descriptors is declared in lwip/sockets.h.
+ */
+int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+
+#endif
+
+#endif
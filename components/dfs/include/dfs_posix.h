@@ -19,6 +19,7 @@
 
 #include <dfs_file.h>
 #include <dfs_def.h>
+#include <dfs_poll.h>
 
 #ifndef RT_USING_NEWLIB
 #define O_RDONLY    DFS_O_RDONLY
@@ -11,6 +11,7 @@
  * Date           Author       Notes
  * 2005-02-22     Bernard      The first version.
  * 2011-12-08     Bernard      Merges rename patch from iamcacy.
+ * 2013-06-10     Bernard      Add dfs_file_poll.
  */
 
 #include <dfs.h>
@@ -161,6 +162,32 @@ int dfs_file_ioctl(struct dfs_fd *fd, int cmd, void *args)
     return -DFS_STATUS_ENOSYS;
 }
 
+#ifdef RT_USING_POLL
+/**
+ * this function will get the ready events of a file descriptor, and add the
+ * poll request on the wait queue of it.
+ *
+ * @param fd the file descriptor.
+ * @param req the poll request, RT_NULL for checking the events only.
+ *
+ * @return the ready events.
+ */
+int dfs_file_poll(struct dfs_fd *fd, struct rt_pollreq *req)
+{
+    struct dfs_filesystem *fs;
+
+    if (fd == RT_NULL)
+        return POLLNVAL;
+
+    fs = fd->fs;
+    if (fs->ops->poll != RT_NULL)
+        return fs->ops->poll(fd, req);
+
+    /* the file of file system never blocks */
+    return POLLIN | POLLOUT;
+}
+#endif
+
 /**
  * this function will read specified length data from a file descriptor to a
  * buffer.
@@ -0,0 +1,400 @@
+/*
+ * File      : poll.c
+ * This file is part of Device File System in RT-Thread RTOS
+ * COPYRIGHT (C) 2004-2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE.
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-10     Bernard      The first version.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <dfs.h>
+#include <dfs_file.h>
+#include <dfs_poll.h>
+
+#ifdef RT_USING_LWIP
+#include <lwip/sockets.h>
+#endif
+
+/*
+ * The poll table is added on the wait queue of each polled object by the
+ * first scan of descriptors, then the thread sleeps until one of the objects
+ * wakes up its wait queue, and the descriptors are scanned again.
+ */
+struct rt_poll_node
+{
+    struct rt_wqueue_node wqn;
+    struct rt_poll_table *pt;
+};
+
+struct rt_poll_table
+{
+    struct rt_pollreq req;
+
+    volatile rt_uint8_t triggered;      /* an event happened after the scan */
+    volatile rt_uint8_t waiting;        /* the thread is sleeping in poll */
+
+    rt_thread_t polling_thread;
+
+    struct rt_poll_node *nodes;
+    rt_uint32_t node_count, node_max;
+};
+
+static int _poll_wakeup(struct rt_wqueue_node *wait, rt_uint32_t key)
+{
+    struct rt_poll_table *pt;
+
+    if (key != 0 && !(key & wait->key))
+        return -1;
+
+    pt = rt_list_entry(wait, struct rt_poll_node, wqn)->pt;
+    pt->triggered = 1;
+
+    /* the thread may be blocked on others while it's scanning */
+    if (pt->waiting == 0)
+        return -1;
+    pt->waiting = 0;
+
+    return 0;
+}
+
+static void _poll_add(rt_wqueue_t *queue, struct rt_pollreq *req)
+{
+    struct rt_poll_table *pt;
+    struct rt_poll_node *node;
+
+    pt = rt_list_entry(req, struct rt_poll_table, req);
+    if (pt->node_count == pt->node_max)
+        return;
+
+    node = &(pt->nodes[pt->node_count ++]);
+    node->wqn.thread = pt->polling_thread;
+    node->wqn.wakeup = _poll_wakeup;
+    node->wqn.key    = req->key;
+    node->pt         = pt;
+
+    rt_wqueue_add(queue, &(node->wqn));
+}
+
+static void poll_table_init(struct rt_poll_table *pt,
+                            struct rt_poll_node *nodes, rt_uint32_t count)
+{
+    pt->req.proc = _poll_add;
+    pt->req.key = 0;
+    pt->triggered = 0;
+    pt->waiting = 0;
+    pt->polling_thread = rt_thread_self();
+    pt->nodes = nodes;
+    pt->node_count = 0;
+    pt->node_max = count;
+}
+
+static void poll_table_teardown(struct rt_poll_table *pt)
+{
+    rt_uint32_t index;
+
+    for (index = 0; index < pt->node_count; index ++)
+        rt_wqueue_remove(&(pt->nodes[index].wqn));
+}
+
+/* sleep until an event happens or timeout */
+static rt_err_t poll_wait(struct rt_poll_table *pt, rt_int32_t timeout)
+{
+    rt_base_t level;
+    rt_thread_t thread;
+    rt_err_t result;
+
+    thread = pt->polling_thread;
+    result = RT_EOK;
+
+    level = rt_hw_interrupt_disable();
+    if (pt->triggered == 0)
+    {
+        if (timeout == 0)
+        {
+            rt_hw_interrupt_enable(level);
+
+            return -RT_ETIMEOUT;
+        }
+
+        thread->error = RT_EOK;
+        rt_thread_suspend(thread);
+        if (timeout > 0)
+        {
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
+        pt->waiting = 1;
+        rt_hw_interrupt_enable(level);
+
+        rt_schedule();
+
+        level = rt_hw_interrupt_disable();
+        pt->waiting = 0;
+        result = thread->error;
+    }
+    pt->triggered = 0;
+    rt_hw_interrupt_enable(level);
+
+    return result;
+}
+
+static int do_pollfd(struct pollfd *pollfd, struct rt_pollreq *req)
+{
+    int mask, fd;
+    struct dfs_fd *d;
+
+    mask = 0;
+    fd = pollfd->fd;
+    if (fd >= 0)
+    {
+        /* the errors are always reported */
+        req->key = pollfd->events | POLLERR | POLLHUP;
+
+#if defined(RT_USING_LWIP) && LWIP_SOCKET_OFFSET
+        if (fd >= LWIP_SOCKET_OFFSET)
+        {
+            mask = lwip_poll(fd, req);
+        }
+        else
+#endif
+        {
+            d = fd_get(fd);
+            if (d != RT_NULL)
+            {
+                mask = dfs_file_poll(d, req);
+                fd_put(d);
+            }
+            else
+            {
+                mask = POLLNVAL;
+            }
+        }
+
+        mask &= req->key | POLLNVAL;
+    }
+    pollfd->revents = mask;
+
+    return mask;
+}
+
+static int do_poll(struct pollfd *fds, nfds_t nfds, struct rt_poll_table *pt,
+                   rt_int32_t timeout)
+{
+    rt_tick_t deadline;
+    nfds_t index;
+    int num;
+
+    deadline = rt_tick_get() + timeout;
+    while (1)
+    {
+        num = 0;
+        for (index = 0; index < nfds; index ++)
+        {
+            if (do_pollfd(&fds[index], &(pt->req)))
+            {
+                num ++;
+                /* no need to wait any more */
+                pt->req.proc = RT_NULL;
+            }
+        }
+        /* only the first scan adds the poll table on the wait queues */
+        pt->req.proc = RT_NULL;
+
+        if (num != 0 || timeout == 0)
+            break;
+
+        if (poll_wait(pt, timeout) != RT_EOK)
+            timeout = 0;
+        else if (timeout > 0)
+        {
+            timeout = (rt_int32_t)(deadline - rt_tick_get());
+            if (timeout < 0)
+                timeout = 0;
+        }
+    }
+
+    return num;
+}
+
+/**
+ * this function will wait for the events of a set of file descriptors and
+ * sockets.
+ *
+ * @param fds the array of polled descriptors.
+ * @param nfds the number of descriptors.
+ * @param timeout the waiting time in milliseconds, -1 for waiting forever.
+ *
+ * @return the number of descriptors with events, 0 on timeout or -1 on failed.
+ */
+int poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+    struct rt_poll_node stack_nodes[DFS_POLL_STACK_NODES];
+    struct rt_poll_node *nodes;
+    struct rt_poll_table table;
+    rt_int32_t ticks;
+    int num;
+
+    /* each descriptor is added on one wait queue */
+    nodes = stack_nodes;
+    if (nfds > DFS_POLL_STACK_NODES)
+    {
+        nodes = (struct rt_poll_node *)rt_malloc(nfds * sizeof(struct rt_poll_node));
+        if (nodes == RT_NULL)
+        {
+            rt_set_errno(-DFS_STATUS_ENOMEM);
+
+            return -1;
+        }
+    }
+
+    if (timeout < 0)
+        ticks = RT_WAITING_FOREVER;
+    else if (timeout == 0)
+        ticks = 0;
+    else
+    {
+        ticks = rt_tick_from_millisecond(timeout);
+        if (ticks == 0)
+            ticks = 1;
+    }
+
+    poll_table_init(&table, nodes, nfds);
+    num = do_poll(fds, nfds, &table, ticks);
+    poll_table_teardown(&table);
+
+    if (nodes != stack_nodes)
+        rt_free(nodes);
+
+    return num;
+}
+RTM_EXPORT(poll);
+
+#ifdef RT_USING_LWIP
+/**
+ * this function will wait for the file descriptors and sockets in the sets
+ * to be ready. It's built on poll.
+ *
+ * @param nfds the highest-numbered descriptor in the sets, plus 1.
+ * @param readfds the descriptors to be read, RT_NULL for none.
+ * @param writefds the descriptors to be written, RT_NULL for none.
+ * @param exceptfds the descriptors to be checked for errors, RT_NULL for none.
+ * @param timeout the waiting time, RT_NULL for waiting forever.
+ *
+ * @return the number of ready descriptors in the sets, 0 on timeout or -1 on
+ * failed.
+ */
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout)
+{
+    struct pollfd *fds;
+    nfds_t count, index;
+    int fd, num, msec;
+
+    if (nfds < 0 || nfds > FD_SETSIZE)
+    {
+        rt_set_errno(-DFS_STATUS_EINVAL);
+
+        return -1;
+    }
+
+    count = 0;
+    for (fd = 0; fd < nfds; fd ++)
+    {
+        if ((readfds && FD_ISSET(fd, readfds)) ||
+            (writefds && FD_ISSET(fd, writefds)) ||
+            (exceptfds && FD_ISSET(fd, exceptfds)))
+            count ++;
+    }
+
+    fds = RT_NULL;
+    if (count > 0)
+    {
+        fds = (struct pollfd *)rt_malloc(count * sizeof(struct pollfd));
+        if (fds == RT_NULL)
+        {
+            rt_set_errno(-DFS_STATUS_ENOMEM);
+
+            return -1;
+        }
+    }
+
+    index = 0;
+    for (fd = 0; fd < nfds; fd ++)
+    {
+        short events = 0;
+
+        if (readfds && FD_ISSET(fd, readfds))
+            events |= POLLIN;
+        if (writefds && FD_ISSET(fd, writefds))
+            events |= POLLOUT;
+        if (exceptfds && FD_ISSET(fd, exceptfds))
+            events |= POLLPRI;
+
+        if (events != 0)
+        {
+            fds[index].fd = fd;
+            fds[index].events = events;
+            fds[index].revents = 0;
+            index ++;
+        }
+    }
+
+    msec = -1;
+    if (timeout != RT_NULL)
+        msec = timeout->tv_sec * 1000 + timeout->tv_usec / 1000;
+
+    num = poll(fds, count, msec);
+    if (num < 0)
+    {
+        rt_free(fds);
+
+        return -1;
+    }
+
+    if (readfds) FD_ZERO(readfds);
+    if (writefds) FD_ZERO(writefds);
+    if (exceptfds) FD_ZERO(exceptfds);
+
+    num = 0;
+    for (index = 0; index < count; index ++)
+    {
+        if (fds[index].revents & POLLNVAL)
+        {
+            rt_free(fds);
+            rt_set_errno(-DFS_STATUS_EBADF);
+
+            return -1;
+        }
+
+        fd = fds[index].fd;
+        if (readfds && (fds[index].revents & (POLLIN | POLLHUP | POLLERR)))
+        {
+            FD_SET(fd, readfds);
+            num ++;
+        }
+        if (writefds && (fds[index].revents & (POLLOUT | POLLERR)))
+        {
+            FD_SET(fd, writefds);
+            num ++;
+        }
+        if (exceptfds && (fds[index].revents & POLLPRI))
+        {
+            FD_SET(fd, exceptfds);
+            num ++;
+        }
+    }
+    rt_free(fds);
+
+    return num;
+}
+RTM_EXPORT(select);
+#endif
@@ -0,0 +1,509 @@
+/*
+ * File      : i2c_async.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author        Notes
+ * 2013-06-23     Bernard       first version
+ */
+
+#include <rthw.h>
+#include <rtdevice.h>
+
+/*
+ * The requests are queued on the bus and transferred in order. If the bus
+ * controller has the master_xfer_async operation, the next transfer is
+ * started in rt_i2c_bus_xfer_done, and the complete callbacks are invoked
+ * in the context of it, which may be ISR. Otherwise the requests are
+ * transferred by master_xfer in a workqueue with the bus lock taken.
+ */
+
+static rt_workqueue_t _i2c_workqueue = RT_NULL;
+
+/* a reading request of one device, which can be merged with others */
+static rt_bool_t _i2c_request_mergeable(struct rt_i2c_request *request)
+{
+    rt_uint32_t index;
+
+    if (request->num == 0 || request->num > RT_I2C_ASYNC_MSGS)
+        return RT_FALSE;
+    if (request->msgs[0].flags & RT_I2C_NO_START)
+        return RT_FALSE;
+    if (!(request->msgs[request->num - 1].flags & RT_I2C_RD))
+        return RT_FALSE;
+
+    for (index = 1; index < request->num; index ++)
+    {
+        if (request->msgs[index].addr != request->msgs[0].addr)
+            return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+
+/*
+ * This function takes the first request and the reading requests of the same
+ * address right after it, it's invoked with interrupt disabled.
+ */
+static struct rt_i2c_request *_i2c_batch_take(struct rt_i2c_bus_device *bus,
+                                              struct rt_i2c_msg       **msgs,
+                                              rt_uint32_t              *num)
+{
+    struct rt_i2c_request *first, *last, *request;
+    rt_list_t *node, *next;
+    rt_uint32_t count;
+
+    if (rt_list_isempty(&(bus->request_list)))
+        return RT_NULL;
+
+    first = rt_list_entry(bus->request_list.next, struct rt_i2c_request, list);
+    rt_list_remove(&(first->list));
+    first->next = RT_NULL;
+
+    *msgs = first->msgs;
+    *num  = first->num;
+    if (_i2c_request_mergeable(first) == RT_FALSE)
+        return first;
+
+    last  = first;
+    count = first->num;
+    for (node = bus->request_list.next; node != &(bus->request_list); node = next)
+    {
+        next = node->next;
+        request = rt_list_entry(node, struct rt_i2c_request, list);
+
+        if (_i2c_request_mergeable(request) == RT_FALSE ||
+            request->msgs[0].addr != first->msgs[0].addr ||
+            count + request->num > RT_I2C_ASYNC_MSGS)
+            break; /* keep the order of requests */
+
+        rt_list_remove(&(request->list));
+        request->next = RT_NULL;
+        last->next = request;
+        last = request;
+        count += request->num;
+    }
+
+    if (last == first)
+        return first;
+
+    /* the merged messages are transferred with repeated start conditions */
+    count = 0;
+    for (request = first; request != RT_NULL; request = request->next)
+    {
+        rt_memcpy(&(bus->msgs[count]), request->msgs,
+                  request->num * sizeof(struct rt_i2c_msg));
+        count += request->num;
+    }
+    *msgs = bus->msgs;
+    *num  = count;
+
+    return first;
+}
+
+static void _i2c_batch_complete(struct rt_i2c_request *request, rt_err_t result)
+{
+    struct rt_i2c_request *next;
+
+    while (request != RT_NULL)
+    {
+        /* the request may be queued again in complete callback */
+        next = request->next;
+        request->next = RT_NULL;
+        request->result = result;
+
+        if (request->complete != RT_NULL)
+            request->complete(request);
+
+        request = next;
+    }
+}
+
+static void _i2c_bus_work(struct rt_work *work, void *work_data)
+{
+    register rt_base_t level;
+    struct rt_i2c_bus_device *bus;
+    struct rt_i2c_request *batch;
+    struct rt_i2c_msg *msgs;
+    rt_uint32_t num;
+    rt_size_t ret;
+
+    bus = (struct rt_i2c_bus_device *)work_data;
+
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        batch = _i2c_batch_take(bus, &msgs, &num);
+        rt_hw_interrupt_enable(level);
+
+        if (batch == RT_NULL)
+            break;
+
+        rt_mutex_take(&bus->lock, RT_WAITING_FOREVER);
+        ret = bus->ops->master_xfer(bus, msgs, num);
+        rt_mutex_release(&bus->lock);
+
+        _i2c_batch_complete(batch, (ret == num) ? RT_EOK : -RT_EIO);
+    }
+}
+
+/* start the next transfer on the asynchronous controller if it's idle */
+static void _i2c_bus_start(struct rt_i2c_bus_device *bus)
+{
+    register rt_base_t level;
+    struct rt_i2c_request *batch;
+    struct rt_i2c_msg *msgs;
+    rt_uint32_t num;
+
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        if (bus->current != RT_NULL)
+        {
+            rt_hw_interrupt_enable(level);
+
+            return;
+        }
+
+        batch = _i2c_batch_take(bus, &msgs, &num);
+        bus->current = batch;
+        bus->current_num = num;
+        rt_hw_interrupt_enable(level);
+
+        if (batch == RT_NULL ||
+            bus->ops->master_xfer_async(bus, msgs, num) == RT_EOK)
+            return;
+
+        /* failed to start, complete it and try the next one */
+        level = rt_hw_interrupt_disable();
+        bus->current = RT_NULL;
+        rt_hw_interrupt_enable(level);
+
+        _i2c_batch_complete(batch, -RT_EIO);
+    }
+}
+
+void rt_i2c_async_bus_init(struct rt_i2c_bus_device *bus)
+{
+    /* the synchronous controllers of all buses share one workqueue */
+    if (_i2c_workqueue == RT_NULL && bus->ops->master_xfer_async == RT_NULL)
+    {
+        _i2c_workqueue = rt_workqueue_get(RT_I2C_WORKQUEUE_PRIO);
+        RT_ASSERT(_i2c_workqueue != RT_NULL);
+    }
+
+    rt_list_init(&(bus->request_list));
+    rt_work_init(&(bus->work), _i2c_bus_work, bus);
+    bus->current = RT_NULL;
+    bus->current_num = 0;
+}
+
+static void _i2c_transfer_complete(struct rt_i2c_request *request)
+{
+    rt_sem_release((rt_sem_t)request->user_data);
+}
+
+/* the synchronous transfer on the asynchronous controller, 0 on failed */
+rt_size_t rt_i2c_async_transfer(struct rt_i2c_bus_device *bus,
+                                struct rt_i2c_msg         msgs[],
+                                rt_uint32_t               num)
+{
+    struct rt_i2c_request request;
+    struct rt_semaphore sem;
+
+    rt_sem_init(&sem, "i2c", 0, RT_IPC_FLAG_FIFO);
+    rt_i2c_request_init(&request, msgs, num, _i2c_transfer_complete, &sem);
+
+    rt_i2c_transfer_async(bus, &request);
+    rt_sem_take(&sem, RT_WAITING_FOREVER);
+    rt_sem_detach(&sem);
+
+    return (request.result == RT_EOK) ? num : 0;
+}
+
+void rt_i2c_request_init(struct rt_i2c_request *request,
+                         struct rt_i2c_msg      msgs[],
+                         rt_uint32_t            num,
+                         void (*complete)(struct rt_i2c_request *request),
+                         void                  *user_data)
+{
+    RT_ASSERT(request != RT_NULL);
+
+    rt_list_init(&(request->list));
+    request->msgs      = msgs;
+    request->num       = num;
+    request->result    = RT_EOK;
+    request->next      = RT_NULL;
+    request->complete  = complete;
+    request->user_data = user_data;
+}
+
+/**
+ * This function queues a request on the I2C bus, and returns immediately.
+ * The result is saved in the request, which is -RT_EBUSY before it's done.
+ * It can be invoked in ISR.
+ *
+ * @param bus the I2C bus
+ * @param request the request which is not queued
+ *
+ * @return RT_EOK on queued, -RT_EBUSY if the request is not done.
+ */
+rt_err_t rt_i2c_transfer_async(struct rt_i2c_bus_device *bus,
+                               struct rt_i2c_request    *request)
+{
+    register rt_base_t level;
+
+    RT_ASSERT(bus != RT_NULL);
+    RT_ASSERT(request != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    if (request->result == -RT_EBUSY)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EBUSY;
+    }
+
+    request->result = -RT_EBUSY;
+    request->next = RT_NULL;
+    rt_list_insert_before(&(bus->request_list), &(request->list));
+    rt_hw_interrupt_enable(level);
+
+    if (bus->ops->master_xfer_async != RT_NULL)
+        _i2c_bus_start(bus);
+    else
+        rt_workqueue_dowork(_i2c_workqueue, &(bus->work));
+
+    return RT_EOK;
+}
+
+/**
+ * This function is invoked by the asynchronous bus controller when the
+ * transfer is done, and it starts the next transfer.
+ *
+ * @param bus the I2C bus
+ * @param result the number of messages transferred, or the error code
+ */
+void rt_i2c_bus_xfer_done(struct rt_i2c_bus_device *bus, rt_size_t result)
+{
+    register rt_base_t level;
+    struct rt_i2c_request *batch;
+    rt_uint32_t num;
+
+    level = rt_hw_interrupt_disable();
+    batch = bus->current;
+    num = bus->current_num;
+    bus->current = RT_NULL;
+    rt_hw_interrupt_enable(level);
+
+    _i2c_batch_complete(batch, (result == num) ? RT_EOK : -RT_EIO);
+
+    _i2c_bus_start(bus);
+}
+
+static void _i2c_sampler_complete(struct rt_i2c_request *request)
+{
+    register rt_base_t level;
+    struct rt_i2c_sampler *sampler;
+
+    sampler = (struct rt_i2c_sampler *)request->user_data;
+
+    level = rt_hw_interrupt_disable();
+    if (request->result == RT_EOK)
+    {
+        /* the sample is ready */
+        sampler->put_index ++;
+        if (sampler->put_index >= sampler->samples)
+            sampler->put_index = 0;
+    }
+    else
+    {
+        sampler->lost ++;
+    }
+    sampler->reading = 0;
+    rt_hw_interrupt_enable(level);
+}
+
+static void _i2c_sampler_timeout(void *parameter)
+{
+    register rt_base_t level;
+    struct rt_i2c_sampler *sampler;
+    rt_uint16_t next;
+    rt_uint8_t *sample;
+    rt_uint8_t index;
+
+    sampler = (struct rt_i2c_sampler *)parameter;
+
+    level = rt_hw_interrupt_disable();
+    next = sampler->put_index + 1;
+    if (next >= sampler->samples)
+        next = 0;
+
+    /* the buffer is full or the last reading is not done */
+    if (next == sampler->get_index || sampler->reading)
+    {
+        sampler->lost ++;
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+    sampler->reading = 1;
+    rt_hw_interrupt_enable(level);
+
+    /* read into the buffer directly */
+    sample = sampler->buffer + sampler->put_index * sampler->sample_size;
+    for (index = 0; index < sampler->count; index ++)
+        sampler->msgs[index * 2 + 1].buf = sample + index * sampler->reg_size;
+
+    rt_i2c_transfer_async(sampler->bus, &(sampler->request));
+}
+
+/**
+ * This function initializes a periodic sampler, which reads the registers
+ * of a device by writing the register address and reading reg_size bytes.
+ *
+ * @param sampler the sampler
+ * @param name the name of sampler timer
+ * @param bus the I2C bus
+ * @param addr the device address
+ * @param regs the register addresses, which are copied into sampler
+ * @param count the number of registers, up to RT_I2C_SAMPLE_REGS
+ * @param reg_size the bytes of each register
+ * @param buffer the ring buffer, whose size is samples * count * reg_size
+ * @param samples the number of samples in buffer, one of which is unused
+ * @param period the sampling period in ticks
+ *
+ * @return the error code, RT_EOK on successfully.
+ */
+rt_err_t rt_i2c_sampler_init(struct rt_i2c_sampler    *sampler,
+                             const char               *name,
+                             struct rt_i2c_bus_device *bus,
+                             rt_uint16_t               addr,
+                             const rt_uint8_t         *regs,
+                             rt_uint8_t                count,
+                             rt_uint8_t                reg_size,
+                             void                     *buffer,
+                             rt_uint16_t               samples,
+                             rt_tick_t                 period)
+{
+    rt_uint8_t index;
+
+    RT_ASSERT(sampler != RT_NULL);
+    RT_ASSERT(bus != RT_NULL);
+
+    if (count == 0 || count > RT_I2C_SAMPLE_REGS || reg_size == 0 ||
+        samples < 2 || period == 0)
+        return -RT_ERROR;
+
+    sampler->bus         = bus;
+    sampler->count       = count;
+    sampler->reg_size    = reg_size;
+    sampler->sample_size = count * reg_size;
+    sampler->buffer      = (rt_uint8_t *)buffer;
+    sampler->samples     = samples;
+    sampler->put_index   = 0;
+    sampler->get_index   = 0;
+    sampler->reading     = 0;
+    sampler->lost        = 0;
+
+    for (index = 0; index < count; index ++)
+    {
+        /* the message buffer is writable, the address is copied */
+        sampler->regs[index] = regs[index];
+
+        sampler->msgs[index * 2].addr      = addr;
+        sampler->msgs[index * 2].flags     = RT_I2C_WR;
+        sampler->msgs[index * 2].len       = 1;
+        sampler->msgs[index * 2].buf       = &(sampler->regs[index]);
+
+        sampler->msgs[index * 2 + 1].addr  = addr;
+        sampler->msgs[index * 2 + 1].flags = RT_I2C_RD;
+        sampler->msgs[index * 2 + 1].len   = reg_size;
+        sampler->msgs[index * 2 + 1].buf   = RT_NULL;
+    }
+    rt_i2c_request_init(&(sampler->request), sampler->msgs, count * 2,
+                        _i2c_sampler_complete, sampler);
+
+    /* the reading is queued in timer ISR */
+    rt_timer_init(&(sampler->timer), name, _i2c_sampler_timeout, sampler,
+                  period, RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+
+    return RT_EOK;
+}
+
+rt_err_t rt_i2c_sampler_detach(struct rt_i2c_sampler *sampler)
+{
+    RT_ASSERT(sampler != RT_NULL);
+
+    rt_timer_stop(&(sampler->timer));
+
+    /* the reading request is still queued */
+    if (sampler->reading)
+        return -RT_EBUSY;
+
+    return rt_timer_detach(&(sampler->timer));
+}
+
+rt_err_t rt_i2c_sampler_start(struct rt_i2c_sampler *sampler)
+{
+    RT_ASSERT(sampler != RT_NULL);
+
+    return rt_timer_start(&(sampler->timer));
+}
+
+rt_err_t rt_i2c_sampler_stop(struct rt_i2c_sampler *sampler)
+{
+    RT_ASSERT(sampler != RT_NULL);
+
+    return rt_timer_stop(&(sampler->timer));
+}
+
+/**
+ * This function reads the samples from the ring buffer of sampler.
+ *
+ * @param sampler the sampler
+ * @param buffer the buffer to save the samples
+ * @param samples the maximal number of samples to be read
+ *
+ * @return the number of samples read.
+ */
+rt_size_t rt_i2c_sampler_read(struct rt_i2c_sampler *sampler,
+                              void                  *buffer,
+                              rt_size_t              samples)
+{
+    register rt_base_t level;
+    rt_uint8_t *ptr;
+    rt_size_t count;
+
+    RT_ASSERT(sampler != RT_NULL);
+
+    ptr = (rt_uint8_t *)buffer;
+    for (count = 0; count < samples; count ++)
+    {
+        level = rt_hw_interrupt_disable();
+        if (sampler->get_index == sampler->put_index)
+        {
+            rt_hw_interrupt_enable(level);
+            break;
+        }
+        rt_hw_interrupt_enable(level);
+
+        /* the sample at get index is never written by timer */
+        rt_memcpy(ptr, sampler->buffer + sampler->get_index * sampler->sample_size,
+                  sampler->sample_size);
+        ptr += sampler->sample_size;
+
+        level = rt_hw_interrupt_disable();
+        sampler->get_index ++;
+        if (sampler->get_index >= sampler->samples)
+            sampler->get_index = 0;
+        rt_hw_interrupt_enable(level);
+    }
+
+    return count;
+}
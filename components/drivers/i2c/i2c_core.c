@@ -10,12 +10,20 @@
  * Change Logs:
  * Date           Author        Notes
  * 2012-04-25     weety         first version
+ * 2013-06-23     Bernard       add asynchronous transfer
  */
 
 #include <rtdevice.h>
 
 static struct rt_mutex i2c_core_lock;
 
+#ifdef RT_USING_I2C_ASYNC
+extern void rt_i2c_async_bus_init(struct rt_i2c_bus_device *bus);
+extern rt_size_t rt_i2c_async_transfer(struct rt_i2c_bus_device *bus,
+                                       struct rt_i2c_msg         msgs[],
+                                       rt_uint32_t               num);
+#endif
+
 rt_err_t rt_i2c_bus_device_register(struct rt_i2c_bus_device *bus,
                                     const char               *bus_name)
 {
@@ -28,6 +36,10 @@ rt_err_t rt_i2c_bus_device_register(struct rt_i2c_bus_device *bus,
     if (bus->timeout == 0)
         bus->timeout = RT_TICK_PER_SECOND;
 
+#ifdef RT_USING_I2C_ASYNC
+    rt_i2c_async_bus_init(bus);
+#endif
+
     res = rt_i2c_bus_device_device_init(bus, bus_name);
 
     i2c_dbg("I2C bus [%s] registered\n", bus_name);
@@ -59,6 +71,12 @@ rt_size_t rt_i2c_transfer(struct rt_i2c_bus_device *bus,
 {
     rt_size_t ret;
 
+#ifdef RT_USING_I2C_ASYNC
+    /* the asynchronous controller is shared with the queued requests */
+    if (bus->ops->master_xfer_async)
+        return rt_i2c_async_transfer(bus, msgs, num);
+#endif
+
     if (bus->ops->master_xfer)
     {
 #ifdef RT_I2C_DEBUG
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author            Notes
  * 2012-10-27     heyuanjie87       first version.
+ * 2013-06-21     Bernard           update alarm in system workqueue.
  */
 
 #ifndef __ALARM_H__
@@ -60,7 +61,11 @@ struct rt_alarm_container
 {
     rt_list_t head;
     struct rt_mutex mutex;
+#ifdef RT_USING_WORKQUEUE
+    struct rt_delayed_work work;
+#else
     struct rt_event event;
+#endif
     struct rt_alarm *current;
 };
 
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author        Notes
  * 2012-04-25     weety         first version
+ * 2013-06-23     Bernard       add transaction queue and periodic sampling
  */
 
 #ifndef __I2C_H__
@@ -49,7 +50,41 @@ struct rt_i2c_bus_device_ops
     rt_err_t (*i2c_bus_control)(struct rt_i2c_bus_device *bus,
                                 rt_uint32_t,
                                 rt_uint32_t);
+#ifdef RT_USING_I2C_ASYNC
+    /* start the transfer and invoke rt_i2c_bus_xfer_done when it's done, optional */
+    rt_err_t (*master_xfer_async)(struct rt_i2c_bus_device *bus,
+                                  struct rt_i2c_msg msgs[],
+                                  rt_uint32_t num);
+#endif
+};
+
+#ifdef RT_USING_I2C_ASYNC
+/* the maximal messages of the requests merged into one transfer */
+#ifndef RT_I2C_ASYNC_MSGS
+#define RT_I2C_ASYNC_MSGS       8
+#endif
+
+#ifndef RT_I2C_WORKQUEUE_PRIO
+#define RT_I2C_WORKQUEUE_PRIO   (RT_SYSTEM_WORKQUEUE_PRIO + 1)
+#endif
+
+/**
+ * I2C asynchronous request. The requests of reading from the same address
+ * are merged into one transfer with repeated start conditions.
+ */
+struct rt_i2c_request
+{
+    rt_list_t list;
+    struct rt_i2c_msg *msgs;
+    rt_uint32_t num;
+    rt_err_t result;
+
+    struct rt_i2c_request *next;                /* the next request in the same transfer */
+
+    void (*complete)(struct rt_i2c_request *request);
+    void *user_data;
 };
+#endif
 
 /*for i2c bus driver*/
 struct rt_i2c_bus_device
@@ -62,8 +97,47 @@ struct rt_i2c_bus_device
     rt_uint32_t  timeout;
     rt_uint32_t  retries;
     void *priv;
+
+#ifdef RT_USING_I2C_ASYNC
+    rt_list_t request_list;                     /* the queued requests */
+    struct rt_work work;                        /* the work to transfer requests */
+    struct rt_i2c_request *current;             /* the requests in transferring */
+    rt_uint32_t current_num;
+    struct rt_i2c_msg msgs[RT_I2C_ASYNC_MSGS];  /* the messages of merged requests */
+#endif
 };
 
+#ifdef RT_USING_I2C_ASYNC
+#ifndef RT_I2C_SAMPLE_REGS
+#define RT_I2C_SAMPLE_REGS      8
+#endif
+
+/**
+ * I2C periodic sampler, it reads a list of registers in a fixed rate into
+ * a ring buffer. The reading is queued by a hard timer, so no thread is
+ * waked up for each sample if the bus controller is asynchronous.
+ */
+struct rt_i2c_sampler
+{
+    struct rt_i2c_bus_device *bus;
+    rt_uint8_t regs[RT_I2C_SAMPLE_REGS];        /* the register addresses written to device */
+    rt_uint8_t count;                           /* the number of registers */
+    rt_uint8_t reg_size;                        /* the bytes of each register */
+    rt_uint16_t sample_size;
+
+    rt_uint8_t *buffer;                         /* the ring buffer of samples */
+    rt_uint16_t samples;
+    rt_uint16_t put_index;
+    rt_uint16_t get_index;
+    rt_uint16_t reading;                        /* the request is queued or in transferring */
+    rt_uint32_t lost;                           /* the samples lost for full or busy */
+
+    struct rt_timer timer;
+    struct rt_i2c_request request;
+    struct rt_i2c_msg msgs[RT_I2C_SAMPLE_REGS * 2];
+};
+#endif
+
 #ifdef RT_I2C_DEBUG
 #define i2c_dbg(fmt, ...)   rt_kprintf(fmt, ##__VA_ARGS__)
 #else
@@ -88,6 +162,36 @@ rt_size_t rt_i2c_master_recv(struct rt_i2c_bus_device *bus,
                              rt_uint32_t               count);
 rt_err_t rt_i2c_core_init(void);
 
+#ifdef RT_USING_I2C_ASYNC
+/* the asynchronous transfer, it depends on RT_USING_WORKQUEUE */
+void rt_i2c_request_init(struct rt_i2c_request *request,
+                         struct rt_i2c_msg      msgs[],
+                         rt_uint32_t            num,
+                         void (*complete)(struct rt_i2c_request *request),
+                         void                  *user_data);
+rt_err_t rt_i2c_transfer_async(struct rt_i2c_bus_device *bus,
+                               struct rt_i2c_request    *request);
+/* invoked by the asynchronous bus controller, it can be invoked in ISR */
+void rt_i2c_bus_xfer_done(struct rt_i2c_bus_device *bus, rt_size_t result);
+
+rt_err_t rt_i2c_sampler_init(struct rt_i2c_sampler    *sampler,
+                             const char               *name,
+                             struct rt_i2c_bus_device *bus,
+                             rt_uint16_t               addr,
+                             const rt_uint8_t         *regs,
+                             rt_uint8_t                count,
+                             rt_uint8_t                reg_size,
+                             void                     *buffer,
+                             rt_uint16_t               samples,
+                             rt_tick_t                 period);
+rt_err_t rt_i2c_sampler_detach(struct rt_i2c_sampler *sampler);
+rt_err_t rt_i2c_sampler_start(struct rt_i2c_sampler *sampler);
+rt_err_t rt_i2c_sampler_stop(struct rt_i2c_sampler *sampler);
+rt_size_t rt_i2c_sampler_read(struct rt_i2c_sampler *sampler,
+                              void                  *buffer,
+                              rt_size_t              samples);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,84 @@
+/*
+ * File      : mtd_ecc.h
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-26     Bernard      the first version
+ */
+
+#ifndef __MTD_ECC_H__
+#define __MTD_ECC_H__
+
+#include <rtdevice.h>
+
+struct rt_mtd_nand_device;
+
+/* the software ECC modes of MTD NAND device */
+#define RT_MTD_ECC_NONE             0
+#define RT_MTD_ECC_HAMMING_256      1   /* 1 bit in 256 bytes, 3 bytes ECC */
+#define RT_MTD_ECC_HAMMING_512      2   /* 1 bit in 512 bytes, 3 bytes ECC */
+#define RT_MTD_ECC_BCH4             3   /* 4 bits in 512 bytes, 7 bytes ECC */
+#define RT_MTD_ECC_BCH8             4   /* 8 bits in 512 bytes, 13 bytes ECC */
+
+#define RT_MTD_HAMMING_BYTES        3
+
+/* binary BCH code over GF(2^13), the bits of data and ECC are less than 8192 */
+struct rt_mtd_bch
+{
+    rt_uint8_t  t;                  /* the correctable bits */
+    rt_uint8_t  ecc_bytes;
+    rt_uint16_t ecc_bits;
+    rt_uint16_t ecc_words;
+    rt_uint16_t size;               /* the data bytes */
+
+    rt_uint32_t *mod_tab;           /* the remainder of 32 bits, 4 x 256 x ecc_words */
+    rt_uint32_t *ecc_buf;
+    rt_uint8_t  *ecc_mask;          /* make the ECC of erased data to 0xFF */
+
+    rt_uint16_t *syn;               /* the syndromes, 2t */
+    rt_uint16_t *elp;               /* the error locator polynomial, 2t + 1 */
+    rt_uint16_t *elp_prev;
+    rt_uint16_t *elp_tmp;
+};
+
+/* the software ECC attached to MTD NAND device */
+struct rt_mtd_ecc
+{
+    rt_uint8_t  mode;
+    rt_uint8_t  bytes;              /* the ECC bytes of one step */
+    rt_uint16_t step;               /* the data bytes of one step */
+    rt_uint16_t steps;
+
+    struct rt_mtd_bch *bch;
+    rt_uint8_t *spare;              /* the spare of one page */
+    rt_uint8_t *code;               /* the calculated ECC of one step */
+};
+
+/*
+ * The Hamming code of 256 or 512 bytes, the layout of ECC is the same as the
+ * one of Linux. It returns the number of corrected bits, or -RT_MTD_EECC.
+ */
+void rt_mtd_hamming_calc(const rt_uint8_t *data, rt_uint32_t size, rt_uint8_t *ecc);
+int rt_mtd_hamming_correct(rt_uint8_t *data, rt_uint32_t size,
+                           const rt_uint8_t *read_ecc, const rt_uint8_t *calc_ecc);
+
+struct rt_mtd_bch *rt_mtd_bch_create(rt_uint8_t t, rt_uint32_t size);
+void rt_mtd_bch_delete(struct rt_mtd_bch *bch);
+void rt_mtd_bch_calc(struct rt_mtd_bch *bch, const rt_uint8_t *data, rt_uint8_t *ecc);
+int rt_mtd_bch_correct(struct rt_mtd_bch *bch, rt_uint8_t *data,
+                       const rt_uint8_t *read_ecc, const rt_uint8_t *calc_ecc);
+
+/*
+ * Let MTD layer do ECC for the NAND device without ECC hardware. The ECC of
+ * each step is placed from the beginning of spare, which is out of oob_free.
+ * The whole page reading and writing are protected by ECC.
+ */
+rt_err_t rt_mtd_nand_ecc_setup(struct rt_mtd_nand_device *device, int mode);
+
+#endif
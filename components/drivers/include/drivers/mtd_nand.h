@@ -11,6 +11,8 @@
  * Date           Author       Notes
  * 2011-12-05     Bernard      the first version
  * 2011-04-02     prife        add mark_badblock and check_block
+ * 2013-01-26     Bernard      add software ECC of MTD layer
+ * 2013-01-28     Bernard      add multi-page and multi-plane operations
  */
 
 /*
@@ -23,6 +25,7 @@
 #include <rtdevice.h>
 
 struct rt_mtd_nand_driver_ops;
+struct rt_mtd_ecc;
 #define RT_MTD_NAND_DEVICE(device)	((struct rt_mtd_nand_device*)(device))
 
 #define RT_MTD_EOK		0	/* NO error */
@@ -49,6 +52,11 @@ struct rt_mtd_nand_device
 
 	/* operations interface */
 	const struct rt_mtd_nand_driver_ops* ops;
+
+	/* the software ECC of MTD layer, RT_NULL when no ECC or ECC in driver */
+	struct rt_mtd_ecc* ecc;
+	/* the bit flips corrected by ECC in the last reading of page */
+	rt_uint32_t bitflips;
 };
 
 struct rt_mtd_nand_driver_ops
@@ -69,10 +77,54 @@ struct rt_mtd_nand_driver_ops
 	rt_err_t (*erase_block)(struct rt_mtd_nand_device* device, rt_uint32_t block);
 	rt_err_t (*check_block)(struct rt_mtd_nand_device* device, rt_uint32_t block);
 	rt_err_t (*mark_badblock)(struct rt_mtd_nand_device* device, rt_uint32_t block);
+
+	/*
+	 * The following operations are optional, they are emulated by the page
+	 * and block operations when the driver does not implement them.
+	 *
+	 * read_pages/write_pages access the sequential pages in one block by read
+	 * cache and cache program. The data is count pages, and the spare is count
+	 * whole spares or RT_NULL.
+	 */
+	rt_err_t (*read_pages)(struct rt_mtd_nand_device* device,
+                           rt_off_t page, rt_uint32_t count,
+                           rt_uint8_t* data, rt_uint8_t* spare);
+	rt_err_t (*write_pages)(struct rt_mtd_nand_device* device,
+                            rt_off_t page, rt_uint32_t count,
+                            const rt_uint8_t* data, const rt_uint8_t* spare);
+
+	/*
+	 * write_planes/erase_planes program the same page of, or erase, plane_num
+	 * blocks at once. The first block is aligned to plane_num, the data and
+	 * spare are plane_num pages.
+	 */
+	rt_err_t (*write_planes)(struct rt_mtd_nand_device* device, rt_off_t page,
+                             const rt_uint8_t* data, const rt_uint8_t* spare);
+	rt_err_t (*erase_planes)(struct rt_mtd_nand_device* device, rt_uint32_t block);
 };
 
 rt_err_t rt_mtd_nand_register_device(const char* name, struct rt_mtd_nand_device* device);
 
+rt_err_t rt_mtd_nand_read_pages(struct rt_mtd_nand_device* device, rt_off_t page,
+	rt_uint32_t count, rt_uint8_t* data, rt_uint8_t* spare);
+rt_err_t rt_mtd_nand_write_pages(struct rt_mtd_nand_device* device, rt_off_t page,
+	rt_uint32_t count, const rt_uint8_t* data, const rt_uint8_t* spare);
+rt_err_t rt_mtd_nand_write_planes(struct rt_mtd_nand_device* device, rt_off_t page,
+	const rt_uint8_t* data, const rt_uint8_t* spare);
+rt_err_t rt_mtd_nand_erase_planes(struct rt_mtd_nand_device* device, rt_uint32_t block);
+
+#ifdef RT_USING_MTD_ECC
+rt_err_t rt_mtd_nand_ecc_read(struct rt_mtd_nand_device* device, rt_off_t page,
+	rt_uint8_t* data, rt_uint32_t data_len, rt_uint8_t * spare, rt_uint32_t spare_len);
+rt_err_t rt_mtd_nand_ecc_write(struct rt_mtd_nand_device* device, rt_off_t page,
+	const rt_uint8_t* data, rt_uint32_t data_len, const rt_uint8_t * spare, rt_uint32_t spare_len);
+/* check and correct one page with its whole spare, or place ECC in the spare */
+rt_err_t rt_mtd_nand_ecc_check(struct rt_mtd_nand_device* device,
+	rt_uint8_t* data, const rt_uint8_t* spare);
+void rt_mtd_nand_ecc_fill(struct rt_mtd_nand_device* device,
+	const rt_uint8_t* data, rt_uint8_t* spare);
+#endif
+
 rt_inline rt_uint32_t rt_mtd_nand_read_id(struct rt_mtd_nand_device* device)
 {
 	return device->ops->read_id(device);
@@ -84,6 +136,10 @@ rt_inline rt_err_t rt_mtd_nand_read(
 	rt_uint8_t* data, rt_uint32_t data_len,
 	rt_uint8_t * spare, rt_uint32_t spare_len)
 {
+#ifdef RT_USING_MTD_ECC
+	if (device->ecc != RT_NULL)
+		return rt_mtd_nand_ecc_read(device, page, data, data_len, spare, spare_len);
+#endif
 	return device->ops->read_page(device, page, data, data_len, spare, spare_len);
 }
 
@@ -93,6 +149,10 @@ rt_inline rt_err_t rt_mtd_nand_write(
 	const rt_uint8_t* data, rt_uint32_t data_len,
 	const rt_uint8_t * spare, rt_uint32_t spare_len)
 {
+#ifdef RT_USING_MTD_ECC
+	if (device->ecc != RT_NULL)
+		return rt_mtd_nand_ecc_write(device, page, data, data_len, spare, spare_len);
+#endif
 	return device->ops->write_page(device, page, data, data_len, spare, spare_len);
 }
 
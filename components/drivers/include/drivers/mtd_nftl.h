@@ -0,0 +1,76 @@
+/*
+ * File      : mtd_nftl.h
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-22     Bernard      the first version
+ */
+
+#ifndef __MTD_NFTL_H__
+#define __MTD_NFTL_H__
+
+#include <rtdevice.h>
+
+/*
+ * the number of cached pages of mapping table. The mapping table takes 4 bytes
+ * for each page of NAND, the garbage collection writes much more mapping pages
+ * when the cache can not hold the whole table.
+ */
+#ifndef RT_NFTL_MAP_CACHE_NUM
+#define RT_NFTL_MAP_CACHE_NUM       8
+#endif
+
+/* the percent of blocks reserved for garbage collection and bad blocks */
+#ifndef RT_NFTL_RESERVED_PERCENT
+#define RT_NFTL_RESERVED_PERCENT    5
+#endif
+
+/* static wear levelling starts when the difference of erase count exceeds it */
+#ifndef RT_NFTL_WL_THRESHOLD
+#define RT_NFTL_WL_THRESHOLD        64
+#endif
+
+/* the background garbage collection thread */
+#ifndef RT_NFTL_GC_STACK_SIZE
+#define RT_NFTL_GC_STACK_SIZE       1024
+#endif
+#ifndef RT_NFTL_GC_PRIORITY
+#define RT_NFTL_GC_PRIORITY         (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
+struct rt_nftl_stat
+{
+    rt_uint32_t sector_count;       /* logical sectors, one sector is one page */
+    rt_uint32_t block_count;
+    rt_uint32_t free_blocks;
+    rt_uint32_t bad_blocks;
+
+    rt_uint32_t erase_min;
+    rt_uint32_t erase_max;
+    rt_uint32_t erase_avg;
+
+    rt_uint32_t page_read;
+    rt_uint32_t page_write;         /* pages written by host */
+    rt_uint32_t gc_count;           /* blocks collected */
+    rt_uint32_t gc_copy;            /* pages copied by garbage collection */
+    rt_uint32_t wl_count;           /* blocks moved by static wear levelling */
+
+    rt_uint32_t map_hit;
+    rt_uint32_t map_miss;
+    rt_uint32_t map_write;          /* mapping pages written */
+};
+
+/*
+ * Attach a flash translation layer on the MTD NAND device, and register a
+ * block device with name. The sector of block device is one page of NAND.
+ */
+rt_err_t rt_mtd_nftl_attach(const char *mtd_name, const char *name);
+rt_err_t rt_mtd_nftl_get_stat(const char *name, struct rt_nftl_stat *stat);
+
+#endif
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-11-23     Bernard      Add extern "C"
+ * 2013-06-22     Bernard      Add asynchronous transfer queue
  */
 
 #ifndef __SPI_H__
@@ -83,6 +84,11 @@ struct rt_spi_bus
 
     struct rt_mutex lock;
     struct rt_spi_device *owner;
+
+#ifdef RT_USING_SPI_ASYNC
+    rt_list_t request_list;                                /* queued requests in device priority */
+    struct rt_work work;                                   /* the work to transfer the requests */
+#endif
 };
 
 /**
@@ -103,9 +109,45 @@ struct rt_spi_device
     struct rt_spi_bus *bus;
 
     struct rt_spi_configuration config;
+#ifdef RT_USING_SPI_ASYNC
+    rt_uint8_t priority;                                   /* priority of asynchronous requests */
+#endif
 };
 #define SPI_DEVICE(dev) ((struct rt_spi_device *)(dev))
 
+#ifdef RT_USING_SPI_ASYNC
+/**
+ * SPI asynchronous request, the message list of it is transferred by the
+ * workqueue of SPI bus, and the complete callback is invoked then.
+ *
+ * The requests are transferred in the priority of devices, a smaller value
+ * is a higher priority. The following requests of the same device in the
+ * same priority are transferred with the bus taken and configured once.
+ */
+struct rt_spi_request
+{
+    rt_list_t list;
+    struct rt_spi_device  *device;
+    struct rt_spi_message *message;                        /* the message list */
+    rt_uint8_t priority;
+
+    struct rt_spi_message *failed;                         /* RT_NULL if transferred successfully */
+    rt_err_t result;
+
+    void (*complete)(struct rt_spi_request *request);
+    void *user_data;
+};
+
+#ifndef RT_SPI_WORKQUEUE_PRIO
+#define RT_SPI_WORKQUEUE_PRIO   (RT_SYSTEM_WORKQUEUE_PRIO + 1)
+#endif
+
+/* the maximal requests of the same device transferred at once */
+#ifndef RT_SPI_ASYNC_BATCH
+#define RT_SPI_ASYNC_BATCH      8
+#endif
+#endif
+
 /* register a SPI bus */
 rt_err_t rt_spi_bus_register(struct rt_spi_bus       *bus,
                              const char              *name,
@@ -197,6 +239,40 @@ rt_size_t rt_spi_transfer(struct rt_spi_device *device,
 struct rt_spi_message *rt_spi_transfer_message(struct rt_spi_device  *device,
                                                struct rt_spi_message *message);
 
+#ifdef RT_USING_SPI_ASYNC
+/* the asynchronous transfer, it depends on RT_USING_WORKQUEUE */
+void rt_spi_request_init(struct rt_spi_request *request,
+                         struct rt_spi_message *message,
+                         void (*complete)(struct rt_spi_request *request),
+                         void                  *user_data);
+
+/* set the priority of asynchronous requests of SPI device */
+void rt_spi_set_priority(struct rt_spi_device *device, rt_uint8_t priority);
+
+/**
+ * This function queues a request to transfer its message list to the SPI
+ * device. It returns immediately, and can be invoked in ISR.
+ *
+ * @param device the SPI device attached to SPI bus
+ * @param request the request which is not queued
+ *
+ * @return RT_EOK on queued, -RT_EBUSY if the request is queued already.
+ */
+rt_err_t rt_spi_transfer_async(struct rt_spi_device  *device,
+                               struct rt_spi_request *request);
+
+/**
+ * This function removes a request which is not transferred from the queue.
+ *
+ * @param device the SPI device attached to SPI bus
+ * @param request the queued request
+ *
+ * @return RT_EOK on removed, -RT_ERROR if it's not queued.
+ */
+rt_err_t rt_spi_cancel_async(struct rt_spi_device  *device,
+                             struct rt_spi_request *request);
+#endif
+
 rt_inline rt_size_t rt_spi_recv(struct rt_spi_device *device,
                                 void                 *recv_buf,
                                 rt_size_t             length)
@@ -154,6 +154,12 @@ void rt_data_queue_reset(struct rt_data_queue *queue);
 
 #ifdef RT_USING_MTD_NAND
 #include "drivers/mtd_nand.h"
+#ifdef RT_USING_MTD_NFTL
+#include "drivers/mtd_nftl.h"
+#endif
+#ifdef RT_USING_MTD_ECC
+#include "drivers/mtd_ecc.h"
+#endif
 #endif /* RT_USING_MTD_NAND */
 
 #ifdef RT_USING_USB_DEVICE
@@ -0,0 +1,796 @@
+/*
+ * File      : mtd_ecc.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-26     Bernard      the first version
+ */
+
+/*
+ * The software ECC for NAND flash without ECC hardware.
+ *
+ * Hamming code: the parity of each 32 bits word is taken from the table of byte
+ * parity, the line parity is the index of words with odd parity, so there is
+ * no bit operation for each byte.
+ *
+ * BCH code: the remainder of 32 bits data is looked up in 4 tables, one for
+ * each byte, the decoding is done by syndromes, Berlekamp-Massey algorithm and
+ * Chien search, which only runs when there are bit flips.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifdef RT_USING_MTD_ECC
+
+static const rt_uint8_t _parity[256] =
+{
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
+    0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
+};
+
+/* put the 4 bits to the even bits of byte */
+static const rt_uint8_t _spread[16] =
+{
+    0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+    0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+};
+
+/* take the odd bits of byte */
+rt_inline rt_uint32_t _gather(rt_uint8_t value)
+{
+    return ((value >> 1) & 0x01) | ((value >> 2) & 0x02) |
+           ((value >> 3) & 0x04) | ((value >> 4) & 0x08);
+}
+
+rt_inline rt_uint8_t _parity32(rt_uint32_t value)
+{
+    value ^= value >> 16;
+    value ^= value >> 8;
+
+    return _parity[value & 0xFF];
+}
+
+void rt_mtd_hamming_calc(const rt_uint8_t *data, rt_uint32_t size, rt_uint8_t *ecc)
+{
+    rt_uint32_t index, odd, even, total;
+    rt_uint8_t column, code;
+
+    RT_ASSERT(size == 256 || size == 512);
+
+    /* odd: the bit k is the parity of bytes which have bit k of index set */
+    odd = 0;
+    if (((rt_ubase_t)data & 0x03) == 0)
+    {
+        const rt_uint32_t *word = (const rt_uint32_t *)data;
+        rt_uint32_t sum, value;
+        rt_uint8_t *lane = (rt_uint8_t *)&sum;
+
+        sum = 0;
+        for (index = 0; index < size / 4; index ++)
+        {
+            value = word[index];
+            sum ^= value;
+            odd ^= index & (0 - (rt_uint32_t)_parity32(value));
+        }
+
+        /* the bit 0 and 1 of byte index are the lanes in word */
+        odd = (odd << 2) | _parity[lane[1] ^ lane[3]] | (_parity[lane[2] ^ lane[3]] << 1);
+        column = lane[0] ^ lane[1] ^ lane[2] ^ lane[3];
+    }
+    else
+    {
+        column = 0;
+        for (index = 0; index < size; index ++)
+        {
+            column ^= data[index];
+            odd ^= index & (0 - (rt_uint32_t)_parity[data[index]]);
+        }
+    }
+
+    /* the parity of bytes without bit k of index set */
+    total = _parity[column];
+    even = (odd ^ (0 - total)) & (size - 1);
+
+    ecc[0] = ~(_spread[even & 0x0F] | (_spread[odd & 0x0F] << 1));
+    ecc[1] = ~(_spread[(even >> 4) & 0x0F] | (_spread[(odd >> 4) & 0x0F] << 1));
+
+    code = (_parity[column & 0xF0] << 7) | (_parity[column & 0x0F] << 6) |
+           (_parity[column & 0xCC] << 5) | (_parity[column & 0x33] << 4) |
+           (_parity[column & 0xAA] << 3) | (_parity[column & 0x55] << 2);
+    if (size == 512)
+        code |= (((odd >> 8) & 0x01) << 1) | ((even >> 8) & 0x01);
+    ecc[2] = ~code;
+}
+RTM_EXPORT(rt_mtd_hamming_calc);
+
+int rt_mtd_hamming_correct(rt_uint8_t *data, rt_uint32_t size,
+                           const rt_uint8_t *read_ecc, const rt_uint8_t *calc_ecc)
+{
+    rt_uint8_t b0, b1, b2, mask;
+    rt_uint32_t diff, byte, bit;
+
+    b0 = read_ecc[0] ^ calc_ecc[0];
+    b1 = read_ecc[1] ^ calc_ecc[1];
+    b2 = read_ecc[2] ^ calc_ecc[2];
+    if ((b0 | b1 | b2) == 0)
+        return 0;
+
+    /* one bit of data flips: one of each pair of parities is different */
+    mask = (size == 512) ? 0x55 : 0x54;
+    if (((b0 ^ (b0 >> 1)) & 0x55) == 0x55 &&
+        ((b1 ^ (b1 >> 1)) & 0x55) == 0x55 &&
+        ((b2 ^ (b2 >> 1)) & mask) == mask)
+    {
+        byte = _gather(b0) | (_gather(b1) << 4);
+        if (size == 512)
+            byte |= ((b2 >> 1) & 0x01) << 8;
+        bit = _gather(b2 >> 2);
+
+        data[byte] ^= 1 << bit;
+        return 1;
+    }
+
+    /* one bit of ECC flips */
+    diff = b0 | (b1 << 8) | (b2 << 16);
+    if ((diff & (diff - 1)) == 0)
+        return 1;
+
+    return -RT_MTD_EECC;
+}
+RTM_EXPORT(rt_mtd_hamming_correct);
+
+/* GF(2^13) */
+#define BCH_M               13
+#define BCH_N               ((1 << BCH_M) - 1)
+#define BCH_POLY            0x201B      /* x^13 + x^4 + x^3 + x + 1 */
+#define BCH_T_MAX           16
+
+static rt_uint16_t *_gf_pow;            /* alpha^i */
+static rt_uint16_t *_gf_log;
+static rt_uint32_t _gf_ref;
+
+static rt_err_t _gf_init(void)
+{
+    rt_uint32_t index, value;
+
+    if (_gf_ref > 0)
+    {
+        _gf_ref ++;
+        return RT_EOK;
+    }
+
+    _gf_pow = (rt_uint16_t *)rt_malloc((BCH_N + 1) * sizeof(rt_uint16_t));
+    _gf_log = (rt_uint16_t *)rt_malloc((BCH_N + 1) * sizeof(rt_uint16_t));
+    if (_gf_pow == RT_NULL || _gf_log == RT_NULL)
+    {
+        if (_gf_pow != RT_NULL) rt_free(_gf_pow);
+        if (_gf_log != RT_NULL) rt_free(_gf_log);
+        _gf_pow = _gf_log = RT_NULL;
+
+        return -RT_ENOMEM;
+    }
+
+    value = 1;
+    for (index = 0; index < BCH_N; index ++)
+    {
+        _gf_pow[index] = value;
+        _gf_log[value] = index;
+
+        value <<= 1;
+        if (value & (1 << BCH_M))
+            value ^= BCH_POLY;
+    }
+    _gf_pow[BCH_N] = 1;
+    _gf_log[0] = 0;
+    _gf_ref = 1;
+
+    return RT_EOK;
+}
+
+static void _gf_release(void)
+{
+    if (-- _gf_ref == 0)
+    {
+        rt_free(_gf_pow);
+        rt_free(_gf_log);
+        _gf_pow = _gf_log = RT_NULL;
+    }
+}
+
+rt_inline rt_uint32_t _gf_mod(rt_uint32_t value)
+{
+    while (value >= BCH_N)
+        value -= BCH_N;
+
+    return value;
+}
+
+rt_inline rt_uint16_t _gf_mul(rt_uint16_t a, rt_uint16_t b)
+{
+    return (a && b) ? _gf_pow[_gf_mod(_gf_log[a] + _gf_log[b])] : 0;
+}
+
+rt_inline rt_uint16_t _gf_div(rt_uint16_t a, rt_uint16_t b)
+{
+    return a ? _gf_pow[_gf_mod(_gf_log[a] + BCH_N - _gf_log[b])] : 0;
+}
+
+#define BIT_GET(map, bit)   (((map)[(bit) >> 5] >> ((bit) & 31)) & 0x01)
+#define BIT_XOR(map, bit)   ((map)[(bit) >> 5] ^= 1UL << ((bit) & 31))
+
+/*
+ * The generator polynomial is the product of minimal polynomials of alpha^1 to
+ * alpha^2t, the bit i of genpoly is the coefficient of x^i. Returns the degree.
+ */
+static rt_uint32_t _bch_genpoly(rt_uint8_t t, rt_uint32_t *genpoly, rt_uint32_t words)
+{
+    rt_uint16_t minpoly[BCH_M + 1];
+    rt_uint32_t product[(BCH_M * BCH_T_MAX + 32) / 32];
+    rt_uint8_t done[2 * BCH_T_MAX + 1];
+    rt_uint32_t degree, mdeg, index, k, root, bit;
+
+    rt_memset(genpoly, 0, words * sizeof(rt_uint32_t));
+    rt_memset(done, 0, sizeof(done));
+    genpoly[0] = 1;
+    degree = 0;
+
+    for (index = 1; index <= 2 * t; index ++)
+    {
+        if (done[index])
+            continue;
+
+        /* the roots of minimal polynomial are the conjugates of alpha^index */
+        minpoly[0] = 1;
+        mdeg = 0;
+        root = index;
+        do
+        {
+            if (root <= 2 * t)
+                done[root] = 1;
+
+            /* minpoly = minpoly * (x + alpha^root) */
+            minpoly[mdeg + 1] = minpoly[mdeg];
+            for (k = mdeg; k > 0; k --)
+                minpoly[k] = minpoly[k - 1] ^ _gf_mul(minpoly[k], _gf_pow[root]);
+            minpoly[0] = _gf_mul(minpoly[0], _gf_pow[root]);
+            mdeg ++;
+
+            root = _gf_mod(root * 2);
+        } while (root != index);
+
+        /* the coefficients of minimal polynomial are 0 or 1 */
+        rt_memset(product, 0, sizeof(product));
+        for (k = 0; k <= mdeg; k ++)
+        {
+            if (minpoly[k] == 0)
+                continue;
+
+            for (bit = 0; bit <= degree; bit ++)
+            {
+                if (BIT_GET(genpoly, bit))
+                    BIT_XOR(product, bit + k);
+            }
+        }
+        degree += mdeg;
+        rt_memcpy(genpoly, product, words * sizeof(rt_uint32_t));
+    }
+
+    return degree;
+}
+
+/* the remainder of data * x^ecc_bits divided by the generator polynomial */
+static void _bch_encode(struct rt_mtd_bch *bch, const rt_uint8_t *data,
+                        rt_uint32_t size, rt_uint32_t *remainder)
+{
+    const rt_uint32_t *t0, *t1, *t2, *t3;
+    rt_uint32_t words = bch->ecc_words;
+    rt_uint32_t value, index;
+
+    rt_memset(remainder, 0, words * sizeof(rt_uint32_t));
+
+    /* 32 bits each time, the first bit of data is the highest degree */
+    while (size >= 4)
+    {
+        value = ((rt_uint32_t)data[0] << 24) | ((rt_uint32_t)data[1] << 16) |
+                ((rt_uint32_t)data[2] << 8) | data[3];
+        value ^= remainder[0];
+
+        t0 = bch->mod_tab + (value & 0xFF) * words;
+        t1 = bch->mod_tab + (256 + ((value >> 8) & 0xFF)) * words;
+        t2 = bch->mod_tab + (512 + ((value >> 16) & 0xFF)) * words;
+        t3 = bch->mod_tab + (768 + (value >> 24)) * words;
+        for (index = 0; index < words - 1; index ++)
+            remainder[index] = remainder[index + 1] ^ t0[index] ^ t1[index] ^ t2[index] ^ t3[index];
+        remainder[words - 1] = t0[words - 1] ^ t1[words - 1] ^ t2[words - 1] ^ t3[words - 1];
+
+        data += 4;
+        size -= 4;
+    }
+
+    while (size > 0)
+    {
+        value = (remainder[0] >> 24) ^ *data;
+
+        t0 = bch->mod_tab + value * words;
+        for (index = 0; index < words - 1; index ++)
+            remainder[index] = ((remainder[index] << 8) | (remainder[index + 1] >> 24)) ^ t0[index];
+        remainder[words - 1] = (remainder[words - 1] << 8) ^ t0[words - 1];
+
+        data ++;
+        size --;
+    }
+}
+
+/* build the remainder tables of 4 bytes of a 32 bits word */
+static void _bch_build_table(struct rt_mtd_bch *bch, const rt_uint32_t *genpoly)
+{
+    rt_uint32_t words = bch->ecc_words;
+    rt_uint32_t *power, *entry;
+    rt_uint32_t degree, index, carry, byte, value, low;
+
+    /* power: x^(ecc_bits + k) mod g(x), the highest degree is the MSB of word 0 */
+    power = bch->ecc_buf;
+    rt_memset(power, 0, words * sizeof(rt_uint32_t));
+    for (degree = 0; degree < bch->ecc_bits; degree ++)
+    {
+        if (BIT_GET(genpoly, degree))
+        {
+            index = bch->ecc_bits - 1 - degree;
+            power[index >> 5] |= 0x80000000UL >> (index & 31);
+        }
+    }
+
+    for (byte = 0; byte < 4; byte ++)
+    {
+        entry = bch->mod_tab + byte * 256 * words;
+        rt_memset(entry, 0, words * sizeof(rt_uint32_t));
+
+        for (value = 1; value < 256; value <<= 1)
+        {
+            rt_memcpy(entry + value * words, power, words * sizeof(rt_uint32_t));
+
+            /* power = power * x mod g(x) */
+            carry = power[0] & 0x80000000UL;
+            for (index = 0; index < words - 1; index ++)
+                power[index] = (power[index] << 1) | (power[index + 1] >> 31);
+            power[words - 1] <<= 1;
+            if (carry)
+            {
+                for (index = 0; index < words; index ++)
+                    power[index] ^= bch->mod_tab[words + index];
+            }
+        }
+
+        /* the remainder is linear */
+        for (value = 3; value < 256; value ++)
+        {
+            low = value & (0 - value);
+            if (low == value)
+                continue;
+
+            for (index = 0; index < words; index ++)
+            {
+                entry[value * words + index] = entry[(value ^ low) * words + index] ^
+                                               entry[low * words + index];
+            }
+        }
+    }
+}
+
+struct rt_mtd_bch *rt_mtd_bch_create(rt_uint8_t t, rt_uint32_t size)
+{
+    struct rt_mtd_bch *bch;
+    rt_uint32_t genpoly[(BCH_M * BCH_T_MAX + 32) / 32];
+    rt_uint8_t *erased;
+    rt_uint32_t index;
+
+    /* the remainder should be more than 32 bits */
+    if (t < 3 || t > BCH_T_MAX || size * 8 + t * BCH_M > BCH_N)
+        return RT_NULL;
+
+    if (_gf_init() != RT_EOK)
+        return RT_NULL;
+
+    bch = (struct rt_mtd_bch *)rt_malloc(sizeof(struct rt_mtd_bch));
+    if (bch == RT_NULL)
+    {
+        _gf_release();
+        return RT_NULL;
+    }
+    rt_memset(bch, 0, sizeof(struct rt_mtd_bch));
+
+    bch->t = t;
+    bch->size = size;
+    bch->ecc_bits = _bch_genpoly(t, genpoly, sizeof(genpoly) / sizeof(rt_uint32_t));
+    bch->ecc_words = (bch->ecc_bits + 31) / 32;
+    bch->ecc_bytes = (bch->ecc_bits + 7) / 8;
+
+    bch->mod_tab = (rt_uint32_t *)rt_malloc(4 * 256 * bch->ecc_words * sizeof(rt_uint32_t));
+    bch->ecc_buf = (rt_uint32_t *)rt_malloc(bch->ecc_words * sizeof(rt_uint32_t));
+    bch->ecc_mask = (rt_uint8_t *)rt_malloc(bch->ecc_bytes);
+    bch->syn = (rt_uint16_t *)rt_malloc(2 * t * sizeof(rt_uint16_t));
+    bch->elp = (rt_uint16_t *)rt_malloc((2 * t + 1) * sizeof(rt_uint16_t));
+    bch->elp_prev = (rt_uint16_t *)rt_malloc((2 * t + 1) * sizeof(rt_uint16_t));
+    bch->elp_tmp = (rt_uint16_t *)rt_malloc((2 * t + 1) * sizeof(rt_uint16_t));
+    erased = (rt_uint8_t *)rt_malloc(size);
+    if (bch->mod_tab == RT_NULL || bch->ecc_buf == RT_NULL ||
+        bch->ecc_mask == RT_NULL || bch->syn == RT_NULL || bch->elp == RT_NULL ||
+        bch->elp_prev == RT_NULL || bch->elp_tmp == RT_NULL || erased == RT_NULL)
+    {
+        if (erased != RT_NULL) rt_free(erased);
+        rt_mtd_bch_delete(bch);
+
+        return RT_NULL;
+    }
+
+    _bch_build_table(bch, genpoly);
+
+    /* the ECC of erased data is 0xFF, so the erased page has no error */
+    rt_memset(bch->ecc_mask, 0, bch->ecc_bytes);
+    rt_memset(erased, 0xFF, size);
+    rt_mtd_bch_calc(bch, erased, bch->ecc_mask);
+    for (index = 0; index < bch->ecc_bytes; index ++)
+        bch->ecc_mask[index] ^= 0xFF;
+    rt_free(erased);
+
+    return bch;
+}
+RTM_EXPORT(rt_mtd_bch_create);
+
+void rt_mtd_bch_delete(struct rt_mtd_bch *bch)
+{
+    if (bch->mod_tab != RT_NULL) rt_free(bch->mod_tab);
+    if (bch->ecc_buf != RT_NULL) rt_free(bch->ecc_buf);
+    if (bch->ecc_mask != RT_NULL) rt_free(bch->ecc_mask);
+    if (bch->syn != RT_NULL) rt_free(bch->syn);
+    if (bch->elp != RT_NULL) rt_free(bch->elp);
+    if (bch->elp_prev != RT_NULL) rt_free(bch->elp_prev);
+    if (bch->elp_tmp != RT_NULL) rt_free(bch->elp_tmp);
+    rt_free(bch);
+
+    _gf_release();
+}
+RTM_EXPORT(rt_mtd_bch_delete);
+
+void rt_mtd_bch_calc(struct rt_mtd_bch *bch, const rt_uint8_t *data, rt_uint8_t *ecc)
+{
+    rt_uint32_t index;
+
+    _bch_encode(bch, data, bch->size, bch->ecc_buf);
+    for (index = 0; index < bch->ecc_bytes; index ++)
+    {
+        ecc[index] = (rt_uint8_t)(bch->ecc_buf[index >> 2] >> (24 - ((index & 0x03) << 3))) ^
+                     bch->ecc_mask[index];
+    }
+}
+RTM_EXPORT(rt_mtd_bch_calc);
+
+int rt_mtd_bch_correct(struct rt_mtd_bch *bch, rt_uint8_t *data,
+                       const rt_uint8_t *read_ecc, const rt_uint8_t *calc_ecc)
+{
+    rt_uint16_t *syn = bch->syn, *elp = bch->elp, *prev = bch->elp_prev, *tmp = bch->elp_tmp;
+    rt_uint32_t index, j, bit, degree, length, count, position;
+    rt_uint32_t order, shift, n;
+    rt_uint16_t discrepancy, last, coef;
+    rt_uint8_t diff;
+    rt_bool_t error = RT_FALSE;
+
+    /* the syndromes of the remainder of error polynomial */
+    rt_memset(syn, 0, 2 * bch->t * sizeof(rt_uint16_t));
+    for (index = 0; index < bch->ecc_bytes; index ++)
+    {
+        diff = read_ecc[index] ^ calc_ecc[index];
+        if (index == bch->ecc_bytes - 1 && (bch->ecc_bits & 0x07))
+            diff &= 0xFF << (8 - (bch->ecc_bits & 0x07));
+
+        for (bit = 0; diff != 0; bit ++, diff <<= 1)
+        {
+            if ((diff & 0x80) == 0)
+                continue;
+
+            error = RT_TRUE;
+            degree = bch->ecc_bits - 1 - (index * 8 + bit);
+            for (j = 1; j < 2 * bch->t; j += 2)
+                syn[j - 1] ^= _gf_pow[(j * degree) % BCH_N];
+        }
+    }
+    if (error == RT_FALSE)
+        return 0;
+
+    for (j = 2; j <= 2 * bch->t; j += 2)
+        syn[j - 1] = _gf_mul(syn[j / 2 - 1], syn[j / 2 - 1]);
+
+    /* Berlekamp-Massey algorithm for the error locator polynomial */
+    length = 2 * bch->t + 1;
+    rt_memset(elp, 0, length * sizeof(rt_uint16_t));
+    rt_memset(prev, 0, length * sizeof(rt_uint16_t));
+    elp[0] = prev[0] = 1;
+    order = 0;
+    shift = 1;
+    last = 1;
+    for (n = 0; n < 2 * bch->t; n ++)
+    {
+        discrepancy = syn[n];
+        for (index = 1; index <= order; index ++)
+            discrepancy ^= _gf_mul(elp[index], syn[n - index]);
+
+        if (discrepancy == 0)
+        {
+            shift ++;
+            continue;
+        }
+
+        coef = _gf_div(discrepancy, last);
+        if (2 * order <= n)
+        {
+            rt_memcpy(tmp, elp, length * sizeof(rt_uint16_t));
+            for (index = 0; index + shift < length; index ++)
+                elp[index + shift] ^= _gf_mul(coef, prev[index]);
+            rt_memcpy(prev, tmp, length * sizeof(rt_uint16_t));
+
+            order = n + 1 - order;
+            last = discrepancy;
+            shift = 1;
+        }
+        else
+        {
+            for (index = 0; index + shift < length; index ++)
+                elp[index + shift] ^= _gf_mul(coef, prev[index]);
+            shift ++;
+        }
+    }
+    if (order > bch->t)
+        return -RT_MTD_EECC;
+
+    /* Chien search: the error at degree d is the root alpha^-d */
+    for (index = 1; index <= order; index ++)
+        tmp[index] = elp[index] ? _gf_log[elp[index]] : 0xFFFF;
+
+    count = 0;
+    length = bch->size * 8 + bch->ecc_bits;
+    if (order == 1)
+    {
+        /* the most common case, 1 + alpha^d x has the root alpha^-d */
+        if (tmp[1] < length)
+            syn[count ++] = tmp[1];
+        degree = length;
+    }
+    else
+    {
+        degree = 0;
+    }
+    for (; degree < length && count < order; degree ++)
+    {
+        rt_uint16_t sum = 1;
+
+        for (index = 1; index <= order; index ++)
+        {
+            if (tmp[index] == 0xFFFF)
+                continue;
+
+            sum ^= _gf_pow[tmp[index]];
+            tmp[index] = (tmp[index] >= index) ? tmp[index] - index : tmp[index] + BCH_N - index;
+        }
+
+        /* the syndromes are not used any more */
+        if (sum == 0)
+            syn[count ++] = degree;
+    }
+    if (count != order)
+        return -RT_MTD_EECC;
+
+    for (index = 0; index < count; index ++)
+    {
+        /* the error in ECC is not corrected */
+        if (syn[index] < bch->ecc_bits)
+            continue;
+
+        position = bch->size * 8 - 1 - (syn[index] - bch->ecc_bits);
+        data[position >> 3] ^= 0x80 >> (position & 0x07);
+    }
+
+    return count;
+}
+RTM_EXPORT(rt_mtd_bch_correct);
+
+/* MTD layer */
+static void _ecc_calc(struct rt_mtd_ecc *ecc, const rt_uint8_t *data, rt_uint8_t *code)
+{
+    if (ecc->bch != RT_NULL)
+        rt_mtd_bch_calc(ecc->bch, data, code);
+    else
+        rt_mtd_hamming_calc(data, ecc->step, code);
+}
+
+static int _ecc_correct(struct rt_mtd_ecc *ecc, rt_uint8_t *data,
+                        const rt_uint8_t *read_ecc, const rt_uint8_t *calc_ecc)
+{
+    if (ecc->bch != RT_NULL)
+        return rt_mtd_bch_correct(ecc->bch, data, read_ecc, calc_ecc);
+
+    return rt_mtd_hamming_correct(data, ecc->step, read_ecc, calc_ecc);
+}
+
+static void _ecc_free(struct rt_mtd_ecc *ecc)
+{
+    if (ecc->bch != RT_NULL) rt_mtd_bch_delete(ecc->bch);
+    if (ecc->spare != RT_NULL) rt_free(ecc->spare);
+    if (ecc->code != RT_NULL) rt_free(ecc->code);
+    rt_free(ecc);
+}
+
+rt_err_t rt_mtd_nand_ecc_setup(struct rt_mtd_nand_device *device, int mode)
+{
+    struct rt_mtd_ecc *ecc;
+
+    if (device->ecc != RT_NULL)
+    {
+        _ecc_free(device->ecc);
+        device->ecc = RT_NULL;
+    }
+    if (mode == RT_MTD_ECC_NONE)
+        return RT_EOK;
+
+    ecc = (struct rt_mtd_ecc *)rt_malloc(sizeof(struct rt_mtd_ecc));
+    if (ecc == RT_NULL)
+        return -RT_ENOMEM;
+    rt_memset(ecc, 0, sizeof(struct rt_mtd_ecc));
+    ecc->mode = mode;
+
+    switch (mode)
+    {
+    case RT_MTD_ECC_HAMMING_256:
+        ecc->step = 256;
+        ecc->bytes = RT_MTD_HAMMING_BYTES;
+        break;
+
+    case RT_MTD_ECC_HAMMING_512:
+        ecc->step = 512;
+        ecc->bytes = RT_MTD_HAMMING_BYTES;
+        break;
+
+    case RT_MTD_ECC_BCH4:
+    case RT_MTD_ECC_BCH8:
+        ecc->step = 512;
+        ecc->bch = rt_mtd_bch_create(mode == RT_MTD_ECC_BCH4 ? 4 : 8, ecc->step);
+        if (ecc->bch == RT_NULL)
+            goto __error;
+        ecc->bytes = ecc->bch->ecc_bytes;
+        break;
+
+    default:
+        goto __error;
+    }
+
+    ecc->steps = device->page_size / ecc->step;
+    if (ecc->steps == 0 || device->page_size % ecc->step != 0 ||
+        ecc->steps * ecc->bytes > device->oob_size - device->oob_free)
+    {
+        rt_kprintf("mtd: no room for ECC mode %d in spare\n", mode);
+        goto __error;
+    }
+
+    ecc->spare = (rt_uint8_t *)rt_malloc(device->oob_size);
+    ecc->code = (rt_uint8_t *)rt_malloc(ecc->bytes);
+    if (ecc->spare == RT_NULL || ecc->code == RT_NULL)
+        goto __error;
+
+    device->ecc = ecc;
+
+    return RT_EOK;
+
+__error:
+    _ecc_free(ecc);
+
+    return -RT_ERROR;
+}
+RTM_EXPORT(rt_mtd_nand_ecc_setup);
+
+/* the bit flips corrected are added to device->bitflips */
+rt_err_t rt_mtd_nand_ecc_check(struct rt_mtd_nand_device *device,
+                               rt_uint8_t *data, const rt_uint8_t *spare)
+{
+    struct rt_mtd_ecc *ecc = device->ecc;
+    rt_err_t result = RT_EOK;
+    rt_uint32_t index;
+    int bitflips;
+
+    for (index = 0; index < ecc->steps; index ++)
+    {
+        _ecc_calc(ecc, data + index * ecc->step, ecc->code);
+        bitflips = _ecc_correct(ecc, data + index * ecc->step,
+                                spare + index * ecc->bytes, ecc->code);
+        if (bitflips < 0)
+            result = -RT_MTD_EECC;
+        else
+            device->bitflips += bitflips;
+    }
+
+    return result;
+}
+RTM_EXPORT(rt_mtd_nand_ecc_check);
+
+void rt_mtd_nand_ecc_fill(struct rt_mtd_nand_device *device,
+                          const rt_uint8_t *data, rt_uint8_t *spare)
+{
+    struct rt_mtd_ecc *ecc = device->ecc;
+    rt_uint32_t index;
+
+    for (index = 0; index < ecc->steps; index ++)
+        _ecc_calc(ecc, data + index * ecc->step, spare + index * ecc->bytes);
+}
+RTM_EXPORT(rt_mtd_nand_ecc_fill);
+
+rt_err_t rt_mtd_nand_ecc_read(struct rt_mtd_nand_device *device, rt_off_t page,
+                              rt_uint8_t *data, rt_uint32_t data_len,
+                              rt_uint8_t *spare, rt_uint32_t spare_len)
+{
+    struct rt_mtd_ecc *ecc = device->ecc;
+    rt_err_t result;
+
+    device->bitflips = 0;
+
+    /* only the whole page is protected */
+    if (data == RT_NULL || data_len != device->page_size)
+        return device->ops->read_page(device, page, data, data_len, spare, spare_len);
+
+    result = device->ops->read_page(device, page, data, data_len, ecc->spare, device->oob_size);
+    if (result != RT_EOK)
+        return result;
+
+    result = rt_mtd_nand_ecc_check(device, data, ecc->spare);
+    if (spare != RT_NULL && spare_len != 0)
+    {
+        if (spare_len > device->oob_size)
+            spare_len = device->oob_size;
+        rt_memcpy(spare, ecc->spare, spare_len);
+    }
+
+    return result;
+}
+RTM_EXPORT(rt_mtd_nand_ecc_read);
+
+rt_err_t rt_mtd_nand_ecc_write(struct rt_mtd_nand_device *device, rt_off_t page,
+                               const rt_uint8_t *data, rt_uint32_t data_len,
+                               const rt_uint8_t *spare, rt_uint32_t spare_len)
+{
+    struct rt_mtd_ecc *ecc = device->ecc;
+
+    if (data == RT_NULL || data_len != device->page_size)
+        return device->ops->write_page(device, page, data, data_len, spare, spare_len);
+
+    rt_memset(ecc->spare, 0xFF, device->oob_size);
+    if (spare != RT_NULL && spare_len != 0)
+    {
+        if (spare_len > device->oob_size)
+            spare_len = device->oob_size;
+        rt_memcpy(ecc->spare, spare, spare_len);
+    }
+    rt_mtd_nand_ecc_fill(device, data, ecc->spare);
+
+    return device->ops->write_page(device, page, data, data_len, ecc->spare, device->oob_size);
+}
+RTM_EXPORT(rt_mtd_nand_ecc_write);
+
+#endif /* RT_USING_MTD_ECC */
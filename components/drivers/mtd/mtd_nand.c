@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2011-12-05     Bernard      the first version
+ * 2013-01-28     Bernard      add multi-page and multi-plane operations
  */
 
 /*
@@ -83,5 +84,245 @@ rt_err_t rt_mtd_nand_register_device(const char                *name,
     return rt_device_register(dev, name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_STANDALONE);
 }
 
+#define _PLANE_NUM(device)  ((device)->plane_num > 1 ? (device)->plane_num : 1)
+
+/*
+ * The whole spares of pages passed to driver when the MTD layer does ECC. The
+ * ECC of each page is placed in the spare for writing.
+ */
+static rt_uint8_t *_ecc_spare(struct rt_mtd_nand_device *device, rt_uint32_t count,
+                              const rt_uint8_t *data, const rt_uint8_t *spare)
+{
+#ifdef RT_USING_MTD_ECC
+    rt_uint8_t *buffer;
+    rt_uint32_t index;
+
+    buffer = (rt_uint8_t *)rt_malloc(count * device->oob_size);
+    if (buffer == RT_NULL)
+        return RT_NULL;
+
+    if (data == RT_NULL)
+        return buffer;
+
+    if (spare != RT_NULL)
+        rt_memcpy(buffer, spare, count * device->oob_size);
+    else
+        rt_memset(buffer, 0xFF, count * device->oob_size);
+    for (index = 0; index < count; index ++)
+    {
+        rt_mtd_nand_ecc_fill(device, data + index * device->page_size,
+                             buffer + index * device->oob_size);
+    }
+
+    return buffer;
+#else
+    return RT_NULL;
+#endif
+}
+
+/**
+ * This function reads the sequential pages in one block, by read cache if the
+ * driver supports it.
+ *
+ * @param device the MTD NAND device
+ * @param page the first page
+ * @param count the number of pages
+ * @param data the buffer of count pages
+ * @param spare the buffer of count whole spares, or RT_NULL
+ *
+ * @return RT_EOK, -RT_MTD_EECC if any page has uncorrectable error, or the
+ * error of driver.
+ */
+rt_err_t rt_mtd_nand_read_pages(struct rt_mtd_nand_device *device, rt_off_t page,
+                                rt_uint32_t count, rt_uint8_t *data, rt_uint8_t *spare)
+{
+    rt_uint8_t *buffer = spare;
+    rt_uint32_t index, bitflips;
+    rt_err_t result, error;
+
+    RT_ASSERT(page % device->pages_per_block + count <= device->pages_per_block);
+
+    if (device->ecc != RT_NULL && spare == RT_NULL)
+        buffer = _ecc_spare(device, count, RT_NULL, RT_NULL);
+
+    if (device->ops->read_pages != RT_NULL && (device->ecc == RT_NULL || buffer != RT_NULL))
+    {
+        result = device->ops->read_pages(device, page, count, data, buffer);
+#ifdef RT_USING_MTD_ECC
+        if (device->ecc != RT_NULL && result == RT_EOK)
+        {
+            device->bitflips = 0;
+            for (index = 0; index < count; index ++)
+            {
+                error = rt_mtd_nand_ecc_check(device, data + index * device->page_size,
+                                              buffer + index * device->oob_size);
+                if (error != RT_EOK)
+                    result = error;
+            }
+        }
+#endif
+        if (buffer != spare)
+            rt_free(buffer);
+
+        return result;
+    }
+    if (buffer != spare)
+        rt_free(buffer);
+
+    /* emulated by reading page one by one */
+    result = RT_EOK;
+    bitflips = 0;
+    for (index = 0; index < count; index ++)
+    {
+        error = rt_mtd_nand_read(device, page + index,
+                                 data + index * device->page_size, device->page_size,
+                                 spare ? spare + index * device->oob_size : RT_NULL,
+                                 spare ? device->oob_size : 0);
+        bitflips += device->bitflips;
+
+        /* the other pages are still read when ECC fails */
+        if (error == -RT_MTD_EECC)
+            result = error;
+        else if (error != RT_EOK)
+            return error;
+    }
+    device->bitflips = bitflips;
+
+    return result;
+}
+RTM_EXPORT(rt_mtd_nand_read_pages);
+
+/**
+ * This function programs the sequential pages in one block, by cache program
+ * if the driver supports it.
+ *
+ * @param device the MTD NAND device
+ * @param page the first page
+ * @param count the number of pages
+ * @param data the data of count pages
+ * @param spare the count whole spares, or RT_NULL
+ *
+ * @return RT_EOK on successful, otherwise the error of driver.
+ */
+rt_err_t rt_mtd_nand_write_pages(struct rt_mtd_nand_device *device, rt_off_t page,
+                                 rt_uint32_t count, const rt_uint8_t *data,
+                                 const rt_uint8_t *spare)
+{
+    const rt_uint8_t *buffer = spare;
+    rt_uint32_t index;
+    rt_err_t result;
+
+    RT_ASSERT(page % device->pages_per_block + count <= device->pages_per_block);
+
+    if (device->ops->write_pages != RT_NULL)
+    {
+        if (device->ecc != RT_NULL)
+            buffer = _ecc_spare(device, count, data, spare);
+
+        if (device->ecc == RT_NULL || buffer != RT_NULL)
+        {
+            result = device->ops->write_pages(device, page, count, data, buffer);
+            if (buffer != spare)
+                rt_free((void *)buffer);
+
+            return result;
+        }
+    }
+
+    /* emulated by programming page one by one */
+    for (index = 0; index < count; index ++)
+    {
+        result = rt_mtd_nand_write(device, page + index,
+                                   data + index * device->page_size, device->page_size,
+                                   spare ? spare + index * device->oob_size : RT_NULL,
+                                   spare ? device->oob_size : 0);
+        if (result != RT_EOK)
+            return result;
+    }
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mtd_nand_write_pages);
+
+/**
+ * This function programs the same page of the blocks in each plane at once if
+ * the driver supports multi-plane program.
+ *
+ * @param device the MTD NAND device
+ * @param page the page in the first block, which is aligned to plane_num
+ * @param data the data of plane_num pages
+ * @param spare the plane_num whole spares, or RT_NULL
+ *
+ * @return RT_EOK on successful, otherwise the error of driver.
+ */
+rt_err_t rt_mtd_nand_write_planes(struct rt_mtd_nand_device *device, rt_off_t page,
+                                  const rt_uint8_t *data, const rt_uint8_t *spare)
+{
+    const rt_uint8_t *buffer = spare;
+    rt_uint32_t index, planes;
+    rt_err_t result;
+
+    planes = _PLANE_NUM(device);
+    RT_ASSERT((page / device->pages_per_block) % planes == 0);
+
+    if (device->ops->write_planes != RT_NULL)
+    {
+        if (device->ecc != RT_NULL)
+            buffer = _ecc_spare(device, planes, data, spare);
+
+        if (device->ecc == RT_NULL || buffer != RT_NULL)
+        {
+            result = device->ops->write_planes(device, page, data, buffer);
+            if (buffer != spare)
+                rt_free((void *)buffer);
+
+            return result;
+        }
+    }
+
+    for (index = 0; index < planes; index ++)
+    {
+        result = rt_mtd_nand_write(device, page + index * device->pages_per_block,
+                                   data + index * device->page_size, device->page_size,
+                                   spare ? spare + index * device->oob_size : RT_NULL,
+                                   spare ? device->oob_size : 0);
+        if (result != RT_EOK)
+            return result;
+    }
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mtd_nand_write_planes);
+
+/**
+ * This function erases the blocks in each plane at once if the driver supports
+ * multi-plane erase.
+ *
+ * @param device the MTD NAND device
+ * @param block the first block, which is aligned to plane_num
+ *
+ * @return RT_EOK on successful, otherwise the error of driver.
+ */
+rt_err_t rt_mtd_nand_erase_planes(struct rt_mtd_nand_device *device, rt_uint32_t block)
+{
+    rt_uint32_t index, planes;
+    rt_err_t result;
+
+    planes = _PLANE_NUM(device);
+    RT_ASSERT(block % planes == 0);
+
+    if (device->ops->erase_planes != RT_NULL)
+        return device->ops->erase_planes(device, block);
+
+    for (index = 0; index < planes; index ++)
+    {
+        result = device->ops->erase_block(device, block + index);
+        if (result != RT_EOK)
+            return result;
+    }
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mtd_nand_erase_planes);
 
 #endif
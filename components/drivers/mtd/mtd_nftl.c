@@ -0,0 +1,1130 @@
+/*
+ * File      : mtd_nftl.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-22     Bernard      the first version
+ * 2013-01-28     Bernard      read and program the sequential pages at once
+ */
+
+/*
+ * A log-structured NAND flash translation layer with page mapping.
+ *
+ * Every programmed page carries a tag in the free area of spare, which holds
+ * the logical page number, a global sequence number and the erase count of
+ * block. The tag is written with page data in one program operation, so the
+ * flash is always self-described: the newest page of a logical page is the one
+ * with the largest sequence, and a page torn by power failure has a broken tag
+ * and is treated as garbage.
+ *
+ * The mapping table is stored in flash as mapping pages as well, and only a
+ * few of them are cached in memory. The directory of mapping pages and the
+ * data pages written after the last mapping page are rebuilt by scanning the
+ * tags when attached.
+ *
+ * The free block with the least erase count is used at first (dynamic wear
+ * levelling), and the block of cold data is collected when the difference of
+ * erase count exceeds RT_NFTL_WL_THRESHOLD (static wear levelling). The
+ * garbage collection runs in a thread of the lowest priority besides idle,
+ * and is run in the writer when the free blocks are exhausted.
+ */
+
+#include <rtdevice.h>
+#include <drivers/mtd_nftl.h>
+
+#ifdef RT_USING_MTD_NFTL
+
+#define NFTL_INVALID            (~(rt_uint32_t)0)
+
+/* page type */
+#define NFTL_PAGE_FREE          0x00
+#define NFTL_PAGE_DATA          0x01
+#define NFTL_PAGE_MAP           0x02
+#define NFTL_PAGE_GARBAGE       0x03
+
+/* block state */
+#define NFTL_BLOCK_FREE         0x00
+#define NFTL_BLOCK_OPEN         0x01    /* the block being written */
+#define NFTL_BLOCK_FULL         0x02
+#define NFTL_BLOCK_RETIRE       0x03    /* failed to program, bad after collected */
+#define NFTL_BLOCK_BAD          0x04
+
+/* the free blocks kept for garbage collection of the writer */
+#define NFTL_GC_LOW             3
+
+/* the tag is stored twice in spare */
+#define NFTL_TAG_COPIES         2
+
+struct nftl_tag
+{
+    rt_uint32_t lpn;                /* logical page, or the index of mapping page */
+    rt_uint32_t seq;
+    rt_uint32_t erase_count;
+    rt_uint8_t  type;
+    rt_uint8_t  reserved;
+    rt_uint16_t check;
+};
+
+struct nftl_block
+{
+    rt_uint32_t erase_count;
+    rt_uint16_t valid;              /* the number of valid pages */
+    rt_uint16_t written;            /* the number of programmed pages */
+    rt_uint8_t  state;
+};
+
+struct nftl_map_cache
+{
+    rt_uint32_t index;              /* the index of mapping page */
+    rt_uint32_t age;
+    rt_bool_t   dirty;
+    rt_uint32_t *entry;
+};
+
+struct rt_mtd_nftl
+{
+    struct rt_device parent;
+
+    struct rt_mtd_nand_device *nand;
+    struct rt_mutex lock;
+    struct rt_semaphore gc_sem;
+
+    rt_uint32_t block_count;
+    rt_uint32_t pages_per_block;
+    rt_uint32_t page_size;
+    rt_uint32_t tag_offset;         /* the offset of tag in spare */
+
+    rt_uint32_t lpn_count;          /* logical pages */
+    rt_uint32_t map_count;          /* mapping pages */
+    rt_uint32_t entry_per_page;
+
+    struct nftl_block *blocks;
+    rt_uint32_t *directory;         /* the physical page of mapping pages */
+    struct nftl_map_cache cache[RT_NFTL_MAP_CACHE_NUM];
+    rt_uint32_t cache_age;
+
+    rt_uint32_t seq;
+    rt_uint32_t current;            /* the open block */
+    rt_uint32_t free_count;
+    rt_uint32_t gc_high;            /* background collection below it */
+
+    rt_uint8_t *page_buffer;
+    rt_uint8_t *spare_buffer;       /* the spares of one block */
+    rt_uint32_t *gc_lpn;            /* the logical pages of block in collection */
+
+    struct rt_nftl_stat stat;
+};
+
+static rt_uint16_t _tag_checksum(const struct nftl_tag *tag)
+{
+    const rt_uint8_t *ptr = (const rt_uint8_t *)tag;
+    rt_uint16_t sum1 = 0x5a, sum2 = 0xa5;
+    rt_uint32_t index, size;
+
+    /* fletcher-16 of the fields before check */
+    size = (rt_uint32_t)&(((struct nftl_tag *)0)->check);
+    for (index = 0; index < size; index ++)
+    {
+        sum1 = (sum1 + ptr[index]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+static rt_bool_t _is_erased(const rt_uint8_t *ptr, rt_uint32_t size)
+{
+    while (size --)
+    {
+        if (*ptr++ != 0xFF)
+            return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+
+static int _read_tag(struct rt_mtd_nftl *nftl, rt_uint32_t page, struct nftl_tag *tag)
+{
+    struct rt_mtd_nand_device *nand = nftl->nand;
+    rt_uint8_t *ptr;
+    int index;
+
+    if (rt_mtd_nand_read(nand, page, RT_NULL, 0, nftl->spare_buffer, nand->oob_size) != RT_EOK)
+        return NFTL_PAGE_GARBAGE;
+
+    ptr = nftl->spare_buffer + nftl->tag_offset;
+    if (_is_erased(ptr, sizeof(struct nftl_tag) * NFTL_TAG_COPIES))
+        return NFTL_PAGE_FREE;
+
+    for (index = 0; index < NFTL_TAG_COPIES; index ++)
+    {
+        rt_memcpy(tag, ptr + index * sizeof(struct nftl_tag), sizeof(struct nftl_tag));
+        if (tag->check == _tag_checksum(tag) &&
+            (tag->type == NFTL_PAGE_DATA || tag->type == NFTL_PAGE_MAP))
+            return tag->type;
+    }
+
+    return NFTL_PAGE_GARBAGE;
+}
+
+static void _fill_tag(struct rt_mtd_nftl *nftl, rt_uint8_t *spare, rt_uint32_t page,
+                      rt_uint8_t type, rt_uint32_t lpn)
+{
+    struct nftl_tag tag;
+    rt_uint8_t *ptr;
+    int index;
+
+    rt_memset(&tag, 0xFF, sizeof(struct nftl_tag));
+    tag.lpn = lpn;
+    tag.seq = nftl->seq ++;
+    tag.erase_count = nftl->blocks[page / nftl->pages_per_block].erase_count;
+    tag.type = type;
+    tag.check = _tag_checksum(&tag);
+
+    rt_memset(spare, 0xFF, nftl->nand->oob_size);
+    ptr = spare + nftl->tag_offset;
+    for (index = 0; index < NFTL_TAG_COPIES; index ++)
+        rt_memcpy(ptr + index * sizeof(struct nftl_tag), &tag, sizeof(struct nftl_tag));
+}
+
+/* program one page with tag in the open block */
+static rt_err_t _program_page(struct rt_mtd_nftl *nftl, rt_uint32_t page,
+                              const rt_uint8_t *data, rt_uint8_t type, rt_uint32_t lpn)
+{
+    struct rt_mtd_nand_device *nand = nftl->nand;
+
+    _fill_tag(nftl, nftl->spare_buffer, page, type, lpn);
+
+    return rt_mtd_nand_write(nand, page, data, nftl->page_size,
+                             nftl->spare_buffer, nand->oob_size);
+}
+
+/* open the free block with the least erase count */
+static rt_err_t _open_block(struct rt_mtd_nftl *nftl)
+{
+    rt_uint32_t block, found;
+
+    found = NFTL_INVALID;
+    for (block = 0; block < nftl->block_count; block ++)
+    {
+        if (nftl->blocks[block].state != NFTL_BLOCK_FREE)
+            continue;
+
+        if (found == NFTL_INVALID ||
+            nftl->blocks[block].erase_count < nftl->blocks[found].erase_count)
+            found = block;
+    }
+    if (found == NFTL_INVALID)
+        return -RT_EFULL;
+
+    nftl->blocks[found].state = NFTL_BLOCK_OPEN;
+    nftl->blocks[found].written = 0;
+    nftl->blocks[found].valid = 0;
+    nftl->free_count --;
+    nftl->current = found;
+
+    return RT_EOK;
+}
+
+/* make sure there is room in the open block */
+static rt_err_t _prepare_block(struct rt_mtd_nftl *nftl)
+{
+    if (nftl->current == NFTL_INVALID ||
+        nftl->blocks[nftl->current].written >= nftl->pages_per_block)
+    {
+        if (nftl->current != NFTL_INVALID)
+            nftl->blocks[nftl->current].state = NFTL_BLOCK_FULL;
+        nftl->current = NFTL_INVALID;
+
+        return _open_block(nftl);
+    }
+
+    return RT_EOK;
+}
+
+/* write a page to the open block, returns the physical page */
+static rt_uint32_t _write_page(struct rt_mtd_nftl *nftl, const rt_uint8_t *data,
+                               rt_uint8_t type, rt_uint32_t lpn)
+{
+    struct nftl_block *block;
+    rt_uint32_t page;
+    int retry;
+
+    for (retry = 0; retry < 3; retry ++)
+    {
+        if (_prepare_block(nftl) != RT_EOK)
+            return NFTL_INVALID;
+
+        block = &nftl->blocks[nftl->current];
+        page = nftl->current * nftl->pages_per_block + block->written;
+        block->written ++;
+
+        if (_program_page(nftl, page, data, type, lpn) == RT_EOK)
+        {
+            block->valid ++;
+            return page;
+        }
+
+        /* the block will be marked as bad after its valid pages are moved out */
+        rt_kprintf("nftl: program page %d failed\n", page);
+        block->state = NFTL_BLOCK_RETIRE;
+        nftl->current = NFTL_INVALID;
+    }
+
+    return NFTL_INVALID;
+}
+
+/*
+ * write the sequential logical pages to the rest of open block by one cache
+ * program, returns the number of pages written and the first physical page.
+ */
+static rt_uint32_t _write_pages(struct rt_mtd_nftl *nftl, const rt_uint8_t *data,
+                                rt_uint32_t lpn, rt_uint32_t count, rt_uint32_t *first)
+{
+    struct nftl_block *block;
+    rt_uint32_t page, index;
+
+    if (_prepare_block(nftl) != RT_EOK)
+        return 0;
+
+    block = &nftl->blocks[nftl->current];
+    if (count > nftl->pages_per_block - block->written)
+        count = nftl->pages_per_block - block->written;
+    if (count == 1)
+    {
+        *first = _write_page(nftl, data, NFTL_PAGE_DATA, lpn);
+        return *first != NFTL_INVALID ? 1 : 0;
+    }
+
+    page = nftl->current * nftl->pages_per_block + block->written;
+    for (index = 0; index < count; index ++)
+    {
+        _fill_tag(nftl, nftl->spare_buffer + index * nftl->nand->oob_size,
+                  page + index, NFTL_PAGE_DATA, lpn + index);
+    }
+
+    block->written += count;
+    if (rt_mtd_nand_write_pages(nftl->nand, page, count, data, nftl->spare_buffer) == RT_EOK)
+    {
+        block->valid += count;
+        *first = page;
+        return count;
+    }
+
+    /* the pages are written one by one in another block */
+    rt_kprintf("nftl: program page %d-%d failed\n", page, page + count - 1);
+    block->state = NFTL_BLOCK_RETIRE;
+    nftl->current = NFTL_INVALID;
+
+    *first = _write_page(nftl, data, NFTL_PAGE_DATA, lpn);
+    return *first != NFTL_INVALID ? 1 : 0;
+}
+
+rt_inline void _invalidate(struct rt_mtd_nftl *nftl, rt_uint32_t page)
+{
+    if (page != NFTL_INVALID)
+        nftl->blocks[page / nftl->pages_per_block].valid --;
+}
+
+static rt_err_t _map_flush(struct rt_mtd_nftl *nftl, struct nftl_map_cache *cache)
+{
+    rt_uint32_t page;
+
+    page = _write_page(nftl, (rt_uint8_t *)cache->entry, NFTL_PAGE_MAP, cache->index);
+    if (page == NFTL_INVALID)
+        return -RT_ERROR;
+
+    _invalidate(nftl, nftl->directory[cache->index]);
+    nftl->directory[cache->index] = page;
+    cache->dirty = RT_FALSE;
+    nftl->stat.map_write ++;
+
+    return RT_EOK;
+}
+
+static struct nftl_map_cache *_map_load(struct rt_mtd_nftl *nftl, rt_uint32_t index)
+{
+    struct nftl_map_cache *cache, *victim;
+    rt_uint32_t page, i;
+
+    victim = &nftl->cache[0];
+    for (i = 0; i < RT_NFTL_MAP_CACHE_NUM; i ++)
+    {
+        cache = &nftl->cache[i];
+        if (cache->index == index)
+        {
+            cache->age = ++ nftl->cache_age;
+            nftl->stat.map_hit ++;
+            return cache;
+        }
+
+        /* the empty one, or the least recently used one */
+        if (victim->index != NFTL_INVALID &&
+            (cache->index == NFTL_INVALID || cache->age < victim->age))
+            victim = cache;
+    }
+
+    nftl->stat.map_miss ++;
+    if (victim->index != NFTL_INVALID && victim->dirty == RT_TRUE)
+    {
+        if (_map_flush(nftl, victim) != RT_EOK)
+            return RT_NULL;
+    }
+
+    page = nftl->directory[index];
+    if (page == NFTL_INVALID)
+    {
+        /* never written, all of logical pages are not mapped */
+        rt_memset(victim->entry, 0xFF, nftl->page_size);
+    }
+    else
+    {
+        if (rt_mtd_nand_read(nftl->nand, page, (rt_uint8_t *)victim->entry,
+                             nftl->page_size, RT_NULL, 0) != RT_EOK)
+        {
+            /* the entry of victim is overwritten, drop it */
+            rt_kprintf("nftl: read mapping page %d failed\n", page);
+            victim->index = NFTL_INVALID;
+            return RT_NULL;
+        }
+
+        /* the physical page out of device is not mapped */
+        for (i = 0; i < nftl->entry_per_page; i ++)
+        {
+            if (victim->entry[i] != NFTL_INVALID &&
+                victim->entry[i] >= nftl->block_count * nftl->pages_per_block)
+            {
+                rt_kprintf("nftl: bad entry %d in mapping page %d\n", i, page);
+                victim->entry[i] = NFTL_INVALID;
+            }
+        }
+    }
+
+    victim->index = index;
+    victim->dirty = RT_FALSE;
+    victim->age = ++ nftl->cache_age;
+
+    return victim;
+}
+
+static rt_uint32_t _map_get(struct rt_mtd_nftl *nftl, rt_uint32_t lpn)
+{
+    struct nftl_map_cache *cache;
+
+    cache = _map_load(nftl, lpn / nftl->entry_per_page);
+    if (cache == RT_NULL)
+        return NFTL_INVALID;
+
+    return cache->entry[lpn % nftl->entry_per_page];
+}
+
+/* set the mapping, the old physical page is returned in old if it's not null */
+static rt_err_t _map_set(struct rt_mtd_nftl *nftl, rt_uint32_t lpn, rt_uint32_t page,
+                         rt_uint32_t *old)
+{
+    struct nftl_map_cache *cache;
+
+    cache = _map_load(nftl, lpn / nftl->entry_per_page);
+    if (cache == RT_NULL)
+        return -RT_EIO;
+
+    if (old != RT_NULL)
+        *old = cache->entry[lpn % nftl->entry_per_page];
+    cache->entry[lpn % nftl->entry_per_page] = page;
+    cache->dirty = RT_TRUE;
+
+    return RT_EOK;
+}
+
+static rt_err_t _map_sync(struct rt_mtd_nftl *nftl)
+{
+    int index;
+
+    for (index = 0; index < RT_NFTL_MAP_CACHE_NUM; index ++)
+    {
+        if (nftl->cache[index].index != NFTL_INVALID && nftl->cache[index].dirty)
+        {
+            if (_map_flush(nftl, &nftl->cache[index]) != RT_EOK)
+                return -RT_ERROR;
+        }
+    }
+
+    return RT_EOK;
+}
+
+/* move the valid pages out of block, then erase it */
+static rt_err_t _collect_block(struct rt_mtd_nftl *nftl, rt_uint32_t block)
+{
+    struct nftl_block *blk = &nftl->blocks[block];
+    struct nftl_tag tag;
+    rt_uint32_t page, offset, next, index, new_page, old;
+    rt_uint32_t *lpns = nftl->gc_lpn;
+
+    /* move the mapping pages, and collect the logical page of data pages */
+    for (offset = 0; offset < blk->written; offset ++)
+    {
+        page = block * nftl->pages_per_block + offset;
+        lpns[offset] = NFTL_INVALID;
+
+        switch (_read_tag(nftl, page, &tag))
+        {
+        case NFTL_PAGE_DATA:
+            if (tag.lpn < nftl->lpn_count)
+                lpns[offset] = tag.lpn;
+            break;
+
+        case NFTL_PAGE_MAP:
+            if (tag.lpn < nftl->map_count && nftl->directory[tag.lpn] == page)
+            {
+                struct nftl_map_cache *cache;
+
+                /* rewrite the mapping page to the open block */
+                cache = _map_load(nftl, tag.lpn);
+                if (cache == RT_NULL || _map_flush(nftl, cache) != RT_EOK)
+                    return -RT_EFULL;
+                nftl->stat.gc_copy ++;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    /* move the data pages grouped by mapping page, so each mapping page is
+     * loaded once for one block */
+    for (offset = 0; offset < blk->written && blk->valid > 0; offset ++)
+    {
+        if (lpns[offset] == NFTL_INVALID)
+            continue;
+
+        index = lpns[offset] / nftl->entry_per_page;
+        for (next = offset; next < blk->written; next ++)
+        {
+            if (lpns[next] == NFTL_INVALID || lpns[next] / nftl->entry_per_page != index)
+                continue;
+
+            page = block * nftl->pages_per_block + next;
+            if (_map_get(nftl, lpns[next]) == page)
+            {
+                if (rt_mtd_nand_read(nftl->nand, page, nftl->page_buffer,
+                                     nftl->page_size, RT_NULL, 0) != RT_EOK)
+                    rt_kprintf("nftl: read page %d failed, the data is lost\n", page);
+
+                new_page = _write_page(nftl, nftl->page_buffer, NFTL_PAGE_DATA, lpns[next]);
+                if (new_page == NFTL_INVALID)
+                    return -RT_EFULL;
+                if (_map_set(nftl, lpns[next], new_page, &old) != RT_EOK)
+                {
+                    /* the old page is still mapped, the new one is garbage */
+                    _invalidate(nftl, new_page);
+                    return -RT_EIO;
+                }
+                _invalidate(nftl, old);
+                nftl->stat.gc_copy ++;
+            }
+            lpns[next] = NFTL_INVALID;
+        }
+    }
+
+    if (blk->state == NFTL_BLOCK_RETIRE ||
+        rt_mtd_nand_erase_block(nftl->nand, block) != RT_EOK)
+    {
+        rt_kprintf("nftl: block %d is bad\n", block);
+        if (nftl->nand->ops->mark_badblock != RT_NULL)
+            rt_mtd_nand_mark_badblock(nftl->nand, block);
+        blk->state = NFTL_BLOCK_BAD;
+        nftl->stat.bad_blocks ++;
+    }
+    else
+    {
+        blk->erase_count ++;
+        blk->state = NFTL_BLOCK_FREE;
+        nftl->free_count ++;
+    }
+    blk->valid = 0;
+    blk->written = 0;
+    nftl->stat.gc_count ++;
+
+    return RT_EOK;
+}
+
+/* the full block with the least valid pages */
+static rt_uint32_t _select_victim(struct rt_mtd_nftl *nftl)
+{
+    rt_uint32_t block, found;
+
+    found = NFTL_INVALID;
+    for (block = 0; block < nftl->block_count; block ++)
+    {
+        struct nftl_block *blk = &nftl->blocks[block];
+
+        if (blk->state == NFTL_BLOCK_RETIRE)
+            return block;
+        if (blk->state != NFTL_BLOCK_FULL || blk->valid >= nftl->pages_per_block)
+            continue;
+
+        if (found == NFTL_INVALID || blk->valid < nftl->blocks[found].valid)
+            found = block;
+    }
+
+    return found;
+}
+
+/* the full block of cold data, when it's erased much less than others */
+static rt_uint32_t _select_cold(struct rt_mtd_nftl *nftl)
+{
+    rt_uint32_t block, found, max;
+
+    found = NFTL_INVALID;
+    max = 0;
+    for (block = 0; block < nftl->block_count; block ++)
+    {
+        struct nftl_block *blk = &nftl->blocks[block];
+
+        if (blk->state == NFTL_BLOCK_BAD)
+            continue;
+        if (blk->erase_count > max)
+            max = blk->erase_count;
+
+        if (blk->state == NFTL_BLOCK_FULL &&
+            (found == NFTL_INVALID || blk->erase_count < nftl->blocks[found].erase_count))
+            found = block;
+    }
+
+    if (found != NFTL_INVALID &&
+        max - nftl->blocks[found].erase_count > RT_NFTL_WL_THRESHOLD)
+        return found;
+
+    return NFTL_INVALID;
+}
+
+static void _nftl_gc_entry(void *parameter)
+{
+    struct rt_mtd_nftl *nftl = (struct rt_mtd_nftl *)parameter;
+    rt_uint32_t block;
+    rt_bool_t busy = RT_FALSE;
+
+    while (1)
+    {
+        /* keep working while there is something to do */
+        if (busy == RT_FALSE)
+            rt_sem_take(&nftl->gc_sem, RT_TICK_PER_SECOND);
+
+        busy = RT_FALSE;
+        rt_mutex_take(&nftl->lock, RT_WAITING_FOREVER);
+        if (nftl->free_count < nftl->gc_high)
+        {
+            /* collect the block with enough garbage in background, the others
+             * are left to the writer */
+            block = _select_victim(nftl);
+            if (block != NFTL_INVALID &&
+                nftl->blocks[block].valid <= nftl->pages_per_block * 3 / 4)
+            {
+                _collect_block(nftl, block);
+                busy = RT_TRUE;
+            }
+        }
+        else
+        {
+            /* move one block of cold data in each period */
+            block = _select_cold(nftl);
+            if (block != NFTL_INVALID)
+            {
+                _collect_block(nftl, block);
+                nftl->stat.wl_count ++;
+            }
+        }
+        rt_mutex_release(&nftl->lock);
+    }
+}
+
+/* make sure there are free blocks for the writer */
+static void _make_space(struct rt_mtd_nftl *nftl)
+{
+    rt_uint32_t block, count;
+
+    for (count = 0; nftl->free_count < NFTL_GC_LOW && count < nftl->block_count; count ++)
+    {
+        block = _select_victim(nftl);
+        if (block == NFTL_INVALID || _collect_block(nftl, block) != RT_EOK)
+            break;
+    }
+
+    if (nftl->free_count < nftl->gc_high)
+        rt_sem_release(&nftl->gc_sem);
+}
+
+/* rebuild the blocks, the directory of mapping pages and the mapping table */
+static rt_err_t _nftl_scan(struct rt_mtd_nftl *nftl)
+{
+    struct nftl_tag tag, cur_tag;
+    struct nftl_block *blk;
+    rt_uint32_t *directory_seq;
+    rt_uint32_t block, offset, page, ec_total, ec_known, mapped, last;
+    int type;
+
+    directory_seq = (rt_uint32_t *)rt_malloc(nftl->map_count * sizeof(rt_uint32_t));
+    if (directory_seq == RT_NULL)
+        return -RT_ENOMEM;
+
+    /* pass 1: the state of blocks and the newest mapping pages */
+    ec_total = ec_known = 0;
+    nftl->seq = 0;
+    last = NFTL_INVALID;
+    for (block = 0; block < nftl->block_count; block ++)
+    {
+        blk = &nftl->blocks[block];
+        rt_memset(blk, 0, sizeof(struct nftl_block));
+        blk->erase_count = NFTL_INVALID;
+
+        if (nftl->nand->ops->check_block != RT_NULL &&
+            rt_mtd_nand_check_block(nftl->nand, block) != RT_EOK)
+        {
+            blk->state = NFTL_BLOCK_BAD;
+            nftl->stat.bad_blocks ++;
+            continue;
+        }
+
+        for (offset = 0; offset < nftl->pages_per_block; offset ++)
+        {
+            page = block * nftl->pages_per_block + offset;
+            type = _read_tag(nftl, page, &tag);
+            if (type == NFTL_PAGE_FREE)
+                continue;
+
+            blk->written = offset + 1;
+            if (type == NFTL_PAGE_GARBAGE)
+                continue;
+
+            if (blk->erase_count == NFTL_INVALID || tag.erase_count > blk->erase_count)
+                blk->erase_count = tag.erase_count;
+            if (tag.seq >= nftl->seq)
+            {
+                nftl->seq = tag.seq + 1;
+                last = block;
+            }
+
+            if (type == NFTL_PAGE_MAP && tag.lpn < nftl->map_count &&
+                (nftl->directory[tag.lpn] == NFTL_INVALID || tag.seq > directory_seq[tag.lpn]))
+            {
+                nftl->directory[tag.lpn] = page;
+                directory_seq[tag.lpn] = tag.seq;
+            }
+        }
+
+        /* the block written before is full, except the one written last */
+        if (blk->written > 0)
+            blk->state = NFTL_BLOCK_FULL;
+        else
+        {
+            blk->state = NFTL_BLOCK_FREE;
+            nftl->free_count ++;
+        }
+
+        if (blk->erase_count != NFTL_INVALID)
+        {
+            ec_total += blk->erase_count;
+            ec_known ++;
+        }
+    }
+
+    /* continue to write the block written last, skip the page after the last
+     * programmed one, which may be interrupted by power loss */
+    if (last != NFTL_INVALID && nftl->blocks[last].written + 1 < nftl->pages_per_block)
+    {
+        nftl->blocks[last].state = NFTL_BLOCK_OPEN;
+        nftl->blocks[last].written ++;
+        nftl->current = last;
+    }
+
+    /* the erase count of erased block is not recorded, use the average */
+    for (block = 0; block < nftl->block_count; block ++)
+    {
+        if (nftl->blocks[block].erase_count == NFTL_INVALID)
+            nftl->blocks[block].erase_count = ec_known ? ec_total / ec_known : 0;
+    }
+
+    /* pass 2: replay the data pages written after their mapping page */
+    for (page = 0; page < nftl->block_count * nftl->pages_per_block; page ++)
+    {
+        rt_uint32_t index;
+
+        blk = &nftl->blocks[page / nftl->pages_per_block];
+        if (blk->state != NFTL_BLOCK_FULL && blk->state != NFTL_BLOCK_OPEN)
+            continue;
+        if (_read_tag(nftl, page, &tag) != NFTL_PAGE_DATA || tag.lpn >= nftl->lpn_count)
+            continue;
+
+        index = tag.lpn / nftl->entry_per_page;
+        if (nftl->directory[index] != NFTL_INVALID && tag.seq < directory_seq[index])
+            continue;
+
+        /* the mapped page may be erased and written again by other one */
+        mapped = _map_get(nftl, tag.lpn);
+        if (mapped == NFTL_INVALID ||
+            _read_tag(nftl, mapped, &cur_tag) != NFTL_PAGE_DATA ||
+            cur_tag.lpn != tag.lpn || cur_tag.seq < tag.seq)
+        {
+            if (_map_set(nftl, tag.lpn, page, RT_NULL) != RT_EOK)
+            {
+                rt_free(directory_seq);
+                return -RT_EIO;
+            }
+        }
+    }
+    rt_free(directory_seq);
+
+    /* write back the replayed mapping, then no page is written in pass 3 */
+    if (_map_sync(nftl) != RT_EOK)
+        return -RT_EIO;
+
+    /* pass 3: count the valid pages */
+    for (block = 0; block < nftl->block_count; block ++)
+        nftl->blocks[block].valid = 0;
+    for (page = 0; page < nftl->block_count * nftl->pages_per_block; page ++)
+    {
+        blk = &nftl->blocks[page / nftl->pages_per_block];
+        if (blk->state != NFTL_BLOCK_FULL && blk->state != NFTL_BLOCK_OPEN)
+            continue;
+        if (page % nftl->pages_per_block >= blk->written)
+            continue;
+
+        type = _read_tag(nftl, page, &tag);
+        if ((type == NFTL_PAGE_DATA && tag.lpn < nftl->lpn_count &&
+             _map_get(nftl, tag.lpn) == page) ||
+            (type == NFTL_PAGE_MAP && tag.lpn < nftl->map_count &&
+             nftl->directory[tag.lpn] == page))
+        {
+            blk->valid ++;
+        }
+    }
+
+    return RT_EOK;
+}
+
+/* RT-Thread device interface */
+static rt_err_t _nftl_init(rt_device_t dev)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _nftl_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _nftl_close(rt_device_t dev)
+{
+    return RT_EOK;
+}
+
+static rt_size_t _nftl_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    struct rt_mtd_nftl *nftl = (struct rt_mtd_nftl *)dev;
+    rt_uint8_t *ptr = (rt_uint8_t *)buffer;
+    rt_uint32_t page, run;
+    rt_size_t count;
+
+    if (pos >= nftl->lpn_count)
+        return 0;
+    if (size > nftl->lpn_count - pos)
+        size = nftl->lpn_count - pos;
+
+    rt_mutex_take(&nftl->lock, RT_WAITING_FOREVER);
+    for (count = 0; count < size; count += run)
+    {
+        run = 1;
+        page = _map_get(nftl, pos + count);
+        if (page == NFTL_INVALID)
+        {
+            rt_memset(ptr, 0xFF, nftl->page_size);
+        }
+        else
+        {
+            /* the logical pages written together are sequential in block */
+            while (count + run < size &&
+                   (page + run) % nftl->pages_per_block != 0 &&
+                   _map_get(nftl, pos + count + run) == page + run)
+                run ++;
+
+            if (rt_mtd_nand_read_pages(nftl->nand, page, run, ptr, RT_NULL) != RT_EOK)
+            {
+                rt_set_errno(-RT_EIO);
+                break;
+            }
+        }
+
+        ptr += run * nftl->page_size;
+        nftl->stat.page_read += run;
+    }
+    rt_mutex_release(&nftl->lock);
+
+    return count;
+}
+
+static rt_size_t _nftl_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    struct rt_mtd_nftl *nftl = (struct rt_mtd_nftl *)dev;
+    const rt_uint8_t *ptr = (const rt_uint8_t *)buffer;
+    rt_uint32_t page, run, index, old;
+    rt_size_t count;
+
+    if (pos >= nftl->lpn_count)
+        return 0;
+    if (size > nftl->lpn_count - pos)
+        size = nftl->lpn_count - pos;
+
+    rt_mutex_take(&nftl->lock, RT_WAITING_FOREVER);
+    for (count = 0; count < size; count += run)
+    {
+        _make_space(nftl);
+
+        run = _write_pages(nftl, ptr, pos + count, size - count, &page);
+        if (run == 0)
+        {
+            rt_set_errno(-RT_EFULL);
+            break;
+        }
+        for (index = 0; index < run; index ++)
+        {
+            if (_map_set(nftl, pos + count + index, page + index, &old) != RT_EOK)
+                break;
+            _invalidate(nftl, old);
+        }
+        nftl->stat.page_write += index;
+
+        if (index < run)
+        {
+            /* the rest of written pages are not mapped, which are garbage */
+            count += index;
+            while (index < run)
+                _invalidate(nftl, page + index ++);
+
+            rt_set_errno(-RT_EIO);
+            break;
+        }
+
+        ptr += run * nftl->page_size;
+    }
+    rt_mutex_release(&nftl->lock);
+
+    return count;
+}
+
+static rt_err_t _nftl_control(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+    struct rt_mtd_nftl *nftl = (struct rt_mtd_nftl *)dev;
+    rt_err_t result = RT_EOK;
+
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_BLK_GETGEOME:
+        {
+            struct rt_device_blk_geometry *geometry;
+
+            geometry = (struct rt_device_blk_geometry *)args;
+            if (geometry == RT_NULL)
+                return -RT_ERROR;
+
+            geometry->sector_count = nftl->lpn_count;
+            geometry->bytes_per_sector = nftl->page_size;
+            geometry->block_size = nftl->page_size * nftl->pages_per_block;
+        }
+        break;
+
+    case RT_DEVICE_CTRL_BLK_SYNC:
+        rt_mutex_take(&nftl->lock, RT_WAITING_FOREVER);
+        result = _map_sync(nftl);
+        rt_mutex_release(&nftl->lock);
+        break;
+
+    default:
+        break;
+    }
+
+    return result;
+}
+
+rt_err_t rt_mtd_nftl_attach(const char *mtd_name, const char *name)
+{
+    struct rt_mtd_nand_device *nand;
+    struct rt_mtd_nftl *nftl;
+    rt_uint32_t reserved, data_pages;
+    rt_thread_t tid;
+    rt_err_t result;
+    int index;
+
+    nand = RT_MTD_NAND_DEVICE(rt_device_find(mtd_name));
+    if (nand == RT_NULL || nand->parent.type != RT_Device_Class_MTD)
+    {
+        rt_kprintf("nftl: no MTD NAND device %s\n", mtd_name);
+        return -RT_ERROR;
+    }
+
+    /* the tag is placed after the bad block marker in free area of spare */
+    if (nand->oob_free < sizeof(struct nftl_tag) * NFTL_TAG_COPIES + 1)
+    {
+        rt_kprintf("nftl: no room for tag in spare of %s\n", mtd_name);
+        return -RT_ERROR;
+    }
+
+    nftl = (struct rt_mtd_nftl *)rt_malloc(sizeof(struct rt_mtd_nftl));
+    if (nftl == RT_NULL)
+        return -RT_ENOMEM;
+    rt_memset(nftl, 0, sizeof(struct rt_mtd_nftl));
+
+    nftl->nand = nand;
+    nftl->block_count = nand->block_total;
+    nftl->pages_per_block = nand->pages_per_block;
+    nftl->page_size = nand->page_size;
+    nftl->tag_offset = nand->oob_size - nand->oob_free + 1;
+    nftl->entry_per_page = nand->page_size / sizeof(rt_uint32_t);
+    nftl->current = NFTL_INVALID;
+
+    /* the capacity does not change with bad blocks */
+    reserved = nftl->block_count * RT_NFTL_RESERVED_PERCENT / 100 + NFTL_GC_LOW + 1;
+    if (nftl->block_count <= reserved * 2)
+    {
+        rt_kprintf("nftl: too few blocks in %s\n", mtd_name);
+        rt_free(nftl);
+        return -RT_ERROR;
+    }
+    data_pages = (nftl->block_count - reserved) * nftl->pages_per_block;
+    nftl->map_count = (data_pages + nftl->entry_per_page - 1) / nftl->entry_per_page;
+    nftl->lpn_count = data_pages - nftl->map_count;
+    /* the garbage is not enough to keep all of reserved blocks free */
+    nftl->gc_high = reserved / 2 + NFTL_GC_LOW;
+
+    nftl->blocks = (struct nftl_block *)rt_malloc(nftl->block_count * sizeof(struct nftl_block));
+    nftl->directory = (rt_uint32_t *)rt_malloc(nftl->map_count * sizeof(rt_uint32_t));
+    nftl->page_buffer = (rt_uint8_t *)rt_malloc(nand->page_size);
+    nftl->spare_buffer = (rt_uint8_t *)rt_malloc(nand->pages_per_block * nand->oob_size);
+    nftl->gc_lpn = (rt_uint32_t *)rt_malloc(nand->pages_per_block * sizeof(rt_uint32_t));
+    result = -RT_ENOMEM;
+    if (nftl->blocks == RT_NULL || nftl->directory == RT_NULL ||
+        nftl->page_buffer == RT_NULL || nftl->spare_buffer == RT_NULL ||
+        nftl->gc_lpn == RT_NULL)
+        goto __failed;
+    rt_memset(nftl->directory, 0xFF, nftl->map_count * sizeof(rt_uint32_t));
+
+    for (index = 0; index < RT_NFTL_MAP_CACHE_NUM; index ++)
+    {
+        nftl->cache[index].index = NFTL_INVALID;
+        nftl->cache[index].entry = (rt_uint32_t *)rt_malloc(nand->page_size);
+        if (nftl->cache[index].entry == RT_NULL)
+            goto __failed;
+    }
+
+    result = _nftl_scan(nftl);
+    if (result != RT_EOK)
+    {
+        rt_kprintf("nftl: scan %s failed\n", mtd_name);
+        goto __failed;
+    }
+
+    rt_mutex_init(&nftl->lock, name, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&nftl->gc_sem, name, 0, RT_IPC_FLAG_FIFO);
+
+    nftl->parent.type    = RT_Device_Class_Block;
+    nftl->parent.init    = _nftl_init;
+    nftl->parent.open    = _nftl_open;
+    nftl->parent.close   = _nftl_close;
+    nftl->parent.read    = _nftl_read;
+    nftl->parent.write   = _nftl_write;
+    nftl->parent.control = _nftl_control;
+    rt_device_register(&nftl->parent, name,
+                       RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_STANDALONE);
+
+    tid = rt_thread_create(name, _nftl_gc_entry, nftl,
+                           RT_NFTL_GC_STACK_SIZE, RT_NFTL_GC_PRIORITY, 20);
+    if (tid != RT_NULL)
+        rt_thread_startup(tid);
+
+    return RT_EOK;
+
+__failed:
+    for (index = 0; index < RT_NFTL_MAP_CACHE_NUM; index ++)
+    {
+        if (nftl->cache[index].entry != RT_NULL)
+            rt_free(nftl->cache[index].entry);
+    }
+    if (nftl->blocks != RT_NULL) rt_free(nftl->blocks);
+    if (nftl->directory != RT_NULL) rt_free(nftl->directory);
+    if (nftl->page_buffer != RT_NULL) rt_free(nftl->page_buffer);
+    if (nftl->spare_buffer != RT_NULL) rt_free(nftl->spare_buffer);
+    if (nftl->gc_lpn != RT_NULL) rt_free(nftl->gc_lpn);
+    rt_free(nftl);
+
+    return result;
+}
+
+rt_err_t rt_mtd_nftl_get_stat(const char *name, struct rt_nftl_stat *stat)
+{
+    struct rt_mtd_nftl *nftl;
+    rt_uint32_t block, total, count;
+
+    nftl = (struct rt_mtd_nftl *)rt_device_find(name);
+    if (nftl == RT_NULL || nftl->parent.type != RT_Device_Class_Block ||
+        nftl->parent.read != _nftl_read)
+        return -RT_ERROR;
+
+    rt_mutex_take(&nftl->lock, RT_WAITING_FOREVER);
+    *stat = nftl->stat;
+    stat->sector_count = nftl->lpn_count;
+    stat->block_count = nftl->block_count;
+    stat->free_blocks = nftl->free_count;
+
+    stat->erase_min = NFTL_INVALID;
+    stat->erase_max = 0;
+    total = count = 0;
+    for (block = 0; block < nftl->block_count; block ++)
+    {
+        if (nftl->blocks[block].state == NFTL_BLOCK_BAD)
+            continue;
+
+        if (nftl->blocks[block].erase_count < stat->erase_min)
+            stat->erase_min = nftl->blocks[block].erase_count;
+        if (nftl->blocks[block].erase_count > stat->erase_max)
+            stat->erase_max = nftl->blocks[block].erase_count;
+        total += nftl->blocks[block].erase_count;
+        count ++;
+    }
+    stat->erase_avg = count ? total / count : 0;
+    rt_mutex_release(&nftl->lock);
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+void nftl_info(const char *name)
+{
+    struct rt_nftl_stat stat;
+
+    if (rt_mtd_nftl_get_stat(name, &stat) != RT_EOK)
+    {
+        rt_kprintf("%s is not a NFTL device\n", name);
+        return;
+    }
+
+    rt_kprintf("sectors: %d, blocks: %d, free: %d, bad: %d\n",
+               stat.sector_count, stat.block_count, stat.free_blocks, stat.bad_blocks);
+    rt_kprintf("erase count min: %d, max: %d, average: %d\n",
+               stat.erase_min, stat.erase_max, stat.erase_avg);
+    rt_kprintf("page read: %d, write: %d\n", stat.page_read, stat.page_write);
+    rt_kprintf("gc blocks: %d, copied pages: %d, wear levelling: %d\n",
+               stat.gc_count, stat.gc_copy, stat.wl_count);
+    rt_kprintf("mapping cache hit: %d, miss: %d, written: %d\n",
+               stat.map_hit, stat.map_miss, stat.map_write);
+}
+FINSH_FUNCTION_EXPORT(nftl_info, show the information of NFTL device);
+#endif
+
+#endif /* RT_USING_MTD_NFTL */
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author            Notes
  * 2012-10-27     heyuanjie87       first version.
+ * 2013-06-21     Bernard           update alarm in system workqueue.
  */
 
 #include <rtthread.h>
@@ -377,7 +378,11 @@ _exit:
  */
 void rt_alarm_update(rt_device_t dev, rt_uint32_t event)
 {
+#ifdef RT_USING_WORKQUEUE
+    rt_workqueue_dowork(rt_workqueue_get(RT_SYSTEM_WORKQUEUE_PRIO), &_container.work.work);
+#else
     rt_event_send(&_container.event, 1);
+#endif
 }
 
 /** \brief modify the alarm setup
@@ -569,6 +574,39 @@ rt_alarm_t rt_alarm_create(rt_alarm_callback_t callback, struct rt_alarm_setup *
     return (alarm);
 }
 
+#ifdef RT_USING_WORKQUEUE
+/** \brief rtc alarm service work
+ *
+ */
+static void rt_alarmsvc_work(struct rt_work *work, void *work_data)
+{
+    /* don't block the shared system workqueue while the alarms are being
+     * changed, retry it in the next tick */
+    if (rt_mutex_take(&_container.mutex, 0) != RT_EOK)
+    {
+        rt_workqueue_submit_delayed(rt_workqueue_get(RT_SYSTEM_WORKQUEUE_PRIO),
+                                    &_container.work, 1);
+        return;
+    }
+
+    alarm_update(1);
+    rt_mutex_release(&_container.mutex);
+}
+
+/** \brief initialize alarm service system
+ *
+ * \param none
+ * \return none
+ */
+void rt_alarm_system_init(void)
+{
+    /* the alarm is updated in system workqueue, no service thread */
+    rt_list_init(&_container.head);
+    rt_mutex_init(&_container.mutex, "alarmsvc", RT_IPC_FLAG_FIFO);
+    rt_delayed_work_init(&_container.work, rt_alarmsvc_work, RT_NULL);
+    _container.current = RT_NULL;
+}
+#else
 /** \brief rtc alarm service thread entry
  *
  */
@@ -609,3 +647,4 @@ void rt_alarm_system_init(void)
         rt_thread_startup(tid);
 }
 #endif
+#endif
@@ -13,6 +13,7 @@
  * 2012-05-15     lgnq         modified according bernard's implementation.
  * 2012-05-28     bernard      code cleanup
  * 2012-11-23     bernard      fix compiler warning.
+ * 2013-06-10     bernard      add poll operation.
  */
 
 #include <rthw.h>
@@ -366,6 +367,27 @@ static rt_err_t rt_serial_control(struct rt_device *dev,
     return RT_EOK;
 }
 
+#ifdef RT_USING_POLL
+static int rt_serial_poll(struct rt_device *dev, struct rt_pollreq *req)
+{
+    int mask;
+    struct rt_serial_device *serial;
+
+    RT_ASSERT(dev != RT_NULL);
+    serial = (struct rt_serial_device *)dev;
+
+    rt_poll_add(&(dev->wait_queue), req);
+
+    /* the polling mode Rx is always ready, it waits for each char */
+    mask = POLLOUT;
+    if (!(dev->flag & RT_DEVICE_FLAG_INT_RX) ||
+        serial_ringbuffer_size(serial->int_rx) > 0)
+        mask |= POLLIN;
+
+    return mask;
+}
+#endif
+
 /*
  * serial register
  */
@@ -390,6 +412,9 @@ rt_err_t rt_hw_serial_register(struct rt_serial_device *serial,
     device->write       = rt_serial_write;
     device->control     = rt_serial_control;
     device->user_data   = data;
+#ifdef RT_USING_POLL
+    device->poll        = rt_serial_poll;
+#endif
 
     /* register a character device */
     return rt_device_register(device, name, flag);
@@ -412,6 +437,11 @@ void rt_hw_serial_isr(struct rt_serial_device *serial)
         serial_ringbuffer_putc(serial->int_rx, ch);
     }
 
+#ifdef RT_USING_POLL
+    /* wake up the pollers for reading */
+    rt_wqueue_wakeup(&(serial->parent.wait_queue), POLLIN);
+#endif
+
     /* invoke callback */
     if (serial->parent.rx_indicate != RT_NULL)
     {
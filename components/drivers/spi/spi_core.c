@@ -15,13 +15,20 @@
  * 2012-05-18     bernard      Changed SPI message to message list.
  *                             Added take/release SPI device/bus interface.
  * 2012-09-28     aozima       fixed rt_spi_release_bus assert error.
+ * 2013-06-22     bernard      add asynchronous transfer queue.
  */
 
+#include <rthw.h>
 #include <drivers/spi.h>
 
 extern rt_err_t rt_spi_bus_device_init(struct rt_spi_bus *bus, const char *name);
 extern rt_err_t rt_spidev_device_init(struct rt_spi_device *dev, const char *name);
 
+#ifdef RT_USING_SPI_ASYNC
+static rt_workqueue_t _spi_workqueue = RT_NULL;
+static void _spi_bus_work(struct rt_work *work, void *work_data);
+#endif
+
 rt_err_t rt_spi_bus_register(struct rt_spi_bus       *bus,
                              const char              *name,
                              const struct rt_spi_ops *ops)
@@ -39,6 +46,16 @@ rt_err_t rt_spi_bus_register(struct rt_spi_bus       *bus,
     /* initialize owner */
     bus->owner = RT_NULL;
 
+#ifdef RT_USING_SPI_ASYNC
+    /* the asynchronous requests of all buses are transferred in one workqueue */
+    if (_spi_workqueue == RT_NULL)
+        _spi_workqueue = rt_workqueue_get(RT_SPI_WORKQUEUE_PRIO);
+    RT_ASSERT(_spi_workqueue != RT_NULL);
+
+    rt_list_init(&(bus->request_list));
+    rt_work_init(&(bus->work), _spi_bus_work, bus);
+#endif
+
     return RT_EOK;
 }
 
@@ -63,6 +80,10 @@ rt_err_t rt_spi_bus_attach_device(struct rt_spi_device *device,
 
         rt_memset(&device->config, 0, sizeof(device->config));
         device->parent.user_data = user_data;
+#ifdef RT_USING_SPI_ASYNC
+        /* in the middle of priorities */
+        device->priority = 0x80;
+#endif
 
         return RT_EOK;
     }
@@ -461,3 +482,209 @@ rt_err_t rt_spi_release(struct rt_spi_device *device)
 
     return result;
 }
+
+#ifdef RT_USING_SPI_ASYNC
+void rt_spi_request_init(struct rt_spi_request *request,
+                         struct rt_spi_message *message,
+                         void (*complete)(struct rt_spi_request *request),
+                         void                  *user_data)
+{
+    RT_ASSERT(request != RT_NULL);
+
+    rt_list_init(&(request->list));
+    request->device    = RT_NULL;
+    request->message   = message;
+    request->priority  = 0;
+    request->failed    = RT_NULL;
+    request->result    = RT_EOK;
+    request->complete  = complete;
+    request->user_data = user_data;
+}
+
+void rt_spi_set_priority(struct rt_spi_device *device, rt_uint8_t priority)
+{
+    RT_ASSERT(device != RT_NULL);
+
+    device->priority = priority;
+}
+
+rt_err_t rt_spi_transfer_async(struct rt_spi_device  *device,
+                               struct rt_spi_request *request)
+{
+    register rt_base_t level;
+    struct rt_spi_request *index;
+    struct rt_spi_bus *bus;
+    rt_list_t *node;
+
+    RT_ASSERT(device != RT_NULL);
+    RT_ASSERT(device->bus != RT_NULL);
+    RT_ASSERT(request != RT_NULL);
+
+    bus = device->bus;
+
+    level = rt_hw_interrupt_disable();
+    if (!rt_list_isempty(&(request->list)))
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EBUSY;
+    }
+
+    request->device   = device;
+    request->priority = device->priority;
+    request->failed   = RT_NULL;
+    request->result   = RT_EOK;
+
+    /* insert after the requests in the same or higher priority */
+    for (node = bus->request_list.next; node != &(bus->request_list); node = node->next)
+    {
+        index = rt_list_entry(node, struct rt_spi_request, list);
+        if (index->priority > request->priority)
+            break;
+    }
+    rt_list_insert_before(node, &(request->list));
+    rt_hw_interrupt_enable(level);
+
+    /* the work may be pending already */
+    rt_workqueue_dowork(_spi_workqueue, &(bus->work));
+
+    return RT_EOK;
+}
+
+rt_err_t rt_spi_cancel_async(struct rt_spi_device  *device,
+                             struct rt_spi_request *request)
+{
+    register rt_base_t level;
+    rt_err_t result;
+
+    RT_ASSERT(device != RT_NULL);
+    RT_ASSERT(request != RT_NULL);
+
+    result = -RT_ERROR;
+
+    level = rt_hw_interrupt_disable();
+    if (!rt_list_isempty(&(request->list)) && request->device == device)
+    {
+        rt_list_remove(&(request->list));
+        result = RT_EOK;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return result;
+}
+
+/* take the next request, which is of the device if it's not RT_NULL */
+static struct rt_spi_request *_spi_request_take(struct rt_spi_bus    *bus,
+                                                struct rt_spi_device *device)
+{
+    register rt_base_t level;
+    struct rt_spi_request *request, *index;
+    rt_list_t *node;
+
+    level = rt_hw_interrupt_disable();
+    if (rt_list_isempty(&(bus->request_list)))
+    {
+        rt_hw_interrupt_enable(level);
+
+        return RT_NULL;
+    }
+
+    request = rt_list_entry(bus->request_list.next, struct rt_spi_request, list);
+    if (device != RT_NULL)
+    {
+        /* the requests in higher priority can't be delayed by batching */
+        index = request;
+        request = RT_NULL;
+        for (node = &(index->list); node != &(bus->request_list); node = node->next)
+        {
+            if (rt_list_entry(node, struct rt_spi_request, list)->priority != index->priority)
+                break;
+
+            if (rt_list_entry(node, struct rt_spi_request, list)->device == device)
+            {
+                request = rt_list_entry(node, struct rt_spi_request, list);
+                break;
+            }
+        }
+    }
+
+    if (request != RT_NULL)
+        rt_list_remove(&(request->list));
+    rt_hw_interrupt_enable(level);
+
+    return request;
+}
+
+static void _spi_request_transfer(struct rt_spi_bus *bus, struct rt_spi_request *request)
+{
+    struct rt_spi_device *device;
+    struct rt_spi_message *index;
+
+    device = request->device;
+    index  = request->message;
+
+    if (bus->owner != device)
+    {
+        /* not the same owner as current, re-configure SPI bus */
+        if (bus->ops->configure(device, &device->config) == RT_EOK)
+        {
+            /* set SPI bus owner */
+            bus->owner = device;
+        }
+        else
+        {
+            /* configure SPI bus failed */
+            request->failed = index;
+            request->result = -RT_EIO;
+
+            return;
+        }
+    }
+
+    /* transmit each SPI message */
+    while (index != RT_NULL)
+    {
+        if (bus->ops->xfer(device, index) == 0)
+            break;
+
+        index = index->next;
+    }
+
+    request->failed = index;
+    request->result = (index == RT_NULL) ? RT_EOK : -RT_EIO;
+}
+
+static void _spi_bus_work(struct rt_work *work, void *work_data)
+{
+    struct rt_spi_bus *bus;
+    struct rt_spi_device *device;
+    struct rt_spi_request *request;
+    rt_uint32_t batch;
+
+    bus = (struct rt_spi_bus *)work_data;
+
+    while ((request = _spi_request_take(bus, RT_NULL)) != RT_NULL)
+    {
+        rt_mutex_take(&(bus->lock), RT_WAITING_FOREVER);
+
+        /* transfer the following requests of the same device at once */
+        device = request->device;
+        batch  = 0;
+        while (request != RT_NULL)
+        {
+            _spi_request_transfer(bus, request);
+
+            /* the complete callback is invoked with bus taken */
+            if (request->complete != RT_NULL)
+                request->complete(request);
+
+            if (++ batch >= RT_SPI_ASYNC_BATCH)
+                break;
+
+            request = _spi_request_take(bus, device);
+        }
+
+        rt_mutex_release(&(bus->lock));
+    }
+}
+#endif
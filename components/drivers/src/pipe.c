@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-09-30     Bernard      first version.
+ * 2013-06-10     Bernard      add poll operation.
  */
 
 #include <rthw.h>
@@ -67,6 +68,10 @@ static rt_size_t rt_pipe_read(rt_device_t dev,
             {
                 rt_hw_interrupt_enable(level);
             }
+#ifdef RT_USING_POLL
+            /* wake up the pollers for writing */
+            rt_wqueue_wakeup(&(dev->wait_queue), POLLOUT);
+#endif
             break;
         }
     } while (read_nbytes == 0);
@@ -129,6 +134,10 @@ static rt_size_t rt_pipe_write(rt_device_t dev,
             {
                 rt_hw_interrupt_enable(level);
             }
+#ifdef RT_USING_POLL
+            /* wake up the pollers for reading */
+            rt_wqueue_wakeup(&(dev->wait_queue), POLLIN);
+#endif
             break;
         }
     }while (write_nbytes == 0);
@@ -141,6 +150,30 @@ static rt_err_t rt_pipe_control(rt_device_t dev, rt_uint8_t cmd, void *args)
     return RT_EOK;
 }
 
+#ifdef RT_USING_POLL
+static int rt_pipe_poll(rt_device_t dev, struct rt_pollreq *req)
+{
+    int mask;
+    rt_uint32_t level;
+    struct rt_pipe_device *pipe;
+
+    pipe = PIPE_DEVICE(dev);
+    RT_ASSERT(pipe != RT_NULL);
+
+    rt_poll_add(&(dev->wait_queue), req);
+
+    mask = 0;
+    level = rt_hw_interrupt_disable();
+    if ((rt_uint16_t)RT_RINGBUFFER_SIZE(&(pipe->ringbuffer)) > 0)
+        mask |= POLLIN;
+    if ((rt_uint16_t)RT_RINGBUFFER_EMPTY(&(pipe->ringbuffer)) > 0)
+        mask |= POLLOUT;
+    rt_hw_interrupt_enable(level);
+
+    return mask;
+}
+#endif
+
 rt_err_t rt_pipe_create(const char *name, rt_size_t size)
 {
     rt_err_t result = RT_EOK;
@@ -174,6 +207,9 @@ rt_err_t rt_pipe_create(const char *name, rt_size_t size)
         pipe->parent.read    = rt_pipe_read;
         pipe->parent.write   = rt_pipe_write;
         pipe->parent.control = rt_pipe_control;
+#ifdef RT_USING_POLL
+        pipe->parent.poll    = rt_pipe_poll;
+#endif
 
         return rt_device_register(&(pipe->parent), name, RT_DEVICE_FLAG_RDWR);
     }
@@ -28,10 +28,13 @@
  * 2012-04-29     goprife      improve the command line auto-complete feature.
  * 2012-06-02     lgnq         add list_memheap
  * 2012-10-22     Bernard      add MS VC++ patch.
+ * 2013-06-14     Bernard      list the matched symbols by the sorted index.
+ * 2013-06-26     Bernard      list the attributes and failures of memheap.
  */
 
 #include <rtthread.h>
 #include "finsh.h"
+#include "finsh_index.h"
 
 rt_inline unsigned int rt_list_len(const rt_list_t *l)
 {
@@ -317,18 +320,23 @@ static long _list_memheap(struct rt_list_node *list)
     struct rt_memheap *mh;
     struct rt_list_node *node;
 
-    rt_kprintf("memheap  pool size  max used size available size\n");
-    rt_kprintf("-------- ---------- ------------- --------------\n");
+    rt_kprintf("memheap  pool size  max used size available size attr failed\n");
+    rt_kprintf("-------- ---------- ------------- -------------- ---- ------\n");
     for (node = list->next; node != list; node = node->next)
     {
         mh = (struct rt_memheap *)rt_list_entry(node, struct rt_object, list);
 
-        rt_kprintf("%-8.*s %-010d %-013d %-05d\n",
+        rt_kprintf("%-8.*s %-010d %-013d %-014d %c%c%c%c %d\n",
                    RT_NAME_MAX,
                    mh->parent.name,
                    mh->pool_size,
                    mh->max_used_size,
-                   mh->available_size);
+                   mh->available_size,
+                   mh->attr & RT_MEMHEAP_ATTR_FAST ? 'f' : '-',
+                   mh->attr & RT_MEMHEAP_ATTR_DMA ? 'd' : '-',
+                   mh->attr & RT_MEMHEAP_ATTR_CACHEABLE ? 'c' : '-',
+                   mh->attr & RT_MEMHEAP_ATTR_EXTERNAL ? 'e' : '-',
+                   mh->fail_count);
     }
 
     return 0;
@@ -672,6 +680,61 @@ static int str_common(const char *str1, const char *str2)
     return (str - str1);
 }
 
+/* update the common prefix of the matched names */
+static void str_common_update(const char *prefix, const char *name,
+                              const char **name_ptr, int *min_length)
+{
+    int length;
+
+    if (*prefix == 0)
+        return;
+
+    if (*name_ptr == NULL)
+    {
+        /* set name_ptr and initial length */
+        *name_ptr = name;
+        *min_length = strlen(name);
+    }
+
+    length = str_common(*name_ptr, name);
+    if (length < *min_length)
+        *min_length = length;
+}
+
+static void list_prefix_syscall(const char *prefix, struct finsh_syscall *call,
+                                rt_uint16_t *func_cnt,
+                                const char **name_ptr, int *min_length)
+{
+    if (*func_cnt == 0)
+        rt_kprintf("--function:\n");
+    (*func_cnt) ++;
+
+    str_common_update(prefix, call->name, name_ptr, min_length);
+
+#ifdef FINSH_USING_DESCRIPTION
+    rt_kprintf("%-16s -- %s\n", call->name, call->desc);
+#else
+    rt_kprintf("%s\n", call->name);
+#endif
+}
+
+static void list_prefix_sysvar(const char *prefix, struct finsh_sysvar *var,
+                               rt_uint16_t *var_cnt,
+                               const char **name_ptr, int *min_length)
+{
+    if (*var_cnt == 0)
+        rt_kprintf("--variable:\n");
+    (*var_cnt) ++;
+
+    str_common_update(prefix, var->name, name_ptr, min_length);
+
+#ifdef FINSH_USING_DESCRIPTION
+    rt_kprintf("%-16s -- %s\n", var->name, var->desc);
+#else
+    rt_kprintf("%s\n", var->name);
+#endif
+}
+
 void list_prefix(char *prefix)
 {
     struct finsh_syscall_item *syscall_item;
@@ -688,41 +751,25 @@ void list_prefix(char *prefix)
     /* checks in system function call */
     {
         struct finsh_syscall *index;
+#ifdef FINSH_USING_INDEX
+        struct finsh_syscall **sorted;
+        int count;
+
+        /* the matched functions are adjacent in the sorted index */
+        count = finsh_index_syscall_prefix(prefix, &sorted);
+        if (count >= 0)
+        {
+            while (count --)
+                list_prefix_syscall(prefix, *sorted ++, &func_cnt, &name_ptr, &min_length);
+        }
+        else
+#endif
         for (index = _syscall_table_begin;
              index < _syscall_table_end;
              FINSH_NEXT_SYSCALL(index))
         {
             if (str_is_prefix(prefix, index->name) == 0)
-            {
-                if (func_cnt == 0)
-                {
-                    rt_kprintf("--function:\n");
-
-                    if (*prefix != 0)
-                    {
-                        /* set name_ptr */
-                        name_ptr = index->name;
-
-                        /* set initial length */
-                        min_length = strlen(name_ptr);
-                    }
-                }
-
-                func_cnt ++;
-
-                if (*prefix != 0)
-                {
-                    length = str_common(name_ptr, index->name);
-                    if (length < min_length)
-                        min_length = length;
-                }
-
-#ifdef FINSH_USING_DESCRIPTION
-                rt_kprintf("%-16s -- %s\n", index->name, index->desc);
-#else
-                rt_kprintf("%s\n", index->name);
-#endif
-            }
+                list_prefix_syscall(prefix, index, &func_cnt, &name_ptr, &min_length);
         }
     }
 
@@ -762,40 +809,22 @@ void list_prefix(char *prefix)
     /* checks in system variable */
     {
         struct finsh_sysvar* index;
+#ifdef FINSH_USING_INDEX
+        struct finsh_sysvar **sorted;
+        int count;
+
+        count = finsh_index_sysvar_prefix(prefix, &sorted);
+        if (count >= 0)
+        {
+            while (count --)
+                list_prefix_sysvar(prefix, *sorted ++, &var_cnt, &name_ptr, &min_length);
+        }
+        else
+#endif
         for (index = _sysvar_table_begin; index < _sysvar_table_end; index ++)
         {
             if (str_is_prefix(prefix, index->name) == 0)
-            {
-                if (var_cnt == 0)
-                {
-                    rt_kprintf("--variable:\n");
-
-                    if (*prefix != 0 && name_ptr == NULL)
-                    {
-                        /* set name_ptr */
-                        name_ptr = index->name;
-
-                        /* set initial length */
-                        min_length = strlen(name_ptr);
-
-                    }
-                }
-
-                var_cnt ++;
-
-                if (*prefix != 0)
-                {
-                    length = str_common(name_ptr, index->name);
-                    if (length < min_length)
-                        min_length = length;
-                }
-
-#ifdef FINSH_USING_DESCRIPTION
-                rt_kprintf("%-16s -- %s\n", index->name, index->desc);
-#else
-                rt_kprintf("%s\n", index->name);
-#endif
-            }
+                list_prefix_sysvar(prefix, index, &var_cnt, &name_ptr, &min_length);
         }
     }
 
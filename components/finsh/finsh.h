@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-03-22     Bernard      first version
+ * 2013-06-14     Bernard      add the symbol index and the cache of compiled lines
  */
 #ifndef __FINSH_H__
 #define __FINSH_H__
@@ -34,6 +35,16 @@
 
 #define HEAP_ALIGNMENT          4       /* heap alignment */
 
+/* sort the symbol tables on heap for looking up symbols */
+#ifdef RT_USING_HEAP
+#define FINSH_USING_INDEX
+#endif
+
+/* the number of compiled lines in cache when FINSH_USING_CACHE is defined */
+#ifndef FINSH_CACHE_LINES
+#define FINSH_CACHE_LINES       4
+#endif
+
 #define FINSH_GET16(x)    (*(x)) | (*((x)+1) << 8)
 #define FINSH_GET32(x)    (rt_uint32_t)(*(x)) | ((rt_uint32_t)*((x)+1) << 8) | \
     ((rt_uint32_t)*((x)+2) << 16) | ((rt_uint32_t)*((x)+3) << 24)
@@ -0,0 +1,145 @@
+/*
+ * File      : finsh_cache.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-14     Bernard      first version
+ */
+#include <finsh.h>
+
+#include "finsh_vm.h"
+#include "finsh_cache.h"
+#include "shell.h"
+
+#ifdef FINSH_USING_CACHE
+
+struct finsh_cache_line
+{
+	rt_uint32_t hash;				/* the hash of line, 0 for an empty entry */
+	rt_uint32_t serial;				/* the serial of symbols when compiled */
+	rt_uint32_t stamp;				/* the time of last use */
+
+	rt_uint16_t length;				/* the length of text segment */
+	u_char text[FINSH_TEXT_MAX];	/* the compiled text segment */
+	char line[FINSH_CMD_SIZE];		/* the command line */
+};
+
+static struct finsh_cache_line cache_lines[FINSH_CACHE_LINES];
+static rt_uint32_t cache_serial = 1;
+static rt_uint32_t cache_stamp;
+
+extern u_char* finsh_compile_pc;
+
+static rt_uint32_t line_hash(const char* line)
+{
+	rt_uint32_t hash = 5381;
+
+	while (*line)
+		hash = hash * 33 + (u_char)*line ++;
+
+	return hash ? hash : 1;
+}
+
+/**
+ * This function invalidates all lines in cache, it's invoked when the
+ * variables or symbols are inserted or deleted.
+ */
+void finsh_cache_invalidate(void)
+{
+	cache_serial ++;
+}
+
+/**
+ * This function returns the serial of symbols, which should be got before
+ * parsing the line to be saved in cache.
+ */
+rt_uint32_t finsh_cache_serial(void)
+{
+	return cache_serial;
+}
+
+/**
+ * This function loads the text segment compiled from the line.
+ *
+ * @param line the command line
+ *
+ * @return 0 on the line is in cache, -1 on not.
+ */
+int finsh_cache_load(const char* line)
+{
+	struct finsh_cache_line* entry;
+	rt_uint32_t hash;
+	int index;
+
+	hash = line_hash(line);
+	for (index = 0; index < FINSH_CACHE_LINES; index ++)
+	{
+		entry = &cache_lines[index];
+		if (entry->hash == hash && entry->serial == cache_serial &&
+			strcmp(entry->line, line) == 0)
+		{
+			memset(&text_segment[0], 0, sizeof(text_segment));
+			rt_memcpy(&text_segment[0], entry->text, entry->length);
+			memset(&finsh_vm_stack[0], 0, sizeof(finsh_vm_stack[0]));
+
+			entry->stamp = ++ cache_stamp;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * This function saves the text segment compiled from the line in cache, it
+ * replaces the least recently used line.
+ *
+ * @param line the command line
+ * @param serial the serial of symbols before parsing the line
+ */
+void finsh_cache_save(const char* line, rt_uint32_t serial)
+{
+	struct finsh_cache_line *entry, *victim;
+	const char* ptr;
+	int index;
+
+	/* the parser inserted variables, which will fail in the next time */
+	if (serial != cache_serial)
+		return;
+
+	/* the strings are allocated on finsh heap by the parser */
+	for (ptr = line; *ptr; ptr ++)
+	{
+		if (*ptr == '"') return;
+	}
+	if (ptr - line >= FINSH_CMD_SIZE)
+		return;
+
+	victim = &cache_lines[0];
+	for (index = 0; index < FINSH_CACHE_LINES; index ++)
+	{
+		entry = &cache_lines[index];
+		if (entry->hash == 0 || entry->serial != cache_serial)
+		{
+			victim = entry;
+			break;
+		}
+		if (entry->stamp < victim->stamp)
+			victim = entry;
+	}
+
+	victim->hash = line_hash(line);
+	victim->serial = cache_serial;
+	victim->stamp = ++ cache_stamp;
+	victim->length = finsh_compile_pc - &text_segment[0];
+	rt_memcpy(victim->text, &text_segment[0], victim->length);
+	strncpy(victim->line, line, FINSH_CMD_SIZE);
+}
+
+#endif
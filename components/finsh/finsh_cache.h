@@ -0,0 +1,32 @@
+/*
+ * File      : finsh_cache.h
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-14     Bernard      first version
+ */
+#include <finsh.h>
+
+#ifndef __FINSH_CACHE_H__
+#define __FINSH_CACHE_H__
+
+#ifdef FINSH_USING_CACHE
+/*
+ * The cache of text segments compiled from the command lines. The cache is
+ * invalidated when the variables or symbols are changed, because the text
+ * segment refers to the symbols found by the parser.
+ */
+void finsh_cache_invalidate(void);
+rt_uint32_t finsh_cache_serial(void);
+
+int  finsh_cache_load(const char* line);
+void finsh_cache_save(const char* line, rt_uint32_t serial);
+#endif
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ * File      : finsh_index.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-14     Bernard      first version
+ */
+#include <finsh.h>
+#include "finsh_index.h"
+
+#ifdef FINSH_USING_INDEX
+
+/*
+ * The index is an array of pointers to the items of table sorted by name.
+ * Both of finsh_syscall and finsh_sysvar begin with the name pointer.
+ */
+struct finsh_index
+{
+	const void* begin;			/* the table indexed */
+	const void* end;
+	void** items;				/* the sorted items */
+	int count;					/* the number of items, -1 for no index */
+};
+
+#define INDEX_NAME(item)	(*(const char**)(item))
+
+static struct finsh_index syscall_index = {NULL, NULL, NULL, -1};
+static struct finsh_index sysvar_index = {NULL, NULL, NULL, -1};
+
+/* shell sort, there is no qsort in all of libc */
+static void index_sort(void** items, int count)
+{
+	int gap, i, j;
+	void* item;
+
+	for (gap = 1; gap < count / 3; gap = gap * 3 + 1) ;
+
+	for (; gap > 0; gap /= 3)
+	{
+		for (i = gap; i < count; i ++)
+		{
+			item = items[i];
+			for (j = i; j >= gap &&
+				strcmp(INDEX_NAME(items[j - gap]), INDEX_NAME(item)) > 0; j -= gap)
+			{
+				items[j] = items[j - gap];
+			}
+			items[j] = item;
+		}
+	}
+}
+
+/* get the first item which is not less than the name */
+static int index_lower_bound(struct finsh_index* index, const char* name)
+{
+	int low, high, middle;
+
+	low = 0;
+	high = index->count;
+	while (low < high)
+	{
+		middle = (low + high) / 2;
+		if (strcmp(INDEX_NAME(index->items[middle]), name) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+static void index_free(struct finsh_index* index)
+{
+	if (index->items != NULL)
+		rt_free(index->items);
+
+	index->items = NULL;
+	index->count = -1;
+}
+
+static int syscall_index_build(void)
+{
+	struct finsh_syscall* call;
+	int count;
+
+	if (syscall_index.begin == _syscall_table_begin &&
+		syscall_index.end == _syscall_table_end)
+		return syscall_index.count;
+
+	index_free(&syscall_index);
+	syscall_index.begin = _syscall_table_begin;
+	syscall_index.end = _syscall_table_end;
+
+	count = 0;
+	for (call = _syscall_table_begin; call < _syscall_table_end; FINSH_NEXT_SYSCALL(call))
+		count ++;
+	if (count == 0)
+		return -1;
+
+	syscall_index.items = (void**)rt_malloc(count * sizeof(void*));
+	if (syscall_index.items == NULL)
+		return -1;
+
+	count = 0;
+	for (call = _syscall_table_begin; call < _syscall_table_end; FINSH_NEXT_SYSCALL(call))
+		syscall_index.items[count ++] = call;
+
+	index_sort(syscall_index.items, count);
+	syscall_index.count = count;
+
+	return count;
+}
+
+static int sysvar_index_build(void)
+{
+	struct finsh_sysvar* var;
+	int count;
+
+	if (sysvar_index.begin == _sysvar_table_begin &&
+		sysvar_index.end == _sysvar_table_end)
+		return sysvar_index.count;
+
+	index_free(&sysvar_index);
+	sysvar_index.begin = _sysvar_table_begin;
+	sysvar_index.end = _sysvar_table_end;
+
+	count = _sysvar_table_end - _sysvar_table_begin;
+	if (count <= 0)
+		return -1;
+
+	sysvar_index.items = (void**)rt_malloc(count * sizeof(void*));
+	if (sysvar_index.items == NULL)
+		return -1;
+
+	count = 0;
+	for (var = _sysvar_table_begin; var < _sysvar_table_end; var ++)
+		sysvar_index.items[count ++] = var;
+
+	index_sort(sysvar_index.items, count);
+	sysvar_index.count = count;
+
+	return count;
+}
+
+static void* index_lookup(struct finsh_index* index, const char* name)
+{
+	int position;
+
+	position = index_lower_bound(index, name);
+	if (position < index->count &&
+		strcmp(INDEX_NAME(index->items[position]), name) == 0)
+		return index->items[position];
+
+	return NULL;
+}
+
+static int index_prefix(struct finsh_index* index, const char* prefix, void*** first)
+{
+	int position, last;
+	size_t length;
+
+	length = strlen(prefix);
+	position = index_lower_bound(index, prefix);
+	for (last = position; last < index->count; last ++)
+	{
+		if (strncmp(INDEX_NAME(index->items[last]), prefix, length) != 0)
+			break;
+	}
+
+	*first = &(index->items[position]);
+	return last - position;
+}
+
+int finsh_index_syscall(const char* name, struct finsh_syscall** call)
+{
+	if (syscall_index_build() < 0)
+		return -1;
+
+	*call = (struct finsh_syscall*)index_lookup(&syscall_index, name);
+	return 0;
+}
+
+int finsh_index_sysvar(const char* name, struct finsh_sysvar** var)
+{
+	if (sysvar_index_build() < 0)
+		return -1;
+
+	*var = (struct finsh_sysvar*)index_lookup(&sysvar_index, name);
+	return 0;
+}
+
+int finsh_index_syscall_prefix(const char* prefix, struct finsh_syscall*** first)
+{
+	if (syscall_index_build() < 0)
+		return -1;
+
+	return index_prefix(&syscall_index, prefix, (void***)first);
+}
+
+int finsh_index_sysvar_prefix(const char* prefix, struct finsh_sysvar*** first)
+{
+	if (sysvar_index_build() < 0)
+		return -1;
+
+	return index_prefix(&sysvar_index, prefix, (void***)first);
+}
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * File      : finsh_index.h
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-14     Bernard      first version
+ */
+#include <finsh.h>
+
+#ifndef __FINSH_INDEX_H__
+#define __FINSH_INDEX_H__
+
+#ifdef FINSH_USING_INDEX
+/*
+ * The sorted index of system call and system variable tables, which is built
+ * on heap by the first lookup and built again when the tables are changed. All
+ * functions return -1 when there is no index and the tables should be searched
+ * one by one.
+ */
+int finsh_index_syscall(const char* name, struct finsh_syscall** call);
+int finsh_index_sysvar(const char* name, struct finsh_sysvar** var);
+
+/* get the symbols with the prefix, which are adjacent in the index */
+int finsh_index_syscall_prefix(const char* prefix, struct finsh_syscall*** first);
+int finsh_index_sysvar_prefix(const char* prefix, struct finsh_sysvar*** first);
+#endif
+
+#endif
@@ -12,9 +12,12 @@
  * 2010-03-22     Bernard      first version
  * 2012-04-27     Bernard      fixed finsh_var_delete issue which
  *                             is found by Grissiom.
+ * 2013-06-14     Bernard      look up system variable in the sorted index
  */
 #include <finsh.h>
 #include "finsh_var.h"
+#include "finsh_index.h"
+#include "finsh_cache.h"
 
 struct finsh_var global_variable[FINSH_VARIABLE_MAX];
 struct finsh_sysvar_item* global_sysvar_list;
@@ -23,6 +26,10 @@ int finsh_var_init()
 {
 	memset(global_variable, 0, sizeof(global_variable));
 
+#ifdef FINSH_USING_CACHE
+	finsh_cache_invalidate();
+#endif
+
 	return 0;
 }
 
@@ -50,6 +57,10 @@ int finsh_var_insert(const char* name, int type)
 	strncpy(global_variable[empty].name, name, FINSH_NAME_MAX);
 	global_variable[empty].type = type;
 
+#ifdef FINSH_USING_CACHE
+	finsh_cache_invalidate();
+#endif
+
 	/* return the offset */
 	return empty;
 }
@@ -69,6 +80,10 @@ int finsh_var_delete(const char* name)
 
 	memset(&global_variable[i], 0, sizeof(struct finsh_var));
 
+#ifdef FINSH_USING_CACHE
+	finsh_cache_invalidate();
+#endif
+
 	return 0;
 }
 
@@ -112,6 +127,11 @@ void finsh_sysvar_append(const char* name, u_char type, void* var_addr)
 			item->next = global_sysvar_list;
 			global_sysvar_list = item;
 		}
+
+#ifdef FINSH_USING_CACHE
+		/* the new sysvar may hide the symbol in compiled lines */
+		finsh_cache_invalidate();
+#endif
 	}
 }
 #endif
@@ -121,6 +141,14 @@ struct finsh_sysvar* finsh_sysvar_lookup(const char* name)
 	struct finsh_sysvar* index;
 	struct finsh_sysvar_item* item;
 
+#ifdef FINSH_USING_INDEX
+	if (finsh_index_sysvar(name, &index) == 0)
+	{
+		if (index != NULL)
+			return index;
+	}
+	else
+#endif
 	for (index = _sysvar_table_begin; index < _sysvar_table_end; index ++)
 	{
 		if (strcmp(index->name, name) == 0)
@@ -10,12 +10,15 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-03-22     Bernard      first version
+ * 2013-06-14     Bernard      look up system call in the sorted index
  */
 #include <finsh.h>
 
 #include "finsh_vm.h"
 #include "finsh_ops.h"
 #include "finsh_var.h"
+#include "finsh_index.h"
+#include "finsh_cache.h"
 
 /* stack */
 union finsh_value	finsh_vm_stack[FINSH_STACK_MAX];
@@ -79,6 +82,11 @@ void finsh_syscall_append(const char* name, syscall_func func)
 			item->next = global_syscall_list;
 			global_syscall_list = item;
 		}
+
+#ifdef FINSH_USING_CACHE
+		/* the new syscall may hide the symbol in compiled lines */
+		finsh_cache_invalidate();
+#endif
 	}
 }
 #endif
@@ -100,6 +108,14 @@ struct finsh_syscall* finsh_syscall_lookup(const char* name)
 	struct finsh_syscall* index;
 	struct finsh_syscall_item* item;
 
+#ifdef FINSH_USING_INDEX
+	if (finsh_index_syscall(name, &index) == 0)
+	{
+		if (index != NULL)
+			return index;
+	}
+	else
+#endif
 	for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
 	{
 		if (strcmp(index->name, name) == 0)
@@ -18,6 +18,7 @@
  * 2010-04-01     Bernard      add prompt output when start and remove the empty history
  * 2011-02-23     Bernard      fix variable section end issue of finsh shell
  *                             initialization when use GNU GCC compiler.
+ * 2013-06-14     Bernard      run the compiled lines in cache.
  */
 
 #include <rtthread.h>
@@ -25,6 +26,7 @@
 
 #include "finsh.h"
 #include "shell.h"
+#include "finsh_cache.h"
 
 #ifdef _WIN32
 #include <stdio.h> /* for putchar */
@@ -199,19 +201,36 @@ void finsh_auto_complete(char* prefix)
 void finsh_run_line(struct finsh_parser* parser, const char *line)
 {
 	const char* err_str;
+#ifdef FINSH_USING_CACHE
+	rt_uint32_t serial;
+#endif
 
 	rt_kprintf("\n");
-	finsh_parser_run(parser, (unsigned char*)line);
-
-	/* compile node root */
-	if (finsh_errno() == 0)
-	{
-		finsh_compiler_run(parser->root);
-	}
-	else
+#ifdef FINSH_USING_CACHE
+	/* the text segment compiled before is loaded from cache */
+	if (finsh_cache_load(line) != 0)
+#endif
 	{
-		err_str = finsh_error_string(finsh_errno());
-		rt_kprintf("%s\n", err_str);
+#ifdef FINSH_USING_CACHE
+		serial = finsh_cache_serial();
+#endif
+		finsh_parser_run(parser, (unsigned char*)line);
+
+		/* compile node root */
+		if (finsh_errno() == 0)
+		{
+			finsh_compiler_run(parser->root);
+		}
+		else
+		{
+			err_str = finsh_error_string(finsh_errno());
+			rt_kprintf("%s\n", err_str);
+		}
+
+#ifdef FINSH_USING_CACHE
+		if (finsh_errno() == 0)
+			finsh_cache_save(line, serial);
+#endif
 	}
 
 	/* run virtual machine */
@@ -453,12 +472,20 @@ void finsh_system_function_init(const void* begin, const void* end)
 {
 	_syscall_table_begin = (struct finsh_syscall*) begin;
 	_syscall_table_end = (struct finsh_syscall*) end;
+
+#ifdef FINSH_USING_CACHE
+	finsh_cache_invalidate();
+#endif
 }
 
 void finsh_system_var_init(const void* begin, const void* end)
 {
 	_sysvar_table_begin = (struct finsh_sysvar*) begin;
 	_sysvar_table_end = (struct finsh_sysvar*) end;
+
+#ifdef FINSH_USING_CACHE
+	finsh_cache_invalidate();
+#endif
 }
 
 #if defined(__ICCARM__)               /* for IAR compiler */
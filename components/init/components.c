@@ -12,86 +12,482 @@
  * 2012-09-20     Bernard      Change the name to components.c
  *                             And all components related header files.
  * 2012-12-23     Bernard      fix the pthread initialization issue.
+ * 2013-01-20     Bernard      initialize components by level and dependency,
+ *                             with worker threads and boot timeline.
  */
 
 #include "components.h"
 
-/**
- * RT-Thread Components Initialization
- */
-void rt_components_init(void)
-{
-#ifdef RT_USING_MODULE
-    rt_system_module_init();
-#endif
-
 #ifdef RT_USING_FINSH
+static void _finsh_init(void)
+{
     /* initialize finsh */
     finsh_system_init();
     finsh_set_device(RT_CONSOLE_DEVICE_NAME);
+}
 #endif
 
 #ifdef RT_USING_LWIP
-    /* initialize lwip stack */
-    /* register ethernetif device */
-    eth_system_device_init();
-
+static void _lwip_init(void)
+{
     /* initialize lwip system */
     lwip_system_init();
     rt_kprintf("TCP/IP initialized!\n");
+}
+#endif
+
+#ifdef RT_USING_NEWLIB
+static void _libc_init(void)
+{
+    libc_system_init(RT_CONSOLE_DEVICE_NAME);
+}
+#endif
+
+#ifdef RT_USING_USB_HOST
+static void _usbh_init(void)
+{
+    rt_usb_host_init();
+}
+#endif
+
+#ifdef RT_USING_DFS
+#ifdef RT_USING_DFS_ELMFAT
+static void _elm_init(void)
+{
+    elm_init();
+}
+#endif
+
+#if defined(RT_USING_DFS_NFS) && defined(RT_USING_LWIP)
+static void _nfs_init(void)
+{
+    nfs_init();
+}
+#endif
+
+#ifdef RT_USING_DFS_YAFFS2
+static void _yaffs2_init(void)
+{
+    dfs_yaffs2_init();
+}
+#endif
+
+#ifdef RT_USING_DFS_UFFS
+static void _uffs_init(void)
+{
+    dfs_uffs_init();
+}
+#endif
+
+#ifdef RT_USING_DFS_JFFS2
+static void _jffs2_init(void)
+{
+    dfs_jffs2_init();
+}
+#endif
+
+#ifdef RT_USING_DFS_ROMFS
+static void _romfs_init(void)
+{
+    dfs_romfs_init();
+}
+#endif
+
+#ifdef RT_USING_DFS_DEVFS
+static void _devfs_init(void)
+{
+    devfs_init();
+}
+#endif
+#endif /* end of RT_USING_DFS */
+
+#if !defined(RT_USING_NEWLIB) && defined(RT_USING_PTHREADS)
+static void _pthread_init(void)
+{
+    pthread_system_init();
+}
+#endif
+
+static const char * const _depends_dfs[] = {"dfs", RT_NULL};
+static const char * const _depends_lwip[] = {"eth", RT_NULL};
+static const char * const _depends_nfs[] = {"dfs", "lwip", RT_NULL};
+static const char * const _depends_libc[] = {"dfs", "devfs", RT_NULL};
+
+/* the components of RT-Thread */
+static struct rt_component _components[] =
+{
+#ifdef RT_USING_MODULE
+    {"module", rt_system_module_init, RT_INIT_LEVEL_COMPONENT},
+#endif
+
+#ifdef RT_USING_FINSH
+    {"finsh", _finsh_init, RT_INIT_LEVEL_COMPONENT},
+#endif
+
+#ifdef RT_USING_LWIP
+    /* register ethernetif device */
+    {"eth", eth_system_device_init, RT_INIT_LEVEL_COMPONENT},
+    /* initialize lwip stack, which waits for the tcpip thread */
+    {"lwip", _lwip_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_lwip},
 #endif
 
 #ifdef RT_USING_DFS
     /* initialize the device file system */
-    dfs_init();
+    {"dfs", dfs_init, RT_INIT_LEVEL_COMPONENT},
 
     #ifdef RT_USING_DFS_ELMFAT
     /* initialize the elm chan FatFS file system*/
-    elm_init();
+    {"elm", _elm_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_dfs},
     #endif
 
     #if defined(RT_USING_DFS_NFS) && defined(RT_USING_LWIP)
     /* initialize NFSv3 client file system */
-    nfs_init();
+    {"nfs", _nfs_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_nfs},
     #endif
 
     #ifdef RT_USING_DFS_YAFFS2
-    dfs_yaffs2_init();
+    {"yaffs2", _yaffs2_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_dfs},
     #endif
 
     #ifdef RT_USING_DFS_UFFS
-    dfs_uffs_init();
+    {"uffs", _uffs_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_dfs},
     #endif
 
     #ifdef RT_USING_DFS_JFFS2
-    dfs_jffs2_init();
+    {"jffs2", _jffs2_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_dfs},
     #endif
 
     #ifdef RT_USING_DFS_ROMFS
-    dfs_romfs_init();
+    {"romfs", _romfs_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_dfs},
     #endif
 
     #ifdef RT_USING_DFS_DEVFS
-    devfs_init();
+    {"devfs", _devfs_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_dfs},
     #endif
 #endif /* end of RT_USING_DFS */
 
 #ifdef RT_USING_NEWLIB
-    libc_system_init(RT_CONSOLE_DEVICE_NAME);
+    {"libc", _libc_init, RT_INIT_LEVEL_COMPONENT, 0, 0, _depends_libc},
 #else
     /* the pthread system initialization will be initiallized in libc */
-    #ifdef RT_USING_PTHREADS 
-    pthread_system_init();
+    #ifdef RT_USING_PTHREADS
+    {"pthread", _pthread_init, RT_INIT_LEVEL_COMPONENT},
     #endif
 #endif
 
 #ifdef RT_USING_RTGUI
-    rtgui_system_server_init();
+    {"rtgui", rtgui_system_server_init, RT_INIT_LEVEL_COMPONENT},
 #endif
 
 #ifdef RT_USING_USB_HOST
-    rt_usb_host_init();
+    {"usbh", _usbh_init, RT_INIT_LEVEL_COMPONENT},
 #endif
 
+    {RT_NULL}
+};
+
+static struct rt_component *_component_list = RT_NULL;
+static rt_tick_t _boot_start, _boot_end;
+
+struct rt_boot_stage
+{
+    const char *name;
+    rt_tick_t tick;
+};
+static struct rt_boot_stage _boot_stages[RT_BOOT_STAGE_MAX];
+static rt_uint8_t _boot_stage_count = 0;
+
+void rt_components_register(struct rt_component *component)
+{
+    struct rt_component **node;
+
+    RT_ASSERT(component != RT_NULL);
+    RT_ASSERT(component->level < RT_INIT_LEVEL_MAX);
+
+    component->state = RT_COMPONENT_PENDING;
+    component->next = RT_NULL;
+
+    /* keep the registered order */
+    for (node = &_component_list; *node != RT_NULL; node = &((*node)->next)) ;
+    *node = component;
+}
+RTM_EXPORT(rt_components_register);
+
+static struct rt_component *_component_find(const char *name)
+{
+    struct rt_component *component;
+
+    for (component = _component_list; component != RT_NULL; component = component->next)
+    {
+        if (rt_strncmp(component->name, name, RT_NAME_MAX) == 0)
+            return component;
+    }
+
+    return RT_NULL;
+}
+
+/* get the first depended component which isn't finished */
+static struct rt_component *_component_depend(struct rt_component *component)
+{
+    const char * const *name;
+    struct rt_component *depend;
+
+    if (component->depends == RT_NULL)
+        return RT_NULL;
+
+    for (name = component->depends; *name != RT_NULL; name ++)
+    {
+        depend = _component_find(*name);
+        if (depend != RT_NULL && depend->state != RT_COMPONENT_DONE)
+            return depend;
+    }
+
+    return RT_NULL;
+}
+
+/* whether all of the depended components are finished */
+rt_inline rt_bool_t _component_ready(struct rt_component *component)
+{
+    return _component_depend(component) == RT_NULL ? RT_TRUE : RT_FALSE;
+}
+
+static void _component_run(struct rt_component *component)
+{
+    component->start = rt_tick_get();
+    component->init();
+    component->end = rt_tick_get();
+}
+
+#if RT_COMPONENTS_INIT_WORKERS > 0
+static struct rt_mailbox _job_mb, _done_mb;
+static rt_uint32_t _job_pool[RT_COMPONENTS_INIT_WORKERS];
+static rt_uint32_t _done_pool[RT_COMPONENTS_INIT_WORKERS];
+
+static void _component_worker(void *parameter)
+{
+    struct rt_component *component;
+
+    while (rt_mb_recv(&_job_mb, (rt_uint32_t *)&component, RT_WAITING_FOREVER) == RT_EOK)
+    {
+        /* the null job for exit */
+        if (component == RT_NULL)
+            break;
+
+        component->worker = (rt_uint32_t)parameter;
+        _component_run(component);
+        rt_mb_send(&_done_mb, (rt_uint32_t)component);
+    }
+}
+#endif
+
+/* initialize the components of one level */
+static void _components_init_level(rt_uint8_t level, int workers)
+{
+    struct rt_component *component;
+    int pending, running;
+
+    running = 0;
+    while (1)
+    {
+        pending = 0;
+        for (component = _component_list; component != RT_NULL; component = component->next)
+        {
+            if (component->level != level || component->state != RT_COMPONENT_PENDING)
+                continue;
+
+            if (!_component_ready(component))
+            {
+                pending ++;
+                continue;
+            }
+
+#if RT_COMPONENTS_INIT_WORKERS > 0
+            if (running < workers)
+            {
+                component->state = RT_COMPONENT_RUNNING;
+                rt_mb_send(&_job_mb, (rt_uint32_t)component);
+                running ++;
+                continue;
+            }
+
+            if (workers > 0)
+            {
+                /* wait for an idle worker */
+                pending ++;
+                continue;
+            }
+#endif
+            /* initialize in caller thread */
+            component->worker = 0;
+            _component_run(component);
+            component->state = RT_COMPONENT_DONE;
+
+            /* the other components may depend on this one */
+            pending ++;
+            break;
+        }
+
+        if (running > 0)
+        {
+#if RT_COMPONENTS_INIT_WORKERS > 0
+            rt_mb_recv(&_done_mb, (rt_uint32_t *)&component, RT_WAITING_FOREVER);
+            component->state = RT_COMPONENT_DONE;
+            running --;
+#endif
+            continue;
+        }
+
+        if (pending == 0)
+            break;
+
+        /* nothing is running and nothing is ready, the component depends on
+         * a component of higher level, or there is dependency cycle */
+        for (component = _component_list; component != RT_NULL; component = component->next)
+        {
+            struct rt_component *depend;
+
+            if (component->level != level || component->state != RT_COMPONENT_PENDING)
+                continue;
+
+            depend = _component_depend(component);
+            if (depend != RT_NULL)
+            {
+                if (depend->level > level)
+                    rt_kprintf("component %s: depends on %s of higher level %d, "
+                               "initialize it anyway\n",
+                               component->name, depend->name, depend->level);
+                else
+                    rt_kprintf("component %s: dependency cycle, initialize it anyway\n",
+                               component->name);
+                component->worker = 0;
+                _component_run(component);
+                component->state = RT_COMPONENT_DONE;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * RT-Thread Components Initialization
+ */
+void rt_components_init(void)
+{
+    struct rt_component *component;
+    rt_uint8_t level;
+    int index, workers = 0;
+
+    _boot_start = rt_tick_get();
+
+    /* the components of RT-Thread go before the registered ones, the last
+     * one of table is the terminator */
+    for (index = sizeof(_components)/sizeof(_components[0]) - 2; index >= 0; index --)
+    {
+        component = &_components[index];
+        component->state = RT_COMPONENT_PENDING;
+        component->next = _component_list;
+        _component_list = component;
+    }
+
+#if RT_COMPONENTS_INIT_WORKERS > 0
+    rt_mb_init(&_job_mb, "initjob", _job_pool,
+               RT_COMPONENTS_INIT_WORKERS, RT_IPC_FLAG_FIFO);
+    rt_mb_init(&_done_mb, "initdone", _done_pool,
+               RT_COMPONENTS_INIT_WORKERS, RT_IPC_FLAG_FIFO);
+
+#ifdef RT_USING_HEAP
+    for (workers = 0; workers < RT_COMPONENTS_INIT_WORKERS; workers ++)
+    {
+        rt_thread_t tid;
+
+        /* the worker has the same priority as caller thread */
+        tid = rt_thread_create("init",
+                               _component_worker, (void *)(workers + 1),
+                               RT_COMPONENTS_INIT_STACK_SIZE,
+                               rt_thread_self()->current_priority, 20);
+        if (tid == RT_NULL)
+            break;
+        rt_thread_startup(tid);
+    }
+#endif /* without heap, all of components are initialized in caller thread */
+#endif
+
+    for (level = 0; level < RT_INIT_LEVEL_MAX; level ++)
+        _components_init_level(level, workers);
+
+#if RT_COMPONENTS_INIT_WORKERS > 0
+    /* let the workers exit */
+    while (workers --)
+        rt_mb_send(&_job_mb, (rt_uint32_t)RT_NULL);
+    /* the mailbox is detached after all of the workers exit */
+    while (_job_mb.entry > 0)
+        rt_thread_delay(1);
+    rt_mb_detach(&_job_mb);
+    rt_mb_detach(&_done_mb);
+#endif
+
+    _boot_end = rt_tick_get();
+
     return;
 }
+
+void rt_boot_stage(const char *name)
+{
+    if (_boot_stage_count >= RT_BOOT_STAGE_MAX)
+        return;
+
+    _boot_stages[_boot_stage_count].name = name;
+    _boot_stages[_boot_stage_count].tick = rt_tick_get();
+    _boot_stage_count ++;
+}
+RTM_EXPORT(rt_boot_stage);
+
+void rt_boot_timeline(void)
+{
+    struct rt_component *component;
+    rt_uint8_t index;
+    rt_tick_t span;
+
+    /* the bar of 40 columns covers from system startup to components finished */
+    span = _boot_end > 0 ? _boot_end : rt_tick_get();
+    if (span == 0)
+        span = 1;
+
+    rt_kprintf("(tick %d per second)\n", RT_TICK_PER_SECOND);
+    rt_kprintf("level worker component start    cost  timeline\n");
+    rt_kprintf("----- ------ --------- -------- ----- ----------------------------------------\n");
+    for (component = _component_list; component != RT_NULL; component = component->next)
+    {
+        rt_uint32_t column, begin, finish;
+
+        if (component->state != RT_COMPONENT_DONE)
+        {
+            rt_kprintf("%5d %6s %-9.*s %8s\n", component->level, "-",
+                       RT_NAME_MAX, component->name, "pending");
+            continue;
+        }
+
+        rt_kprintf("%5d %6d %-9.*s %8d %5d  ", component->level, component->worker,
+                   RT_NAME_MAX, component->name, component->start,
+                   component->end - component->start);
+
+        begin = component->start * 40 / span;
+        finish = component->end * 40 / span;
+        for (column = 0; column < 40 && column <= finish; column ++)
+            rt_kprintf("%c", column < begin ? ' ' : '#');
+        rt_kprintf("\n");
+    }
+
+    rt_kprintf("components: start at %d, finish at %d, cost %d\n",
+               _boot_start, _boot_end, _boot_end - _boot_start);
+    for (index = 0; index < _boot_stage_count; index ++)
+    {
+        rt_kprintf("stage %-*.*s: %d\n", RT_NAME_MAX, RT_NAME_MAX,
+                   _boot_stages[index].name, _boot_stages[index].tick);
+    }
+}
+RTM_EXPORT(rt_boot_timeline);
+
+#ifdef RT_USING_FINSH
+FINSH_FUNCTION_EXPORT_ALIAS(rt_boot_timeline, list_boot, list boot timeline of components);
+#endif
@@ -11,6 +11,7 @@
  * Date           Author       Notes
  * 2012-09-20     Bernard      Change the name to components.h
  *                             And all components related header files.
+ * 2013-01-20     Bernard      Add the declarative components initialization.
  */
 
 #ifndef __COMPONENTS_INIT_H__
@@ -77,12 +78,74 @@ extern void lwip_system_init(void);
 extern "C" {
 #endif
 
+/* the initialization level, a level is started after all of the lower levels
+ * are finished */
+#define RT_INIT_LEVEL_BOARD         0   /* the devices of board */
+#define RT_INIT_LEVEL_COMPONENT     1   /* the components of RT-Thread */
+#define RT_INIT_LEVEL_APP           2   /* the applications */
+#define RT_INIT_LEVEL_MAX           3
+
+/* the number of worker threads to initialize independent components concurrently,
+ * 0 for initializing all of components in the caller thread */
+#ifndef RT_COMPONENTS_INIT_WORKERS
+#define RT_COMPONENTS_INIT_WORKERS  0
+#endif
+#ifndef RT_COMPONENTS_INIT_STACK_SIZE
+#define RT_COMPONENTS_INIT_STACK_SIZE   2048
+#endif
+
+/* the maximal number of boot stages marked by application */
+#ifndef RT_BOOT_STAGE_MAX
+#define RT_BOOT_STAGE_MAX           8
+#endif
+
+/* the state of component */
+#define RT_COMPONENT_PENDING        0x00
+#define RT_COMPONENT_RUNNING        0x01
+#define RT_COMPONENT_DONE           0x02
+
+struct rt_component
+{
+    const char *name;
+    void (*init)(void);
+
+    rt_uint8_t level;
+    rt_uint8_t state;
+    rt_uint8_t worker;                  /* the worker index, 0 for caller thread */
+
+    /* the names of depended components, which is terminated by RT_NULL. The
+     * name which is not registered is ignored, so the optional component can
+     * be depended on. */
+    const char * const *depends;
+
+    /* the boot timeline, in OS tick */
+    rt_tick_t start;
+    rt_tick_t end;
+
+    struct rt_component *next;
+};
+
+/**
+ * Registers a component, which should be invoked before rt_components_init
+ */
+void rt_components_register(struct rt_component *component);
+
 /**
  * Initializes components in RT-Thread
  * notes: this function must be invoked in thread
  */
 void rt_components_init(void);
 
+/**
+ * Marks a boot stage with current tick, such as the service is ready
+ */
+void rt_boot_stage(const char *name);
+
+/**
+ * Prints the boot timeline
+ */
+void rt_boot_timeline(void);
+
 #ifdef __cplusplus
 }
 #endif
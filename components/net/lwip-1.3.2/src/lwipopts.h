@@ -91,7 +91,12 @@
 #define MEM_ALIGNMENT               RT_ALIGN_SIZE
 
 #define MEM_LIBC_MALLOC             1
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+/* the pbufs are placed in the memory heap chosen by malloc policy */
+#define mem_malloc(size)            rt_malloc_usage((size), RT_MALLOC_USAGE_NET)
+#else
 #define mem_malloc                  rt_malloc
+#endif
 #define mem_free                    rt_free
 #define mem_calloc                  rt_calloc
 
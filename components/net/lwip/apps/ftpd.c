@@ -504,6 +504,7 @@ err1:
 	else if (str_begin_with(buf, "RETR")==0)
 	{
 		int file_size;
+		rt_off_t offset = 0;
 
 		strcpy(filename, buf + 5);
 
@@ -527,7 +528,7 @@ err1:
 
 		if(session->offset>0 && session->offset < file_size)
 		{
-			lseek(fd, session->offset, SEEK_SET);
+			offset = session->offset;
 			rt_sprintf(sbuf, "150 Opening binary mode data connection for partial \"%s\" (%d/%d bytes).\r\n",
 				filename, file_size - session->offset, file_size);
 		}
@@ -536,10 +537,8 @@ err1:
 			rt_sprintf(sbuf, "150 Opening binary mode data connection for \"%s\" (%d bytes).\r\n", filename, file_size);
 		}
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		while((numbytes = read(fd, sbuf, FTP_BUFFER_SIZE))>0)
-		{
-			send(session->pasv_sockfd, sbuf, numbytes, 0);
-		}
+		/* the file in memory is sent without copying to sbuf */
+		sendfile(session->pasv_sockfd, fd, &offset, file_size - offset);
 		rt_sprintf(sbuf, "226 Finished.\r\n");
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
 		close(fd);
@@ -567,32 +566,20 @@ err1:
 		}
 		rt_sprintf(sbuf, "150 Opening binary mode data connection for \"%s\".\r\n", filename);
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		FD_ZERO(&readfds);
-		FD_SET(session->pasv_sockfd, &readfds);
 		rt_kprintf("Waiting %d seconds for data...\n", tv.tv_sec);
-		while(select(session->pasv_sockfd+1, &readfds, 0, 0, &tv)>0 )
+		/* receive until the client closes the data connection */
+		numbytes = tv.tv_sec * 1000;
+		setsockopt(session->pasv_sockfd, SOL_SOCKET, SO_RCVTIMEO, &numbytes, sizeof(numbytes));
+		numbytes = lwip_recvfile(session->pasv_sockfd, fd, 0);
+		close(fd);
+		closesocket(session->pasv_sockfd);
+		if(numbytes==-1)
 		{
-			if((numbytes=recv(session->pasv_sockfd, sbuf, FTP_BUFFER_SIZE, 0))>0)
-			{
-				write(fd, sbuf, numbytes);
-			}
-			else if(numbytes==0)
-			{
-				close(fd);
-				closesocket(session->pasv_sockfd);
-				rt_sprintf(sbuf, "226 Finished.\r\n");
-				send(session->sockfd, sbuf, strlen(sbuf), 0);
-				break;
-			}
-			else if(numbytes==-1)
-			{
-				close(fd);
-				closesocket(session->pasv_sockfd);
-				rt_free(sbuf);
-				return -1;
-			}
+			rt_free(sbuf);
+			return -1;
 		}
-		closesocket(session->pasv_sockfd);
+		rt_sprintf(sbuf, "226 Finished.\r\n");
+		send(session->sockfd, sbuf, strlen(sbuf), 0);
 	}
 	else if(str_begin_with(buf, "SIZE")==0)
 	{
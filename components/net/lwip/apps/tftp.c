@@ -18,7 +18,8 @@ void tftp_get(const char* host, const char* dir, const char* filename)
 {
 	int fd, sock_fd, sock_opt;
 	struct sockaddr_in tftp_addr, from_addr;
-	rt_uint32_t length;
+	int length, fill;
+	rt_uint8_t *file_buffer, *packet, saved[4];
 	socklen_t fromlen;
 
 	/* make local file name */
@@ -64,27 +65,54 @@ void tftp_get(const char* host, const char* dir, const char* filename)
 	lwip_sendto(sock_fd, tftp_buffer, length, 0, 
 		(struct sockaddr *)&tftp_addr, fromlen);
 	
+	/*
+	 * The blocks are received one after another in the file buffer and it's
+	 * written to file when it is full. The header of each packet overlaps
+	 * the tail of previous block, which is saved and restored.
+	 */
+	file_buffer = (rt_uint8_t *)lwip_filebuf_alloc();
+	if (file_buffer == RT_NULL)
+	{
+		close(fd);
+		lwip_close(sock_fd);
+		rt_kprintf("no memory\n");
+		return;
+	}
+	fill = 0;
+
 	do
 	{
-		length = lwip_recvfrom(sock_fd, tftp_buffer, sizeof(tftp_buffer), 0, 
+		packet = &file_buffer[fill];
+		rt_memcpy(saved, packet, 4);
+		length = lwip_recvfrom(sock_fd, packet, 512 + 4, 0, 
 			(struct sockaddr *)&from_addr, &fromlen);
 		
-		if (length > 0)
+		if (length >= 4)
 		{
-			write(fd, (char*)&tftp_buffer[4], length - 4);
+			/* make ACK */
+			tftp_buffer[0] = 0; tftp_buffer[1] = TFTP_ACK; /* opcode */
+			tftp_buffer[2] = packet[2]; tftp_buffer[3] = packet[3];
+
+			rt_memcpy(packet, saved, 4);
+			fill += length - 4;
+			if (fill + 512 + 4 > RT_LWIP_FILEBUF_SIZE || length != 516)
+			{
+				write(fd, (char*)&file_buffer[4], fill);
+				fill = 0;
+			}
 			rt_kprintf("#");
 
-			/* make ACK */			
-			tftp_buffer[0] = 0; tftp_buffer[1] = TFTP_ACK; /* opcode */
 			/* send ACK */
 			lwip_sendto(sock_fd, tftp_buffer, 4, 0, 
 				(struct sockaddr *)&from_addr, fromlen);
 		}
 	} while (length == 516);
 
-	if (length == 0) rt_kprintf("timeout\n");
+	if (fill > 0) write(fd, (char*)&file_buffer[4], fill);
+	if (length <= 0) rt_kprintf("timeout\n");
 	else rt_kprintf("done\n");
 
+	lwip_filebuf_free(file_buffer);
 	close(fd);
 	lwip_close(sock_fd);
 }
@@ -95,6 +123,8 @@ void tftp_put(const char* host, const char* dir, const char* filename)
 	int fd, sock_fd, sock_opt;
 	struct sockaddr_in tftp_addr, from_addr;
 	rt_uint32_t length, block_number = 0;
+	int fill, position;
+	rt_uint8_t *file_buffer, *packet;
 	socklen_t fromlen;
 
 	/* make local file name */
@@ -153,20 +183,47 @@ void tftp_put(const char* host, const char* dir, const char* filename)
 		return;
 	}
 
+	/*
+	 * The file is read to the file buffer in large pieces, and each block is
+	 * sent in place with its header over the tail of previous block, which
+	 * has been acked.
+	 */
+	file_buffer = (rt_uint8_t *)lwip_filebuf_alloc();
+	if (file_buffer == RT_NULL)
+	{
+		rt_kprintf("no memory\n");
+		close(fd);
+		lwip_close(sock_fd);
+		return;
+	}
+	fill = 0;
+	position = 0;
+
 	block_number = 1;
 	
 	while (1)
 	{
-		length = read(fd, (char*)&tftp_buffer[4], 512);
+		if (position >= fill)
+		{
+			/* read whole blocks of file */
+			fill = read(fd, (char*)&file_buffer[4], (RT_LWIP_FILEBUF_SIZE - 4) & ~511);
+			position = 0;
+			if (fill < 0) fill = 0;
+		}
+
+		length = fill - position;
+		if (length > 512) length = 512;
 		if (length > 0)
 		{
 			/* make opcode and block number */
-			tftp_buffer[0] = 0; tftp_buffer[1] = TFTP_DATA;
-			tftp_buffer[2] = (block_number >> 8) & 0xff;
-			tftp_buffer[3] = block_number & 0xff;
+			packet = &file_buffer[position];
+			packet[0] = 0; packet[1] = TFTP_DATA;
+			packet[2] = (block_number >> 8) & 0xff;
+			packet[3] = block_number & 0xff;
 
-			lwip_sendto(sock_fd, tftp_buffer, length + 4, 0, 
+			lwip_sendto(sock_fd, packet, length + 4, 0, 
 				(struct sockaddr *)&from_addr, fromlen);
+			position += length;
 		}
 		else
 		{
@@ -200,6 +257,7 @@ void tftp_put(const char* host, const char* dir, const char* filename)
 		}
 	}
 
+	lwip_filebuf_free(file_buffer);
 	close(fd);
 	lwip_close(sock_fd);
 }
@@ -80,6 +80,10 @@ struct lwip_sock {
   int err;
   /** counter of how many threads are waiting for this socket using select */
   int select_waiting;
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL)
+  /** RT-Thread: the threads waiting for this socket using poll */
+  rt_wqueue_t wait_head;
+#endif
 };
 
 /** Description for a task waiting in select */
@@ -183,6 +187,15 @@ static void lwip_setsockopt_internal(void *arg);
 void
 lwip_socket_init(void)
 {
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL)
+  int i;
+
+  /* the poll nodes may stay on the queue until the poll returns, so the
+     queue is not initialized again when the socket is allocated */
+  for (i = 0; i < NUM_SOCKETS; ++i) {
+    rt_wqueue_init(&sockets[i].wait_head);
+  }
+#endif
 }
 
 /**
@@ -196,8 +209,9 @@ get_socket(int s)
 {
   struct lwip_sock *sock;
 
+  s -= LWIP_SOCKET_OFFSET;
   if ((s < 0) || (s >= NUM_SOCKETS)) {
-    LWIP_DEBUGF(SOCKETS_DEBUG, ("get_socket(%d): invalid\n", s));
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("get_socket(%d): invalid\n", s + LWIP_SOCKET_OFFSET));
     set_errno(EBADF);
     return NULL;
   }
@@ -205,7 +219,7 @@ get_socket(int s)
   sock = &sockets[s];
 
   if (!sock->conn) {
-    LWIP_DEBUGF(SOCKETS_DEBUG, ("get_socket(%d): not active\n", s));
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("get_socket(%d): not active\n", s + LWIP_SOCKET_OFFSET));
     set_errno(EBADF);
     return NULL;
   }
@@ -222,6 +236,7 @@ get_socket(int s)
 static struct lwip_sock *
 tryget_socket(int s)
 {
+  s -= LWIP_SOCKET_OFFSET;
   if ((s < 0) || (s >= NUM_SOCKETS)) {
     return NULL;
   }
@@ -263,7 +278,7 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].errevent   = 0;
       sockets[i].err        = 0;
       sockets[i].select_waiting = 0;
-      return i;
+      return i + LWIP_SOCKET_OFFSET;
     }
     SYS_ARCH_UNPROTECT(lev);
   }
@@ -293,6 +308,12 @@ free_socket(struct lwip_sock *sock, int is_tcp)
   SYS_ARCH_UNPROTECT(lev);
   /* don't use 'sock' after this line, as another task might have allocated it */
 
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL)
+  /* RT-Thread: the queue stays in the array, the woken polling threads
+     will find the socket is closed */
+  rt_wqueue_wakeup(&sock->wait_head, POLLHUP);
+#endif
+
   if (lastdata != NULL) {
     if (is_tcp) {
       pbuf_free((struct pbuf *)lastdata);
@@ -375,9 +396,10 @@ lwip_accept(int s, struct sockaddr *addr, socklen_t *addrlen)
     sock_set_errno(sock, ENFILE);
     return -1;
   }
-  LWIP_ASSERT("invalid socket index", (newsock >= 0) && (newsock < NUM_SOCKETS));
+  LWIP_ASSERT("invalid socket index", (newsock >= LWIP_SOCKET_OFFSET) &&
+    (newsock < NUM_SOCKETS + LWIP_SOCKET_OFFSET));
   LWIP_ASSERT("newconn->callback == event_callback", newconn->callback == event_callback);
-  nsock = &sockets[newsock];
+  nsock = &sockets[newsock - LWIP_SOCKET_OFFSET];
 
   /* See event_callback: If data comes in right away after an accept, even
    * though the server task might not have created a new socket yet.
@@ -774,7 +796,7 @@ lwip_send(int s, const void *data, size_t size, int flags)
     }
   }
 
-  write_flags = NETCONN_COPY |
+  write_flags = ((flags & MSG_NOCOPY)   ? NETCONN_NOCOPY    : NETCONN_COPY) |
     ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
     ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
   err = netconn_write(sock->conn, data, size, write_flags);
@@ -1293,6 +1315,20 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL)
+  /* RT-Thread: wake up the threads polling this socket */
+  if (evt == NETCONN_EVT_RCVPLUS || evt == NETCONN_EVT_SENDPLUS ||
+      evt == NETCONN_EVT_ERROR) {
+    rt_uint32_t mask;
+
+    mask = (evt == NETCONN_EVT_RCVPLUS) ? POLLIN :
+           (evt == NETCONN_EVT_SENDPLUS) ? POLLOUT : POLLERR;
+    SYS_ARCH_UNPROTECT(lev);
+    rt_wqueue_wakeup(&sock->wait_head, mask);
+    SYS_ARCH_PROTECT(lev);
+  }
+#endif
+
   if (sock->select_waiting == 0) {
     /* noone is waiting for this socket, no need to check select_cb_list */
     SYS_ARCH_UNPROTECT(lev);
@@ -2344,4 +2380,42 @@ lwip_fcntl(int s, int cmd, int val)
   return ret;
 }
 
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL)
+/** RT-Thread: the poll operation of socket, which is invoked by poll and
+ * select of DFS.
+ *
+ * @param s the socket
+ * @param req the poll request to be added on the wait queue of socket
+ * @return the events of socket, POLLNVAL for an invalid socket
+ */
+int
+lwip_poll(int s, struct rt_pollreq *req)
+{
+  struct lwip_sock *sock;
+  int mask = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  sock = tryget_socket(s);
+  if (!sock) {
+    return POLLNVAL;
+  }
+
+  rt_poll_add(&sock->wait_head, req);
+
+  SYS_ARCH_PROTECT(lev);
+  if (sock->lastdata || sock->rcvevent > 0) {
+    mask |= POLLIN;
+  }
+  if (sock->sendevent != 0) {
+    mask |= POLLOUT;
+  }
+  if (sock->errevent != 0) {
+    mask |= POLLERR;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  return mask;
+}
+#endif
+
 #endif /* LWIP_SOCKET */
@@ -0,0 +1,308 @@
+/*
+ * File      : sendfile.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-02     Bernard      the first version
+ */
+
+#include <rtthread.h>
+#include <dfs.h>
+#include <dfs_file.h>
+
+#include "lwip/sockets.h"
+
+/* the number of buffers for the file which is not in memory */
+#ifndef RT_LWIP_FILEBUF_NUM
+#define RT_LWIP_FILEBUF_NUM     2
+#endif
+
+#ifdef RT_USING_MEMPOOL
+static rt_mp_t _filebuf_mp = RT_NULL;
+#endif
+
+/**
+ * This function allocates a buffer of RT_LWIP_FILEBUF_SIZE bytes from the
+ * file buffer pool, it waits until a buffer is released when the pool is
+ * empty.
+ *
+ * @return the buffer, or RT_NULL if there is no memory to create the pool.
+ */
+void *lwip_filebuf_alloc(void)
+{
+#ifdef RT_USING_MEMPOOL
+    rt_mp_t mp;
+
+    if (_filebuf_mp == RT_NULL)
+    {
+        mp = rt_mp_create("filebuf", RT_LWIP_FILEBUF_NUM, RT_LWIP_FILEBUF_SIZE);
+        if (mp == RT_NULL)
+            return RT_NULL;
+
+        rt_enter_critical();
+        if (_filebuf_mp == RT_NULL)
+        {
+            _filebuf_mp = mp;
+            mp = RT_NULL;
+        }
+        rt_exit_critical();
+
+        /* the pool has been created by another thread */
+        if (mp != RT_NULL)
+            rt_mp_delete(mp);
+    }
+
+    return rt_mp_alloc(_filebuf_mp, RT_WAITING_FOREVER);
+#else
+    return rt_malloc(RT_LWIP_FILEBUF_SIZE);
+#endif
+}
+RTM_EXPORT(lwip_filebuf_alloc);
+
+void lwip_filebuf_free(void *buffer)
+{
+#ifdef RT_USING_MEMPOOL
+    rt_mp_free(buffer);
+#else
+    rt_free(buffer);
+#endif
+}
+RTM_EXPORT(lwip_filebuf_free);
+
+/* send the file which is in memory */
+static int _sendfile_mem(int s, struct dfs_fd *d, struct dfs_file_mem *mem,
+                         rt_off_t pos, rt_size_t count)
+{
+    rt_size_t sent, length;
+    int result;
+
+    if (pos >= mem->size)
+        return 0;
+    if (count > mem->size - pos)
+        count = mem->size - pos;
+
+    /* the data is acked before it is gone, let TCP reference it directly */
+    if (mem->stable == RT_TRUE)
+        return lwip_send(s, (const rt_uint8_t *)mem->addr + pos, count, MSG_NOCOPY);
+
+    /*
+     * The data may be moved by the writing of other thread, copy it to TCP
+     * in pieces and get the address again for each piece.
+     */
+    for (sent = 0; sent < count; sent += result)
+    {
+        if (sent != 0 && (dfs_file_ioctl(d, DFS_F_GETADDR, mem) != DFS_STATUS_OK ||
+            pos + sent >= mem->size))
+            break;
+
+        length = count - sent;
+        if (length > RT_LWIP_FILEBUF_SIZE)
+            length = RT_LWIP_FILEBUF_SIZE;
+        if (length > mem->size - pos - sent)
+            length = mem->size - pos - sent;
+
+        result = lwip_send(s, (const rt_uint8_t *)mem->addr + pos + sent, length, 0);
+        if (result <= 0)
+            return sent ? (int)sent : -1;
+    }
+
+    return sent;
+}
+
+/* send the file through the buffer of pool */
+static int _sendfile_buffer(int s, struct dfs_fd *d, rt_size_t count)
+{
+    rt_size_t sent, length;
+    rt_uint8_t *buffer;
+    int result;
+
+    buffer = (rt_uint8_t *)lwip_filebuf_alloc();
+    if (buffer == RT_NULL)
+    {
+        rt_set_errno(-DFS_STATUS_ENOMEM);
+        return -1;
+    }
+
+    for (sent = 0; sent < count; sent += length)
+    {
+        length = count - sent;
+        if (length > RT_LWIP_FILEBUF_SIZE)
+            length = RT_LWIP_FILEBUF_SIZE;
+
+        result = dfs_file_read(d, buffer, length);
+        if (result <= 0)
+            break;
+
+        length = result;
+        result = lwip_send(s, buffer, length, 0);
+        if (result != (int)length)
+        {
+            lwip_filebuf_free(buffer);
+
+            return sent ? (int)sent : -1;
+        }
+    }
+    lwip_filebuf_free(buffer);
+
+    return sent;
+}
+
+/**
+ * This function sends the data of file to the socket. The data of romfs is
+ * sent without copying, the data of other file system in memory is copied
+ * to TCP directly, and the file of others is read to a pooled buffer.
+ *
+ * @param s the socket to send data.
+ * @param fd the file descriptor opened for reading.
+ * @param offset the offset of file to start reading. When it's not RT_NULL,
+ *        it's updated to the end of sent data and the position of file is
+ *        not changed; otherwise the data is read from the current position
+ *        of file, which is updated.
+ * @param count the bytes to be sent.
+ *
+ * @return the bytes sent, or -1 on failed.
+ */
+int lwip_sendfile(int s, int fd, rt_off_t *offset, rt_size_t count)
+{
+    struct dfs_fd *d;
+    struct dfs_file_mem mem;
+    rt_off_t pos, saved;
+    int result;
+
+    d = fd_get(fd);
+    if (d == RT_NULL)
+    {
+        rt_set_errno(-DFS_STATUS_EBADF);
+        return -1;
+    }
+
+    saved = d->pos;
+    pos = (offset != RT_NULL) ? *offset : d->pos;
+    if (pos < 0)
+    {
+        fd_put(d);
+        rt_set_errno(-DFS_STATUS_EINVAL);
+        return -1;
+    }
+
+    rt_memset(&mem, 0, sizeof(mem));
+    if (dfs_file_ioctl(d, DFS_F_GETADDR, &mem) == DFS_STATUS_OK &&
+        mem.addr != RT_NULL)
+    {
+        result = _sendfile_mem(s, d, &mem, pos, count);
+        if (result > 0 && offset == RT_NULL)
+            dfs_file_lseek(d, pos + result);
+    }
+    else
+    {
+        if (pos != d->pos && dfs_file_lseek(d, pos) < 0)
+        {
+            fd_put(d);
+            rt_set_errno(-DFS_STATUS_EINVAL);
+            return -1;
+        }
+
+        result = _sendfile_buffer(s, d, count);
+        if (offset != RT_NULL)
+            dfs_file_lseek(d, saved);
+    }
+
+    if (result > 0 && offset != RT_NULL)
+        *offset = pos + result;
+    fd_put(d);
+
+    return result;
+}
+RTM_EXPORT(lwip_sendfile);
+
+/**
+ * This function receives the data from socket and writes it to the file at
+ * the current position. The data is collected in a pooled buffer, which is
+ * written to file when it is full.
+ *
+ * @param s the socket to receive data.
+ * @param fd the file descriptor opened for writing.
+ * @param count the bytes to be received, 0 for receiving until the peer
+ *        closes the connection. The receive timeout of socket (SO_RCVTIMEO)
+ *        ends the receiving as well.
+ *
+ * @return the bytes written, or -1 on failed.
+ */
+int lwip_recvfile(int s, int fd, rt_size_t count)
+{
+    struct dfs_fd *d;
+    rt_uint8_t *buffer;
+    rt_size_t received, fill, length;
+    int result, error;
+    socklen_t optlen;
+
+    d = fd_get(fd);
+    if (d == RT_NULL)
+    {
+        rt_set_errno(-DFS_STATUS_EBADF);
+        return -1;
+    }
+
+    buffer = (rt_uint8_t *)lwip_filebuf_alloc();
+    if (buffer == RT_NULL)
+    {
+        fd_put(d);
+        rt_set_errno(-DFS_STATUS_ENOMEM);
+        return -1;
+    }
+
+    received = 0;
+    fill = 0;
+    result = 0;
+    while (count == 0 || received + fill < count)
+    {
+        length = RT_LWIP_FILEBUF_SIZE - fill;
+        if (count != 0 && length > count - received - fill)
+            length = count - received - fill;
+
+        result = lwip_recv(s, buffer + fill, length, 0);
+        if (result < 0)
+        {
+            /* the timeout is not an error, the received data is kept */
+            optlen = sizeof(error);
+            if (lwip_getsockopt(s, SOL_SOCKET, SO_ERROR, &error, &optlen) == 0 &&
+                    error == EWOULDBLOCK)
+                result = 0;
+        }
+        if (result <= 0)
+            break;
+
+        fill += result;
+        if (fill == RT_LWIP_FILEBUF_SIZE)
+        {
+            if (dfs_file_write(d, buffer, fill) != (int)fill)
+            {
+                result = -1;
+                fill = 0;
+                break;
+            }
+            received += fill;
+            fill = 0;
+        }
+    }
+
+    if (fill > 0)
+    {
+        if (dfs_file_write(d, buffer, fill) != (int)fill)
+            result = -1;
+        else
+            received += fill;
+    }
+
+    lwip_filebuf_free(buffer);
+    fd_put(d);
+
+    return result < 0 ? -1 : (int)received;
+}
+RTM_EXPORT(lwip_recvfile);
@@ -132,6 +132,7 @@ struct linger {
 #define MSG_OOB        0x04    /* Unimplemented: Requests out-of-band data. The significance and semantics of out-of-band data are protocol-specific */
 #define MSG_DONTWAIT   0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE       0x10    /* Sender will send more */
+#define MSG_NOCOPY     0x20    /* RT-Thread: the data stays valid until it is acked, send it without copying */
 
 
 /*
@@ -285,11 +286,16 @@ typedef struct ip_mreq {
   #define SHUT_RDWR 2
 #endif
 
+/* RT-Thread: the first socket number, the sockets are after the files of DFS */
+#ifndef LWIP_SOCKET_OFFSET
+#define LWIP_SOCKET_OFFSET    0
+#endif
+
 /* FD_SET used for lwip_select */
 #ifndef FD_SET
   #undef  FD_SETSIZE
   /* Make FD_SETSIZE match NUM_SOCKETS in socket.c */
-  #define FD_SETSIZE    MEMP_NUM_NETCONN
+  #define FD_SETSIZE    (LWIP_SOCKET_OFFSET + MEMP_NUM_NETCONN)
   #define FD_SET(n, p)  ((p)->fd_bits[(n)/8] |=  (1 << ((n) & 7)))
   #define FD_CLR(n, p)  ((p)->fd_bits[(n)/8] &= ~(1 << ((n) & 7)))
   #define FD_ISSET(n,p) ((p)->fd_bits[(n)/8] &   (1 << ((n) & 7)))
@@ -340,6 +346,25 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
 
+#ifdef RT_USING_DFS
+/* RT-Thread: transfer data between the socket and the file of DFS */
+#ifndef RT_LWIP_FILEBUF_SIZE
+#define RT_LWIP_FILEBUF_SIZE  4096    /* the size of pooled buffer for file */
+#endif
+
+int lwip_sendfile(int s, int fd, rt_off_t *offset, rt_size_t count);
+int lwip_recvfile(int s, int fd, rt_size_t count);
+void *lwip_filebuf_alloc(void);
+void lwip_filebuf_free(void *buffer);
+
+#ifdef RT_USING_POLL
+/* RT-Thread: poll and select over both the files of DFS and the sockets */
+int lwip_poll(int s, struct rt_pollreq *req);
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout);
+#endif
+#endif
+
 #if LWIP_COMPAT_SOCKETS
 #define accept(a,b,c)         lwip_accept(a,b,c)
 #define bind(a,b,c)           lwip_bind(a,b,c)
@@ -356,8 +381,13 @@ int lwip_fcntl(int s, int cmd, int val);
 #define send(a,b,c,d)         lwip_send(a,b,c,d)
 #define sendto(a,b,c,d,e,f)   lwip_sendto(a,b,c,d,e,f)
 #define socket(a,b,c)         lwip_socket(a,b,c)
+#if !defined(RT_USING_DFS) || !defined(RT_USING_POLL)
 #define select(a,b,c,d,e)     lwip_select(a,b,c,d,e)
+#endif
 #define ioctlsocket(a,b,c)    lwip_ioctl(a,b,c)
+#ifdef RT_USING_DFS
+#define sendfile(a,b,c,d)     lwip_sendfile(a,b,c,d)
+#endif
 
 #if LWIP_POSIX_SOCKETS_IO_NAMES
 #define read(a,b,c)           lwip_read(a,b,c)
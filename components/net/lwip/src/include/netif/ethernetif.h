@@ -7,6 +7,45 @@
 #define NIOCTL_GADDR		0x01
 #define ETHERNET_MTU		1500
 
+/* the buffer size for a received frame: header(14) + vlan(4) + mtu + fcs(4) */
+#ifndef ETH_RX_BUF_SIZE
+#define ETH_RX_BUF_SIZE		(ETH_PAD_SIZE + 14 + 4 + ETHERNET_MTU + 4)
+#endif
+
+struct eth_device;
+
+/*
+ * The descriptor ring interface of Ethernet device.
+ *
+ * Rx: ethernetif posts empty pbufs (ETH_RX_BUF_SIZE) to device, the device
+ * receives frame into p->payload + ETH_PAD_SIZE by DMA and reports it by
+ * eth_device_rx_done() in the same order as they were posted.
+ *
+ * Tx: ethernetif posts the pbuf chain of a frame to device in the context of
+ * sender, the device transmits the chain (skip ETH_PAD_SIZE bytes of the
+ * first pbuf) by DMA and reports it by eth_device_tx_done() in order. The
+ * pbuf is kept by ethernetif until it's reported.
+ *
+ * Both post functions return -RT_EFULL when there is no free descriptor.
+ */
+struct eth_ring_ops
+{
+	rt_err_t (*rx_post)(struct eth_device *dev, struct pbuf *p);
+	rt_err_t (*tx_post)(struct eth_device *dev, struct pbuf *p);
+};
+
+struct eth_ring
+{
+	struct pbuf **queue;
+	rt_uint16_t *length;		/* frame length of rx ring */
+	rt_uint16_t size;			/* must be power of 2 */
+
+	/* free running indexes: posted to device, done by device, reclaimed */
+	rt_uint16_t post;
+	rt_uint16_t done;
+	rt_uint16_t reclaim;
+};
+
 struct eth_device
 {
 	/* inherit from rt_device */
@@ -23,6 +62,13 @@ struct eth_device
 	/* eth device interface */
 	struct pbuf* (*eth_rx)(rt_device_t dev);
 	rt_err_t (*eth_tx)(rt_device_t dev, struct pbuf* p);
+
+	/* descriptor ring interface, it's used instead of eth_rx/eth_tx if set */
+	const struct eth_ring_ops *ring_ops;
+	struct eth_ring *rx_ring;
+	struct eth_ring *tx_ring;
+	struct rt_semaphore tx_lock;
+	rt_uint8_t tx_waiting;
 };
 
 rt_err_t eth_device_ready(struct eth_device* dev);
@@ -30,6 +76,12 @@ rt_err_t eth_device_init(struct eth_device * dev, char *name);
 rt_err_t eth_device_init_with_flag(struct eth_device *dev, char *name, rt_uint8_t flag);
 rt_err_t eth_device_linkchange(struct eth_device* dev, rt_bool_t up);
 
+/* descriptor ring device */
+rt_err_t eth_device_init_ring(struct eth_device *dev, char *name,
+	const struct eth_ring_ops *ops, rt_uint16_t rx_size, rt_uint16_t tx_size);
+void eth_device_rx_done(struct eth_device *dev, rt_uint16_t length);
+void eth_device_tx_done(struct eth_device *dev, rt_uint16_t count);
+
 void eth_system_device_init(void);
 
 #endif /* __NETIF_ETHERNETIF_H__ */
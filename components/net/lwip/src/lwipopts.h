@@ -89,7 +89,12 @@
 #endif
 
 #define MEM_LIBC_MALLOC             1
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+/* the pbufs are placed in the memory heap chosen by malloc policy */
+#define mem_malloc(size)            rt_malloc_usage((size), RT_MALLOC_USAGE_NET)
+#else
 #define mem_malloc                  rt_malloc
+#endif
 #define mem_free                    rt_free
 #define mem_calloc                  rt_calloc
 
@@ -324,6 +329,11 @@
 
 /* no read/write/close for socket */
 #define LWIP_POSIX_SOCKETS_IO_NAMES 0
+
+/* number the sockets after the file descriptors of DFS for poll and select */
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL)
+#define LWIP_SOCKET_OFFSET          (DFS_FD_MAX + 3)
+#endif
 #define LWIP_NETIF_API  1
 
 /* MEMP_NUM_SYS_TIMEOUT: the number of simulateously active timeouts. */
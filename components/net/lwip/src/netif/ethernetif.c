@@ -14,6 +14,8 @@
  * 2012-04-10     Bernard      add more compatible with RT-Thread.
  * 2012-11-12     Bernard      The network interface can be initialized 
  *                             after lwIP initialization.
+ * 2013-01-16     Bernard      add descriptor ring interface for zero-copy
+ *                             and asynchronous transmission.
  */
 
 /*
@@ -97,6 +99,205 @@ static char eth_rx_thread_mb_pool[RT_LWIP_ETHTHREAD_MBOX_SIZE * 4];
 static char eth_rx_thread_stack[RT_LWIP_ETHTHREAD_STACKSIZE];
 #endif
 
+#define ETH_RING_INDEX(ring, index)		((index) & ((ring)->size - 1))
+
+/* free the pbufs which have been transmitted by device */
+static void eth_ring_tx_reclaim(struct eth_device *dev)
+{
+	struct eth_ring *ring = dev->tx_ring;
+
+	while (ring->reclaim != ring->done)
+	{
+		pbuf_free(ring->queue[ETH_RING_INDEX(ring, ring->reclaim)]);
+		ring->reclaim ++;
+	}
+}
+
+/* the pbuf of PBUF_ROM or PBUF_REF refers to the memory of caller, which may
+ * be changed after linkoutput returns. Such chain is copied to a PBUF_RAM one
+ * before it's queued in tx ring. */
+static struct pbuf *eth_ring_tx_pbuf(struct pbuf *p)
+{
+	struct pbuf *q;
+
+	for (q = p; q != RT_NULL; q = q->next)
+	{
+		if (q->type != PBUF_RAM && q->type != PBUF_POOL)
+			break;
+	}
+
+	if (q == RT_NULL)
+	{
+		/* the pbuf is kept until the device reports it's transmitted */
+		pbuf_ref(p);
+		return p;
+	}
+
+	q = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+	if (q == RT_NULL)
+		return RT_NULL;
+
+	if (pbuf_copy(q, p) != ERR_OK)
+	{
+		pbuf_free(q);
+		return RT_NULL;
+	}
+
+	return q;
+}
+
+static err_t eth_ring_linkoutput(struct eth_device *dev, struct pbuf *p)
+{
+	err_t result = ERR_OK;
+	rt_uint32_t level;
+	struct eth_ring *ring = dev->tx_ring;
+
+	rt_sem_take(&(dev->tx_lock), RT_WAITING_FOREVER);
+
+	eth_ring_tx_reclaim(dev);
+	while ((rt_uint16_t)(ring->post - ring->reclaim) >= ring->size)
+	{
+		/* the ring is full, wait for the transmission done */
+		level = rt_hw_interrupt_disable();
+		if (ring->done == ring->reclaim)
+		{
+			dev->tx_waiting = 1;
+			rt_hw_interrupt_enable(level);
+			if (rt_sem_take(&(dev->tx_ack), RT_TICK_PER_SECOND) != RT_EOK)
+			{
+				dev->tx_waiting = 0;
+				result = ERR_MEM;
+				goto __exit;
+			}
+		}
+		else rt_hw_interrupt_enable(level);
+
+		eth_ring_tx_reclaim(dev);
+	}
+
+	p = eth_ring_tx_pbuf(p);
+	if (p == RT_NULL)
+	{
+		LINK_STATS_INC(link.memerr);
+		result = ERR_MEM;
+		goto __exit;
+	}
+
+	ring->queue[ETH_RING_INDEX(ring, ring->post)] = p;
+	ring->post ++;
+	if (dev->ring_ops->tx_post(dev, p) != RT_EOK)
+	{
+		ring->post --;
+		pbuf_free(p);
+		LINK_STATS_INC(link.drop);
+		result = ERR_IF;
+	}
+
+__exit:
+	rt_sem_release(&(dev->tx_lock));
+	return result;
+}
+
+/* post empty pbufs to device until the rx ring is full */
+static void eth_ring_rx_refill(struct eth_device *dev)
+{
+	struct pbuf *p;
+	struct eth_ring *ring = dev->rx_ring;
+
+	while ((rt_uint16_t)(ring->post - ring->reclaim) < ring->size)
+	{
+		p = pbuf_alloc(PBUF_RAW, ETH_RX_BUF_SIZE, PBUF_RAM);
+		if (p == RT_NULL) break;
+
+		/* the ring entry must be ready before device may complete it */
+		ring->queue[ETH_RING_INDEX(ring, ring->post)] = p;
+		ring->post ++;
+		if (dev->ring_ops->rx_post(dev, p) != RT_EOK)
+		{
+			ring->post --;
+			pbuf_free(p);
+			break;
+		}
+	}
+}
+
+/* pass the received frames to lwIP and post new buffers to device */
+static void eth_ring_rx(struct eth_device *dev)
+{
+	struct pbuf *p;
+	rt_uint16_t length;
+	struct eth_ring *ring = dev->rx_ring;
+
+	while (ring->reclaim != ring->done)
+	{
+		p = ring->queue[ETH_RING_INDEX(ring, ring->reclaim)];
+		length = ring->length[ETH_RING_INDEX(ring, ring->reclaim)];
+		ring->reclaim ++;
+
+		/* zero length means an error frame */
+		if (length == 0 || length > ETH_RX_BUF_SIZE - ETH_PAD_SIZE)
+		{
+			LINK_STATS_INC(link.drop);
+			pbuf_free(p);
+			continue;
+		}
+
+		p->len = p->tot_len = length + ETH_PAD_SIZE;
+		if (dev->netif->input(p, dev->netif) != ERR_OK)
+		{
+			LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: Input error\n"));
+			pbuf_free(p);
+		}
+	}
+
+	eth_ring_rx_refill(dev);
+}
+
+/**
+ * This function will be invoked by device when a frame has been received into
+ * the oldest buffer posted, it can be invoked in interrupt service routine.
+ *
+ * @param dev the ethernet device
+ * @param length the frame length without ETH_PAD_SIZE, 0 for error frame
+ */
+void eth_device_rx_done(struct eth_device *dev, rt_uint16_t length)
+{
+	rt_uint32_t level;
+	struct eth_ring *ring = dev->rx_ring;
+
+	level = rt_hw_interrupt_disable();
+	RT_ASSERT(ring->done != ring->post);
+	ring->length[ETH_RING_INDEX(ring, ring->done)] = length;
+	ring->done ++;
+	rt_hw_interrupt_enable(level);
+
+	eth_device_ready(dev);
+}
+
+/**
+ * This function will be invoked by device when the oldest count frames have
+ * been transmitted, it can be invoked in interrupt service routine.
+ *
+ * @param dev the ethernet device
+ * @param count the number of transmitted frames
+ */
+void eth_device_tx_done(struct eth_device *dev, rt_uint16_t count)
+{
+	rt_uint32_t level;
+
+	level = rt_hw_interrupt_disable();
+	dev->tx_ring->done += count;
+	if (dev->tx_waiting)
+	{
+		dev->tx_waiting = 0;
+		rt_hw_interrupt_enable(level);
+
+		rt_sem_release(&(dev->tx_ack));
+		return;
+	}
+	rt_hw_interrupt_enable(level);
+}
+
 static err_t ethernetif_linkoutput(struct netif *netif, struct pbuf *p)
 {
 	struct eth_tx_msg msg;
@@ -104,6 +305,10 @@ static err_t ethernetif_linkoutput(struct netif *netif, struct pbuf *p)
 
 	enetif = (struct eth_device*)netif->state;
 
+	/* the frame is posted to device directly without the eth tx thread */
+	if (enetif->ring_ops != RT_NULL)
+		return eth_ring_linkoutput(enetif, p);
+
 	/* send a message to eth tx thread */
 	msg.netif = netif;
 	msg.buf   = p;
@@ -135,6 +340,10 @@ static err_t eth_netif_device_init(struct netif *netif)
 		/* copy device flags to netif flags */
 		netif->flags = ethif->flags;
 
+		/* let eth rx thread post the rx buffers */
+		if (ethif->ring_ops != RT_NULL)
+			eth_device_ready(ethif);
+
 		/* set default netif */
 		if (netif_default == RT_NULL)
 			netif_set_default(ethif->netif);
@@ -223,6 +432,58 @@ rt_err_t eth_device_init_with_flag(struct eth_device *dev, char *name, rt_uint8_
 	return RT_EOK;
 }
 
+static struct eth_ring *eth_ring_create(rt_uint16_t size, rt_bool_t with_length)
+{
+	struct eth_ring *ring;
+
+	/* the ring size must be power of 2 */
+	RT_ASSERT(size != 0 && (size & (size - 1)) == 0);
+
+	ring = (struct eth_ring *) rt_malloc(sizeof(struct eth_ring) +
+		size * sizeof(struct pbuf *) + (with_length ? size * sizeof(rt_uint16_t) : 0));
+	if (ring == RT_NULL) return RT_NULL;
+
+	ring->queue = (struct pbuf **)(ring + 1);
+	ring->length = with_length ? (rt_uint16_t *)(ring->queue + size) : RT_NULL;
+	ring->size = size;
+	ring->post = ring->done = ring->reclaim = 0;
+
+	return ring;
+}
+
+/**
+ * This function initializes an Ethernet device which uses descriptor rings,
+ * the frames are transferred by DMA into/from pbuf without copy.
+ *
+ * @param dev the ethernet device
+ * @param name the device name
+ * @param ops the ring operations of device
+ * @param rx_size the number of rx buffers, must be power of 2
+ * @param tx_size the number of tx frames in flight, must be power of 2
+ */
+rt_err_t eth_device_init_ring(struct eth_device *dev, char *name,
+	const struct eth_ring_ops *ops, rt_uint16_t rx_size, rt_uint16_t tx_size)
+{
+	RT_ASSERT(ops != RT_NULL);
+	RT_ASSERT(ops->rx_post != RT_NULL && ops->tx_post != RT_NULL);
+
+	dev->rx_ring = eth_ring_create(rx_size, RT_TRUE);
+	dev->tx_ring = eth_ring_create(tx_size, RT_FALSE);
+	if (dev->rx_ring == RT_NULL || dev->tx_ring == RT_NULL)
+	{
+		rt_kprintf("malloc eth ring failed\n");
+		rt_free(dev->rx_ring);
+		rt_free(dev->tx_ring);
+		return -RT_ENOMEM;
+	}
+
+	dev->ring_ops = ops;
+	dev->tx_waiting = 0;
+	rt_sem_init(&(dev->tx_lock), name, 1, RT_IPC_FLAG_FIFO);
+
+	return eth_device_init(dev, name);
+}
+
 rt_err_t eth_device_init(struct eth_device * dev, char *name)
 {
 	rt_uint8_t flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
@@ -325,6 +586,13 @@ static void eth_rx_thread_entry(void* parameter)
 					netifapi_netif_set_link_down(device->netif);
 			}
 
+			/* receive the frames in rx ring */
+			if (device->ring_ops != RT_NULL)
+			{
+				eth_ring_rx(device);
+				continue;
+			}
+
 			/* receive all of buffer */
 			while (1)
 			{
@@ -100,7 +100,12 @@ struct rtgui_dc *rtgui_dc_buffer_create(int w, int h)
 
     rtgui_region_init(&(dc->clip));
 
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+    /* the big pixel buffer is placed in the memory heap chosen by malloc policy */
+    dc->pixel = rtgui_malloc_usage(h * dc->pitch, RT_MALLOC_USAGE_GUI);
+#else
     dc->pixel = rtgui_malloc(h * dc->pitch);
+#endif
     rt_memset(dc->pixel, 0, h * dc->pitch);
 
     return &(dc->parent);
@@ -10,8 +10,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2009-10-16     Bernard      first version
+ * 2013-01-10     Bernard      add glyph cache
  */
 #include <rtgui/font.h>
+#include <rtgui/font_cache.h>
 #include <rtgui/dc.h>
 
 static rtgui_list_t _rtgui_font_list;
@@ -29,6 +31,7 @@ extern struct rtgui_font rtgui_font_hz12;
 void rtgui_font_system_init()
 {
     rtgui_list_init(&(_rtgui_font_list));
+    rtgui_glyph_cache_init();
 
     /* set default font to NULL */
     rtgui_default_font = RT_NULL;
@@ -75,6 +78,9 @@ RTM_EXPORT(rtgui_font_system_add_font);
 void rtgui_font_system_remove_font(struct rtgui_font *font)
 {
     rtgui_list_remove(&_rtgui_font_list, &(font->list));
+
+    /* drop the cached glyphs of this font */
+    rtgui_glyph_cache_flush(font);
 }
 RTM_EXPORT(rtgui_font_system_remove_font);
 
@@ -0,0 +1,422 @@
+/*
+ * File      : font_cache.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-10     Bernard      first version
+ */
+
+/*
+ * Glyph cache shared by the font engines.
+ *
+ * All the glyphs are kept in a hash table for looking up and in a LRU list
+ * for eviction. The cache is limited by a byte budget which could be changed
+ * at runtime, the least recently used glyph is freed when the budget is
+ * exceeded.
+ */
+#include <rtgui/dc.h>
+#include <rtgui/font.h>
+#include <rtgui/font_cache.h>
+#include <rtgui/rtgui_system.h>
+
+struct rtgui_glyph_cache
+{
+    struct rtgui_glyph *hash[RTGUI_GLYPH_HASH_SIZE];
+
+    /* the head is the most recently used glyph */
+    struct rtgui_dlist_node lru_list;
+
+    struct rtgui_glyph_cache_stat stat;
+};
+static struct rtgui_glyph_cache _glyph_cache;
+
+#define _glyph_hash(font, code)     \
+    ((((rt_uint32_t)(font) >> 4) ^ (code)) & (RTGUI_GLYPH_HASH_SIZE - 1))
+
+void rtgui_glyph_cache_init(void)
+{
+    rt_memset(&_glyph_cache, 0, sizeof(_glyph_cache));
+    rtgui_dlist_init(&_glyph_cache.lru_list);
+
+    _glyph_cache.stat.budget = RTGUI_GLYPH_CACHE_SIZE;
+}
+
+/* remove a glyph from the cache. Should be invoked in critical. */
+static void _glyph_cache_remove(struct rtgui_glyph *glyph)
+{
+    struct rtgui_glyph **prev;
+
+    prev = &_glyph_cache.hash[_glyph_hash(glyph->font, glyph->code)];
+    while (*prev != RT_NULL && *prev != glyph)
+        prev = &((*prev)->hash_next);
+    if (*prev != RT_NULL)
+        *prev = glyph->hash_next;
+
+    rtgui_dlist_remove(&glyph->lru);
+
+    _glyph_cache.stat.count --;
+    _glyph_cache.stat.used -= glyph->size;
+}
+
+/* evict glyphs until there are size bytes free in budget. The evicted glyphs
+ * are linked to the returned list and they should be freed out of critical.
+ * Should be invoked in critical. */
+static struct rtgui_glyph *_glyph_cache_evict(rt_size_t size)
+{
+    struct rtgui_glyph *glyph, *evicted = RT_NULL;
+    struct rtgui_dlist_node *node;
+
+    node = _glyph_cache.lru_list.prev;
+    while (node != &_glyph_cache.lru_list &&
+            _glyph_cache.stat.used + size > _glyph_cache.stat.budget)
+    {
+        glyph = rtgui_dlist_entry(node, struct rtgui_glyph, lru);
+        node = node->prev;
+
+        /* the glyph is still used by someone */
+        if (glyph->ref_count != 0)
+            continue;
+
+        _glyph_cache_remove(glyph);
+        _glyph_cache.stat.evict ++;
+
+        glyph->hash_next = evicted;
+        evicted = glyph;
+    }
+
+    return evicted;
+}
+
+static void _glyph_free_list(struct rtgui_glyph *glyph)
+{
+    struct rtgui_glyph *next;
+
+    while (glyph != RT_NULL)
+    {
+        next = glyph->hash_next;
+        rtgui_free(glyph);
+        glyph = next;
+    }
+}
+
+void rtgui_glyph_cache_set_budget(rt_size_t size)
+{
+    struct rtgui_glyph *evicted;
+
+    rtgui_enter_critical();
+    _glyph_cache.stat.budget = size;
+    evicted = _glyph_cache_evict(0);
+    rtgui_exit_critical();
+
+    _glyph_free_list(evicted);
+}
+
+void rtgui_glyph_cache_get_stat(struct rtgui_glyph_cache_stat *stat)
+{
+    RT_ASSERT(stat != RT_NULL);
+
+    rtgui_enter_critical();
+    *stat = _glyph_cache.stat;
+    rtgui_exit_critical();
+}
+
+void rtgui_glyph_cache_dump(void)
+{
+    rt_uint32_t total;
+    struct rtgui_glyph_cache_stat stat;
+
+    rtgui_glyph_cache_get_stat(&stat);
+
+    total = stat.hit + stat.miss;
+    rt_kprintf("glyph cache: %d glyphs, used %d/%d bytes\n",
+               stat.count, stat.used, stat.budget);
+    rt_kprintf("hit: %d, miss: %d, evict: %d, hit ratio: %d%%\n",
+               stat.hit, stat.miss, stat.evict,
+               total == 0 ? 0 : stat.hit * 100 / total);
+}
+
+/* should be invoked in critical */
+static struct rtgui_glyph *_glyph_cache_find(struct rtgui_font *font, rt_uint32_t code)
+{
+    struct rtgui_glyph *glyph;
+
+    glyph = _glyph_cache.hash[_glyph_hash(font, code)];
+    while (glyph != RT_NULL)
+    {
+        if (glyph->font == font && glyph->code == code)
+            break;
+        glyph = glyph->hash_next;
+    }
+
+    return glyph;
+}
+
+/* check whether a glyph is in cache without touching the LRU and statistics */
+rt_bool_t rtgui_glyph_cache_exist(struct rtgui_font *font, rt_uint32_t code)
+{
+    struct rtgui_glyph *glyph;
+
+    rtgui_enter_critical();
+    glyph = _glyph_cache_find(font, code);
+    rtgui_exit_critical();
+
+    return glyph != RT_NULL ? RT_TRUE : RT_FALSE;
+}
+
+struct rtgui_glyph *rtgui_glyph_cache_get(struct rtgui_font *font, rt_uint32_t code)
+{
+    struct rtgui_glyph *glyph;
+
+    rtgui_enter_critical();
+
+    glyph = _glyph_cache_find(font, code);
+
+    if (glyph != RT_NULL)
+    {
+        /* move to the head of LRU list */
+        rtgui_dlist_remove(&glyph->lru);
+        rtgui_dlist_insert_after(&_glyph_cache.lru_list, &glyph->lru);
+
+        glyph->ref_count ++;
+        _glyph_cache.stat.hit ++;
+    }
+    else
+    {
+        _glyph_cache.stat.miss ++;
+    }
+
+    rtgui_exit_critical();
+
+    return glyph;
+}
+
+void rtgui_glyph_cache_release(struct rtgui_glyph *glyph)
+{
+    if (glyph == RT_NULL)
+        return;
+
+    rtgui_enter_critical();
+    RT_ASSERT(glyph->ref_count > 0);
+    glyph->ref_count --;
+    rtgui_exit_critical();
+}
+
+struct rtgui_glyph *rtgui_glyph_alloc(struct rtgui_font *font, rt_uint32_t code, rt_size_t bitmap_size)
+{
+    struct rtgui_glyph *glyph;
+
+    glyph = (struct rtgui_glyph *)rtgui_malloc(sizeof(struct rtgui_glyph) + bitmap_size);
+    if (glyph == RT_NULL)
+        return RT_NULL;
+
+    rt_memset(glyph, 0, sizeof(struct rtgui_glyph));
+    glyph->font = font;
+    glyph->code = code;
+    glyph->size = sizeof(struct rtgui_glyph) + bitmap_size;
+    if (bitmap_size != 0)
+        glyph->bitmap = (const rt_uint8_t *)(glyph + 1);
+    else
+        glyph->flag = RTGUI_GLYPH_FLAG_EXTERN;
+    rtgui_dlist_init(&glyph->lru);
+
+    return glyph;
+}
+
+void rtgui_glyph_free(struct rtgui_glyph *glyph)
+{
+    rtgui_free(glyph);
+}
+
+/* put a glyph into cache. The returned glyph is referred and it may be
+ * another one if the same glyph has been put by other thread. */
+struct rtgui_glyph *rtgui_glyph_cache_put(struct rtgui_glyph *glyph)
+{
+    rt_uint32_t index;
+    struct rtgui_glyph *item, *evicted;
+
+    RT_ASSERT(glyph != RT_NULL);
+
+    index = _glyph_hash(glyph->font, glyph->code);
+
+    rtgui_enter_critical();
+
+    item = _glyph_cache_find(glyph->font, glyph->code);
+    if (item != RT_NULL)
+    {
+        /* loaded by others at the same time */
+        item->ref_count ++;
+        rtgui_exit_critical();
+
+        rtgui_glyph_free(glyph);
+        return item;
+    }
+
+    evicted = _glyph_cache_evict(glyph->size);
+
+    glyph->ref_count = 1;
+    glyph->hash_next = _glyph_cache.hash[index];
+    _glyph_cache.hash[index] = glyph;
+    rtgui_dlist_insert_after(&_glyph_cache.lru_list, &glyph->lru);
+
+    _glyph_cache.stat.count ++;
+    _glyph_cache.stat.used += glyph->size;
+
+    rtgui_exit_critical();
+
+    _glyph_free_list(evicted);
+
+    return glyph;
+}
+
+void rtgui_glyph_cache_flush(struct rtgui_font *font)
+{
+    struct rtgui_glyph *glyph, *evicted = RT_NULL;
+    struct rtgui_dlist_node *node;
+
+    rtgui_enter_critical();
+
+    node = _glyph_cache.lru_list.next;
+    while (node != &_glyph_cache.lru_list)
+    {
+        glyph = rtgui_dlist_entry(node, struct rtgui_glyph, lru);
+        node = node->next;
+
+        if (glyph->font != font)
+            continue;
+
+        RT_ASSERT(glyph->ref_count == 0);
+        _glyph_cache_remove(glyph);
+
+        glyph->hash_next = evicted;
+        evicted = glyph;
+    }
+
+    rtgui_exit_critical();
+
+    _glyph_free_list(evicted);
+}
+
+/* draw the spans of a row. The set bits are drawn with foreground color and
+ * the clear bits are drawn with background color if needed. */
+static void _glyph_draw_mono_row(struct rtgui_dc *dc, const rt_uint8_t *row,
+                                 int x, int y, int start, int end, rt_bool_t draw_bg)
+{
+    int i, span;
+    rt_bool_t bit;
+    rtgui_gc_t *gc;
+    rtgui_color_t fc;
+
+    gc = rtgui_dc_get_gc(dc);
+    fc = gc->foreground;
+
+    i = start;
+    while (i < end)
+    {
+        bit = (row[i >> 3] >> (7 - (i & 0x07))) & 0x01;
+
+        /* find the end of this span */
+        span = i + 1;
+        while (span < end &&
+                (((row[span >> 3] >> (7 - (span & 0x07))) & 0x01) == bit))
+            span ++;
+
+        if (bit)
+        {
+            rtgui_dc_draw_hline(dc, x + i, x + span, y);
+        }
+        else if (draw_bg)
+        {
+            gc->foreground = gc->background;
+            rtgui_dc_draw_hline(dc, x + i, x + span, y);
+            gc->foreground = fc;
+        }
+
+        i = span;
+    }
+}
+
+void rtgui_glyph_draw_mono(struct rtgui_dc *dc, const rt_uint8_t *bitmap, int pitch,
+                           int x, int y, int w, int h, const struct rtgui_rect *rect)
+{
+    int row, start, end;
+    rt_bool_t draw_bg;
+
+    RT_ASSERT(dc != RT_NULL);
+    RT_ASSERT(rect != RT_NULL);
+
+    if (bitmap == RT_NULL)
+        return;
+
+    draw_bg = (rtgui_dc_get_gc(dc)->textstyle & RTGUI_TEXTSTYLE_DRAW_BACKGROUND) ?
+              RT_TRUE : RT_FALSE;
+
+    /* clip the bitmap with rect */
+    start = x < rect->x1 ? rect->x1 - x : 0;
+    end = x + w > rect->x2 ? rect->x2 - x : w;
+    if (start >= end)
+        return;
+
+    for (row = 0; row < h; row ++)
+    {
+        if (y + row < rect->y1)
+            continue;
+        if (y + row >= rect->y2)
+            break;
+
+        _glyph_draw_mono_row(dc, bitmap + row * pitch, x, y + row, start, end, draw_bg);
+    }
+}
+
+void rtgui_glyph_draw(struct rtgui_dc *dc, const struct rtgui_glyph *glyph,
+                      int x, int y, const struct rtgui_rect *rect)
+{
+    RT_ASSERT(glyph != RT_NULL);
+
+    x += glyph->left;
+    y += glyph->top;
+
+    if (glyph->format == RTGUI_GLYPH_MONO)
+    {
+        rtgui_glyph_draw_mono(dc, glyph->bitmap, glyph->pitch,
+                              x, y, glyph->width, glyph->height, rect);
+    }
+    else
+    {
+        int row, col;
+        const rt_uint8_t *ptr;
+
+        for (row = 0; row < glyph->height; row ++)
+        {
+            if (y + row < rect->y1)
+                continue;
+            if (y + row >= rect->y2)
+                break;
+
+            ptr = glyph->bitmap + row * glyph->pitch;
+            for (col = 0; col < glyph->width; col ++)
+            {
+                if (ptr[col] == 0 || x + col < rect->x1 || x + col >= rect->x2)
+                    continue;
+
+                rtgui_dc_draw_color_point(dc, x + col, y + row,
+                                          RTGUI_RGB(0xff - ptr[col], 0xff - ptr[col], 0xff - ptr[col]));
+            }
+        }
+    }
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+void glyph_cache_budget(rt_size_t size)
+{
+    rtgui_glyph_cache_set_budget(size);
+    rtgui_glyph_cache_dump();
+}
+FINSH_FUNCTION_EXPORT(glyph_cache_budget, set the byte budget of glyph cache);
+#endif
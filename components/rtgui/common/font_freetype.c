@@ -1,4 +1,5 @@
 #include <rtgui/font_freetype.h>
+#include <rtgui/font_cache.h>
 
 #ifdef RTGUI_USING_TTF
 #include <ft2build.h>
@@ -54,11 +55,51 @@ static void gbk_to_unicode(rt_uint16_t *unicode, const unsigned char *text, int
     *unicode = '\0';
 }
 
-static void rtgui_freetype_font_draw_text(struct rtgui_font *font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect)
+/* get the rendered glyph of a unicode character from glyph cache. The glyph
+ * is rendered by freetype and put into cache when it's missed. */
+static struct rtgui_glyph *_rtgui_freetype_get_glyph(struct rtgui_font *font, rt_uint16_t code)
 {
-    int index = 0;
+    int index, rows;
     FT_Error err = 0;
+    FT_Bitmap *bitmap;
+    struct rtgui_glyph *glyph;
+    struct rtgui_freetype_font *freetype;
+
+    glyph = rtgui_glyph_cache_get(font, code);
+    if (glyph != RT_NULL)
+        return glyph;
+
+    freetype = (struct rtgui_freetype_font *) font->data;
+    index = FT_Get_Char_Index(freetype->face, code);
+    err = FT_Load_Glyph(freetype->face, index, FT_LOAD_DEFAULT | FT_LOAD_RENDER);
+    if (err != 0)
+        return RT_NULL;
+
+    bitmap = &(freetype->face->glyph->bitmap);
+    glyph = rtgui_glyph_alloc(font, code, bitmap->width * bitmap->rows);
+    if (glyph == RT_NULL)
+        return RT_NULL;
+
+    glyph->format  = RTGUI_GLYPH_GRAY8;
+    glyph->pitch   = bitmap->width;
+    glyph->width   = bitmap->width;
+    glyph->height  = bitmap->rows;
+    glyph->advance = bitmap->width;
+
+    /* the pitch of freetype bitmap may be larger than width */
+    for (rows = 0; rows < bitmap->rows; rows ++)
+    {
+        rt_memcpy((rt_uint8_t *)glyph->bitmap + rows * glyph->pitch,
+                  bitmap->buffer + rows * bitmap->pitch, bitmap->width);
+    }
+
+    return rtgui_glyph_cache_put(glyph);
+}
+
+static void rtgui_freetype_font_draw_text(struct rtgui_font *font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect)
+{
     rt_uint16_t *text_short, *text_ptr;
+    struct rtgui_glyph *glyph;
     struct rtgui_freetype_font *freetype;
 
     RT_ASSERT(font != RT_NULL);
@@ -75,27 +116,16 @@ static void rtgui_freetype_font_draw_text(struct rtgui_font *font, struct rtgui_
 
     while (*text_ptr)
     {
-        index = FT_Get_Char_Index(freetype->face, *text_ptr);
-        err = FT_Load_Glyph(freetype->face, index, FT_LOAD_DEFAULT | FT_LOAD_RENDER);
-        if (err == 0)
+        glyph = _rtgui_freetype_get_glyph(font, *text_ptr);
+        if (glyph != RT_NULL)
         {
-            int rows, x;
-            rt_uint8_t *ptr;
+            rtgui_glyph_draw(dc, glyph, rect->x1, rect->y1, rect);
+            rect->x1 += glyph->advance;
 
-            /* render font */
-            ptr = (rt_uint8_t *)freetype->face->glyph->bitmap.buffer;
-
-            for (rows = 0; rows < freetype->face->glyph->bitmap.rows; rows ++)
-                for (x = 0; x < freetype->face->glyph->bitmap.width; x++)
-                {
-                    if (*ptr > 0)
-                        rtgui_dc_draw_color_point(dc, rect->x1 + x, rect->y1 + rows, RTGUI_RGB(0xff - *ptr, 0xff - *ptr, 0xff - *ptr));
-                    ptr ++;
-                }
+            rtgui_glyph_cache_release(glyph);
         }
 
         text_ptr ++;
-        rect->x1 += freetype->face->glyph->bitmap.width;
     }
 
     /* release unicode buffer */
@@ -128,6 +158,21 @@ static void rtgui_freetype_font_get_metrics(struct rtgui_font *font, const char
 
     while (*text_ptr)
     {
+        struct rtgui_glyph *glyph;
+
+        /* use the metrics of cached glyph if it's rendered already */
+        glyph = rtgui_glyph_cache_get(font, *text_ptr);
+        if (glyph != RT_NULL)
+        {
+            w += glyph->advance;
+            if (glyph->height > h)
+                h = glyph->height;
+
+            rtgui_glyph_cache_release(glyph);
+            text_ptr ++;
+            continue;
+        }
+
         index = FT_Get_Char_Index(freetype->face, *text_ptr);
         err = FT_Load_Glyph(freetype->face, index, FT_LOAD_DEFAULT);
 
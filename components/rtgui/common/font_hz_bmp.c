@@ -1,6 +1,7 @@
 
 #include <rtgui/dc.h>
 #include <rtgui/font.h>
+#include <rtgui/font_cache.h>
 
 #ifdef RTGUI_USING_HZ_BMP
 
@@ -17,7 +18,7 @@ const struct rtgui_font_engine hz_bmp_font_engine =
 #ifdef RTGUI_USING_FONT_COMPACT
 extern rt_uint32_t rtgui_font_mph12(const rt_uint16_t key);
 extern rt_uint32_t rtgui_font_mph16(const rt_uint16_t key);
-rt_inline const rt_uint8_t *_rtgui_hz_bitmap_get_font_ptr(struct rtgui_font_bitmap *bmp_font,
+rt_inline const rt_uint8_t *_rtgui_hz_bitmap_lookup(struct rtgui_font_bitmap *bmp_font,
         rt_uint8_t *str,
         rt_base_t font_bytes)
 {
@@ -36,6 +37,34 @@ rt_inline const rt_uint8_t *_rtgui_hz_bitmap_get_font_ptr(struct rtgui_font_bitm
     /* get font pixel data */
     return bmp_font->bmp + idx * font_bytes;
 }
+
+/* the perfect hash lookup is expensive, so the result is kept in the glyph
+ * cache which only refers to the font data. */
+rt_inline struct rtgui_glyph *_rtgui_hz_bitmap_get_glyph(struct rtgui_font *font,
+        rt_uint8_t *str,
+        rt_base_t font_bytes)
+{
+    rt_uint16_t cha = *(rt_uint16_t *)str;
+    struct rtgui_glyph *glyph;
+    struct rtgui_font_bitmap *bmp_font = (struct rtgui_font_bitmap *)(font->data);
+
+    glyph = rtgui_glyph_cache_get(font, cha);
+    if (glyph != RT_NULL)
+        return glyph;
+
+    glyph = rtgui_glyph_alloc(font, cha, 0);
+    if (glyph == RT_NULL)
+        return RT_NULL;
+
+    glyph->format  = RTGUI_GLYPH_MONO;
+    glyph->pitch   = (bmp_font->width + 7) / 8;
+    glyph->width   = bmp_font->width;
+    glyph->height  = bmp_font->height;
+    glyph->advance = bmp_font->width;
+    glyph->bitmap  = _rtgui_hz_bitmap_lookup(bmp_font, str, font_bytes);
+
+    return rtgui_glyph_cache_put(glyph);
+}
 #else
 rt_inline const rt_uint8_t *_rtgui_hz_bitmap_get_font_ptr(struct rtgui_font_bitmap *bmp_font,
         rt_uint8_t *str,
@@ -52,21 +81,14 @@ rt_inline const rt_uint8_t *_rtgui_hz_bitmap_get_font_ptr(struct rtgui_font_bitm
 }
 #endif
 
-static void _rtgui_hz_bitmap_font_draw_text(struct rtgui_font_bitmap *bmp_font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect)
+static void _rtgui_hz_bitmap_font_draw_text(struct rtgui_font *font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect)
 {
-    rtgui_color_t bc;
-    rt_uint16_t style;
     rt_uint8_t *str;
-    register rt_base_t h, word_bytes, font_bytes;
+    struct rtgui_font_bitmap *bmp_font = (struct rtgui_font_bitmap *)(font->data);
+    register rt_base_t word_bytes, font_bytes;
 
     RT_ASSERT(bmp_font != RT_NULL);
 
-    /* get text style */
-    style = rtgui_dc_get_gc(dc)->textstyle;
-    bc = rtgui_dc_get_gc(dc)->background;
-
-    /* drawing height */
-    h = (bmp_font->height + rect->y1 > rect->y2) ? rect->y2 - rect->y1 : bmp_font->height;
     word_bytes = (bmp_font->width + 7) / 8;
     font_bytes = word_bytes * bmp_font->height;
 
@@ -74,28 +96,26 @@ static void _rtgui_hz_bitmap_font_draw_text(struct rtgui_font_bitmap *bmp_font,
 
     while (len > 0 && rect->x1 < rect->x2)
     {
-        const rt_uint8_t *font_ptr;
-        register rt_base_t i, j, k;
+#ifdef RTGUI_USING_FONT_COMPACT
+        struct rtgui_glyph *glyph;
 
         /* get font pixel data */
-        font_ptr = _rtgui_hz_bitmap_get_font_ptr(bmp_font, str, font_bytes);
+        glyph = _rtgui_hz_bitmap_get_glyph(font, str, font_bytes);
         /* draw word */
-        for (i = 0; i < h; i ++)
+        if (glyph != RT_NULL)
         {
-            for (j = 0; j < word_bytes; j++)
-                for (k = 0; k < 8; k++)
-                {
-                    if (((font_ptr[i * word_bytes + j] >> (7 - k)) & 0x01) != 0 &&
-                            (rect->x1 + 8 * j + k < rect->x2))
-                    {
-                        rtgui_dc_draw_point(dc, rect->x1 + 8 * j + k, rect->y1 + i);
-                    }
-                    else if (style & RTGUI_TEXTSTYLE_DRAW_BACKGROUND)
-                    {
-                        rtgui_dc_draw_color_point(dc, rect->x1 + 8 * j + k, rect->y1 + i, bc);
-                    }
-                }
+            rtgui_glyph_draw(dc, glyph, rect->x1, rect->y1, rect);
+            rtgui_glyph_cache_release(glyph);
         }
+#else
+        const rt_uint8_t *font_ptr;
+
+        /* get font pixel data */
+        font_ptr = _rtgui_hz_bitmap_get_font_ptr(bmp_font, str, font_bytes);
+        /* draw word */
+        rtgui_glyph_draw_mono(dc, font_ptr, word_bytes, rect->x1, rect->y1,
+                              bmp_font->width, bmp_font->height, rect);
+#endif
 
         /* move x to next character */
         rect->x1 += bmp_font->width;
@@ -133,7 +153,7 @@ static void rtgui_hz_bitmap_font_draw_text(struct rtgui_font *font, struct rtgui
         while (((rt_uint8_t) * (text + len)) >= 0x80 && len < length) len ++;
         if (len > 0)
         {
-            _rtgui_hz_bitmap_font_draw_text(bmp_font, dc, text, len, rect);
+            _rtgui_hz_bitmap_font_draw_text(font, dc, text, len, rect);
 
             text += len;
             length -= len;
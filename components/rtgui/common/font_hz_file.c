@@ -3,7 +3,7 @@
  */
 #include <rtgui/dc.h>
 #include <rtgui/font.h>
-#include <rtgui/tree.h>
+#include <rtgui/font_cache.h>
 #include <rtgui/rtgui_system.h>
 
 #ifdef RTGUI_USING_HZ_FILE
@@ -21,9 +21,9 @@
 #include <dfs_posix.h>
 #endif
 
-#define HZ_CACHE_MAX    64
-
-static int _font_cache_compare(struct hz_cache *node1, struct hz_cache *node2);
+/* the maximal glyphs loaded in one batch and read in one file access */
+#define HZ_BATCH_MAX    16
+#define HZ_READ_MAX     8
 
 static void rtgui_hz_file_font_load(struct rtgui_font *font);
 static void rtgui_hz_file_font_draw_text(struct rtgui_font *font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect);
@@ -36,82 +36,118 @@ const struct rtgui_font_engine rtgui_hz_file_font_engine =
     rtgui_hz_file_font_get_metrics
 };
 
-SPLAY_PROTOTYPE(cache_tree, hz_cache, hz_node, _font_cache_compare);
-SPLAY_GENERATE(cache_tree, hz_cache, hz_node, _font_cache_compare);
-
-static int _font_cache_compare(struct hz_cache *cache_1, struct hz_cache *cache_2)
+rt_inline rt_uint32_t _hz_file_font_index(rt_uint16_t hz_id)
 {
-    if (cache_1->hz_id > cache_2->hz_id) return 1;
-    if (cache_1->hz_id < cache_2->hz_id) return -1;
-
-    return 0;
+    return 94 * (((hz_id & 0xff) - 0xA0) - 1) + ((hz_id >> 8) - 0xA0) - 1;
 }
 
-static rt_uint8_t *_font_cache_get(struct rtgui_hz_file_font *font, rt_uint16_t hz_id)
+rt_inline rt_uint16_t _hz_file_font_id(rt_uint32_t index)
 {
-    rt_uint32_t seek;
-    struct hz_cache *cache, search;
-
-    search.hz_id = hz_id;
+    return ((index / 94 + 1 + 0xA0) & 0xff) | ((index % 94 + 1 + 0xA0) << 8);
+}
 
-    /* enter critical */
-    rtgui_enter_critical();
+/* load the glyphs of [index, index + count) by one read. The glyph of wanted
+ * index is kept referenced in current, so it isn't evicted by the others. */
+static void _font_cache_load(struct rtgui_font *font, rt_uint32_t index,
+                             rt_uint32_t count, rt_uint8_t *buffer,
+                             rt_uint32_t wanted, struct rtgui_glyph **current)
+{
+    rt_uint32_t i;
+    struct rtgui_glyph *glyph;
+    struct rtgui_hz_file_font *hz_file_font = (struct rtgui_hz_file_font *)font->data;
 
-    cache = SPLAY_FIND(cache_tree, &(font->cache_root), &search);
-    if (cache != RT_NULL)
+    /* read hz font data */
+    if ((lseek(hz_file_font->fd, index * hz_file_font->font_data_size, SEEK_SET) < 0) ||
+            read(hz_file_font->fd, (char *)buffer, count * hz_file_font->font_data_size) !=
+            count * hz_file_font->font_data_size)
     {
-        /* exit critical */
-        rtgui_exit_critical();
+        return;
+    }
 
-        /* found it */
-        return (rt_uint8_t *)(cache + 1);
+    for (i = 0; i < count; i ++)
+    {
+        glyph = rtgui_glyph_alloc(font, _hz_file_font_id(index + i), hz_file_font->font_data_size);
+        if (glyph == RT_NULL)
+            return; /* no memory yet */
+
+        glyph->format  = RTGUI_GLYPH_MONO;
+        glyph->pitch   = (hz_file_font->font_size + 7) / 8;
+        glyph->width   = hz_file_font->font_size;
+        glyph->height  = hz_file_font->font_size;
+        glyph->advance = hz_file_font->font_size;
+        rt_memcpy((rt_uint8_t *)glyph->bitmap, buffer + i * hz_file_font->font_data_size,
+                  hz_file_font->font_data_size);
+
+        glyph = rtgui_glyph_cache_put(glyph);
+        if (index + i == wanted && *current == RT_NULL)
+            *current = glyph;
+        else
+            rtgui_glyph_cache_release(glyph);
     }
+}
 
-    /* exit critical */
-    rtgui_exit_critical();
+/* load the missed glyphs of the string into cache. The missed glyphs are
+ * sorted by the file offset, so the adjacent glyphs are read at once. It
+ * returns the referenced glyph of the first character, which should be
+ * released after used. */
+static struct rtgui_glyph *_font_cache_prefetch(struct rtgui_font *font,
+                                                const rt_uint8_t *str, rt_ubase_t len)
+{
+    rt_uint8_t *buffer;
+    struct rtgui_glyph *current = RT_NULL;
+    rt_uint32_t index, start, count, wanted;
+    rt_uint32_t missed[HZ_BATCH_MAX];
+    rt_uint32_t missed_num = 0, i, j;
+    struct rtgui_hz_file_font *hz_file_font = (struct rtgui_hz_file_font *)font->data;
+
+    wanted = _hz_file_font_index(*str | (*(str + 1) << 8));
+    while (len >= 2 && missed_num < HZ_BATCH_MAX)
+    {
+        rt_uint16_t hz_id = *str | (*(str + 1) << 8);
 
-    /* can not find it, load to cache */
-    cache = (struct hz_cache *) rtgui_malloc(sizeof(struct hz_cache) + font->font_data_size);
-    if (cache == RT_NULL)
-        return RT_NULL; /* no memory yet */
+        if (rtgui_glyph_cache_exist(font, hz_id) == RT_FALSE)
+        {
+            index = _hz_file_font_index(hz_id);
+
+            /* insert into the sorted missed list */
+            for (i = 0; i < missed_num && missed[i] < index; i ++) ;
+            if (i == missed_num || missed[i] != index)
+            {
+                for (j = missed_num; j > i; j --)
+                    missed[j] = missed[j - 1];
+                missed[i] = index;
+                missed_num ++;
+            }
+        }
 
-    cache->hz_id = hz_id;
-    seek = 94 * (((hz_id & 0xff) - 0xA0) - 1) + ((hz_id >> 8) - 0xA0) - 1;
-    seek *= font->font_data_size;
+        str += 2;
+        len -= 2;
+    }
 
-    /* read hz font data */
-    if ((lseek(font->fd, seek, SEEK_SET) < 0) ||
-            read(font->fd, (char *)(cache + 1), font->font_data_size) !=
-            font->font_data_size)
-    {
-        rtgui_free(cache);
+    if (missed_num == 0)
         return RT_NULL;
-    }
 
-    /* enter critical */
-    rtgui_enter_critical();
+    buffer = (rt_uint8_t *)rtgui_malloc(HZ_READ_MAX * hz_file_font->font_data_size);
+    if (buffer == RT_NULL)
+        return RT_NULL;
 
-    if (font->cache_size >= HZ_CACHE_MAX)
+    i = 0;
+    while (i < missed_num)
     {
-        /* remove a cache */
-        struct hz_cache *left;
-        left = font->cache_root.sph_root;
-        while (SPLAY_LEFT(left, hz_node) != RT_NULL) left = SPLAY_LEFT(left, hz_node);
-
-        /* remove the left node */
-        SPLAY_REMOVE(cache_tree, &(font->cache_root), left);
-        rtgui_free(left);
-        font->cache_size --;
+        /* find the consecutive glyphs */
+        start = missed[i];
+        count = 1;
+        while (i + count < missed_num && count < HZ_READ_MAX &&
+                missed[i + count] == start + count)
+            count ++;
+
+        _font_cache_load(font, start, count, buffer, wanted, &current);
+        i += count;
     }
 
-    /* insert to cache */
-    SPLAY_INSERT(cache_tree, &(font->cache_root), cache);
-    font->cache_size ++;
-
-    /* exit critical */
-    rtgui_exit_critical();
+    rtgui_free(buffer);
 
-    return (rt_uint8_t *)(cache + 1);
+    return current;
 }
 
 static void rtgui_hz_file_font_load(struct rtgui_font *font)
@@ -122,48 +158,33 @@ static void rtgui_hz_file_font_load(struct rtgui_font *font)
     hz_file_font->fd = open(hz_file_font->font_fn, O_RDONLY, 0);
 }
 
-static void _rtgui_hz_file_font_draw_text(struct rtgui_hz_file_font *hz_file_font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect)
+static void _rtgui_hz_file_font_draw_text(struct rtgui_font *font, struct rtgui_dc *dc, const char *text, rt_ubase_t len, struct rtgui_rect *rect)
 {
     rt_uint8_t *str;
-    rtgui_color_t bc;
-    rt_uint16_t style;
-    register rt_base_t h, word_bytes;
-
-    /* get text style */
-    style = rtgui_dc_get_gc(dc)->textstyle;
-    bc = rtgui_dc_get_gc(dc)->background;
-
-    /* drawing height */
-    h = (hz_file_font->font_size + rect->y1 > rect->y2) ?
-        rect->y2 - rect->y1 : hz_file_font->font_size;
-    word_bytes = (hz_file_font->font_size + 7) / 8;
+    struct rtgui_glyph *glyph;
+    struct rtgui_hz_file_font *hz_file_font = (struct rtgui_hz_file_font *)font->data;
 
     str = (rt_uint8_t *)text;
 
     while (len > 0 && rect->x1 < rect->x2)
     {
-        const rt_uint8_t *font_ptr;
-        register rt_base_t i, j, k;
+        rt_uint16_t hz_id = *str | (*(str + 1) << 8);
 
         /* get font pixel data */
-        font_ptr = _font_cache_get(hz_file_font, *str | (*(str + 1) << 8));
+        glyph = rtgui_glyph_cache_get(font, hz_id);
+        if (glyph == RT_NULL)
+        {
+            /* load the rest of string in batch */
+            glyph = _font_cache_prefetch(font, str, len);
+            if (glyph == RT_NULL)
+                glyph = rtgui_glyph_cache_get(font, hz_id);
+        }
 
         /* draw word */
-        for (i = 0; i < h; i ++)
+        if (glyph != RT_NULL)
         {
-            for (j = 0; j < word_bytes; j++)
-                for (k = 0; k < 8; k++)
-                {
-                    if (((font_ptr[i * word_bytes + j] >> (7 - k)) & 0x01) != 0 &&
-                            (rect->x1 + 8 * j + k < rect->x2))
-                    {
-                        rtgui_dc_draw_point(dc, rect->x1 + 8 * j + k, rect->y1 + i);
-                    }
-                    else if (style & RTGUI_TEXTSTYLE_DRAW_BACKGROUND)
-                    {
-                        rtgui_dc_draw_color_point(dc, rect->x1 + 8 * j + k, rect->y1 + i, bc);
-                    }
-                }
+            rtgui_glyph_draw(dc, glyph, rect->x1, rect->y1, rect);
+            rtgui_glyph_cache_release(glyph);
         }
 
         /* move x to next character */
@@ -203,7 +224,7 @@ static void rtgui_hz_file_font_draw_text(struct rtgui_font *font, struct rtgui_d
         while (((rt_uint8_t) * (text + len)) >= 0x80 && len < length) len ++;
         if (len > 0)
         {
-            _rtgui_hz_file_font_draw_text(hz_file_font, dc, text, len, rect);
+            _rtgui_hz_file_font_draw_text(font, dc, text, len, rect);
 
             text += len;
             length -= len;
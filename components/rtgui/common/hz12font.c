@@ -12303,8 +12303,6 @@ struct rtgui_font rtgui_font_hz12 =
 #else
 struct rtgui_hz_file_font hz12 =
 {
-    {RT_NULL},              /* cache root       */
-    0,                      /* cache size       */
     12,                     /* font size        */
     24,                     /* font data size   */
     -1,                     /* fd               */
@@ -16762,8 +16762,6 @@ struct rtgui_font rtgui_font_hz16 =
 #else
 struct rtgui_hz_file_font hz16 =
 {
-    {RT_NULL},              /* cache root       */
-    0,                      /* cache size       */
     16,                     /* font size        */
     32,                     /* font data size   */
     -1,                     /* fd               */
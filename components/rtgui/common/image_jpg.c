@@ -2,6 +2,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-01-24     onelife      add TJpgDec (Tiny JPEG Decompressor) support
+ * 2013-01-14     Bernard      blit jpeg to dc line by line and add scaled decoding
  */
 #include <rtthread.h>
 #include <rtgui/rtgui.h>
@@ -13,6 +14,7 @@
 
 #include <rtgui/rtgui_system.h>
 #include <rtgui/filerw.h>
+#include <rtgui/driver.h>
 #include <rtgui/image_jpeg.h>
 
 #ifdef RTGUI_USING_DFS_FILERW
@@ -32,6 +34,9 @@ struct rtgui_jpeg_error_mgr
 struct rtgui_image_jpeg
 {
     rt_bool_t is_loaded;
+    rt_bool_t is_started;
+    /* the output is scaled by 1/(2^scale) */
+    rt_uint8_t scale;
 
     struct rtgui_filerw *filerw;
 
@@ -40,7 +45,6 @@ struct rtgui_image_jpeg
     struct rtgui_jpeg_error_mgr errmgr;
 
     rt_uint8_t *pixels;
-    rt_uint8_t *line_pixels;
 };
 
 struct rtgui_image_engine rtgui_image_jpeg_engine =
@@ -185,51 +189,34 @@ static void rtgui_jpeg_filerw_src_init(j_decompress_ptr cinfo, struct rtgui_file
     src->pub.next_input_byte = NULL; /* until buffer loaded */
 }
 
-/* get line data of a jpeg image */
-static rt_uint8_t *rtgui_image_get_line(struct rtgui_image *image, int h)
+/* start decompression from the beginning of file */
+static rt_bool_t rtgui_image_jpeg_start(struct rtgui_image_jpeg *jpeg)
 {
-    struct rtgui_image_jpeg *jpeg;
-    rt_uint8_t *result_ptr;
-
-    JSAMPARRAY buffer;      /* Output row buffer */
-    int row_stride;
-
-    RT_ASSERT(image != RT_NULL);
-    jpeg = (struct rtgui_image_jpeg *) image->data;
-    RT_ASSERT(jpeg != RT_NULL);
-
-    if (h < 0 || h > image->h) return RT_NULL;
-
-    /* if the image is loaded, */
-    if (jpeg->is_loaded == RT_TRUE)
+    if (jpeg->is_started == RT_TRUE)
     {
-        result_ptr = jpeg->pixels + (image->w * sizeof(rtgui_color_t)) * h;
-
-        return result_ptr;
+        jpeg_abort_decompress(&jpeg->cinfo);
+        jpeg->is_started = RT_FALSE;
     }
 
-    if (jpeg->line_pixels == RT_NULL)
-        jpeg->line_pixels = rtgui_malloc(image->w * sizeof(rtgui_color_t));
-
-    row_stride = jpeg->cinfo.output_width * jpeg->cinfo.output_components;
-    buffer = (*jpeg->cinfo.mem->alloc_sarray)
-             ((j_common_ptr) &jpeg->cinfo, JPOOL_IMAGE, row_stride, 1);
-
-    /* decompress line data */
-    jpeg->cinfo.output_scanline = h;
-    jpeg_read_scanlines(&jpeg->cinfo, buffer, (JDIMENSION) 1);
+    rtgui_filerw_seek(jpeg->filerw, 0, RTGUI_FILE_SEEK_SET);
+    rtgui_jpeg_filerw_src_init(&jpeg->cinfo, jpeg->filerw);
+    if (jpeg_read_header(&jpeg->cinfo, TRUE) != JPEG_HEADER_OK)
+        return RT_FALSE;
 
-    /* copy pixels memory */
-    {
-        int index;
-        rtgui_color_t *ptr;
+    /* the parameters must be set before start decompress */
+    jpeg->cinfo.out_color_space = JCS_RGB;
+    jpeg->cinfo.quantize_colors = FALSE;
+    /* use fast jpeg */
+    jpeg->cinfo.scale_num   = 1;
+    jpeg->cinfo.scale_denom = 1 << jpeg->scale;
+    jpeg->cinfo.dct_method = JDCT_FASTEST;
+    jpeg->cinfo.do_fancy_upsampling = FALSE;
 
-        ptr = (rtgui_color_t *)jpeg->line_pixels;
-        for (index = 0; index < image->w; index ++)
-            ptr[index] = RTGUI_ARGB(0, buffer[0][index * 3], buffer[0][index * 3 + 1], buffer[0][index * 3 + 2]);
-    }
+    if (jpeg_start_decompress(&jpeg->cinfo) != TRUE)
+        return RT_FALSE;
 
-    return jpeg->line_pixels;
+    jpeg->is_started = RT_TRUE;
+    return RT_TRUE;
 }
 
 static rt_bool_t rtgui_image_jpeg_loadall(struct rtgui_image *image)
@@ -249,8 +236,13 @@ static rt_bool_t rtgui_image_jpeg_loadall(struct rtgui_image *image)
     jpeg->pixels = rtgui_malloc(image->h * image->w * sizeof(rtgui_color_t));
     if (jpeg->pixels == RT_NULL) return RT_FALSE;
 
-    /* reset scan line to zero */
-    jpeg->cinfo.output_scanline = 0;
+    /* decompress from the first scan line */
+    if (jpeg->cinfo.output_scanline != 0 && rtgui_image_jpeg_start(jpeg) != RT_TRUE)
+    {
+        rtgui_free(jpeg->pixels);
+        jpeg->pixels = RT_NULL;
+        return RT_FALSE;
+    }
     line_ptr = jpeg->pixels;
 
     row_stride = jpeg->cinfo.output_width * jpeg->cinfo.output_components;
@@ -273,7 +265,7 @@ static rt_bool_t rtgui_image_jpeg_loadall(struct rtgui_image *image)
 
             ptr = (rtgui_color_t *)line_ptr;
             for (index = 0; index < image->w; index ++)
-                ptr[index] = RTGUI_ARGB(0, buffer[0][index * 3], buffer[0][index * 3 + 1], buffer[0][index * 3 + 2]);
+                ptr[index] = RTGUI_RGB(buffer[0][index * 3], buffer[0][index * 3 + 1], buffer[0][index * 3 + 2]);
         }
 
         /* move to next line */
@@ -281,13 +273,45 @@ static rt_bool_t rtgui_image_jpeg_loadall(struct rtgui_image *image)
     }
 
     /* decompress done */
-    rtgui_filerw_close(jpeg->filerw);
     jpeg_finish_decompress(&jpeg->cinfo);
+    jpeg->is_started = RT_FALSE;
+    rtgui_filerw_close(jpeg->filerw);
 
     jpeg->is_loaded = RT_TRUE;
     return RT_TRUE;
 }
 
+/* convert RGB888 samples to the pixel format of graphic device */
+static rt_bool_t rtgui_image_jpeg_convert_line(rt_uint8_t *dst, const rt_uint8_t *src, int count)
+{
+    struct rtgui_graphic_driver *hwdev = rtgui_graphic_get_device();
+    int index;
+
+    switch (hwdev->pixel_format)
+    {
+    case RTGRAPHIC_PIXEL_FORMAT_RGB565:
+        for (index = 0; index < count; index ++, src += 3)
+            ((rt_uint16_t *)dst)[index] = rtgui_color_to_565(RTGUI_RGB(src[0], src[1], src[2]));
+        break;
+
+    case RTGRAPHIC_PIXEL_FORMAT_RGB565P:
+        for (index = 0; index < count; index ++, src += 3)
+            ((rt_uint16_t *)dst)[index] = rtgui_color_to_565p(RTGUI_RGB(src[0], src[1], src[2]));
+        break;
+
+    case RTGRAPHIC_PIXEL_FORMAT_RGB888:
+    case RTGRAPHIC_PIXEL_FORMAT_ARGB888:
+        for (index = 0; index < count; index ++, src += 3)
+            ((rt_uint32_t *)dst)[index] = rtgui_color_to_888(RTGUI_RGB(src[0], src[1], src[2]));
+        break;
+
+    default:
+        return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+
 void rtgui_image_jpeg_init()
 {
     /* register jpeg on image system */
@@ -313,55 +337,59 @@ static rt_bool_t rtgui_image_jpeg_load(struct rtgui_image *image, struct rtgui_f
     if (jpeg == RT_NULL) return RT_FALSE;
 
     jpeg->filerw = file;
+    jpeg->pixels = RT_NULL;
+    jpeg->is_loaded = RT_FALSE;
+    jpeg->is_started = RT_FALSE;
+    jpeg->scale = 0;
 
-    /* read file header */
     /* Create a decompression structure and load the JPEG header */
     jpeg->cinfo.err = jpeg_std_error(&jpeg->errmgr.pub);
     jpeg->errmgr.pub.error_exit = my_error_exit;
     jpeg->errmgr.pub.output_message = output_no_message;
 
     jpeg_create_decompress(&jpeg->cinfo);
-    rtgui_jpeg_filerw_src_init(&jpeg->cinfo, jpeg->filerw);
-    (void)jpeg_read_header(&jpeg->cinfo, TRUE);
+    if (rtgui_image_jpeg_start(jpeg) != RT_TRUE)
+    {
+        jpeg_destroy_decompress(&jpeg->cinfo);
+        rtgui_free(jpeg);
 
-    image->w = jpeg->cinfo.image_width;
-    image->h = jpeg->cinfo.image_height;
+        return RT_FALSE;
+    }
+
+    image->w = jpeg->cinfo.output_width;
+    image->h = jpeg->cinfo.output_height;
 
     /* set image private data and engine */
     image->data = jpeg;
     image->engine = &rtgui_image_jpeg_engine;
 
-    /* start decompression */
-    (void) jpeg_start_decompress(&jpeg->cinfo);
+    if (load == RT_TRUE) rtgui_image_jpeg_loadall(image);
 
-    jpeg->cinfo.out_color_space = JCS_RGB;
-    jpeg->cinfo.quantize_colors = FALSE;
-    /* use fast jpeg */
-    jpeg->cinfo.scale_num   = 1;
-    jpeg->cinfo.scale_denom = 1;
-    jpeg->cinfo.dct_method = JDCT_FASTEST;
-    jpeg->cinfo.do_fancy_upsampling = FALSE;
+    /* create jpeg image successful */
+    return RT_TRUE;
+}
 
-    jpeg->pixels = RT_NULL;
-    jpeg->is_loaded = RT_FALSE;
+rt_err_t rtgui_image_jpeg_set_scale(struct rtgui_image *image, rt_uint8_t scale)
+{
+    struct rtgui_image_jpeg *jpeg;
 
-    /* allocate line pixels */
-    jpeg->line_pixels = rtgui_malloc(image->w * sizeof(rtgui_color_t));
-    if (jpeg->line_pixels == RT_NULL)
-    {
-        /* no memory */
-        jpeg_finish_decompress(&jpeg->cinfo);
-        rt_free(jpeg);
+    RT_ASSERT(image != RT_NULL);
+    jpeg = (struct rtgui_image_jpeg *) image->data;
+    RT_ASSERT(jpeg != RT_NULL);
 
-        return RT_FALSE;
-    }
+    /* the pixels of a loaded image are not scaled again */
+    if (jpeg->is_loaded == RT_TRUE || scale > RTGUI_IMAGE_JPEG_SCALE_MAX)
+        return -RT_ERROR;
 
-    if (load == RT_TRUE) rtgui_image_jpeg_loadall(image);
+    jpeg->scale = scale;
+    if (rtgui_image_jpeg_start(jpeg) != RT_TRUE)
+        return -RT_ERROR;
 
-    /* create jpeg image successful */
-    return RT_TRUE;
-}
+    image->w = jpeg->cinfo.output_width;
+    image->h = jpeg->cinfo.output_height;
 
+    return RT_EOK;
+}
 
 static void rtgui_image_jpeg_unload(struct rtgui_image *image)
 {
@@ -374,21 +402,21 @@ static void rtgui_image_jpeg_unload(struct rtgui_image *image)
 
         if (jpeg->is_loaded == RT_TRUE)
             rtgui_free(jpeg->pixels);
-        if (jpeg->line_pixels != RT_NULL) rtgui_free(jpeg->line_pixels);
-
-        if (jpeg->is_loaded != RT_TRUE)
-        {
+        else
             rtgui_filerw_close(jpeg->filerw);
-            jpeg_finish_decompress(&jpeg->cinfo);
-        }
-        rt_free(jpeg);
+
+        /* release all the memory of decompression */
+        jpeg_destroy_decompress(&jpeg->cinfo);
+        rtgui_free(jpeg);
     }
 }
 
 static void rtgui_image_jpeg_blit(struct rtgui_image *image, struct rtgui_dc *dc, struct rtgui_rect *rect)
 {
-    rt_uint16_t x, y;
+    rt_uint16_t x, y, w, h;
+    int y1, y2;
     rtgui_color_t *ptr;
+    struct rtgui_rect dc_rect;
     struct rtgui_image_jpeg *jpeg;
 
     RT_ASSERT(image != RT_NULL && dc != RT_NULL && rect != RT_NULL);
@@ -396,20 +424,27 @@ static void rtgui_image_jpeg_blit(struct rtgui_image *image, struct rtgui_dc *dc
     jpeg = (struct rtgui_image_jpeg *) image->data;
     RT_ASSERT(jpeg != RT_NULL);
 
+    if (rtgui_dc_get_visible(dc) != RT_TRUE) return;
+
+    w = image->w < rtgui_rect_width(*rect) ? image->w : rtgui_rect_width(*rect);
+    h = image->h < rtgui_rect_height(*rect) ? image->h : rtgui_rect_height(*rect);
+
+    /* only the rows inside of dc are drawn */
+    rtgui_dc_get_rect(dc, &dc_rect);
+    y1 = dc_rect.y1 - rect->y1;
+    if (y1 < 0) y1 = 0;
+    y2 = dc_rect.y2 - rect->y1;
+    if (y2 > h) y2 = h;
+
     if (jpeg->pixels != RT_NULL)
     {
-        ptr = (rtgui_color_t *) jpeg->pixels;
-
         /* draw each point within dc */
-        for (y = 0; y < image->h; y ++)
+        for (y = y1; y < y2; y ++)
         {
-            for (x = 0; x < image->w; x++)
+            ptr = (rtgui_color_t *) jpeg->pixels + y * image->w;
+            for (x = 0; x < w; x++)
             {
-                /* not alpha */
-                if ((*ptr >> 24) != 255)
-                {
-                    rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1, *ptr);
-                }
+                rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1, *ptr);
 
                 /* move to next color buffer */
                 ptr ++;
@@ -418,25 +453,47 @@ static void rtgui_image_jpeg_blit(struct rtgui_image *image, struct rtgui_dc *dc
     }
     else
     {
-        /* seek to the begin of file */
-        rtgui_filerw_seek(jpeg->filerw, 0, RTGUI_FILE_SEEK_SET);
+        JSAMPARRAY buffer;
+        rt_uint8_t *line;
+
+        /*
+         * Decode the image scan line by scan line and blit it to dc directly,
+         * so only a scan line of jpeg and a line of device pixel are used.
+         * The decompression stops at the last visible line.
+         */
+        if (jpeg->cinfo.output_scanline != 0 || jpeg->is_started != RT_TRUE)
+        {
+            if (rtgui_image_jpeg_start(jpeg) != RT_TRUE) return;
+        }
+
+        buffer = (*jpeg->cinfo.mem->alloc_sarray)
+                 ((j_common_ptr) &jpeg->cinfo, JPOOL_IMAGE,
+                  jpeg->cinfo.output_width * jpeg->cinfo.output_components, 1);
+        line = (rt_uint8_t *) rtgui_malloc(w * sizeof(rtgui_color_t));
+        if (line == RT_NULL) return;
 
-        /* decompress line and line */
-        for (y = 0; y < image->h; y ++)
+        for (y = 0; y < y2; y ++)
         {
-            ptr = (rtgui_color_t *)rtgui_image_get_line(image, y);
-            for (x = 0; x < image->w; x++)
+            (void) jpeg_read_scanlines(&jpeg->cinfo, buffer, 1);
+            if (y < y1) continue;
+
+            if (rtgui_image_jpeg_convert_line(line, buffer[0], w) == RT_TRUE)
+            {
+                dc->engine->blit_line(dc, rect->x1, rect->x1 + w, rect->y1 + y, line);
+            }
+            else
             {
-                /* not alpha */
-                if ((*ptr >> 24) != 255)
+                for (x = 0; x < w; x++)
                 {
-                    rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1, *ptr);
+                    rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1,
+                                              RTGUI_RGB(buffer[0][x * 3],
+                                                        buffer[0][x * 3 + 1],
+                                                        buffer[0][x * 3 + 2]));
                 }
-
-                /* move to next color buffer */
-                ptr ++;
             }
         }
+
+        rtgui_free(line);
     }
 }
 
@@ -536,6 +593,7 @@ static rt_bool_t rtgui_image_jpeg_check(struct rtgui_filerw *file)
  * @section Change Logs
  * Date         Author      Notes
  * 2012-01-24   onelife     Initial creation for limited memory devices
+ * 2013-01-14   Bernard     only decode the visible blocks and add scaled decoding
  ******************************************************************************/
 
 /***************************************************************************//**
@@ -561,7 +619,7 @@ struct rtgui_image_jpeg
     struct rtgui_filerw *filerw;
     struct rtgui_dc *dc;
     rt_uint16_t dst_x, dst_y;
-    rt_uint16_t dst_w, dst_h;
+    struct rtgui_rect clip;         /* visible area in image coordinate */
     rt_bool_t is_loaded;
     rt_bool_t to_buffer;
     rt_uint8_t scale;
@@ -574,7 +632,7 @@ struct rtgui_image_jpeg
 /* Private define ------------------------------------------------------------*/
 #define TJPGD_WORKING_BUFFER_SIZE   (3100)
 #define TJPGD_MAX_MCU_WIDTH_ON_DISP (2 * 8 * 4)     /* Y component: 2x2; Display: 4-byte per pixel */
-#define TJPGD_MAX_SCALING_FACTOR    (3)
+#define TJPGD_MAX_SCALING_FACTOR    RTGUI_IMAGE_JPEG_SCALE_MAX
 #define hw_driver                   (rtgui_graphic_driver_get_default())
 
 /* Private macro -------------------------------------------------------------*/
@@ -663,19 +721,25 @@ static UINT tjpgd_out_func(JDEC *jdec, void *bitmap, JRECT *rect)
     else
     {
         rtgui_blit_line_func blit_line = RT_NULL;
+        rt_int16_t x1, x2, y1, y2;
 
-        /* we decompress from top to bottom if the block is beyond the right
-         * boundary, just continue to next block. However, if the block is
-         * beyond the bottom boundary, we don't need to decompress the rest. */
-        if (rect->left > jpeg->dst_w)
-            return 1;
-        if (rect->top  > jpeg->dst_h)
+        /* we decompress from top to bottom. If the block is out of the
+         * visible area, just continue to next block. However, if the block
+         * is beyond the bottom boundary, we don't need to decompress the
+         * rest. */
+        if (rect->top >= jpeg->clip.y2)
             return 0;
+        if (rect->bottom < jpeg->clip.y1 ||
+            rect->left >= jpeg->clip.x2 || rect->right < jpeg->clip.x1)
+            return 1;
+
+        x1 = rect->left > jpeg->clip.x1 ? rect->left : jpeg->clip.x1;
+        x2 = rect->right + 1 < jpeg->clip.x2 ? rect->right + 1 : jpeg->clip.x2;
+        y1 = rect->top > jpeg->clip.y1 ? rect->top : jpeg->clip.y1;
+        y2 = rect->bottom + 1 < jpeg->clip.y2 ? rect->bottom + 1 : jpeg->clip.y2;
+        w = x2 - x1;
+        src += (y1 - rect->top) * rectWidth + (x1 - rect->left) * jpeg->byte_per_pixel;
 
-        w = rect->right < jpeg->dst_w ? rect->right : jpeg->dst_w;
-        w = w - rect->left + 1;
-        h = rect->bottom < jpeg->dst_h ? rect->bottom : jpeg->dst_h;
-        h = h - rect->top + 1;
         if (jpeg->byte_per_pixel == hw_driver->bits_per_pixel / 8)
         {
             if (hw_driver->pixel_format == RTGRAPHIC_PIXEL_FORMAT_RGB565)
@@ -692,23 +756,23 @@ static UINT tjpgd_out_func(JDEC *jdec, void *bitmap, JRECT *rect)
         {
             rt_uint8_t line_buf[TJPGD_MAX_MCU_WIDTH_ON_DISP];
 
-            for (y = 0; y < h; y++)
+            for (y = y1; y < y2; y++)
             {
                 blit_line(line_buf, src, w * jpeg->byte_per_pixel);
                 jpeg->dc->engine->blit_line(jpeg->dc,
-                                            jpeg->dst_x + rect->left, jpeg->dst_x + rect->left + w,
-                                            jpeg->dst_y + rect->top + y,
+                                            jpeg->dst_x + x1, jpeg->dst_x + x2,
+                                            jpeg->dst_y + y,
                                             line_buf);
                 src += rectWidth;
             }
         }
         else
         {
-            for (y = 0; y < h; y++)
+            for (y = y1; y < y2; y++)
             {
                 jpeg->dc->engine->blit_line(jpeg->dc,
-                                            jpeg->dst_x + rect->left, jpeg->dst_x + rect->left + w,
-                                            jpeg->dst_y + rect->top + y,
+                                            jpeg->dst_x + x1, jpeg->dst_x + x2,
+                                            jpeg->dst_y + y,
                                             src);
                 src += rectWidth;
             }
@@ -866,6 +930,26 @@ static rt_bool_t rtgui_image_jpeg_load(struct rtgui_image *image, struct rtgui_f
     return res;
 }
 
+rt_err_t rtgui_image_jpeg_set_scale(struct rtgui_image *image, rt_uint8_t scale)
+{
+    struct rtgui_image_jpeg *jpeg;
+
+    RT_ASSERT(image != RT_NULL);
+    jpeg = (struct rtgui_image_jpeg *) image->data;
+    RT_ASSERT(jpeg != RT_NULL);
+
+    /* the pixels of a loaded image are not scaled again */
+    if (jpeg->to_buffer == RT_TRUE || scale > TJPGD_MAX_SCALING_FACTOR)
+    {
+        return -RT_ERROR;
+    }
+
+    jpeg->scale = scale;
+    image->w = (rt_uint16_t)jpeg->tjpgd.width >> jpeg->scale;
+    image->h = (rt_uint16_t)jpeg->tjpgd.height >> jpeg->scale;
+
+    return RT_EOK;
+}
 
 static void rtgui_image_jpeg_unload(struct rtgui_image *image)
 {
@@ -938,16 +1022,39 @@ static void rtgui_image_jpeg_blit(struct rtgui_image *image,
         if (!jpeg->is_loaded)
         {
             JRESULT ret;
+            struct rtgui_rect dc_rect;
 
+            /* only the blocks inside of dc and destination rect are output */
+            rtgui_dc_get_rect(dc, &dc_rect);
             jpeg->dst_x = dst_rect->x1;
             jpeg->dst_y = dst_rect->y1;
-            jpeg->dst_w = w;
-            jpeg->dst_h = h;
-            ret = jd_decomp(&jpeg->tjpgd, tjpgd_out_func, jpeg->scale);
+            jpeg->clip.x1 = dc_rect.x1 > dst_rect->x1 ? dc_rect.x1 - dst_rect->x1 : 0;
+            jpeg->clip.y1 = dc_rect.y1 > dst_rect->y1 ? dc_rect.y1 - dst_rect->y1 : 0;
+            jpeg->clip.x2 = dc_rect.x2 - dst_rect->x1 < w ? dc_rect.x2 - dst_rect->x1 : w;
+            jpeg->clip.y2 = dc_rect.y2 - dst_rect->y1 < h ? dc_rect.y2 - dst_rect->y1 : h;
+            if (jpeg->clip.x1 >= jpeg->clip.x2 || jpeg->clip.y1 >= jpeg->clip.y2)
+            {
+                break;
+            }
+
+            /* the stream is consumed by last decompression, prepare again */
+            if (rtgui_filerw_seek(jpeg->filerw, 0, RTGUI_FILE_SEEK_SET) == -1)
+            {
+                break;
+            }
+            ret = jd_prepare(&jpeg->tjpgd, tjpgd_in_func, jpeg->pool,
+                             TJPGD_WORKING_BUFFER_SIZE, (void *)jpeg);
             if (ret != JDR_OK)
             {
                 break;
             }
+
+            /* the decompression is interrupted after the last visible block */
+            ret = jd_decomp(&jpeg->tjpgd, tjpgd_out_func, jpeg->scale);
+            if (ret != JDR_OK && ret != JDR_INTR)
+            {
+                break;
+            }
 #ifdef RTGUI_DEBUG_TJPGD
             rt_kprintf("TJPGD: load to display\n");
 #endif
@@ -17,6 +17,9 @@ struct rtgui_image_png
     png_structp png_ptr;
     png_infop info_ptr;
 
+    /* the next row to be decoded in stream mode */
+    rt_uint32_t row_index;
+
     rt_uint8_t *pixels;
 };
 
@@ -44,64 +47,139 @@ static void rtgui_image_png_read_data(png_structp png_ptr, png_bytep data, png_s
     rtgui_filerw_read(filerw, data, length, 1);
 }
 
-static rt_bool_t rtgui_image_png_process(png_structp png_ptr, png_infop info_ptr, struct rtgui_image_png *png)
+static void rtgui_image_png_destroy(struct rtgui_image_png *png)
 {
-    rt_uint32_t x, y;
-    png_bytep row;
-    png_bytep data;
-    rtgui_color_t *ptr;
+    /* destroy png struct */
+    png_destroy_info_struct(png->png_ptr, &png->info_ptr);
+    png_destroy_read_struct(&png->png_ptr, RT_NULL, RT_NULL);
+}
 
-    row = (png_bytep) rtgui_malloc(png_get_rowbytes(png_ptr, info_ptr));
-    if (row == RT_NULL) return RT_FALSE;
+/* read png header from the beginning of file and set the transformations, so
+ * each row is decoded as RGB or RGBA in 8 bits. */
+static rt_bool_t rtgui_image_png_prepare(struct rtgui_image_png *png)
+{
+    png_uint_32 width;
+    png_uint_32 height;
+    int bit_depth;
+    int color_type;
+    double gamma;
 
-    ptr = (rtgui_color_t *)png->pixels;
+    png->png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (png->png_ptr == RT_NULL)
+        return RT_FALSE;
 
-    switch (info_ptr->color_type)
+    png->info_ptr = png_create_info_struct(png->png_ptr);
+    if (png->info_ptr == RT_NULL)
     {
-    case PNG_COLOR_TYPE_RGB:
-        for (y = 0; y < info_ptr->height; y++)
-        {
-            png_read_row(png_ptr, row, png_bytep_NULL);
-            for (x = 0; x < info_ptr->width; x++)
-            {
-                data = &(row[x * 3]);
+        png_destroy_read_struct(&png->png_ptr, NULL, NULL);
+        return RT_FALSE;
+    }
 
-                ptr[x + y * info_ptr->width] = RTGUI_RGB(data[0], data[1], data[2]);
-            }
-        }
-        break;
+    rtgui_filerw_seek(png->filerw, 0, RTGUI_FILE_SEEK_SET);
+    png_set_read_fn(png->png_ptr, png->filerw, rtgui_image_png_read_data);
 
-    case PNG_COLOR_TYPE_RGBA:
-        for (y = 0; y < info_ptr->height; y++)
-        {
-            png_read_row(png_ptr, row, png_bytep_NULL);
-            for (x = 0; x < info_ptr->width; x++)
-            {
-                data = &(row[x * 4]);
+    png_read_info(png->png_ptr, png->info_ptr);
+    png_get_IHDR(png->png_ptr, png->info_ptr, &width, &height, &bit_depth,
+                 &color_type, NULL, NULL, NULL);
 
-                ptr[x + y * info_ptr->width] = RTGUI_ARGB((255 - data[3]), data[0], data[1], data[2]);
-            }
-        }
+    if (bit_depth == 16)
+        png_set_strip_16(png->png_ptr);
+    if (color_type == PNG_COLOR_TYPE_PALETTE)
+        png_set_expand(png->png_ptr);
+    if (bit_depth < 8)
+        png_set_expand(png->png_ptr);
+    if (png_get_valid(png->png_ptr, png->info_ptr, PNG_INFO_tRNS))
+        png_set_expand(png->png_ptr);
+    if (color_type == PNG_COLOR_TYPE_GRAY ||
+            color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+        png_set_gray_to_rgb(png->png_ptr);
 
-        break;
+    /* Ignore background color */
 
-    case PNG_COLOR_TYPE_PALETTE:
-        for (y = 0; y < info_ptr->height; y++)
+    /* set gamma conversion */
+    if (png_get_gAMA(png->png_ptr, png->info_ptr, &gamma))
+        png_set_gamma(png->png_ptr, (double)2.2, gamma);
+
+    png_read_update_info(png->png_ptr, png->info_ptr);
+    png->row_index = 0;
+
+    return RT_TRUE;
+}
+
+/* decode next row of png into color line */
+static void rtgui_image_png_read_line(struct rtgui_image_png *png, png_bytep row,
+                                      rtgui_color_t *line, rt_uint32_t width)
+{
+    rt_uint32_t x;
+    png_bytep data;
+
+    png_read_row(png->png_ptr, row, png_bytep_NULL);
+    png->row_index ++;
+
+    /* after transformation, there is only RGB or RGBA format */
+    if (png_get_channels(png->png_ptr, png->info_ptr) == 4)
+    {
+        for (x = 0, data = row; x < width; x++, data += 4)
+            line[x] = RTGUI_ARGB(data[3], data[0], data[1], data[2]);
+    }
+    else
+    {
+        for (x = 0, data = row; x < width; x++, data += 3)
+            line[x] = RTGUI_RGB(data[0], data[1], data[2]);
+    }
+}
+
+/* draw a line of color on (x, y) of dc and composite with the background */
+static void rtgui_image_png_draw_line(struct rtgui_dc *dc, rtgui_color_t *line,
+                                      int x, int y, int w, int bc[3])
+{
+    int index;
+    int ialpha;
+    rtgui_color_t c;
+
+    for (index = 0; index < w; index ++)
+    {
+        c = line[index];
+        ialpha = RTGUI_RGB_A(c);
+        if (ialpha == 0)
+        {
+            /*
+             * Foreground image is transparent hear.
+             * If the background image is already in the frame
+             * buffer, there is nothing to do.
+             */
+        }
+        else if (ialpha == 255)
         {
-            png_read_row(png_ptr, row, png_bytep_NULL);
-            for (x = 0; x < info_ptr->width; x++)
-            {
-                data = &(row[x]);
-
-                ptr[x] = RTGUI_ARGB(0, info_ptr->palette[data[0]].red,
-                                    info_ptr->palette[data[0]].green,
-                                    info_ptr->palette[data[0]].blue);
-            }
+            /*
+             * Copy foreground pixel to frame buffer.
+             */
+            rtgui_dc_draw_color_point(dc, x + index, y, c);
         }
+        else
+        {
+            /* output = alpha * foreground + (1-alpha) * background */
+            c = RTGUI_RGB((RTGUI_RGB_R(c) * ialpha + bc[0] * (255 - ialpha)) / 255,
+                          (RTGUI_RGB_G(c) * ialpha + bc[1] * (255 - ialpha)) / 255,
+                          (RTGUI_RGB_B(c) * ialpha + bc[2] * (255 - ialpha)) / 255);
+            rtgui_dc_draw_color_point(dc, x + index, y, c);
+        }
+    }
+}
 
-    default:
-        break;
-    };
+static rt_bool_t rtgui_image_png_process(struct rtgui_image *image, struct rtgui_image_png *png)
+{
+    rt_uint32_t y;
+    png_bytep row;
+
+    row = (png_bytep) rtgui_malloc(png_get_rowbytes(png->png_ptr, png->info_ptr));
+    if (row == RT_NULL) return RT_FALSE;
+
+    for (y = 0; y < image->h; y++)
+    {
+        rtgui_image_png_read_line(png, row,
+                                  (rtgui_color_t *)png->pixels + y * image->w, image->w);
+    }
 
     rtgui_free(row);
 
@@ -139,84 +217,42 @@ static rt_bool_t rtgui_image_png_check(struct rtgui_filerw *file)
 
 static rt_bool_t rtgui_image_png_load(struct rtgui_image *image, struct rtgui_filerw *file, rt_bool_t load)
 {
-    png_uint_32 width;
-    png_uint_32 height;
-    int bit_depth;
-    int color_type;
-    double gamma;
     struct rtgui_image_png *png;
 
     png = (struct rtgui_image_png *) rtgui_malloc(sizeof(struct rtgui_image_png));
-    png->png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (png->png_ptr == RT_NULL)
-    {
-        rtgui_free(png);
+    if (png == RT_NULL)
         return RT_FALSE;
-    }
 
-    png->info_ptr = png_create_info_struct(png->png_ptr);
-    if (png->info_ptr == RT_NULL)
+    png->filerw = file;
+    png->pixels = RT_NULL;
+    png->is_loaded = RT_FALSE;
+    if (rtgui_image_png_prepare(png) != RT_TRUE)
     {
-        png_destroy_read_struct(&png->png_ptr, NULL, NULL);
         rtgui_free(png);
         return RT_FALSE;
     }
 
-    png->filerw = file;
-    png_set_read_fn(png->png_ptr, png->filerw, rtgui_image_png_read_data);
-
-    png_read_info(png->png_ptr, png->info_ptr);
-    png_get_IHDR(png->png_ptr, png->info_ptr, &width, &height, &bit_depth,
-                 &color_type, NULL, NULL, NULL);
-
     /* set image information */
-    image->w = width;
-    image->h = height;
+    image->w = png_get_image_width(png->png_ptr, png->info_ptr);
+    image->h = png_get_image_height(png->png_ptr, png->info_ptr);
     image->engine = &rtgui_image_png_engine;
     image->data = png;
 
-    if (bit_depth == 16)
-        png_set_strip_16(png->png_ptr);
-    if (color_type == PNG_COLOR_TYPE_PALETTE)
-        png_set_expand(png->png_ptr);
-    if (bit_depth < 8)
-        png_set_expand(png->png_ptr);
-    if (png_get_valid(png->png_ptr, png->info_ptr, PNG_INFO_tRNS))
-        png_set_expand(png->png_ptr);
-    if (color_type == PNG_COLOR_TYPE_GRAY ||
-            color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
-        png_set_gray_to_rgb(png->png_ptr);
-
-    /* Ignore background color */
-
-    /* set gamma conversion */
-    if (png_get_gAMA(png->png_ptr, png->info_ptr, &gamma))
-        png_set_gamma(png->png_ptr, (double)2.2, gamma);
-
-    png_read_update_info(png->png_ptr, png->info_ptr);
-
     if (load == RT_TRUE)
     {
         /* load all pixels */
         png->pixels = rtgui_malloc(image->w * image->h * sizeof(rtgui_color_t));
         if (png->pixels == RT_NULL)
         {
-            png_read_end(png->png_ptr, RT_NULL);
-
-            /* destroy png struct */
-            png_destroy_info_struct(png->png_ptr, &png->info_ptr);
-            png_destroy_read_struct(&png->png_ptr, RT_NULL, RT_NULL);
+            rtgui_image_png_destroy(png);
 
             /* release data */
             rtgui_free(png);
             return RT_FALSE;
         }
 
-        rtgui_image_png_process(png->png_ptr, png->info_ptr, png);
-    }
-    else
-    {
-        png->pixels = RT_NULL;
+        rtgui_image_png_process(image, png);
+        png->is_loaded = RT_TRUE;
     }
 
     return RT_TRUE;
@@ -230,11 +266,7 @@ static void rtgui_image_png_unload(struct rtgui_image *image)
     {
         png = (struct rtgui_image_png *) image->data;
 
-        png_read_end(png->png_ptr, RT_NULL);
-
-        /* destroy png struct */
-        png_destroy_info_struct(png->png_ptr, &png->info_ptr);
-        png_destroy_read_struct(&png->png_ptr, RT_NULL, RT_NULL);
+        rtgui_image_png_destroy(png);
 
         if (png->pixels != RT_NULL) rtgui_free(png->pixels);
 
@@ -245,128 +277,83 @@ static void rtgui_image_png_unload(struct rtgui_image *image)
 
 static void rtgui_image_png_blit(struct rtgui_image *image, struct rtgui_dc *dc, struct rtgui_rect *rect)
 {
-    struct rtgui_graphic_driver *hwdev = rtgui_graphic_get_device();
-    rt_uint16_t x, y, w, h;
-    rtgui_color_t *ptr;
+    rt_uint16_t y, w, h;
     struct rtgui_image_png *png;
-    int fg_maxsample;
-    int ialpha;
-    float alpha;
-    rtgui_color_t color;
-    rtgui_color_t c, bgcolor;
-    int fc[3], bc[3];
+    struct rtgui_rect dc_rect;
+    rtgui_color_t bgcolor;
+    int y1, y2;
+    int bc[3];
 
     RT_ASSERT(image != RT_NULL && dc != RT_NULL && rect != RT_NULL);
     RT_ASSERT(image->data != RT_NULL);
 
     png = (struct rtgui_image_png *) image->data;
 
+    if (rtgui_dc_get_visible(dc) != RT_TRUE) return;
+
     if (image->w < rtgui_rect_width(*rect)) w = image->w;
     else w = rtgui_rect_width(*rect);
     if (image->h < rtgui_rect_height(*rect)) h = image->h;
     else h = rtgui_rect_height(*rect);
 
-    fg_maxsample = (1 << png->info_ptr->bit_depth) - 1;
+    /* only the rows inside of dc are drawn */
+    rtgui_dc_get_rect(dc, &dc_rect);
+    y1 = dc_rect.y1 - rect->y1;
+    if (y1 < 0) y1 = 0;
+    y2 = dc_rect.y2 - rect->y1;
+    if (y2 > h) y2 = h;
+
+    bgcolor = rtgui_color_from_565(RTGUI_DC_BC(dc));
+    bc[0] = RTGUI_RGB_R(bgcolor);
+    bc[1] = RTGUI_RGB_G(bgcolor);
+    bc[2] = RTGUI_RGB_B(bgcolor);
 
     if (png->pixels != RT_NULL)
     {
-        ptr = (rtgui_color_t *)png->pixels;
-        bgcolor = rtgui_color_from_565(RTGUI_DC_BC(dc));
-        bc[0] = RTGUI_RGB_R(bgcolor);
-        bc[1] = RTGUI_RGB_G(bgcolor);
-        bc[2] = RTGUI_RGB_B(bgcolor);
-        /* draw each point within dc */
-        for (y = 0; y < h; y ++)
+        rtgui_color_t *ptr;
+
+        ptr = (rtgui_color_t *)png->pixels + y1 * image->w;
+        for (y = y1; y < y2; y ++)
         {
-            for (x = 0; x < w; x++)
-            {
-                c = *ptr;
-                ialpha = RTGUI_RGB_A(c);
-                if (ialpha == 0)
-                {
-                    /*
-                     * Foreground image is transparent hear.
-                     * If the background image is already in the frame
-                     * buffer, there is nothing to do.
-                     */
-                }
-                else if (ialpha == fg_maxsample)
-                {
-                    /*
-                     * Copy foreground pixel to frame buffer.
-                     */
-                    rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1, c);
-                }
-                else
-                {
-                    /* output = alpha * foreground + (1-alpha) * background */
-                    /*
-                     * Compositing is necessary.
-                     * Get floating-point alpha and its complement.
-                     * Note: alpha is always linear: gamma does not
-                     * affect it.
-                     */
-                    fc[0] = RTGUI_RGB_R(c);
-                    fc[1] = RTGUI_RGB_G(c);
-                    fc[2] = RTGUI_RGB_B(c);
-
-                    alpha = (float) ialpha / fg_maxsample;
-                    color = RTGUI_RGB((rt_uint8_t)(fc[0] * alpha + bc[0] * (1 - alpha)),
-                                      (rt_uint8_t)(fc[1] * alpha + bc[1] * (1 - alpha)),
-                                      (rt_uint8_t)(fc[2] * alpha + bc[2] * (1 - alpha)));
-                    rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1, color);
-                }
-                /* move to next color buffer */
-                ptr ++;
-            }
+            rtgui_image_png_draw_line(dc, ptr, rect->x1, rect->y1 + y, w, bc);
+            ptr += image->w;
         }
     }
     else
     {
         png_bytep row;
-        png_bytep data;
+        rtgui_color_t *line;
+
+        /*
+         * Decode the image row by row and draw it directly, so only a row of
+         * png and a line of color are allocated in stream mode. The decoding
+         * stops at the last visible row.
+         */
+        if (png->row_index != 0)
+        {
+            /* restart decoding from the beginning of file */
+            rtgui_image_png_destroy(png);
+            if (rtgui_image_png_prepare(png) != RT_TRUE)
+                return;
+        }
 
         row = (png_bytep) rtgui_malloc(png_get_rowbytes(png->png_ptr, png->info_ptr));
         if (row == RT_NULL) return ;
+        line = (rtgui_color_t *) rtgui_malloc(image->w * sizeof(rtgui_color_t));
+        if (line == RT_NULL)
+        {
+            rtgui_free(row);
+            return;
+        }
 
-        switch (png->info_ptr->color_type)
+        for (y = 0; y < y2; y++)
         {
-        case PNG_COLOR_TYPE_RGBA:
-            for (y = 0; y < h; y++)
-            {
-                png_read_row(png->png_ptr, row, png_bytep_NULL);
-                for (x = 0; x < w; x++)
-                {
-                    data = &(row[x * 4]);
-                    if (data[3] != 0)
-                    {
-                        rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1,
-                                                  RTGUI_ARGB((255 - data[3]), data[0], data[1], data[2]));
-                    }
-                }
-            }
-
-            break;
-
-        case PNG_COLOR_TYPE_PALETTE:
-            for (y = 0; y < h; y++)
-            {
-                png_read_row(png->png_ptr, row, png_bytep_NULL);
-                for (x = 0; x < w; x++)
-                {
-                    data = &(row[x]);
-
-                    rtgui_dc_draw_color_point(dc, x + rect->x1, y + rect->y1,
-                                              RTGUI_ARGB(0, png->info_ptr->palette[data[0]].red,
-                                                         png->info_ptr->palette[data[0]].green,
-                                                         png->info_ptr->palette[data[0]].blue));
-                }
-            }
-
-        default:
-            break;
-        };
+            rtgui_image_png_read_line(png, row, line, image->w);
+            if (y >= y1)
+                rtgui_image_png_draw_line(dc, line, rect->x1, rect->y1 + y, w, bc);
+        }
 
+        rtgui_free(line);
         rtgui_free(row);
     }
 }
@@ -11,6 +11,7 @@
  * Date           Author       Notes
  * 2012-01-13     Grissiom     first version(just a prototype of application API)
  * 2012-07-07     Bernard      move the send/recv message to the rtgui_system.c
+ * 2013-01-12     Bernard      receive events in batch
  */
 
 #include <rtgui/rtgui_system.h>
@@ -32,6 +33,8 @@ static void _rtgui_app_constructor(struct rtgui_app *app)
     app->tid            = RT_NULL;
     app->server         = RT_NULL;
     app->mq             = RT_NULL;
+    app->event_count    = 0;
+    app->event_index    = 0;
     app->modal_object   = RT_NULL;
     app->main_object    = RT_NULL;
     app->on_idle        = RT_NULL;
@@ -306,17 +309,40 @@ rt_bool_t rtgui_app_event_handler(struct rtgui_object *object, rtgui_event_t *ev
     return RT_TRUE;
 }
 
+/*
+ * get the next event of application. The events are received in batch into
+ * the event buffer of application, and the nested event loops of modal window
+ * take events from the same buffer, so the order of events is kept.
+ */
+static struct rtgui_event *_rtgui_application_get_event(struct rtgui_app *app,
+                                                        rt_int32_t timeout)
+{
+    struct rtgui_event *event;
+
+    if (app->event_index >= app->event_count)
+    {
+        app->event_index = 0;
+        app->event_count = rtgui_recv_batch((struct rtgui_event *)app->event_buffer,
+                                            sizeof(union rtgui_event_generic),
+                                            RTGUI_APP_EVENT_BATCH, timeout);
+        if (app->event_count == 0)
+            return RT_NULL;
+    }
+
+    event = (struct rtgui_event *)(app->event_buffer +
+                                   app->event_index * sizeof(union rtgui_event_generic));
+    app->event_index ++;
+
+    return event;
+}
+
 rt_inline void _rtgui_application_event_loop(struct rtgui_app *app)
 {
-    rt_err_t result;
     rt_uint16_t current_ref;
     struct rtgui_event *event;
 
     _rtgui_application_check(app);
 
-    /* point to event buffer */
-    event = (struct rtgui_event *)app->event_buffer;
-
     current_ref = ++app->ref_count;
 
     while (current_ref <= app->ref_count)
@@ -325,16 +351,16 @@ rt_inline void _rtgui_application_event_loop(struct rtgui_app *app)
 
         if (app->on_idle != RT_NULL)
         {
-            result = rtgui_recv_nosuspend(event, sizeof(union rtgui_event_generic));
-            if (result == RT_EOK)
+            event = _rtgui_application_get_event(app, 0);
+            if (event != RT_NULL)
                 RTGUI_OBJECT(app)->event_handler(RTGUI_OBJECT(app), event);
-            else if (result == -RT_ETIMEOUT)
+            else
                 app->on_idle(RTGUI_OBJECT(app), RT_NULL);
         }
         else
         {
-            result = rtgui_recv(event, sizeof(union rtgui_event_generic));
-            if (result == RT_EOK)
+            event = _rtgui_application_get_event(app, RT_WAITING_FOREVER);
+            if (event != RT_NULL)
                 RTGUI_OBJECT(app)->event_handler(RTGUI_OBJECT(app), event);
         }
     }
@@ -10,8 +10,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2009-10-04     Bernard      first version
+ * 2013-01-12     Bernard      coalesce events in sending and receive events in batch
  */
 
+#include <rthw.h>
 #include <rtgui/rtgui.h>
 #include <rtgui/image.h>
 #include <rtgui/font.h>
@@ -253,11 +255,8 @@ void rti_free_hook(void *ptr)
 }
 #endif
 
-void *rtgui_malloc(rt_size_t size)
+static void *_rtgui_malloc_trace(void *ptr, rt_size_t size)
 {
-    void *ptr;
-
-    ptr = rt_malloc(size);
 #ifdef RTGUI_MEM_TRACE
     if (rti_memtrace_inited == 0)
     {
@@ -271,8 +270,23 @@ void *rtgui_malloc(rt_size_t size)
 
     return ptr;
 }
+
+void *rtgui_malloc(rt_size_t size)
+{
+    return _rtgui_malloc_trace(rt_malloc(size), size);
+}
 RTM_EXPORT(rtgui_malloc);
 
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+/* allocate memory for the usage, such as RT_MALLOC_USAGE_GUI for the big
+ * buffers. It's released by rtgui_free as well. */
+void *rtgui_malloc_usage(rt_size_t size, rt_uint32_t usage)
+{
+    return _rtgui_malloc_trace(rt_malloc_usage(size, usage), size);
+}
+RTM_EXPORT(rtgui_malloc_usage);
+#endif
+
 void *rtgui_realloc(void *ptr, rt_size_t size)
 {
     void *new_ptr;
@@ -303,13 +317,26 @@ void rtgui_free(void *ptr)
 }
 RTM_EXPORT(rtgui_free);
 
-#if defined(RTGUI_MEM_TRACE) && defined(RT_USING_FINSH)
+#ifdef RT_USING_FINSH
 #include <finsh.h>
+#include <rtgui/font_cache.h>
 void list_guimem(void)
 {
+#ifdef RTGUI_MEM_TRACE
     rt_kprintf("Current Used: %d, Maximal Used: %d\n", mem_info.allocated_size, mem_info.max_allocated);
+#endif
+    rtgui_glyph_cache_dump();
 }
 FINSH_FUNCTION_EXPORT(list_guimem, display memory information);
+
+void list_guievent(void)
+{
+    struct rtgui_event_stat stat;
+
+    rtgui_event_get_stat(&stat);
+    rt_kprintf("event coalesced: %d, dropped: %d\n", stat.coalesced, stat.dropped);
+}
+FINSH_FUNCTION_EXPORT(list_guievent, display event statistics);
 #endif
 
 /************************************************************************/
@@ -551,6 +578,125 @@ static void rtgui_event_dump(rt_thread_t tid, rtgui_event_t *event)
 /************************************************************************/
 /* RTGUI IPC APIs                                                       */
 /************************************************************************/
+/* the statistics of event sending */
+static struct rtgui_event_stat _event_stat;
+
+/* the header of message in message queue, which must be the same as
+ * struct rt_mq_message in src/ipc.c */
+struct _rtgui_mq_message
+{
+    struct _rtgui_mq_message *next;
+};
+
+/* get the target of an event which can be coalesced, otherwise RT_NULL */
+static rt_bool_t _rtgui_event_target(rtgui_event_t *event, void **target)
+{
+    switch (event->type)
+    {
+    case RTGUI_EVENT_MOUSE_MOTION:
+        *target = ((struct rtgui_event_mouse *)event)->wid;
+        break;
+
+    case RTGUI_EVENT_PAINT:
+        *target = ((struct rtgui_event_paint *)event)->wid;
+        break;
+
+    case RTGUI_EVENT_TIMER:
+        *target = ((struct rtgui_event_timer *)event)->timer;
+        break;
+
+    case RTGUI_EVENT_UPDATE_TOPLVL:
+        *target = ((struct rtgui_event_update_toplvl *)event)->toplvl;
+        break;
+
+    default:
+        return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+
+/*
+ * Merge the event into the last queued event with the same type and target.
+ * Only the events after the latest non-coalescable event are taken into
+ * account, so the order of other events (button, keyboard, clip etc) is kept.
+ */
+static rt_bool_t _rtgui_event_coalesce(rt_mq_t mq, rtgui_event_t *event)
+{
+    register rt_base_t level;
+    struct _rtgui_mq_message *msg;
+    rtgui_event_t *queued, *candidate;
+    void *target, *queued_target;
+
+    /* a synchronous event should be acknowledged one by one */
+    if (event->ack != RT_NULL || !_rtgui_event_target(event, &target))
+        return RT_FALSE;
+
+    candidate = RT_NULL;
+
+    /* the receiver only takes the message out of queue with interrupt
+     * disabled, so do the scan and merge. */
+    level = rt_hw_interrupt_disable();
+    for (msg = (struct _rtgui_mq_message *)mq->msg_queue_head;
+         msg != RT_NULL; msg = msg->next)
+    {
+        queued = (rtgui_event_t *)(msg + 1);
+
+        if (!_rtgui_event_target(queued, &queued_target))
+            candidate = RT_NULL;
+        else if (queued->type == event->type && queued_target == target &&
+                 queued->ack == RT_NULL)
+            candidate = queued;
+    }
+
+    if (candidate != RT_NULL)
+    {
+        switch (event->type)
+        {
+        case RTGUI_EVENT_MOUSE_MOTION:
+        {
+            struct rtgui_event_mouse *emouse = (struct rtgui_event_mouse *)candidate;
+
+            /* the latest position wins */
+            emouse->x = ((struct rtgui_event_mouse *)event)->x;
+            emouse->y = ((struct rtgui_event_mouse *)event)->y;
+            emouse->button = ((struct rtgui_event_mouse *)event)->button;
+        }
+        break;
+
+        case RTGUI_EVENT_PAINT:
+        {
+            rtgui_rect_t *dst = &((struct rtgui_event_paint *)candidate)->rect;
+            rtgui_rect_t *src = &((struct rtgui_event_paint *)event)->rect;
+
+            /* paint the union of both area */
+            if (src->x1 < dst->x1) dst->x1 = src->x1;
+            if (src->y1 < dst->y1) dst->y1 = src->y1;
+            if (src->x2 > dst->x2) dst->x2 = src->x2;
+            if (src->y2 > dst->y2) dst->y2 = src->y2;
+        }
+        break;
+
+        default:
+            /* timer and update events are just the same */
+            break;
+        }
+
+        _event_stat.coalesced ++;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return candidate != RT_NULL;
+}
+
+void rtgui_event_get_stat(struct rtgui_event_stat *stat)
+{
+    RT_ASSERT(stat != RT_NULL);
+
+    *stat = _event_stat;
+}
+RTM_EXPORT(rtgui_event_get_stat);
+
 rt_err_t rtgui_send(rt_thread_t tid, rtgui_event_t *event, rt_size_t event_size)
 {
     rt_err_t result;
@@ -567,10 +713,16 @@ rt_err_t rtgui_send(rt_thread_t tid, rtgui_event_t *event, rt_size_t event_size)
     if (app == RT_NULL)
         return -RT_ERROR;
 
+    if (_rtgui_event_coalesce(app->mq, event))
+        return RT_EOK;
+
     result = rt_mq_send(app->mq, event, event_size);
     if (result != RT_EOK)
     {
-        if (event->type != RTGUI_EVENT_TIMER)
+        _event_stat.dropped ++;
+        /* don't flood the console with the lost of droppable events */
+        if (event->type != RTGUI_EVENT_TIMER &&
+            event->type != RTGUI_EVENT_MOUSE_MOTION)
             rt_kprintf("send event to %s failed\n", app->tid->name);
     }
 
@@ -698,6 +850,39 @@ rt_err_t rtgui_recv_nosuspend(rtgui_event_t *event, rt_size_t event_size)
 }
 RTM_EXPORT(rtgui_recv_nosuspend);
 
+/*
+ * receive at most count events into the event array, only the first event
+ * waits for timeout. It returns the number of received events.
+ */
+rt_size_t rtgui_recv_batch(rtgui_event_t *event, rt_size_t event_size,
+                           rt_size_t count, rt_int32_t timeout)
+{
+    struct rtgui_app *app;
+    rt_uint8_t *ptr;
+    rt_size_t index;
+
+    RT_ASSERT(event != RT_NULL);
+    RT_ASSERT(event_size != 0);
+
+    app = (struct rtgui_app *)(rt_thread_self()->user_data);
+    if (app == RT_NULL || count == 0)
+        return 0;
+
+    ptr = (rt_uint8_t *)event;
+    if (rt_mq_recv(app->mq, ptr, event_size, timeout) != RT_EOK)
+        return 0;
+
+    for (index = 1; index < count; index ++)
+    {
+        ptr += event_size;
+        if (rt_mq_recv(app->mq, ptr, event_size, 0) != RT_EOK)
+            break;
+    }
+
+    return index;
+}
+RTM_EXPORT(rtgui_recv_batch);
+
 rt_err_t rtgui_recv_filter(rt_uint32_t type, rtgui_event_t *event, rt_size_t event_size)
 {
     struct rtgui_app *app;
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2009-10-16     Bernard      first version
+ * 2013-01-10     Bernard      use the shared glyph cache in hz file font
  */
 #ifndef __RTGUI_FONT_H__
 #define __RTGUI_FONT_H__
@@ -49,20 +50,11 @@ struct rtgui_font_bitmap
 };
 extern const struct rtgui_font_engine bmp_font_engine;
 
-#include <rtgui/tree.h>
-SPLAY_HEAD(cache_tree, hz_cache);
-struct hz_cache
-{
-    SPLAY_ENTRY(hz_cache) hz_node;
-
-    rt_uint16_t hz_id;
-};
-
+/*
+ * HZ font in file, the glyphs are loaded into glyph cache.
+ */
 struct rtgui_hz_file_font
 {
-    struct cache_tree cache_root;
-    rt_uint16_t cache_size;
-
     /* font size */
     rt_uint16_t font_size;
     rt_uint16_t font_data_size;
@@ -0,0 +1,104 @@
+/*
+ * File      : font_cache.h
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2006 - 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-10     Bernard      first version
+ */
+#ifndef __RTGUI_FONT_CACHE_H__
+#define __RTGUI_FONT_CACHE_H__
+
+#include <rtgui/rtgui.h>
+#include <rtgui/dlist.h>
+
+struct rtgui_dc;
+struct rtgui_font;
+struct rtgui_rect;
+
+/* the default byte budget of glyph cache */
+#ifndef RTGUI_GLYPH_CACHE_SIZE
+#define RTGUI_GLYPH_CACHE_SIZE      (8 * 1024)
+#endif
+
+/* the bucket number of glyph hash table, must be power of 2 */
+#define RTGUI_GLYPH_HASH_SIZE       64
+
+/* glyph bitmap format */
+#define RTGUI_GLYPH_MONO            0x00    /* 1bpp, MSB first, byte aligned row */
+#define RTGUI_GLYPH_GRAY8           0x01    /* 8bpp coverage */
+
+/* glyph flag */
+#define RTGUI_GLYPH_FLAG_EXTERN     0x01    /* bitmap is not owned by glyph */
+
+struct rtgui_glyph
+{
+    /* the owner font and the character code in font */
+    struct rtgui_font *font;
+    rt_uint32_t code;
+
+    /* bitmap information */
+    rt_uint8_t  format;
+    rt_uint8_t  flag;
+    rt_uint16_t pitch;              /* bytes per row */
+    rt_uint16_t width;
+    rt_uint16_t height;
+    rt_int16_t  left;               /* offset to the pen position */
+    rt_int16_t  top;
+    rt_uint16_t advance;            /* pen advance after drawing */
+
+    /* reference count, a referred glyph is never evicted */
+    rt_uint16_t ref_count;
+    /* the memory taken by this glyph */
+    rt_uint32_t size;
+
+    const rt_uint8_t *bitmap;
+
+    struct rtgui_glyph *hash_next;
+    struct rtgui_dlist_node lru;
+};
+
+struct rtgui_glyph_cache_stat
+{
+    rt_uint32_t hit;
+    rt_uint32_t miss;
+    rt_uint32_t evict;
+
+    rt_uint32_t count;              /* glyph number in cache */
+    rt_uint32_t used;               /* bytes used by cache */
+    rt_uint32_t budget;             /* maximal bytes of cache */
+};
+
+void rtgui_glyph_cache_init(void);
+void rtgui_glyph_cache_set_budget(rt_size_t size);
+void rtgui_glyph_cache_get_stat(struct rtgui_glyph_cache_stat *stat);
+void rtgui_glyph_cache_dump(void);
+
+/* find a glyph in cache, the glyph should be released after used */
+struct rtgui_glyph *rtgui_glyph_cache_get(struct rtgui_font *font, rt_uint32_t code);
+rt_bool_t rtgui_glyph_cache_exist(struct rtgui_font *font, rt_uint32_t code);
+void rtgui_glyph_cache_release(struct rtgui_glyph *glyph);
+
+/* allocate a glyph with bitmap buffer of bitmap_size bytes, then put it into
+ * cache after filled. A zero bitmap_size allocates a glyph which refers to an
+ * external bitmap. */
+struct rtgui_glyph *rtgui_glyph_alloc(struct rtgui_font *font, rt_uint32_t code, rt_size_t bitmap_size);
+void rtgui_glyph_free(struct rtgui_glyph *glyph);
+struct rtgui_glyph *rtgui_glyph_cache_put(struct rtgui_glyph *glyph);
+
+/* remove all the glyphs of font */
+void rtgui_glyph_cache_flush(struct rtgui_font *font);
+
+/* draw glyph on the pen position (x, y) and clipped by rect */
+void rtgui_glyph_draw(struct rtgui_dc *dc, const struct rtgui_glyph *glyph,
+                      int x, int y, const struct rtgui_rect *rect);
+/* draw a monochrome bitmap with the foreground color of dc */
+void rtgui_glyph_draw_mono(struct rtgui_dc *dc, const rt_uint8_t *bitmap, int pitch,
+                           int x, int y, int w, int h, const struct rtgui_rect *rect);
+
+#endif
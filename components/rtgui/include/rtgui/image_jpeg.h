@@ -3,6 +3,12 @@
 
 #include <rtgui/image.h>
 
+/* the maximal scale of jpeg decoding, which means 1/8 */
+#define RTGUI_IMAGE_JPEG_SCALE_MAX      3
+
 void rtgui_image_jpeg_init(void);
+/* set the decoding scale of an image not loaded into memory, the image is
+ * scaled down to 1/(2^scale), the width and height of image are updated. */
+rt_err_t rtgui_image_jpeg_set_scale(struct rtgui_image *image, rt_uint8_t scale);
 
 #endif
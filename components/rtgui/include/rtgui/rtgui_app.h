@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2012-01-13     Grissiom     first version
+ * 2013-01-12     Bernard      receive events in batch
  */
 
 #ifndef __RTGUI_APP_H__
@@ -57,8 +58,10 @@ struct rtgui_app
 
     /* the message queue of thread */
     rt_mq_t mq;
-    /* event buffer */
-    rt_uint8_t event_buffer[sizeof(union rtgui_event_generic)];
+    /* event buffer, the events are received in batch */
+    rt_uint8_t event_buffer[sizeof(union rtgui_event_generic) * RTGUI_APP_EVENT_BATCH];
+    rt_uint16_t event_count;
+    rt_uint16_t event_index;
 
     /* if not RT_NULL, the application is in modal state by modal_object. If is
      * RT_NULL, nothing modal windows. */
@@ -43,6 +43,11 @@
 #define RTGUI_APP_THREAD_STACK_SIZE     2048
 #endif
 
+/* the number of events received by application in one wakeup */
+#ifndef RTGUI_APP_EVENT_BATCH
+#define RTGUI_APP_EVENT_BATCH           4
+#endif
+
 #define RTGUI_USING_CAST_CHECK
 
 //#define RTGUI_USING_DESKTOP_WINDOW
@@ -47,6 +47,9 @@ void rtgui_timer_stop(rtgui_timer_t *timer);
 void rtgui_system_server_init(void);
 
 void *rtgui_malloc(rt_size_t size);
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+void *rtgui_malloc_usage(rt_size_t size, rt_uint32_t usage);
+#endif
 void rtgui_free(void *ptr);
 void *rtgui_realloc(void *ptr, rt_size_t size);
 
@@ -67,6 +70,13 @@ void rtgui_screen_lock(rt_int32_t timeout);
 void rtgui_screen_unlock(void);
 
 struct rtgui_event;
+struct rtgui_event_stat
+{
+    rt_uint32_t coalesced;          /* events merged into a queued one */
+    rt_uint32_t dropped;            /* events lost for full queue */
+};
+void rtgui_event_get_stat(struct rtgui_event_stat *stat);
+
 rt_err_t rtgui_send(rt_thread_t tid, struct rtgui_event *event, rt_size_t event_size);
 rt_err_t rtgui_send_urgent(rt_thread_t tid, struct rtgui_event *event, rt_size_t event_size);
 rt_err_t rtgui_send_sync(rt_thread_t tid, struct rtgui_event *event, rt_size_t event_size);
@@ -74,5 +84,7 @@ rt_err_t rtgui_ack(struct rtgui_event *event, rt_int32_t status);
 rt_err_t rtgui_recv(struct rtgui_event *event, rt_size_t event_size);
 rt_err_t rtgui_recv_nosuspend(struct rtgui_event *event, rt_size_t event_size);
 rt_err_t rtgui_recv_filter(rt_uint32_t type, struct rtgui_event *event, rt_size_t event_size);
+rt_size_t rtgui_recv_batch(struct rtgui_event *event, rt_size_t event_size,
+                           rt_size_t count, rt_int32_t timeout);
 
 #endif
@@ -10,6 +10,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2009-10-04     Bernard      first version
+ * 2013-01-08     Bernard      add screen to screen blit for window moving
  */
 #include <rtthread.h>
 #include <rtgui/driver.h>
@@ -87,6 +88,53 @@ void rtgui_graphic_driver_screen_update(const struct rtgui_graphic_driver *drive
 }
 RTM_EXPORT(rtgui_graphic_driver_screen_update);
 
+/* copy the pixels of rect from (x - dx, y - dy) to (x, y) in the same
+ * framebuffer. The source and destination area could be overlapped. */
+rt_err_t rtgui_graphic_driver_screen_blit(const struct rtgui_graphic_driver *driver,
+        rtgui_rect_t *rect, int dx, int dy)
+{
+    int y, bpp;
+    rt_uint8_t *fb;
+    rt_size_t length;
+
+    RT_ASSERT(rect != RT_NULL);
+    RT_ASSERT(driver != RT_NULL);
+
+    /* only the linear framebuffer with byte aligned pixel could be blit */
+    if (driver->framebuffer == RT_NULL || driver->bits_per_pixel < 8)
+        return -RT_ERROR;
+
+    if (rect->x1 >= rect->x2 || rect->y1 >= rect->y2)
+        return RT_EOK;
+
+    fb = (rt_uint8_t *)driver->framebuffer;
+    bpp = driver->bits_per_pixel / 8;
+    length = (rect->x2 - rect->x1) * bpp;
+
+    if (dy > 0)
+    {
+        /* move down: copy from the bottom line */
+        for (y = rect->y2 - 1; y >= rect->y1; y --)
+        {
+            rt_memmove(fb + y * driver->pitch + rect->x1 * bpp,
+                       fb + (y - dy) * driver->pitch + (rect->x1 - dx) * bpp,
+                       length);
+        }
+    }
+    else
+    {
+        for (y = rect->y1; y < rect->y2; y ++)
+        {
+            rt_memmove(fb + y * driver->pitch + rect->x1 * bpp,
+                       fb + (y - dy) * driver->pitch + (rect->x1 - dx) * bpp,
+                       length);
+        }
+    }
+
+    return RT_EOK;
+}
+RTM_EXPORT(rtgui_graphic_driver_screen_blit);
+
 /* get video frame buffer */
 rt_uint8_t *rtgui_graphic_driver_get_framebuffer(const struct rtgui_graphic_driver *driver)
 {
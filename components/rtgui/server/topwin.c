@@ -10,6 +10,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2009-10-16     Bernard      first version
+ * 2013-01-08     Bernard      only update the windows in the damaged area and
+ *                             move window by screen blit.
  */
 #include "topwin.h"
 #include "mouse.h"
@@ -46,8 +48,8 @@ static struct rtgui_dlist_node _rtgui_topwin_list;
 
 static struct rt_semaphore _rtgui_topwin_lock;
 
-static void rtgui_topwin_update_clip(void);
-static void rtgui_topwin_redraw(struct rtgui_rect *rect);
+static void rtgui_topwin_update_clip(struct rtgui_rect *damage);
+static void rtgui_topwin_redraw(struct rtgui_rect *rect, struct rtgui_topwin *skip);
 static void _rtgui_topwin_activate_next(enum rtgui_topwin_flag);
 
 void rtgui_topwin_init(void)
@@ -294,6 +296,8 @@ rt_err_t rtgui_topwin_remove(struct rtgui_win *wid)
         return -RT_ERROR;
 
     rtgui_region_init(&region);
+    /* the whole tree is the damaged area */
+    _rtgui_topwin_union_region_tree(topwin, &region);
 
     old_focus = rtgui_topwin_get_focus();
 
@@ -308,12 +312,12 @@ rt_err_t rtgui_topwin_remove(struct rtgui_win *wid)
 
     if (topwin->flag & WINTITLE_SHOWN)
     {
-        rtgui_topwin_update_clip();
+        rtgui_topwin_update_clip(rtgui_region_extents(&region));
         /* redraw the old rect */
-        _rtgui_topwin_union_region_tree(topwin, &region);
-        rtgui_topwin_redraw(rtgui_region_extents(&region));
+        rtgui_topwin_redraw(rtgui_region_extents(&region), RT_NULL);
     }
 
+    rtgui_region_fini(&region);
     _rtgui_topwin_free_tree(topwin);
 
     return RT_EOK;
@@ -505,6 +509,21 @@ static void _rtgui_topwin_draw_tree(struct rtgui_topwin *topwin, struct rtgui_ev
     }
 }
 
+/* raise the tree of topwin and update the clip of the windows covered by
+ * the tree. */
+static void _rtgui_topwin_raise_and_clip(struct rtgui_topwin *topwin)
+{
+    struct rtgui_region region;
+
+    _rtgui_topwin_raise_tree_from_root(topwin);
+
+    /* only the windows beneath the raised tree would change their clip */
+    rtgui_region_init(&region);
+    _rtgui_topwin_union_region_tree(_rtgui_topwin_get_root_win(topwin), &region);
+    rtgui_topwin_update_clip(rtgui_region_extents(&region));
+    rtgui_region_fini(&region);
+}
+
 rt_err_t rtgui_topwin_activate_topwin(struct rtgui_topwin *topwin)
 {
     struct rtgui_topwin *old_focus_topwin;
@@ -520,8 +539,7 @@ rt_err_t rtgui_topwin_activate_topwin(struct rtgui_topwin *topwin)
     if (topwin->flag & WINTITLE_NOFOCUS)
     {
         /* just raise and show, not affect others. */
-        _rtgui_topwin_raise_tree_from_root(topwin);
-        rtgui_topwin_update_clip();
+        _rtgui_topwin_raise_and_clip(topwin);
         _rtgui_topwin_draw_tree(topwin, &epaint);
         return RT_EOK;
     }
@@ -534,9 +552,8 @@ rt_err_t rtgui_topwin_activate_topwin(struct rtgui_topwin *topwin)
      * returned above. */
     RT_ASSERT(old_focus_topwin != topwin);
 
-    _rtgui_topwin_raise_tree_from_root(topwin);
     /* clip before active the window, so we could get right boarder region. */
-    rtgui_topwin_update_clip();
+    _rtgui_topwin_raise_and_clip(topwin);
 
     if (old_focus_topwin != RT_NULL)
     {
@@ -644,6 +661,7 @@ rt_err_t rtgui_topwin_hide(struct rtgui_event_win *event)
     struct rtgui_topwin *old_focus_topwin = rtgui_topwin_get_focus();
     struct rtgui_win    *wid = event->wid;
     struct rtgui_dlist_node *containing_list;
+    struct rtgui_region region;
 
     /* find in show list */
     topwin = rtgui_topwin_search_in_list(wid, &_rtgui_topwin_list);
@@ -668,11 +686,16 @@ rt_err_t rtgui_topwin_hide(struct rtgui_event_win *event)
     rtgui_dlist_remove(&topwin->list);
     rtgui_dlist_insert_before(containing_list, &topwin->list);
 
+    /* the hidden tree is the damaged area */
+    rtgui_region_init(&region);
+    _rtgui_topwin_union_region_tree(topwin, &region);
+
     /* update clip info */
-    rtgui_topwin_update_clip();
+    rtgui_topwin_update_clip(rtgui_region_extents(&region));
 
     /* redraw the old rect */
-    rtgui_topwin_redraw(&(topwin->extent));
+    rtgui_topwin_redraw(rtgui_region_extents(&region), RT_NULL);
+    rtgui_region_fini(&region);
 
     if (topwin->flag & WINTITLE_MODALING)
     {
@@ -690,12 +713,81 @@ rt_err_t rtgui_topwin_hide(struct rtgui_event_win *event)
     return RT_EOK;
 }
 
+/* blit the rects in one band of region, they are walked reversely when the
+ * window is moving right. */
+static void _rtgui_topwin_blit_band(struct rtgui_graphic_driver *driver,
+                                    rtgui_rect_t *rects, int num, int dx, int dy)
+{
+    int index;
+
+    for (index = 0; index < num; index ++)
+    {
+        if (dx > 0)
+            rtgui_graphic_driver_screen_blit(driver, &rects[num - 1 - index], dx, dy);
+        else
+            rtgui_graphic_driver_screen_blit(driver, &rects[index], dx, dy);
+    }
+}
+
+/* blit the visible content of the moved window to the new position. On
+ * return, the region is the area that has been blit(empty if the graphic
+ * driver could not blit). */
+static void _rtgui_topwin_blit_region(struct rtgui_region *region, int dx, int dy)
+{
+    int first, last, num;
+    rtgui_rect_t *rects;
+    struct rtgui_graphic_driver *driver;
+
+    driver = rtgui_graphic_driver_get_default();
+    num = rtgui_region_num_rects(region);
+    rects = rtgui_region_rects(region);
+
+    if (num == 0 || driver->framebuffer == RT_NULL || driver->bits_per_pixel < 8)
+    {
+        /* can't blit, the whole window should be re-painted */
+        rtgui_region_empty(region);
+        return;
+    }
+
+    /* the rects in region are sorted in bands from top to bottom, and from
+     * left to right in a band. The bands are walked reversely when the window
+     * is moving down, and the rects in a band are walked reversely when it's
+     * moving right, otherwise a rect may overwrite the source pixels of
+     * another one. */
+    if (dy > 0)
+    {
+        for (last = num; last > 0; last = first)
+        {
+            first = last - 1;
+            while (first > 0 && rects[first - 1].y1 == rects[last - 1].y1)
+                first --;
+
+            _rtgui_topwin_blit_band(driver, &rects[first], last - first, dx, dy);
+        }
+    }
+    else
+    {
+        for (first = 0; first < num; first = last)
+        {
+            last = first + 1;
+            while (last < num && rects[last].y1 == rects[first].y1)
+                last ++;
+
+            _rtgui_topwin_blit_band(driver, &rects[first], last - first, dx, dy);
+        }
+    }
+
+    rtgui_graphic_driver_screen_update(driver, rtgui_region_extents(region));
+}
+
 /* move top window */
 rt_err_t rtgui_topwin_move(struct rtgui_event_win_move *event)
 {
     struct rtgui_topwin *topwin;
     int dx, dy;
     rtgui_rect_t old_rect; /* the old topwin coverage area */
+    rtgui_rect_t damage;
+    struct rtgui_region visible, region;
     struct rtgui_list_node *node;
 
     /* find in show list */
@@ -710,6 +802,11 @@ rt_err_t rtgui_topwin_move(struct rtgui_event_win_move *event)
     dx = event->x - topwin->extent.x1;
     dy = event->y - topwin->extent.y1;
 
+    /* the visible part of the window before moving. The pixels in it are the
+     * content of window and they are reused after moving. */
+    rtgui_region_init(&visible);
+    rtgui_region_copy(&visible, &RTGUI_WIDGET(topwin->wid)->clip);
+
     old_rect = topwin->extent;
     /* move window rect */
     rtgui_rect_moveto(&(topwin->extent), dx, dy);
@@ -730,27 +827,50 @@ rt_err_t rtgui_topwin_move(struct rtgui_event_win_move *event)
         rtgui_rect_moveto(&(monitor->rect), dx, dy);
     }
 
+    /* the damaged area is the old coverage and the new coverage */
+    rtgui_region_init_with_extents(&region, &old_rect);
+    if (topwin->title != RT_NULL)
+        rtgui_region_union_rect(&region, &region, &RTGUI_WIDGET(topwin->title)->extent);
+    else
+        rtgui_region_union_rect(&region, &region, &topwin->extent);
+    damage = *rtgui_region_extents(&region);
+
     /* update windows clip info */
-    rtgui_topwin_update_clip();
+    rtgui_topwin_update_clip(&damage);
 
-    /* update old window coverage area */
-    rtgui_topwin_redraw(&old_rect);
+    /* blit the content that is still visible after moving. It should be done
+     * before any drawing on the damaged area. */
+    rtgui_region_translate(&visible, dx, dy);
+    rtgui_region_intersect(&visible, &visible, &RTGUI_WIDGET(topwin->wid)->clip);
+    _rtgui_topwin_blit_region(&visible, dx, dy);
 
     /* update top window title */
     if (topwin->title != RT_NULL)
         rtgui_theme_draw_win(topwin);
-    if (rtgui_rect_is_intersect(&old_rect, &(topwin->extent)) != RT_EOK)
+
+    /* the exposed part of window should be painted by application */
+    rtgui_region_subtract(&region, &RTGUI_WIDGET(topwin->wid)->clip, &visible);
+    if (rtgui_region_not_empty(&region))
     {
-        /*
-         * the old rect is not intersect with moved rect,
-         * re-paint window
-         */
         struct rtgui_event_paint epaint;
         RTGUI_EVENT_PAINT_INIT(&epaint);
         epaint.wid = topwin->wid;
+        epaint.rect = *rtgui_region_extents(&region);
         rtgui_send(topwin->tid, &(epaint.parent), sizeof(epaint));
     }
 
+    /* update old window coverage area */
+    rtgui_region_reset(&region, &old_rect);
+    if (topwin->title != RT_NULL)
+        rtgui_region_subtract_rect(&region, &region, &RTGUI_WIDGET(topwin->title)->extent);
+    else
+        rtgui_region_subtract_rect(&region, &region, &topwin->extent);
+    if (rtgui_region_not_empty(&region))
+        rtgui_topwin_redraw(rtgui_region_extents(&region), topwin);
+
+    rtgui_region_fini(&visible);
+    rtgui_region_fini(&region);
+
     return RT_EOK;
 }
 
@@ -795,10 +915,11 @@ void rtgui_topwin_resize(struct rtgui_win *wid, rtgui_rect_t *rect)
     }
 
     /* update windows clip info */
-    rtgui_topwin_update_clip();
+    rtgui_topwin_update_clip(rtgui_region_extents(&region));
 
     /* update old window coverage area */
-    rtgui_topwin_redraw(rtgui_region_extents(&region));
+    rtgui_topwin_redraw(rtgui_region_extents(&region), RT_NULL);
+    rtgui_region_fini(&region);
 }
 
 static struct rtgui_topwin *_rtgui_topwin_get_focus_from_list(struct rtgui_dlist_node *list)
@@ -899,9 +1020,13 @@ rt_inline void _rtgui_topwin_clip_to_region(struct rtgui_region *region,
                            region);
 }
 
-static void rtgui_topwin_update_clip(void)
+/* update the clip of shown windows. Only the windows overlapped with the
+ * damaged area would change their clip, so the others are skipped. If damage
+ * is RT_NULL, all the windows are updated. */
+static void rtgui_topwin_update_clip(struct rtgui_rect *damage)
 {
     struct rtgui_topwin *top;
+    struct rtgui_rect *coverage;
     struct rtgui_event_clip_info eclip;
     /* Note that the region is a "female die", that means it's the region you
      * can paint to, not the region covered by others.
@@ -928,24 +1053,30 @@ static void rtgui_topwin_update_clip(void)
 
     while (top != RT_NULL)
     {
-        /* clip the topwin */
-        _rtgui_topwin_clip_to_region(&region_available, top);
+        if (top->title != RT_NULL)
+            coverage = &RTGUI_WIDGET(top->title)->extent;
+        else
+            coverage = &top->extent;
+
+        if (damage == RT_NULL ||
+                rtgui_rect_is_intersect(damage, coverage) == RT_EOK)
+        {
+            /* clip the topwin */
+            _rtgui_topwin_clip_to_region(&region_available, top);
 #if 0
-        /* debug window clipping */
-        rt_kprintf("clip %s ", top->wid->title);
-        rtgui_region_dump(&region_available);
-        rt_kprintf("\n");
+            /* debug window clipping */
+            rt_kprintf("clip %s ", top->wid->title);
+            rtgui_region_dump(&region_available);
+            rt_kprintf("\n");
 #endif
 
-        /* update available region */
-        if (top->title != RT_NULL)
-            rtgui_region_subtract_rect(&region_available, &region_available, &RTGUI_WIDGET(top->title)->extent);
-        else
-            rtgui_region_subtract_rect(&region_available, &region_available, &top->extent);
+            /* send clip event to destination window */
+            eclip.wid = top->wid;
+            rtgui_send(top->tid, &(eclip.parent), sizeof(struct rtgui_event_clip_info));
+        }
 
-        /* send clip event to destination window */
-        eclip.wid = top->wid;
-        rtgui_send(top->tid, &(eclip.parent), sizeof(struct rtgui_event_clip_info));
+        /* update available region */
+        rtgui_region_subtract_rect(&region_available, &region_available, coverage);
 
         /* move to next sibling tree */
         if (top->parent == RT_NULL)
@@ -962,10 +1093,13 @@ static void rtgui_topwin_update_clip(void)
         else
             top = top->parent;
     }
+
+    rtgui_region_fini(&region_available);
 }
 
 static void _rtgui_topwin_redraw_tree(struct rtgui_dlist_node *list,
                                       struct rtgui_rect *rect,
+                                      struct rtgui_topwin *skip,
                                       struct rtgui_event_paint *epaint)
 {
     struct rtgui_dlist_node *node;
@@ -987,30 +1121,38 @@ static void _rtgui_topwin_redraw_tree(struct rtgui_dlist_node *list,
 
         topwin = get_topwin_from_list(node);
 
-        //FIXME: intersect with clip?
-        if (rtgui_rect_is_intersect(rect, &(topwin->extent)) == RT_EOK)
+        /* only the window which visible region is exposed should be painted */
+        if (topwin != skip)
         {
-            epaint->wid = topwin->wid;
-            rtgui_send(topwin->tid, &(epaint->parent), sizeof(*epaint));
+            if (rtgui_region_contains_rectangle(&RTGUI_WIDGET(topwin->wid)->clip,
+                                                rect) != RTGUI_REGION_OUT)
+            {
+                epaint->wid = topwin->wid;
+                rtgui_send(topwin->tid, &(epaint->parent), sizeof(*epaint));
+            }
 
             /* draw title */
-            if (topwin->title != RT_NULL)
+            if (topwin->title != RT_NULL &&
+                    rtgui_region_contains_rectangle(&RTGUI_WIDGET(topwin->title)->clip,
+                                                    rect) != RTGUI_REGION_OUT)
             {
                 rtgui_theme_draw_win(topwin);
             }
         }
 
-        _rtgui_topwin_redraw_tree(&topwin->child_list, rect, epaint);
+        _rtgui_topwin_redraw_tree(&topwin->child_list, rect, skip, epaint);
     }
 }
 
-static void rtgui_topwin_redraw(struct rtgui_rect *rect)
+/* send paint event to the windows exposed in rect, except the skip one */
+static void rtgui_topwin_redraw(struct rtgui_rect *rect, struct rtgui_topwin *skip)
 {
     struct rtgui_event_paint epaint;
     RTGUI_EVENT_PAINT_INIT(&epaint);
     epaint.wid = RT_NULL;
+    epaint.rect = *rect;
 
-    _rtgui_topwin_redraw_tree(&_rtgui_topwin_list, rect, &epaint);
+    _rtgui_topwin_redraw_tree(&_rtgui_topwin_list, rect, skip, &epaint);
 }
 
 /* a window enter modal mode will modal all the sibling window and parent
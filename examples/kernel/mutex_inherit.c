@@ -0,0 +1,185 @@
+/*
+ * 程序清单：互斥锁优先级继承链及优先级天花板
+ *
+ * thread3持有mutex_b，thread2持有mutex_a并等待mutex_b，thread1等待mutex_a，
+ * thread1的优先级应沿等待链传递给thread3；thread1等待超时后，thread3应恢复到
+ * thread2的优先级。
+ */
+#include <rtthread.h>
+#include "tc_comm.h"
+
+/* 指向线程控制块的指针 */
+static rt_thread_t tid0 = RT_NULL;
+static rt_thread_t tid1 = RT_NULL;
+static rt_thread_t tid2 = RT_NULL;
+static rt_thread_t tid3 = RT_NULL;
+static rt_mutex_t mutex_a = RT_NULL;
+static rt_mutex_t mutex_b = RT_NULL;
+static rt_mutex_t mutex_c = RT_NULL;
+
+/* 检查线程入口 */
+static void thread0_entry(void* parameter)
+{
+	/* 此时thread1等待mutex_a，thread2等待mutex_b */
+	rt_thread_delay(8);
+
+	/* thread1的优先级应传递到thread2与thread3 */
+	if (tid2->current_priority != THREAD_PRIORITY ||
+		tid3->current_priority != THREAD_PRIORITY)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+
+	/* 此时thread1等待超时 */
+	rt_thread_delay(12);
+
+	/* thread3应恢复到thread2的优先级 */
+	if (tid2->current_priority != THREAD_PRIORITY + 1 ||
+		tid3->current_priority != THREAD_PRIORITY + 1)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+}
+
+/* 线程1入口 */
+static void thread1_entry(void* parameter)
+{
+	rt_err_t result;
+
+	rt_thread_delay(5);
+
+	/* 等待mutex_a 10个OS Tick，应超时 */
+	result = rt_mutex_take(mutex_a, 10);
+	if (result != -RT_ETIMEOUT)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+}
+
+/* 线程2入口 */
+static void thread2_entry(void* parameter)
+{
+	rt_thread_delay(2);
+
+	rt_mutex_take(mutex_a, RT_WAITING_FOREVER);
+	/* thread3持有mutex_b，应把thread3的优先级提升到thread2的优先级 */
+	rt_mutex_take(mutex_b, RT_WAITING_FOREVER);
+
+	rt_mutex_release(mutex_b);
+	rt_mutex_release(mutex_a);
+
+	/* 释放后应恢复原优先级 */
+	if (tid2->current_priority != THREAD_PRIORITY + 1)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+}
+
+/* 线程3入口 */
+static void thread3_entry(void* parameter)
+{
+	rt_uint8_t ceiling = THREAD_PRIORITY;
+
+	/* 持有优先级天花板互斥锁时，应立即提升到天花板优先级 */
+	rt_mutex_control(mutex_c, RT_IPC_CMD_SET_CEILING, &ceiling);
+	rt_mutex_take(mutex_c, RT_WAITING_FOREVER);
+	if (tid3->current_priority != THREAD_PRIORITY)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+	rt_mutex_release(mutex_c);
+	if (tid3->current_priority != THREAD_PRIORITY + 2)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+
+	rt_mutex_take(mutex_b, RT_WAITING_FOREVER);
+	rt_thread_delay(30);
+	rt_mutex_release(mutex_b);
+
+	if (tid3->current_priority != THREAD_PRIORITY + 2)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+}
+
+int mutex_inherit_init()
+{
+	/* 创建互斥锁 */
+	mutex_a = rt_mutex_create("mutex_a", RT_IPC_FLAG_PRIO);
+	mutex_b = rt_mutex_create("mutex_b", RT_IPC_FLAG_PRIO);
+	mutex_c = rt_mutex_create("mutex_c", RT_IPC_FLAG_PRIO | RT_IPC_FLAG_CEILING);
+	if (mutex_a == RT_NULL || mutex_b == RT_NULL || mutex_c == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	tid0 = rt_thread_create("t0",
+		thread0_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY - 1, THREAD_TIMESLICE);
+	tid1 = rt_thread_create("t1",
+		thread1_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY, THREAD_TIMESLICE);
+	tid2 = rt_thread_create("t2",
+		thread2_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY + 1, THREAD_TIMESLICE);
+	tid3 = rt_thread_create("t3",
+		thread3_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY + 2, THREAD_TIMESLICE);
+	if (tid0 == RT_NULL || tid1 == RT_NULL || tid2 == RT_NULL || tid3 == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	rt_thread_startup(tid0);
+	rt_thread_startup(tid1);
+	rt_thread_startup(tid2);
+	rt_thread_startup(tid3);
+
+	return 0;
+}
+
+#ifdef RT_USING_TC
+static void _tc_cleanup()
+{
+	/* 调度器上锁，上锁后，将不再切换到其他线程，仅响应中断 */
+	rt_enter_critical();
+
+	/* 删除线程 */
+	if (tid0 != RT_NULL && tid0->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid0);
+	if (tid1 != RT_NULL && tid1->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid1);
+	if (tid2 != RT_NULL && tid2->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid2);
+	if (tid3 != RT_NULL && tid3->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid3);
+
+	if (mutex_a != RT_NULL) rt_mutex_delete(mutex_a);
+	if (mutex_b != RT_NULL) rt_mutex_delete(mutex_b);
+	if (mutex_c != RT_NULL) rt_mutex_delete(mutex_c);
+
+	/* 调度器解锁 */
+	rt_exit_critical();
+
+	/* 设置TestCase状态 */
+	tc_done(TC_STAT_PASSED);
+}
+
+int _tc_mutex_inherit()
+{
+	/* 设置TestCase清理回调函数 */
+	tc_cleanup(_tc_cleanup);
+	mutex_inherit_init();
+
+	/* 返回TestCase运行的最长时间 */
+	return 100;
+}
+/* 输出函数命令到finsh shell中 */
+FINSH_FUNCTION_EXPORT(_tc_mutex_inherit, mutex priority inheritance chain example);
+#else
+/* 用户应用入口 */
+int rt_application_init()
+{
+	mutex_inherit_init();
+
+	return 0;
+}
+#endif
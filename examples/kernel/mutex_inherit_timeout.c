@@ -0,0 +1,157 @@
+/*
+ * 程序清单：互斥锁等待超时后的优先级继承
+ *
+ * thread3持有mutex_b，thread2持有mutex_a并等待mutex_b 10个OS Tick。thread2等待
+ * 超时后，在它运行之前thread1开始等待mutex_a，thread1的优先级只应传递给thread2，
+ * 不应再沿等待链传递给thread3，thread2也不应再被插入mutex_b的等待队列。
+ */
+#include <rtthread.h>
+#include "tc_comm.h"
+
+/* 指向线程控制块的指针 */
+static rt_thread_t tid1 = RT_NULL;
+static rt_thread_t tid2 = RT_NULL;
+static rt_thread_t tid3 = RT_NULL;
+static rt_mutex_t mutex_a = RT_NULL;
+static rt_mutex_t mutex_b = RT_NULL;
+static rt_tick_t start_tick;
+
+/* 线程1入口 */
+static void thread1_entry(void* parameter)
+{
+	rt_thread_delay(8);
+
+	/* 忙等待，使thread2等待超时后不能运行 */
+	while (rt_tick_get() - start_tick < 16) ;
+	if (tid2->stat != RT_THREAD_READY)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+
+	/* thread2持有mutex_a，应把thread2的优先级提升到thread1的优先级 */
+	rt_mutex_take(mutex_a, RT_WAITING_FOREVER);
+
+	/* mutex_b的等待队列应为空，thread3应保持原优先级 */
+	if (!rt_list_isempty(&(mutex_b->parent.suspend_thread)) ||
+		tid3->current_priority != THREAD_PRIORITY + 2)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+
+	rt_mutex_release(mutex_a);
+}
+
+/* 线程2入口 */
+static void thread2_entry(void* parameter)
+{
+	rt_err_t result;
+
+	rt_thread_delay(2);
+
+	rt_mutex_take(mutex_a, RT_WAITING_FOREVER);
+
+	/* 等待mutex_b 10个OS Tick，应超时 */
+	result = rt_mutex_take(mutex_b, 10);
+	if (result != -RT_ETIMEOUT)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+
+	/* thread2继承thread1的优先级，thread3不再继承 */
+	if (tid2->current_priority != THREAD_PRIORITY ||
+		tid3->current_priority != THREAD_PRIORITY + 2)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+
+	rt_mutex_release(mutex_a);
+
+	/* 释放后应恢复原优先级 */
+	if (tid2->current_priority != THREAD_PRIORITY + 1)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+}
+
+/* 线程3入口 */
+static void thread3_entry(void* parameter)
+{
+	rt_mutex_take(mutex_b, RT_WAITING_FOREVER);
+	rt_thread_delay(30);
+	rt_mutex_release(mutex_b);
+}
+
+int mutex_inherit_timeout_init()
+{
+	/* 创建互斥锁 */
+	mutex_a = rt_mutex_create("mutex_a", RT_IPC_FLAG_PRIO);
+	mutex_b = rt_mutex_create("mutex_b", RT_IPC_FLAG_PRIO);
+	if (mutex_a == RT_NULL || mutex_b == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	tid1 = rt_thread_create("t1",
+		thread1_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY, THREAD_TIMESLICE);
+	tid2 = rt_thread_create("t2",
+		thread2_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY + 1, THREAD_TIMESLICE);
+	tid3 = rt_thread_create("t3",
+		thread3_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY + 2, THREAD_TIMESLICE);
+	if (tid1 == RT_NULL || tid2 == RT_NULL || tid3 == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	start_tick = rt_tick_get();
+	rt_thread_startup(tid1);
+	rt_thread_startup(tid2);
+	rt_thread_startup(tid3);
+
+	return 0;
+}
+
+#ifdef RT_USING_TC
+static void _tc_cleanup()
+{
+	/* 调度器上锁，上锁后，将不再切换到其他线程，仅响应中断 */
+	rt_enter_critical();
+
+	/* 删除线程 */
+	if (tid1 != RT_NULL && tid1->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid1);
+	if (tid2 != RT_NULL && tid2->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid2);
+	if (tid3 != RT_NULL && tid3->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid3);
+
+	if (mutex_a != RT_NULL) rt_mutex_delete(mutex_a);
+	if (mutex_b != RT_NULL) rt_mutex_delete(mutex_b);
+
+	/* 调度器解锁 */
+	rt_exit_critical();
+
+	/* 设置TestCase状态 */
+	tc_done(TC_STAT_PASSED);
+}
+
+int _tc_mutex_inherit_timeout()
+{
+	/* 设置TestCase清理回调函数 */
+	tc_cleanup(_tc_cleanup);
+	mutex_inherit_timeout_init();
+
+	/* 返回TestCase运行的最长时间 */
+	return 100;
+}
+/* 输出函数命令到finsh shell中 */
+FINSH_FUNCTION_EXPORT(_tc_mutex_inherit_timeout, mutex timeout before priority inheritance example);
+#else
+/* 用户应用入口 */
+int rt_application_init()
+{
+	mutex_inherit_timeout_init();
+
+	return 0;
+}
+#endif
@@ -0,0 +1,135 @@
+/*
+ * 程序清单：等待多个IPC对象
+ *
+ * 线程1同时等待信号量、邮箱和消息队列，线程2依次向邮箱发送邮件、释放信号量，
+ * 线程1应依次得到邮箱和信号量就绪的结果，最后等待超时。
+ */
+#include <rtthread.h>
+#include "tc_comm.h"
+
+#ifdef RT_USING_WAIT_ANY
+/* 指向线程控制块的指针 */
+static rt_thread_t tid1 = RT_NULL;
+static rt_thread_t tid2 = RT_NULL;
+static rt_sem_t sem = RT_NULL;
+static rt_mailbox_t mb = RT_NULL;
+static rt_mq_t mq = RT_NULL;
+
+/* 线程1入口 */
+static void thread1_entry(void* parameter)
+{
+	rt_object_t objects[3];
+	rt_uint32_t value;
+	rt_int32_t index;
+
+	objects[0] = &(sem->parent.parent);
+	objects[1] = &(mb->parent.parent);
+	objects[2] = &(mq->parent.parent);
+
+	/* 邮箱先就绪 */
+	index = rt_wait_any(objects, 3, 20);
+	if (index != 1 || rt_mb_recv(mb, &value, RT_WAITING_NO) != RT_EOK || value != 1)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+
+	/* 然后信号量就绪 */
+	index = rt_wait_any(objects, 3, 20);
+	if (index != 0 || rt_sem_trytake(sem) != RT_EOK)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+
+	/* 没有对象就绪，应超时 */
+	index = rt_wait_any(objects, 3, 10);
+	if (index != -RT_ETIMEOUT)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+}
+
+/* 线程2入口 */
+static void thread2_entry(void* parameter)
+{
+	rt_thread_delay(5);
+	rt_mb_send(mb, 1);
+
+	rt_thread_delay(5);
+	rt_sem_release(sem);
+}
+
+int wait_any_simple_init()
+{
+	/* 创建IPC对象 */
+	sem = rt_sem_create("sem", 0, RT_IPC_FLAG_FIFO);
+	mb = rt_mb_create("mb", 4, RT_IPC_FLAG_FIFO);
+	mq = rt_mq_create("mq", 4, 4, RT_IPC_FLAG_FIFO);
+	if (sem == RT_NULL || mb == RT_NULL || mq == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	tid1 = rt_thread_create("t1",
+		thread1_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY, THREAD_TIMESLICE);
+	tid2 = rt_thread_create("t2",
+		thread2_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY + 1, THREAD_TIMESLICE);
+	if (tid1 == RT_NULL || tid2 == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	rt_thread_startup(tid1);
+	rt_thread_startup(tid2);
+
+	return 0;
+}
+
+#ifdef RT_USING_TC
+static void _tc_cleanup()
+{
+	/* 调度器上锁，上锁后，将不再切换到其他线程，仅响应中断 */
+	rt_enter_critical();
+
+	/* 删除线程 */
+	if (tid1 != RT_NULL && tid1->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid1);
+	if (tid2 != RT_NULL && tid2->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid2);
+
+	/* 删除IPC对象 */
+	if (sem != RT_NULL) rt_sem_delete(sem);
+	if (mb != RT_NULL) rt_mb_delete(mb);
+	if (mq != RT_NULL) rt_mq_delete(mq);
+
+	/* 调度器解锁 */
+	rt_exit_critical();
+
+	/* 设置TestCase状态 */
+	tc_done(TC_STAT_PASSED);
+}
+
+int _tc_wait_any_simple()
+{
+	/* 设置TestCase清理回调函数 */
+	tc_cleanup(_tc_cleanup);
+	wait_any_simple_init();
+
+	/* 返回TestCase运行的最长时间 */
+	return 50;
+}
+/* 输出函数命令到finsh shell中 */
+FINSH_FUNCTION_EXPORT(_tc_wait_any_simple, wait for any of IPC objects example);
+#else
+/* 用户应用入口 */
+int rt_application_init()
+{
+	wait_any_simple_init();
+
+	return 0;
+}
+#endif
+#endif
@@ -0,0 +1,119 @@
+/*
+ * 程序清单：工作队列例程
+ *
+ * 提交一个普通工作和一个延时工作到同一工作队列，取消另一个延时工作，
+ * 并在flush后检查各工作的执行次数。
+ */
+#include <rtthread.h>
+#include "tc_comm.h"
+
+#ifdef RT_USING_WORKQUEUE
+/* 指向线程控制块的指针 */
+static rt_thread_t tid = RT_NULL;
+static rt_workqueue_t queue = RT_NULL;
+static struct rt_work work;
+static struct rt_delayed_work dwork1, dwork2;
+static int count[3];
+
+/* 工作函数，work_data指向计数 */
+static void work_func(struct rt_work *work, void *work_data)
+{
+	(*(int*)work_data) ++;
+}
+
+/* 线程入口 */
+static void thread_entry(void* parameter)
+{
+	rt_work_init(&work, work_func, &count[0]);
+	rt_delayed_work_init(&dwork1, work_func, &count[1]);
+	rt_delayed_work_init(&dwork2, work_func, &count[2]);
+
+	/* 提交工作 */
+	rt_workqueue_dowork(queue, &work);
+	/* 提交延时工作，分别延时5和10个OS Tick */
+	rt_workqueue_submit_delayed(queue, &dwork1, 5);
+	rt_workqueue_submit_delayed(queue, &dwork2, 10);
+
+	/* 取消延时工作2 */
+	if (rt_workqueue_cancel_work_sync(queue, &dwork2.work) != RT_EOK)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return;
+	}
+
+	/* 等待延时工作1到期后，等待工作队列中的工作全部完成 */
+	rt_thread_delay(20);
+	rt_workqueue_flush(queue);
+
+	/* 工作及延时工作1执行一次，延时工作2不应执行 */
+	if (count[0] != 1 || count[1] != 1 || count[2] != 0)
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+}
+
+int workqueue_simple_init()
+{
+	/* 创建工作队列，优先级低于测试线程 */
+	queue = rt_workqueue_create("wq", THREAD_STACK_SIZE, THREAD_PRIORITY + 1);
+	if (queue == RT_NULL)
+	{
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+		return 0;
+	}
+
+	tid = rt_thread_create("t1",
+		thread_entry, RT_NULL,
+		THREAD_STACK_SIZE, THREAD_PRIORITY, THREAD_TIMESLICE);
+	if (tid != RT_NULL)
+		rt_thread_startup(tid);
+	else
+		tc_stat(TC_STAT_END | TC_STAT_FAILED);
+
+	return 0;
+}
+
+#ifdef RT_USING_TC
+static void _tc_cleanup()
+{
+	/* 调度器上锁，上锁后，将不再切换到其他线程，仅响应中断 */
+	rt_enter_critical();
+
+	/* 删除线程 */
+	if (tid != RT_NULL && tid->stat != RT_THREAD_CLOSE)
+		rt_thread_delete(tid);
+
+	/* 调度器解锁 */
+	rt_exit_critical();
+
+	/* 删除工作队列 */
+	if (queue != RT_NULL)
+	{
+		rt_workqueue_cancel_work(queue, &dwork1.work);
+		rt_workqueue_cancel_work(queue, &dwork2.work);
+		rt_workqueue_destroy(queue);
+	}
+
+	/* 设置TestCase状态 */
+	tc_done(TC_STAT_PASSED);
+}
+
+int _tc_workqueue_simple()
+{
+	/* 设置TestCase清理回调函数 */
+	tc_cleanup(_tc_cleanup);
+	workqueue_simple_init();
+
+	/* 返回TestCase运行的最长时间 */
+	return 50;
+}
+/* 输出函数命令到finsh shell中 */
+FINSH_FUNCTION_EXPORT(_tc_workqueue_simple, a workqueue example);
+#else
+/* 用户应用入口 */
+int rt_application_init()
+{
+	workqueue_simple_init();
+
+	return 0;
+}
+#endif
+#endif
@@ -0,0 +1,141 @@
+/*
+ * File      : context_switch_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-23     Bernard      first version
+ */
+
+/*
+ * Measure the context switch between two threads, which ping-pong by two
+ * semaphores. Each round is two context switches. The threads work in
+ * three modes:
+ *   int   - both threads only use integer registers;
+ *   float - both threads do float arithmetic in each round, so that both
+ *           of them have FP context;
+ *   mixed - only one thread does float arithmetic.
+ *
+ * It only uses OS tick for timing, so it could run on QEMU, which doesn't
+ * emulate the cycle counter of DWT.
+ */
+
+#include <rtthread.h>
+
+#ifdef RT_USING_SEMAPHORE
+
+#define CS_TEST_ROUNDS          10000
+#define CS_TEST_STACK_SIZE      512
+
+static struct rt_semaphore cs_ping, cs_pong, cs_done;
+static ALIGN(RT_ALIGN_SIZE) rt_uint8_t cs_stack[2][CS_TEST_STACK_SIZE];
+static struct rt_thread cs_thread[2];
+static volatile float cs_result[2];
+
+static void cs_float_work(int index)
+{
+    float value;
+
+    value = cs_result[index];
+    value = value * 1.0001f + 0.5f;
+    cs_result[index] = value;
+}
+
+static void cs_ping_entry(void *parameter)
+{
+    int use_float = (int)(rt_uint32_t)parameter;
+    int round;
+
+    for (round = 0; round < CS_TEST_ROUNDS; round ++)
+    {
+        if (use_float) cs_float_work(0);
+
+        rt_sem_release(&cs_ping);
+        rt_sem_take(&cs_pong, RT_WAITING_FOREVER);
+    }
+
+    rt_sem_release(&cs_done);
+}
+
+static void cs_pong_entry(void *parameter)
+{
+    int use_float = (int)(rt_uint32_t)parameter;
+    int round;
+
+    for (round = 0; round < CS_TEST_ROUNDS; round ++)
+    {
+        rt_sem_take(&cs_ping, RT_WAITING_FOREVER);
+        if (use_float) cs_float_work(1);
+
+        rt_sem_release(&cs_pong);
+    }
+
+    rt_sem_release(&cs_done);
+}
+
+static void cs_test_run(const char *name, int ping_float, int pong_float)
+{
+    rt_uint8_t priority;
+    rt_tick_t tick;
+
+    /* the two threads run in the same priority higher than the tester */
+    priority = rt_thread_self()->current_priority;
+    if (priority > 0) priority -= 1;
+
+    rt_sem_init(&cs_ping, "csping", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&cs_pong, "cspong", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&cs_done, "csdone", 0, RT_IPC_FLAG_FIFO);
+
+    rt_thread_init(&cs_thread[0], "csping", cs_ping_entry,
+                   (void *)(rt_uint32_t)ping_float,
+                   &cs_stack[0][0], CS_TEST_STACK_SIZE, priority, 10);
+    rt_thread_init(&cs_thread[1], "cspong", cs_pong_entry,
+                   (void *)(rt_uint32_t)pong_float,
+                   &cs_stack[1][0], CS_TEST_STACK_SIZE, priority, 10);
+
+    /* align to the beginning of a tick */
+    tick = rt_tick_get();
+    while (rt_tick_get() == tick) ;
+
+    tick = rt_tick_get();
+    rt_thread_startup(&cs_thread[1]);
+    rt_thread_startup(&cs_thread[0]);
+
+    rt_sem_take(&cs_done, RT_WAITING_FOREVER);
+    rt_sem_take(&cs_done, RT_WAITING_FOREVER);
+    tick = rt_tick_get() - tick;
+    if (tick == 0) tick = 1;
+
+    rt_kprintf("%-6s %6d switches in %5d ticks, %8d switches/s\n", name,
+               CS_TEST_ROUNDS * 2, tick,
+               (CS_TEST_ROUNDS * 2 * RT_TICK_PER_SECOND) / tick);
+
+    /* let the threads exit */
+    rt_thread_delay(2);
+
+    rt_sem_detach(&cs_ping);
+    rt_sem_detach(&cs_pong);
+    rt_sem_detach(&cs_done);
+}
+
+int context_switch_test(void)
+{
+    cs_result[0] = cs_result[1] = 0.0f;
+
+    cs_test_run("int",   0, 0);
+    cs_test_run("float", 1, 1);
+    cs_test_run("mixed", 1, 0);
+
+    return 0;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(context_switch_test, benchmark the context switch of integer and FP threads);
+#endif
+#endif
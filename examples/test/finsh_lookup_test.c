@@ -0,0 +1,77 @@
+/*
+ * File      : finsh_lookup_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-14     Bernard      first version
+ */
+
+/*
+ * Look up every exported function of finsh by the scan of symbol table and
+ * by finsh_syscall_lookup, which uses the sorted index when the heap is used,
+ * and compare the ticks.
+ */
+
+#include <rtthread.h>
+
+#if defined(RT_USING_FINSH) && defined(FINSH_USING_SYMTAB)
+#include <finsh.h>
+
+#define LOOKUP_TEST_LOOPS       100
+
+static struct finsh_syscall* lookup_scan(const char* name)
+{
+    struct finsh_syscall* index;
+
+    for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+    {
+        if (strcmp(index->name, name) == 0)
+            return index;
+    }
+
+    return RT_NULL;
+}
+
+void finsh_lookup_test(void)
+{
+    struct finsh_syscall* index;
+    rt_tick_t scan_ticks, lookup_ticks;
+    int loop, count, errors;
+
+    count = errors = 0;
+    for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+    {
+        if (finsh_syscall_lookup(index->name) != index)
+            errors ++;
+        count ++;
+    }
+
+    scan_ticks = rt_tick_get();
+    for (loop = 0; loop < LOOKUP_TEST_LOOPS; loop ++)
+    {
+        for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+            lookup_scan(index->name);
+    }
+    scan_ticks = rt_tick_get() - scan_ticks;
+
+    lookup_ticks = rt_tick_get();
+    for (loop = 0; loop < LOOKUP_TEST_LOOPS; loop ++)
+    {
+        for (index = _syscall_table_begin; index < _syscall_table_end; FINSH_NEXT_SYSCALL(index))
+            finsh_syscall_lookup(index->name);
+    }
+    lookup_ticks = rt_tick_get() - lookup_ticks;
+
+    rt_kprintf("%d symbols, %d errors\n", count, errors);
+    rt_kprintf("scan: %d ticks, lookup: %d ticks for %d loops\n",
+               scan_ticks, lookup_ticks, LOOKUP_TEST_LOOPS);
+}
+FINSH_FUNCTION_EXPORT(finsh_lookup_test, compare the lookup of finsh symbols);
+
+#endif /* RT_USING_FINSH && FINSH_USING_SYMTAB */
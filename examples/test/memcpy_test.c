@@ -0,0 +1,179 @@
+/*
+ * File      : memcpy_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-18     Bernard      first version
+ */
+
+/*
+ * Verify and measure rt_memcpy/rt_memmove/rt_memset for the sizes from 4 bytes
+ * to 64K bytes in all combinations of source and destination alignment.
+ *
+ * The result is the throughput in KB per second, the size is copied repeatedly
+ * until at least MEMCPY_TEST_TICKS ticks are elapsed.
+ */
+
+#include <rtthread.h>
+
+#define MEMCPY_TEST_SIZE_MAX    (64 * 1024)
+#define MEMCPY_TEST_TICKS       (RT_TICK_PER_SECOND / 10)
+
+enum
+{
+    TEST_MEMCPY,
+    TEST_MEMMOVE,
+    TEST_MEMSET,
+};
+
+static const char *test_name[] = {"memcpy", "memmove", "memset"};
+
+static rt_bool_t memcpy_verify(rt_uint8_t *dst, rt_uint8_t *src)
+{
+    rt_uint32_t size, i;
+    int sa, da;
+
+    for (size = 0; size < 256; size ++)
+    {
+        for (sa = 0; sa < 4; sa ++)
+        {
+            for (da = 0; da < 4; da ++)
+            {
+                for (i = 0; i < size + 8; i ++)
+                {
+                    src[i] = (rt_uint8_t)(i * 7 + 1);
+                    dst[i] = 0xAA;
+                }
+
+                rt_memcpy(dst + da, src + sa, size);
+                for (i = 0; i < size + 8; i ++)
+                {
+                    rt_uint8_t expect = 0xAA;
+
+                    if (i >= da && i < da + size)
+                        expect = src[i - da + sa];
+                    if (dst[i] != expect)
+                    {
+                        rt_kprintf("memcpy failed: size %d, src+%d, dst+%d\n", size, sa, da);
+                        return RT_FALSE;
+                    }
+                }
+
+                /* move the data forward and backward in the same buffer */
+                rt_memcpy(dst, src, size + 8);
+                rt_memmove(dst + da + 4, dst + sa, size);
+                rt_memmove(dst + sa, dst + da + 4, size);
+                for (i = 0; i < size; i ++)
+                {
+                    if (dst[i + sa] != src[i + sa])
+                    {
+                        rt_kprintf("memmove failed: size %d, src+%d, dst+%d\n", size, sa, da);
+                        return RT_FALSE;
+                    }
+                }
+            }
+        }
+    }
+
+    return RT_TRUE;
+}
+
+static rt_uint32_t memcpy_measure(int type, rt_uint8_t *dst, rt_uint8_t *src, rt_uint32_t size)
+{
+    rt_tick_t start, elapsed;
+    rt_uint32_t loop, total;
+
+    total = 0;
+    loop = 0;
+    start = rt_tick_get();
+    do
+    {
+        switch (type)
+        {
+        case TEST_MEMCPY:
+            rt_memcpy(dst, src, size);
+            break;
+        case TEST_MEMMOVE:
+            /* overlapped and backward */
+            rt_memmove(src + 8, src, size);
+            break;
+        case TEST_MEMSET:
+            rt_memset(dst, loop, size);
+            break;
+        }
+
+        loop ++;
+        total += size;
+        elapsed = rt_tick_get() - start;
+    } while (elapsed < MEMCPY_TEST_TICKS);
+
+    /* KB per second */
+    return (total / 1024) * RT_TICK_PER_SECOND / elapsed;
+}
+
+void memcpy_test(void)
+{
+    rt_uint8_t *src, *dst;
+    rt_uint32_t size;
+    int type, sa, da;
+
+    /* the extra room is for alignment and the overlapped move */
+    src = (rt_uint8_t *)rt_malloc_align(MEMCPY_TEST_SIZE_MAX + 16, 4);
+    dst = (rt_uint8_t *)rt_malloc_align(MEMCPY_TEST_SIZE_MAX + 16, 4);
+    if (src == RT_NULL || dst == RT_NULL)
+    {
+        rt_kprintf("no memory\n");
+        goto __exit;
+    }
+
+    if (memcpy_verify(dst, src) == RT_FALSE)
+        goto __exit;
+    rt_kprintf("verify passed\n");
+
+    for (type = TEST_MEMCPY; type <= TEST_MEMSET; type ++)
+    {
+        rt_kprintf("%s (KB/s), source/destination offset:\n", test_name[type]);
+        rt_kprintf("%15s", "size");
+        for (sa = 0; sa < 4; sa ++)
+        {
+            for (da = 0; da < 4; da ++)
+            {
+                /* memset has only destination */
+                if (type == TEST_MEMSET && sa != 0)
+                    continue;
+                rt_kprintf("    %d/%d", sa, da);
+            }
+        }
+        rt_kprintf("\n");
+
+        for (size = 4; size <= MEMCPY_TEST_SIZE_MAX; size <<= 2)
+        {
+            rt_kprintf("%15d", size);
+            for (sa = 0; sa < 4; sa ++)
+            {
+                for (da = 0; da < 4; da ++)
+                {
+                    if (type == TEST_MEMSET && sa != 0)
+                        continue;
+                    rt_kprintf(" %6d", memcpy_measure(type, dst + da, src + sa, size));
+                }
+            }
+            rt_kprintf("\n");
+        }
+    }
+
+__exit:
+    if (src != RT_NULL) rt_free_align(src);
+    if (dst != RT_NULL) rt_free_align(dst);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(memcpy_test, verify and measure memory copy routines);
+#endif
@@ -0,0 +1,94 @@
+/*
+ * File      : memheap_attr_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-26     Bernard      first version
+ */
+
+/*
+ * Two memory heaps simulate the internal SRAM and the external SDRAM, and
+ * the allocations of rt_malloc_attr and rt_malloc_usage are checked whether
+ * they are placed in the expected memory heap.
+ */
+
+#include <rtthread.h>
+
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+
+#define MEMHEAP_TEST_SIZE       1024
+
+static struct rt_memheap sram_heap, sdram_heap;
+static ALIGN(RT_ALIGN_SIZE) rt_uint8_t sram_pool[MEMHEAP_TEST_SIZE];
+static ALIGN(RT_ALIGN_SIZE) rt_uint8_t sdram_pool[MEMHEAP_TEST_SIZE];
+
+static int memheap_test_in(void *ptr, rt_uint8_t *pool)
+{
+    return (rt_uint8_t *)ptr >= pool && (rt_uint8_t *)ptr < pool + MEMHEAP_TEST_SIZE;
+}
+
+static int memheap_test_check(const char *name, void *ptr, rt_uint8_t *pool)
+{
+    int result;
+
+    result = ptr != RT_NULL && (pool == RT_NULL || memheap_test_in(ptr, pool));
+    rt_kprintf("%-24s %s\n", name, result ? "pass" : "failed");
+    rt_free(ptr);
+
+    return result ? 0 : -1;
+}
+
+int memheap_attr_test(void)
+{
+    void *ptr;
+    int result = 0;
+
+    rt_memheap_init(&sram_heap, "tsram", sram_pool, sizeof(sram_pool));
+    rt_memheap_set_attr(&sram_heap, RT_MEMHEAP_ATTR_FAST | RT_MEMHEAP_ATTR_DMA);
+    rt_memheap_init(&sdram_heap, "tsdram", sdram_pool, sizeof(sdram_pool));
+    rt_memheap_set_attr(&sdram_heap, RT_MEMHEAP_ATTR_EXTERNAL | RT_MEMHEAP_ATTR_CACHEABLE);
+
+    /* the external memory is only in the simulated SDRAM */
+    ptr = rt_malloc_attr(128, RT_MEMHEAP_ATTR_EXTERNAL);
+    result |= memheap_test_check("external", ptr, sdram_pool);
+
+    ptr = rt_malloc_usage(128, RT_MALLOC_USAGE_GUI);
+    result |= memheap_test_check("GUI usage", ptr, sdram_pool);
+
+    /* required attributes, larger than the memory heap */
+    ptr = rt_malloc_attr(MEMHEAP_TEST_SIZE * 2, RT_MEMHEAP_ATTR_EXTERNAL);
+    rt_kprintf("%-24s %s\n", "external too large", ptr == RT_NULL ? "pass" : "failed");
+    if (ptr != RT_NULL)
+    {
+        rt_free(ptr);
+        result = -1;
+    }
+
+    /* the DMA buffer is never placed in the simulated SDRAM */
+    ptr = rt_malloc_usage(128, RT_MALLOC_USAGE_DMA);
+    result |= memheap_test_check("DMA usage", ptr, RT_NULL);
+    if (memheap_test_in(ptr, sdram_pool))
+        result = -1;
+
+    /* preferred attributes fall back to other memory heaps */
+    ptr = rt_malloc_attr(MEMHEAP_TEST_SIZE / 2,
+                         RT_MEMHEAP_ATTR_EXTERNAL | RT_MEMHEAP_ATTR_FAST | RT_MALLOC_ATTR_PREFER);
+    result |= memheap_test_check("preferred fallback", ptr, RT_NULL);
+
+    rt_memheap_detach(&sdram_heap);
+    rt_memheap_detach(&sram_heap);
+
+    return result;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(memheap_attr_test, test the placement of memory heap attributes);
+#endif
+#endif
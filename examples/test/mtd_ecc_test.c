@@ -0,0 +1,222 @@
+/*
+ * File      : mtd_ecc_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-26     Bernard      first version
+ */
+
+/*
+ * Verify and measure the software ECC of MTD layer. The random bit flips from
+ * 1 to t bits must be corrected, and t + 1 bits must not be taken as corrected.
+ *
+ * The result is the throughput in KB per second of calculating ECC (writing)
+ * and of checking one step with one bit flip (reading).
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifdef RT_USING_MTD_ECC
+
+#define ECC_TEST_STEP_MAX       512
+#define ECC_TEST_LOOPS          200
+#define ECC_TEST_TICKS          (RT_TICK_PER_SECOND / 10)
+
+struct ecc_test_mode
+{
+    const char *name;
+    rt_uint16_t step;
+    rt_uint8_t  t;              /* 0 for Hamming code */
+};
+
+static const struct ecc_test_mode test_mode[] =
+{
+    {"hamming256", 256, 0},
+    {"hamming512", 512, 0},
+    {"bch4",       512, 4},
+    {"bch8",       512, 8},
+};
+
+static rt_uint32_t _seed = 1;
+
+static rt_uint32_t ecc_random(void)
+{
+    _seed = _seed * 1103515245 + 12345;
+
+    return (_seed >> 16) & 0x7FFF;
+}
+
+static void ecc_calc(const struct ecc_test_mode *mode, struct rt_mtd_bch *bch,
+                     const rt_uint8_t *data, rt_uint8_t *ecc)
+{
+    if (bch != RT_NULL)
+        rt_mtd_bch_calc(bch, data, ecc);
+    else
+        rt_mtd_hamming_calc(data, mode->step, ecc);
+}
+
+static int ecc_correct(const struct ecc_test_mode *mode, struct rt_mtd_bch *bch,
+                       rt_uint8_t *data, const rt_uint8_t *read_ecc, const rt_uint8_t *calc_ecc)
+{
+    if (bch != RT_NULL)
+        return rt_mtd_bch_correct(bch, data, read_ecc, calc_ecc);
+
+    return rt_mtd_hamming_correct(data, mode->step, read_ecc, calc_ecc);
+}
+
+static rt_bool_t ecc_verify(const struct ecc_test_mode *mode, struct rt_mtd_bch *bch,
+                            rt_uint8_t *data, rt_uint8_t *orig, rt_uint32_t ecc_bytes)
+{
+    rt_uint8_t read_ecc[32], calc_ecc[32];
+    rt_uint32_t loop, index, bit;
+    int t, flips, result;
+
+    t = mode->t ? mode->t : 1;
+    for (loop = 0; loop < ECC_TEST_LOOPS; loop ++)
+    {
+        for (index = 0; index < mode->step; index ++)
+            orig[index] = (rt_uint8_t)ecc_random();
+        ecc_calc(mode, bch, orig, read_ecc);
+
+        for (flips = 1; flips <= t + 1; flips ++)
+        {
+            rt_memcpy(data, orig, mode->step);
+
+            /* the different bits of data */
+            for (index = 0; index < flips; index ++)
+            {
+                do
+                {
+                    bit = ecc_random() % (mode->step * 8);
+                } while (data[bit >> 3] != orig[bit >> 3]);
+                data[bit >> 3] ^= 1 << (bit & 0x07);
+            }
+
+            ecc_calc(mode, bch, data, calc_ecc);
+            result = ecc_correct(mode, bch, data, read_ecc, calc_ecc);
+            if (flips <= t)
+            {
+                if (result != flips || rt_memcmp(data, orig, mode->step) != 0)
+                {
+                    rt_kprintf("%s failed: %d bits flip, result %d\n", mode->name, flips, result);
+                    return RT_FALSE;
+                }
+            }
+            else if (result >= 0 && rt_memcmp(data, orig, mode->step) == 0)
+            {
+                rt_kprintf("%s failed: %d bits flip are corrected\n", mode->name, flips);
+                return RT_FALSE;
+            }
+        }
+    }
+
+    /* the ECC of erased data should be erased too */
+    rt_memset(data, 0xFF, mode->step);
+    ecc_calc(mode, bch, data, calc_ecc);
+    for (index = 0; index < ecc_bytes; index ++)
+    {
+        if (calc_ecc[index] != 0xFF)
+        {
+            rt_kprintf("%s failed: the ECC of erased data\n", mode->name);
+            return RT_FALSE;
+        }
+    }
+
+    return RT_TRUE;
+}
+
+static rt_uint32_t ecc_measure(const struct ecc_test_mode *mode, struct rt_mtd_bch *bch,
+                               rt_uint8_t *data, rt_bool_t correct)
+{
+    rt_uint8_t read_ecc[32], calc_ecc[32];
+    rt_tick_t start, elapsed;
+    rt_uint32_t total;
+
+    ecc_calc(mode, bch, data, read_ecc);
+
+    total = 0;
+    start = rt_tick_get();
+    do
+    {
+        if (correct == RT_TRUE)
+        {
+            data[total % mode->step] ^= 0x01;
+            ecc_calc(mode, bch, data, calc_ecc);
+            ecc_correct(mode, bch, data, read_ecc, calc_ecc);
+        }
+        else
+        {
+            ecc_calc(mode, bch, data, calc_ecc);
+        }
+
+        total += mode->step;
+        elapsed = rt_tick_get() - start;
+    } while (elapsed < ECC_TEST_TICKS);
+
+    /* KB per second */
+    return (total / 1024) * RT_TICK_PER_SECOND / elapsed;
+}
+
+void mtd_ecc_test(void)
+{
+    const struct ecc_test_mode *mode;
+    struct rt_mtd_bch *bch;
+    rt_uint8_t *data, *orig;
+    rt_uint32_t ecc_bytes;
+    int index;
+
+    data = (rt_uint8_t *)rt_malloc_align(ECC_TEST_STEP_MAX, 4);
+    orig = (rt_uint8_t *)rt_malloc_align(ECC_TEST_STEP_MAX, 4);
+    if (data == RT_NULL || orig == RT_NULL)
+    {
+        rt_kprintf("no memory\n");
+        goto __exit;
+    }
+
+    rt_kprintf("%15s %6s %12s %12s\n", "mode", "bytes", "calc(KB/s)", "check(KB/s)");
+    for (index = 0; index < sizeof(test_mode) / sizeof(test_mode[0]); index ++)
+    {
+        mode = &test_mode[index];
+
+        bch = RT_NULL;
+        ecc_bytes = RT_MTD_HAMMING_BYTES;
+        if (mode->t != 0)
+        {
+            bch = rt_mtd_bch_create(mode->t, mode->step);
+            if (bch == RT_NULL)
+            {
+                rt_kprintf("%s: no memory\n", mode->name);
+                continue;
+            }
+            ecc_bytes = bch->ecc_bytes;
+        }
+
+        if (ecc_verify(mode, bch, data, orig, ecc_bytes) == RT_TRUE)
+        {
+            rt_kprintf("%15s %6d %12d %12d\n", mode->name, ecc_bytes,
+                       ecc_measure(mode, bch, data, RT_FALSE),
+                       ecc_measure(mode, bch, data, RT_TRUE));
+        }
+
+        if (bch != RT_NULL)
+            rt_mtd_bch_delete(bch);
+    }
+
+__exit:
+    if (data != RT_NULL) rt_free_align(data);
+    if (orig != RT_NULL) rt_free_align(orig);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(mtd_ecc_test, verify and measure software ECC of MTD layer);
+#endif
+
+#endif /* RT_USING_MTD_ECC */
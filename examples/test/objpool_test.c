@@ -0,0 +1,112 @@
+/*
+ * File      : objpool_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-24     Bernard      first version
+ */
+
+/*
+ * Create and delete semaphores, timers and threads repeatedly, like the
+ * per-request threads and transient timers. The result is the ticks of
+ * churn and the heap usage before and after it. One round is made at first
+ * to warm up the pools, then the heap usage shall not change in the churn.
+ */
+
+#include <rtthread.h>
+
+#if defined(RT_USING_HEAP) && defined(RT_USING_SEMAPHORE) && !defined(RT_USING_MEMHEAP_AS_HEAP)
+
+#define OBJPOOL_TEST_ROUNDS     1000
+#define OBJPOOL_TEST_STACK_SIZE 512
+
+static void objpool_thread_entry(void *parameter)
+{
+    rt_sem_release((rt_sem_t)parameter);
+}
+
+static void objpool_timeout(void *parameter)
+{
+}
+
+/* create and delete the objects, it returns the rounds done */
+static int objpool_churn(int rounds)
+{
+    rt_thread_t thread;
+    rt_timer_t timer;
+    rt_sem_t sem;
+    int round;
+
+    for (round = 0; round < rounds; round ++)
+    {
+        sem = rt_sem_create("optest", 0, RT_IPC_FLAG_FIFO);
+        if (sem == RT_NULL) break;
+
+        timer = rt_timer_create("optest", objpool_timeout, RT_NULL, 10,
+                                RT_TIMER_FLAG_ONE_SHOT);
+        if (timer == RT_NULL)
+        {
+            rt_sem_delete(sem);
+            break;
+        }
+
+        thread = rt_thread_create("optest", objpool_thread_entry, sem,
+                                  OBJPOOL_TEST_STACK_SIZE,
+                                  RT_THREAD_PRIORITY_MAX - 2, 10);
+        if (thread == RT_NULL)
+        {
+            rt_timer_delete(timer);
+            rt_sem_delete(sem);
+            break;
+        }
+        rt_thread_startup(thread);
+
+        rt_sem_take(sem, RT_WAITING_FOREVER);
+        rt_timer_delete(timer);
+        rt_sem_delete(sem);
+
+        /* let idle thread release the exited thread */
+        rt_thread_delay(1);
+    }
+
+    return round;
+}
+
+int objpool_test(void)
+{
+    rt_uint32_t total, used_before, used_after, max_used;
+    rt_tick_t tick;
+    int round;
+
+    /* warm up the pools */
+    if (objpool_churn(1) != 1)
+        return -1;
+
+    rt_memory_info(&total, &used_before, &max_used);
+
+    tick = rt_tick_get();
+    round = objpool_churn(OBJPOOL_TEST_ROUNDS);
+    tick = rt_tick_get() - tick;
+
+    rt_memory_info(&total, &used_after, &max_used);
+
+    rt_kprintf("%d rounds in %d ticks, heap used %d -> %d, max used %d\n",
+               round, tick, used_before, used_after, max_used);
+
+    if (round != OBJPOOL_TEST_ROUNDS || used_after != used_before)
+        return -1;
+
+    return 0;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(objpool_test, benchmark the churn of kernel objects and thread stacks);
+#endif
+#endif
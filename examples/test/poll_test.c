@@ -0,0 +1,196 @@
+/*
+ * File      : poll_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-10     Bernard      first version
+ */
+
+/*
+ * One thread services two pipes and, with lwIP, a loopback UDP socket by
+ * poll. The producer writes the pipes and sends the datagrams in turn, the
+ * test checks that every message is received from the right descriptor, and
+ * reports the ticks from sending to receiving.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#if defined(RT_USING_DFS) && defined(RT_USING_POLL) && defined(RT_USING_DEVICE)
+#include <dfs_posix.h>
+#ifdef RT_USING_LWIP
+#include <lwip/sockets.h>
+#define POLL_TEST_PORT          5002
+#endif
+
+#define POLL_TEST_MSGS          30
+#define POLL_TEST_PIPE_SIZE     64
+
+struct poll_msg
+{
+    rt_uint32_t seq;
+    rt_tick_t tick;
+};
+
+static struct rt_semaphore _produced;
+
+static void poll_producer(void *parameter)
+{
+    struct poll_msg msg;
+    rt_device_t pipes[2];
+    rt_uint32_t seq;
+#ifdef RT_USING_LWIP
+    int sock;
+    struct sockaddr_in addr;
+
+    sock = (int)parameter;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(POLL_TEST_PORT);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    rt_memset(&(addr.sin_zero), 0, sizeof(addr.sin_zero));
+#endif
+
+    pipes[0] = rt_device_find("ptest0");
+    pipes[1] = rt_device_find("ptest1");
+
+    for (seq = 0; seq < POLL_TEST_MSGS; seq ++)
+    {
+        rt_thread_delay(seq % 3 + 1);
+
+        msg.seq = seq;
+        msg.tick = rt_tick_get();
+#ifdef RT_USING_LWIP
+        if (seq % 3 == 2)
+        {
+            sendto(sock, &msg, sizeof(msg), 0, (struct sockaddr *)&addr, sizeof(addr));
+            continue;
+        }
+#endif
+        rt_device_write(pipes[seq & 0x01], 0, &msg, sizeof(msg));
+    }
+
+    rt_sem_release(&_produced);
+}
+
+void poll_test(void)
+{
+    struct pollfd fds[3];
+    struct poll_msg msg;
+    rt_thread_t producer;
+    rt_uint32_t received, latency, timeouts, index;
+    int nfds, result, expected;
+    int producer_sock = -1;
+
+    if (rt_pipe_create("ptest0", POLL_TEST_PIPE_SIZE) != RT_EOK ||
+        rt_pipe_create("ptest1", POLL_TEST_PIPE_SIZE) != RT_EOK)
+    {
+        rt_kprintf("create pipes failed\n");
+        return;
+    }
+    rt_sem_init(&_produced, "pdone", 0, RT_IPC_FLAG_FIFO);
+
+    fds[0].fd = open("/dev/ptest0", O_RDONLY, 0);
+    fds[1].fd = open("/dev/ptest1", O_RDONLY, 0);
+    nfds = 2;
+#ifdef RT_USING_LWIP
+    {
+        struct sockaddr_in addr;
+
+        fds[2].fd = socket(AF_INET, SOCK_DGRAM, 0);
+        producer_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(POLL_TEST_PORT);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        rt_memset(&(addr.sin_zero), 0, sizeof(addr.sin_zero));
+        if (fds[2].fd >= 0 &&
+            bind(fds[2].fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+            nfds = 3;
+    }
+#endif
+    for (index = 0; index < (rt_uint32_t)nfds; index ++)
+        fds[index].events = POLLIN;
+
+    if (fds[0].fd < 0 || fds[1].fd < 0)
+    {
+        rt_kprintf("open pipes failed\n");
+        goto __exit;
+    }
+
+    producer = rt_thread_create("pprod", poll_producer, (void *)producer_sock,
+                                1024, RT_THREAD_PRIORITY_MAX / 2, 10);
+    if (producer == RT_NULL)
+        goto __exit;
+    rt_thread_startup(producer);
+
+    /* the datagrams are lost when there is no socket */
+    expected = POLL_TEST_MSGS;
+#ifdef RT_USING_LWIP
+    if (nfds < 3)
+        expected -= POLL_TEST_MSGS / 3;
+#endif
+
+    received = latency = timeouts = 0;
+    while (received < (rt_uint32_t)expected)
+    {
+        result = poll(fds, nfds, 1000);
+        if (result == 0)
+        {
+            if (++ timeouts > 2)
+                break;
+            continue;
+        }
+        if (result < 0)
+            break;
+
+        for (index = 0; index < (rt_uint32_t)nfds; index ++)
+        {
+            if (!(fds[index].revents & POLLIN))
+                continue;
+
+#ifdef RT_USING_LWIP
+            if (index == 2)
+                result = recv(fds[index].fd, &msg, sizeof(msg), 0);
+            else
+#endif
+                result = read(fds[index].fd, &msg, sizeof(msg));
+            if (result != sizeof(msg))
+                continue;
+
+            /* the pipe of even messages, the odd one and the socket */
+            if ((index < 2 && (msg.seq & 0x01) != index) ||
+                (index == 2 && msg.seq % 3 != 2))
+                rt_kprintf("message %d from wrong descriptor %d\n", msg.seq, index);
+
+            latency += rt_tick_get() - msg.tick;
+            received ++;
+        }
+    }
+
+    rt_sem_take(&_produced, RT_TICK_PER_SECOND * 5);
+    rt_kprintf("poll: %d/%d messages, %d ticks of total latency\n",
+               received, expected, latency);
+
+__exit:
+    if (fds[0].fd >= 0) close(fds[0].fd);
+    if (fds[1].fd >= 0) close(fds[1].fd);
+#ifdef RT_USING_LWIP
+    if (fds[2].fd >= 0) closesocket(fds[2].fd);
+    if (producer_sock >= 0) closesocket(producer_sock);
+#endif
+    rt_sem_detach(&_produced);
+    rt_pipe_destroy((struct rt_pipe_device *)rt_device_find("ptest0"));
+    rt_pipe_destroy((struct rt_pipe_device *)rt_device_find("ptest1"));
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(poll_test, poll the pipes and socket in one thread);
+#endif
+
+#endif /* RT_USING_DFS && RT_USING_POLL && RT_USING_DEVICE */
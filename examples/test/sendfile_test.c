@@ -0,0 +1,223 @@
+/*
+ * File      : sendfile_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-02     Bernard      first version
+ */
+
+/*
+ * Measure the throughput of sending a file over the loopback TCP connection,
+ * by the read and send loop with a small buffer as well as by sendfile. The
+ * receiver checks the length and the sum of received data.
+ *
+ * For example, sendfile_test("/romfs/index.htm")
+ */
+
+#include <rtthread.h>
+
+#if defined(RT_USING_LWIP) && defined(RT_USING_DFS)
+#include <dfs_posix.h>
+#include <lwip/sockets.h>
+
+#define SENDFILE_TEST_PORT      5001
+#define SENDFILE_TEST_BUFSZ     1024
+#define SENDFILE_TEST_LOOPS     10
+
+struct sendfile_result
+{
+    rt_uint32_t length;
+    rt_uint32_t sum;
+};
+
+static struct sendfile_result _received;
+static struct rt_semaphore _done;
+
+static void sendfile_receiver(void *parameter)
+{
+    int listen_sock, sock, length, index;
+    struct sockaddr_in addr;
+    rt_uint8_t *buffer;
+
+    listen_sock = (int)parameter;
+    buffer = (rt_uint8_t *)rt_malloc(SENDFILE_TEST_BUFSZ);
+
+    while (buffer != RT_NULL)
+    {
+        length = sizeof(addr);
+        sock = accept(listen_sock, (struct sockaddr *)&addr, (socklen_t *)&length);
+        if (sock < 0)
+            break;
+
+        _received.length = 0;
+        _received.sum = 0;
+        while ((length = recv(sock, buffer, SENDFILE_TEST_BUFSZ, 0)) > 0)
+        {
+            _received.length += length;
+            for (index = 0; index < length; index ++)
+                _received.sum += buffer[index];
+        }
+        closesocket(sock);
+
+        rt_sem_release(&_done);
+    }
+
+    rt_free(buffer);
+}
+
+static int sendfile_connect(void)
+{
+    int sock;
+    struct sockaddr_in addr;
+
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(SENDFILE_TEST_PORT);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    rt_memset(&(addr.sin_zero), 0, sizeof(addr.sin_zero));
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        closesocket(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/* send the file once, it returns the ticks or -1 on failed */
+static int sendfile_once(int fd, rt_uint32_t size, rt_bool_t zero_copy, rt_uint8_t *buffer)
+{
+    int sock, length;
+    rt_off_t offset;
+    rt_tick_t start;
+
+    sock = sendfile_connect();
+    if (sock < 0)
+        return -1;
+
+    start = rt_tick_get();
+    if (zero_copy == RT_TRUE)
+    {
+        offset = 0;
+        length = sendfile(sock, fd, &offset, size);
+    }
+    else
+    {
+        lseek(fd, 0, SEEK_SET);
+        while ((length = read(fd, buffer, SENDFILE_TEST_BUFSZ)) > 0)
+        {
+            if (send(sock, buffer, length, 0) != length)
+                break;
+        }
+    }
+    closesocket(sock);
+
+    if (rt_sem_take(&_done, RT_TICK_PER_SECOND * 10) != RT_EOK)
+        return -1;
+
+    return rt_tick_get() - start;
+}
+
+void sendfile_test(const char *path)
+{
+    static rt_thread_t receiver = RT_NULL;
+    int listen_sock;
+    struct sockaddr_in addr;
+    struct sendfile_result expected;
+    rt_uint8_t *buffer;
+    rt_uint32_t ticks;
+    int fd, length, index, loop, result;
+
+    buffer = (rt_uint8_t *)rt_malloc(SENDFILE_TEST_BUFSZ);
+    if (buffer == RT_NULL)
+    {
+        rt_kprintf("no memory\n");
+        return;
+    }
+
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        rt_kprintf("open %s failed\n", path);
+        rt_free(buffer);
+        return;
+    }
+
+    expected.length = 0;
+    expected.sum = 0;
+    while ((length = read(fd, buffer, SENDFILE_TEST_BUFSZ)) > 0)
+    {
+        expected.length += length;
+        for (index = 0; index < length; index ++)
+            expected.sum += buffer[index];
+    }
+
+    if (receiver == RT_NULL)
+    {
+        rt_sem_init(&_done, "sfdone", 0, RT_IPC_FLAG_FIFO);
+
+        listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(SENDFILE_TEST_PORT);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        rt_memset(&(addr.sin_zero), 0, sizeof(addr.sin_zero));
+        if (listen_sock < 0 ||
+            bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            listen(listen_sock, 1) < 0)
+            receiver = RT_NULL;
+        else
+            receiver = rt_thread_create("sfrecv", sendfile_receiver, (void *)listen_sock,
+                                        1024, RT_THREAD_PRIORITY_MAX / 2, 10);
+        if (receiver == RT_NULL)
+        {
+            rt_kprintf("create receiver failed\n");
+            if (listen_sock >= 0) closesocket(listen_sock);
+            rt_sem_detach(&_done);
+            goto __exit;
+        }
+        rt_thread_startup(receiver);
+    }
+
+    rt_kprintf("%10s %10s %12s\n", "method", "bytes", "KB/s");
+    for (index = 0; index < 2; index ++)
+    {
+        ticks = 0;
+        for (loop = 0; loop < SENDFILE_TEST_LOOPS; loop ++)
+        {
+            result = sendfile_once(fd, expected.length, index == 1, buffer);
+            if (result < 0 ||
+                _received.length != expected.length || _received.sum != expected.sum)
+            {
+                rt_kprintf("%s failed: %d bytes received\n",
+                           index ? "sendfile" : "read/send", _received.length);
+                goto __exit;
+            }
+            ticks += result;
+        }
+
+        if (ticks == 0)
+            ticks = 1;
+        rt_kprintf("%10s %10d %12d\n", index ? "sendfile" : "read/send", expected.length,
+                   expected.length / 1024 * SENDFILE_TEST_LOOPS * RT_TICK_PER_SECOND / ticks);
+    }
+
+__exit:
+    close(fd);
+    rt_free(buffer);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(sendfile_test, measure sendfile throughput over loopback);
+#endif
+
+#endif /* RT_USING_LWIP && RT_USING_DFS */
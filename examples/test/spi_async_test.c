@@ -0,0 +1,223 @@
+/*
+ * File      : spi_async_test.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-22     Bernard      first version
+ */
+
+/*
+ * Measure the synchronous and asynchronous transfer on a simulated SPI bus,
+ * which loops the sent data back and spends some cycles for configuring bus
+ * and for each byte. Three devices share the bus, and the same transfers of
+ * them are interleaved in both tests.
+ *
+ * The result is the ticks and the times of bus configuring, and the order
+ * of devices finished in asynchronous test, which is the priority order.
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifdef RT_USING_SPI_ASYNC
+
+#define SPI_TEST_DEVICES        3
+#define SPI_TEST_REQUESTS       64
+#define SPI_TEST_LENGTH         32
+
+/* the simulated cost of bus */
+#define SPI_SIM_CONFIG_LOOPS    2000
+#define SPI_SIM_BYTE_LOOPS      20
+
+struct spi_sim_bus
+{
+    struct rt_spi_bus parent;
+
+    rt_uint32_t configured;
+    rt_uint32_t bytes;
+};
+
+static struct spi_sim_bus sim_bus;
+static struct rt_spi_device sim_device[SPI_TEST_DEVICES];
+
+static void spi_sim_delay(rt_uint32_t loops)
+{
+    volatile rt_uint32_t count;
+
+    for (count = 0; count < loops; count ++) ;
+}
+
+static rt_err_t spi_sim_configure(struct rt_spi_device *device,
+                                  struct rt_spi_configuration *configuration)
+{
+    sim_bus.configured ++;
+    spi_sim_delay(SPI_SIM_CONFIG_LOOPS);
+
+    return RT_EOK;
+}
+
+static rt_uint32_t spi_sim_xfer(struct rt_spi_device *device, struct rt_spi_message *message)
+{
+    if (message->recv_buf != RT_NULL && message->send_buf != RT_NULL)
+        rt_memcpy(message->recv_buf, message->send_buf, message->length);
+    else if (message->recv_buf != RT_NULL)
+        rt_memset(message->recv_buf, 0xFF, message->length);
+
+    sim_bus.bytes += message->length;
+    spi_sim_delay(SPI_SIM_BYTE_LOOPS * message->length);
+
+    return message->length;
+}
+
+static const struct rt_spi_ops spi_sim_ops =
+{
+    spi_sim_configure,
+    spi_sim_xfer,
+};
+
+static rt_err_t spi_sim_init(void)
+{
+    struct rt_spi_configuration cfg;
+    char name[RT_NAME_MAX];
+    int index;
+
+    if (rt_device_find("simspi") != RT_NULL)
+        return RT_EOK;
+
+    if (rt_spi_bus_register(&sim_bus.parent, "simspi", &spi_sim_ops) != RT_EOK)
+        return -RT_ERROR;
+
+    for (index = 0; index < SPI_TEST_DEVICES; index ++)
+    {
+        rt_snprintf(name, sizeof(name), "simspi%d", index);
+        if (rt_spi_bus_attach_device(&sim_device[index], name, "simspi", RT_NULL) != RT_EOK)
+            return -RT_ERROR;
+
+        cfg.data_width = 8;
+        cfg.mode = RT_SPI_MODE_0 | RT_SPI_MSB;
+        cfg.max_hz = 1000000 * (index + 1);
+        rt_spi_configure(&sim_device[index], &cfg);
+
+        /* the last device is in the highest priority */
+        rt_spi_set_priority(&sim_device[index], SPI_TEST_DEVICES - index);
+    }
+
+    return RT_EOK;
+}
+
+static struct rt_spi_message test_message[SPI_TEST_DEVICES][SPI_TEST_REQUESTS];
+static struct rt_spi_request test_request[SPI_TEST_DEVICES][SPI_TEST_REQUESTS];
+static rt_uint8_t test_send[SPI_TEST_LENGTH];
+static rt_uint8_t test_recv[SPI_TEST_DEVICES][SPI_TEST_LENGTH];
+
+static struct rt_semaphore test_done;
+static rt_uint32_t test_failed;
+static rt_uint32_t test_finished[SPI_TEST_DEVICES];
+static int test_order[SPI_TEST_DEVICES];
+static int test_order_count;
+
+static void test_complete(struct rt_spi_request *request)
+{
+    int index;
+
+    index = (struct rt_spi_device *)request->device - &sim_device[0];
+    if (request->result != RT_EOK)
+        test_failed ++;
+
+    if (++ test_finished[index] == SPI_TEST_REQUESTS)
+        test_order[test_order_count ++] = index;
+
+    rt_sem_release(&test_done);
+}
+
+static void test_result(const char *name, rt_tick_t tick)
+{
+    rt_kprintf("%-6s %6d ticks, %4d bus configured, %d bytes\n",
+               name, tick, sim_bus.configured, sim_bus.bytes);
+}
+
+int spi_async_test(void)
+{
+    struct rt_spi_message *message;
+    rt_tick_t tick;
+    int index, loop;
+
+    if (spi_sim_init() != RT_EOK)
+    {
+        rt_kprintf("simulated SPI bus init failed\n");
+        return -1;
+    }
+
+    for (index = 0; index < SPI_TEST_LENGTH; index ++)
+        test_send[index] = index;
+
+    /* synchronous transfer, the bus is configured once the device changes */
+    sim_bus.configured = 0;
+    sim_bus.bytes = 0;
+    tick = rt_tick_get();
+    for (loop = 0; loop < SPI_TEST_REQUESTS; loop ++)
+    {
+        for (index = 0; index < SPI_TEST_DEVICES; index ++)
+            rt_spi_transfer(&sim_device[index], test_send, test_recv[index], SPI_TEST_LENGTH);
+    }
+    test_result("sync", rt_tick_get() - tick);
+
+    /* asynchronous transfer in the same order */
+    rt_sem_init(&test_done, "spitest", 0, RT_IPC_FLAG_FIFO);
+    test_failed = 0;
+    test_order_count = 0;
+    rt_memset(test_finished, 0, sizeof(test_finished));
+    sim_bus.configured = 0;
+    sim_bus.bytes = 0;
+
+    /* the requests are queued before transferring */
+    rt_enter_critical();
+    tick = rt_tick_get();
+    for (loop = 0; loop < SPI_TEST_REQUESTS; loop ++)
+    {
+        for (index = 0; index < SPI_TEST_DEVICES; index ++)
+        {
+            message = &test_message[index][loop];
+            message->send_buf   = test_send;
+            message->recv_buf   = test_recv[index];
+            message->length     = SPI_TEST_LENGTH;
+            message->cs_take    = 1;
+            message->cs_release = 1;
+            message->next       = RT_NULL;
+
+            rt_spi_request_init(&test_request[index][loop], message, test_complete, RT_NULL);
+            rt_spi_transfer_async(&sim_device[index], &test_request[index][loop]);
+        }
+    }
+    rt_exit_critical();
+
+    for (loop = 0; loop < SPI_TEST_DEVICES * SPI_TEST_REQUESTS; loop ++)
+        rt_sem_take(&test_done, RT_WAITING_FOREVER);
+    test_result("async", rt_tick_get() - tick);
+    rt_sem_detach(&test_done);
+
+    rt_kprintf("finished order:");
+    for (index = 0; index < test_order_count; index ++)
+        rt_kprintf(" simspi%d", test_order[index]);
+    rt_kprintf("\n");
+
+    if (test_failed != 0 || rt_memcmp(test_recv[0], test_send, SPI_TEST_LENGTH) != 0)
+    {
+        rt_kprintf("failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+FINSH_FUNCTION_EXPORT(spi_async_test, benchmark the asynchronous SPI transfer on a simulated bus);
+#endif
+#endif
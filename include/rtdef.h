@@ -18,6 +18,12 @@
  * 2012-12-29     Bernard      change the RT_USING_MEMPOOL location and add
  *                             RT_USING_MEMHEAP condition.
  * 2012-12-30     Bernard      add more control command for graphic.
+ * 2013-06-10     Bernard      add wait queue and poll operation of device.
+ * 2013-06-16     Bernard      add scheduling statistics of thread.
+ * 2013-06-19     Bernard      add priority inheritance chain and ceiling of mutex.
+ * 2013-06-20     Bernard      add priority index of IPC suspend list.
+ * 2013-06-21     Bernard      add workqueue.
+ * 2013-06-22     Bernard      add waiting for any of IPC objects.
  */
  
 #ifndef __RT_DEF_H__
@@ -389,6 +395,26 @@ typedef struct rt_timer *rt_timer_t;
 #define RT_THREAD_CTRL_CHANGE_PRIORITY  0x02                /**< Change thread priority. */
 #define RT_THREAD_CTRL_INFO             0x03                /**< Get thread information. */
 
+#ifdef RT_USING_SCHEDSTAT
+/**
+ * the number of log2 buckets in the histogram of scheduling latency
+ */
+#ifndef RT_SCHEDSTAT_BUCKETS
+#define RT_SCHEDSTAT_BUCKETS            16
+#endif
+
+/**
+ * Scheduling statistics, the time is in the units of statistics clock.
+ */
+struct rt_schedstat
+{
+    rt_uint32_t ready_stamp;                            /**< the time of being ready */
+    rt_uint32_t count;                                  /**< the number of switching in */
+    rt_uint32_t latency_max;                            /**< worst latency from ready to run */
+    rt_uint32_t histogram[RT_SCHEDSTAT_BUCKETS];        /**< log2 histogram of latency */
+};
+#endif
+
 /**
  * Thread structure
  */
@@ -427,6 +453,21 @@ struct rt_thread
 #endif
     rt_uint32_t number_mask;
 
+#if defined(RT_USING_MUTEX)
+    /* priority inheritance */
+    rt_list_t   taken_mutex_list;                       /**< the mutexes held by thread */
+    struct rt_mutex *pending_mutex;                     /**< the mutex thread is waiting for */
+#endif
+
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    struct rt_ipc_prio_index *suspend_index;            /**< the index of suspend list thread is on */
+    rt_uint8_t  suspend_priority;                       /**< the priority thread is indexed by */
+#endif
+
+#ifdef RT_USING_WAIT_ANY
+    struct rt_ipc_wait *ipc_wait;                       /**< the objects waited for by rt_wait_any */
+#endif
+
 #if defined(RT_USING_EVENT)
     /* thread event */
     rt_uint32_t event_set;
@@ -440,6 +481,10 @@ struct rt_thread
 
     void (*cleanup)(struct rt_thread *tid);             /**< cleanup function when thread exit */
 
+#ifdef RT_USING_SCHEDSTAT
+    struct rt_schedstat schedstat;                      /**< scheduling statistics */
+#endif
+
     rt_uint32_t user_data;                              /**< private user data beyond this thread */
 };
 typedef struct rt_thread *rt_thread_t;
@@ -457,13 +502,37 @@ typedef struct rt_thread *rt_thread_t;
  */
 #define RT_IPC_FLAG_FIFO                0x00            /**< FIFOed IPC. @ref IPC. */
 #define RT_IPC_FLAG_PRIO                0x01            /**< PRIOed IPC. @ref IPC. */
+#define RT_IPC_FLAG_CEILING             0x02            /**< priority ceiling mutex. @ref IPC. */
 
 #define RT_IPC_CMD_UNKNOWN              0x00            /**< unknown IPC command */
 #define RT_IPC_CMD_RESET                0x01            /**< reset IPC object */
+#define RT_IPC_CMD_SET_CEILING          0x02            /**< set the priority ceiling of mutex */
 
 #define RT_WAITING_FOREVER              -1              /**< Block forever until get resource. */
 #define RT_WAITING_NO                   0               /**< Non-block. */
 
+#ifdef RT_USING_IPC_PRIO_QUEUE
+/**
+ * The priority index of a suspend list, which is ordered by priority. The
+ * waiting priorities are kept in bitmap as the ready table of scheduler, and
+ * the first thread of each priority group is recorded, so the position of a
+ * new suspended thread is found by scanning the threads of one group only.
+ */
+struct rt_ipc_prio_index
+{
+    rt_list_t        *list;                             /**< the indexed suspend list */
+
+    rt_uint32_t       priority_group;                   /**< the bitmap of waiting priorities */
+#if RT_THREAD_PRIORITY_MAX > 32
+    rt_uint8_t        priority_table[32];
+
+    struct rt_thread *first[32];                        /**< the first thread of each group of 8 priorities */
+#else
+    struct rt_thread *first[RT_THREAD_PRIORITY_MAX];    /**< the first thread of each priority */
+#endif
+};
+#endif
+
 /**
  * Base structure of IPC object
  */
@@ -472,6 +541,12 @@ struct rt_ipc_object
     struct rt_object parent;                            /**< inherit from rt_object */
 
     rt_list_t        suspend_thread;                    /**< threads pended on this resource */
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    struct rt_ipc_prio_index suspend_index;             /**< priority index of suspend list */
+#endif
+#ifdef RT_USING_WAIT_ANY
+    rt_list_t        wait_list;                         /**< threads waiting for any of objects */
+#endif
 };
 
 #ifdef RT_USING_SEMAPHORE
@@ -499,8 +574,10 @@ struct rt_mutex
 
     rt_uint8_t           original_priority;             /**< priority of last thread hold the mutex */
     rt_uint8_t           hold;                          /**< numbers of thread hold the mutex */
+    rt_uint16_t          ceiling_priority;              /**< priority ceiling of mutex, 0xffff for none */
 
     struct rt_thread    *owner;                         /**< current owner of mutex */
+    rt_list_t            taken_list;                    /**< the node in mutex list of owner */
 };
 typedef struct rt_mutex *rt_mutex_t;
 #endif
@@ -542,6 +619,9 @@ struct rt_mailbox
     rt_uint16_t          out_offset;                    /**< output offset of the message buffer */
 
     rt_list_t            suspend_sender_thread;         /**< sender thread suspended on this mailbox */
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    struct rt_ipc_prio_index suspend_sender_index;      /**< priority index of sender list */
+#endif
 };
 typedef struct rt_mailbox *rt_mailbox_t;
 #endif
@@ -568,7 +648,133 @@ struct rt_messagequeue
 typedef struct rt_messagequeue *rt_mq_t;
 #endif
 
+/**
+ * wait queue, the threads wait on it for the events of the objects which are
+ * not the IPC objects, such as devices and sockets.
+ */
+struct rt_wqueue_node;
+typedef int (*rt_wqueue_func_t)(struct rt_wqueue_node *node, rt_uint32_t key);
+
+struct rt_wqueue_node
+{
+    rt_thread_t          thread;                        /**< the waiting thread */
+    rt_list_t            list;                          /**< node of the wait queue */
+
+    rt_wqueue_func_t     wakeup;                        /**< returns 0 to resume thread, RT_NULL for always */
+    rt_uint32_t          key;                           /**< the events waited for */
+};
+
+struct rt_wqueue
+{
+    rt_list_t            waiting_list;                  /**< the list of rt_wqueue_node */
+};
+typedef struct rt_wqueue rt_wqueue_t;
+
+/**
+ * poll events, the key of wait queue
+ */
+#define POLLIN                          0x001           /**< data to read */
+#define POLLPRI                         0x002           /**< urgent data to read */
+#define POLLOUT                         0x004           /**< writing will not block */
+#define POLLERR                         0x008           /**< error condition */
+#define POLLHUP                         0x010           /**< hang up */
+#define POLLNVAL                        0x020           /**< invalid descriptor */
+
+/**
+ * poll request, it's passed to the poll operation of objects, which add it
+ * on their wait queues by rt_poll_add.
+ */
+struct rt_pollreq
+{
+    void (*proc)(rt_wqueue_t *queue, struct rt_pollreq *req);
+    rt_uint32_t          key;                           /**< the events polled */
+};
+
+/*@}*/
+
+#ifdef RT_USING_WORKQUEUE
+/**
+ * @addtogroup Thread
+ */
+
+/*@{*/
+
+/*
+ * workqueue, the works are done in the worker thread of queue
+ */
+
+/* the system workqueue, which takes the place of soft timer thread */
+#ifndef RT_SYSTEM_WORKQUEUE_PRIO
+#ifdef RT_TIMER_THREAD_PRIO
+#define RT_SYSTEM_WORKQUEUE_PRIO        RT_TIMER_THREAD_PRIO
+#else
+/* not higher than all of the application threads by default */
+#define RT_SYSTEM_WORKQUEUE_PRIO        (RT_THREAD_PRIORITY_MAX / 2)
+#endif
+#endif
+
+#ifndef RT_SYSTEM_WORKQUEUE_STACK_SIZE
+#ifdef RT_TIMER_THREAD_STACK_SIZE
+#define RT_SYSTEM_WORKQUEUE_STACK_SIZE  RT_TIMER_THREAD_STACK_SIZE
+#else
+#define RT_SYSTEM_WORKQUEUE_STACK_SIZE  512
+#endif
+#endif
+
+/*
+ * work state definitions
+ */
+#define RT_WORK_STATE_PENDING           0x01            /**< work is in the work list of queue */
+#define RT_WORK_STATE_SUBMITTING        0x02            /**< delayed work is waiting for timeout */
+
+#define RT_WORK_TYPE_DELAYED            0x01            /**< delayed work */
+
+struct rt_workqueue;
+
+/**
+ * work structure
+ */
+struct rt_work
+{
+    rt_list_t            list;                          /**< node of the work list */
+
+    void (*work_func)(struct rt_work *work, void *work_data);  /**< work function */
+    void                *work_data;                     /**< parameter of work function */
+
+    rt_uint16_t          flags;                         /**< state of work */
+    rt_uint16_t          type;                          /**< type of work */
+
+    struct rt_workqueue *workqueue;                     /**< the queue work is submitted to */
+};
+
+/**
+ * delayed work structure, the work is submitted on the timeout of timer
+ */
+struct rt_delayed_work
+{
+    struct rt_work       work;                          /**< inherit from work */
+
+    struct rt_timer      timer;                         /**< the timer of delay */
+};
+
+/**
+ * workqueue structure
+ */
+struct rt_workqueue
+{
+    rt_list_t            work_list;                     /**< the pending works */
+    struct rt_work      *work_current;                  /**< the work being done */
+
+    struct rt_thread     thread;                        /**< the worker thread */
+    rt_uint8_t           waiting;                       /**< worker is waiting for works */
+    rt_uint8_t           shared;                        /**< shared by priority */
+
+    rt_list_t            list;                          /**< node of shared workqueue list */
+};
+typedef struct rt_workqueue *rt_workqueue_t;
+
 /*@}*/
+#endif
 
 /**
  * @addtogroup MM
@@ -597,6 +803,32 @@ struct rt_memheap_item
     struct rt_memheap_item *prev_free;                  /**< prev free memheap item */
 };
 
+/*
+ * memory heap attributes, the regions of heap are chosen by them
+ */
+#define RT_MEMHEAP_ATTR_FAST            0x01            /**< fast memory, such as internal SRAM */
+#define RT_MEMHEAP_ATTR_DMA             0x02            /**< DMA-capable memory */
+#define RT_MEMHEAP_ATTR_CACHEABLE       0x04            /**< cacheable memory */
+#define RT_MEMHEAP_ATTR_EXTERNAL        0x08            /**< external memory, such as SDRAM */
+#define RT_MEMHEAP_ATTR_MASK            0x0f
+
+/* the attributes of rt_malloc_attr are preferred, not required */
+#define RT_MALLOC_ATTR_PREFER           0x80
+
+/*
+ * memory usages, which are mapped to the attributes by malloc policy
+ */
+#define RT_MALLOC_USAGE_DEFAULT         0x00            /**< general memory */
+#define RT_MALLOC_USAGE_STACK           0x01            /**< thread stack */
+#define RT_MALLOC_USAGE_NET             0x02            /**< network buffer, such as lwIP pbuf */
+#define RT_MALLOC_USAGE_GUI             0x03            /**< GUI buffer, such as RTGUI buffer DC */
+#define RT_MALLOC_USAGE_DMA             0x04            /**< DMA buffer of driver */
+
+/* the attributes of system heap */
+#ifndef RT_SYSTEM_HEAP_ATTR
+#define RT_SYSTEM_HEAP_ATTR             (RT_MEMHEAP_ATTR_FAST | RT_MEMHEAP_ATTR_DMA)
+#endif
+
 /**
  * Base structure of memory heap object
  */
@@ -610,6 +842,9 @@ struct rt_memheap
     rt_uint32_t             available_size;             /**< available size */
     rt_uint32_t             max_used_size;              /**< maximum allocated size */
 
+    rt_uint32_t             attr;                       /**< attributes of memory heap */
+    rt_uint32_t             fail_count;                 /**< count of rt_malloc failed in it */
+
     struct rt_memheap_item *block_list;                 /**< used block list */
 
     struct rt_memheap_item *free_list;                  /**< free block list */
@@ -642,6 +877,86 @@ struct rt_mempool
 typedef struct rt_mempool *rt_mp_t;
 #endif
 
+#ifdef RT_USING_OBJECT_POOL
+/*
+ * the count of pre-allocated objects in the pool of each class, the pool
+ * grows by RT_OBJECT_POOL_GROW objects when it's used up.
+ */
+#ifndef RT_OBJECT_POOL_GROW
+#define RT_OBJECT_POOL_GROW             4
+#endif
+#ifndef RT_OBJECT_POOL_THREAD
+#define RT_OBJECT_POOL_THREAD           4
+#endif
+#ifndef RT_OBJECT_POOL_SEMAPHORE
+#define RT_OBJECT_POOL_SEMAPHORE        8
+#endif
+#ifndef RT_OBJECT_POOL_MUTEX
+#define RT_OBJECT_POOL_MUTEX            4
+#endif
+#ifndef RT_OBJECT_POOL_EVENT
+#define RT_OBJECT_POOL_EVENT            2
+#endif
+#ifndef RT_OBJECT_POOL_MAILBOX
+#define RT_OBJECT_POOL_MAILBOX          2
+#endif
+#ifndef RT_OBJECT_POOL_MESSAGEQUEUE
+#define RT_OBJECT_POOL_MESSAGEQUEUE     2
+#endif
+#ifndef RT_OBJECT_POOL_TIMER
+#define RT_OBJECT_POOL_TIMER            8
+#endif
+#endif
+
+#ifdef RT_USING_HEAP_TRACE
+/* the count of allocations tracked, and the call sites listed */
+#ifndef RT_HEAP_TRACE_SLOTS
+#define RT_HEAP_TRACE_SLOTS             256
+#endif
+#ifndef RT_HEAP_TRACE_SITES
+#define RT_HEAP_TRACE_SITES             32
+#endif
+
+/* the caller address of allocation */
+#if defined(__CC_ARM)
+#define RT_HEAP_CALLER                  ((void *)__return_address())
+#elif defined(__GNUC__)
+#define RT_HEAP_CALLER                  __builtin_return_address(0)
+#else
+#define RT_HEAP_CALLER                  RT_NULL
+#endif
+
+#define RT_HEAP_TRACE_ALLOC(ptr, size)  rt_heap_trace_alloc((ptr), (size), RT_HEAP_CALLER)
+#define RT_HEAP_TRACE_REALLOC(old, ptr, size) \
+    rt_heap_trace_realloc((old), (ptr), (size), RT_HEAP_CALLER)
+#define RT_HEAP_TRACE_FREE(ptr)         rt_heap_trace_free(ptr)
+#else
+#define RT_HEAP_TRACE_ALLOC(ptr, size)
+#define RT_HEAP_TRACE_REALLOC(old, ptr, size)
+#define RT_HEAP_TRACE_FREE(ptr)
+#endif
+
+#ifdef RT_USING_STACK_POOL
+/*
+ * the thread stacks are allocated from the buckets of RT_STACK_POOL_MIN,
+ * 2 * RT_STACK_POOL_MIN, ... RT_STACK_POOL_MAX bytes, the larger stacks are
+ * allocated from heap.
+ */
+#ifndef RT_STACK_POOL_MIN
+#define RT_STACK_POOL_MIN               256
+#endif
+#ifndef RT_STACK_POOL_BUCKETS
+#define RT_STACK_POOL_BUCKETS           4
+#endif
+#ifndef RT_STACK_POOL_COUNT
+#define RT_STACK_POOL_COUNT             2
+#endif
+#define RT_STACK_POOL_MAX               (RT_STACK_POOL_MIN << (RT_STACK_POOL_BUCKETS - 1))
+#ifndef RT_OBJECT_POOL_GROW
+#define RT_OBJECT_POOL_GROW             4
+#endif
+#endif
+
 /*@}*/
 
 #ifdef RT_USING_DEVICE
@@ -748,6 +1063,12 @@ struct rt_device
     rt_err_t  (*control)(rt_device_t dev, rt_uint8_t cmd, void *args);
 
     void                     *user_data;                /**< device private data */
+
+#ifdef RT_USING_POLL
+    /* returns the ready events, and add the request on the wait queue */
+    int       (*poll)   (rt_device_t dev, struct rt_pollreq *req);
+    rt_wqueue_t               wait_queue;               /**< wait queue of poll */
+#endif
 };
 
 /**
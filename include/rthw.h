@@ -13,6 +13,7 @@
  * 2006-04-25     Bernard      add rt_hw_context_switch_interrupt declaration
  * 2006-09-24     Bernard      add rt_hw_context_switch_to declaration
  * 2012-12-29     Bernard      add rt_hw_exception_install declaration
+ * 2013-06-18     Bernard      add cycle counter and interrupt profiler
  */
 
 #ifndef __RT_HW_H__
@@ -62,6 +63,37 @@ void rt_hw_show_memory(rt_uint32_t addr, rt_uint32_t size);
  */
 void rt_hw_exception_install(rt_err_t (*exception_handle)(void* context));
 
+#ifdef RT_USING_IRQPROF
+/*
+ * cycle counter interfaces, which are implemented by libcpu
+ */
+void rt_hw_cycle_init(void);
+rt_uint32_t rt_hw_cycle_get(void);
+
+/* the address which the current function returns to */
+#if defined(__GNUC__)
+#define RT_IRQPROF_CALLER()             __builtin_return_address(0)
+#elif defined(__CC_ARM)
+#define RT_IRQPROF_CALLER()             ((void *)__return_address())
+#else
+#define RT_IRQPROF_CALLER()             RT_NULL
+#endif
+
+/*
+ * The interrupt disable and enable are measured by the profiler. The libcpu
+ * which implements them in C should define them as (rt_hw_interrupt_disable)
+ * to avoid the expansion of macro.
+ */
+rt_base_t rt_irqprof_disable(void);
+void rt_irqprof_enable(rt_base_t level);
+void rt_irqprof_lock(void *caller);
+void rt_irqprof_unlock(void *caller);
+void rt_irqprof_reset(void);
+
+#define rt_hw_interrupt_disable()       rt_irqprof_disable()
+#define rt_hw_interrupt_enable(level)   rt_irqprof_enable(level)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,11 @@
  * 2007-01-28     Bernard      rename RT_OBJECT_Class_Static to RT_Object_Class_Static
  * 2007-03-03     Bernard      clean up the definitions to rtdef.h
  * 2010-04-11     yi.qiu       add module feature
+ * 2013-06-10     Bernard      add wait queue and device poll interface
+ * 2013-06-16     Bernard      add scheduling statistics interface
+ * 2013-06-20     Bernard      add suspend list removing of IPC priority index
+ * 2013-06-21     Bernard      add workqueue interface
+ * 2013-06-22     Bernard      add waiting for any of IPC objects
  */
 
 #ifndef __RT_THREAD_H__
@@ -167,6 +172,16 @@ void rt_exit_critical(void);
 void rt_scheduler_sethook(void (*hook)(rt_thread_t from, rt_thread_t to));
 #endif
 
+#ifdef RT_USING_SCHEDSTAT
+void rt_schedstat_set_clock(rt_uint32_t (*clock)(void), rt_uint32_t frequency);
+void rt_schedstat_reset(void);
+
+void rt_schedstat_ready(struct rt_thread *thread);
+void rt_schedstat_switch(struct rt_thread *from, struct rt_thread *to);
+void rt_schedstat_lock(void);
+void rt_schedstat_unlock(void);
+#endif
+
 /*@}*/
 
 /**
@@ -203,6 +218,21 @@ void rt_mp_free_sethook(void (*hook)(struct rt_mempool *mp, void *block));
 
 #endif
 
+#if defined(RT_USING_OBJECT_POOL) || defined(RT_USING_STACK_POOL)
+/*
+ * object pool and stack pool interface
+ */
+void rt_system_object_pool_init(void);
+#ifdef RT_USING_OBJECT_POOL
+void *rt_object_pool_alloc(enum rt_object_class_type type);
+rt_err_t rt_object_pool_free(enum rt_object_class_type type, void *object);
+#endif
+#ifdef RT_USING_STACK_POOL
+void *rt_stack_pool_alloc(rt_uint32_t *size);
+rt_err_t rt_stack_pool_free(void *stack, rt_uint32_t size);
+#endif
+#endif
+
 #ifdef RT_USING_HEAP
 /*
  * heap memory interface
@@ -220,6 +250,20 @@ void rt_memory_info(rt_uint32_t *total,
                     rt_uint32_t *used,
                     rt_uint32_t *max_used);
 
+#ifdef RT_USING_HEAP_TRACE
+void rt_heap_trace_alloc(void *ptr, rt_size_t size, void *caller);
+void rt_heap_trace_realloc(void *old, void *ptr, rt_size_t size, void *caller);
+void rt_heap_trace_free(void *ptr);
+void rt_system_heap_walk_free(void (*walk)(void *ptr, rt_size_t size, void *parameter),
+                              void *parameter);
+#endif
+
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+void *rt_malloc_attr(rt_size_t size, rt_uint32_t flags);
+void *rt_malloc_usage(rt_size_t size, rt_uint32_t usage);
+void rt_malloc_set_policy(rt_uint32_t (*policy)(rt_uint32_t usage, rt_size_t size));
+#endif
+
 #ifdef RT_USING_SLAB
 void *rt_page_alloc(rt_size_t npages);
 void rt_page_free(void *addr, rt_size_t npages);
@@ -244,6 +288,7 @@ rt_err_t rt_memheap_detach(struct rt_memheap *heap);
 void* rt_memheap_alloc(struct rt_memheap *heap, rt_uint32_t size);
 void *rt_memheap_realloc(struct rt_memheap* heap, void* ptr, rt_size_t newsize);
 void rt_memheap_free(void *ptr);
+rt_err_t rt_memheap_set_attr(struct rt_memheap *heap, rt_uint32_t attr);
 #endif
 
 /*@}*/
@@ -254,6 +299,24 @@ void rt_memheap_free(void *ptr);
 
 /*@{*/
 
+#ifdef RT_USING_IPC_PRIO_QUEUE
+/*
+ * suspend list interface, it's used by kernel only
+ */
+void rt_ipc_list_remove(struct rt_thread *thread);
+#endif
+#ifdef RT_USING_MUTEX
+void rt_mutex_pending_remove(struct rt_thread *thread);
+#endif
+#ifdef RT_USING_WAIT_ANY
+void rt_ipc_wait_remove(struct rt_thread *thread);
+
+/*
+ * waiting for any of IPC objects interface
+ */
+rt_int32_t rt_wait_any(rt_object_t objects[], rt_uint32_t count, rt_int32_t timeout);
+#endif
+
 #ifdef RT_USING_SEMAPHORE
 /*
  * semaphore interface
@@ -351,7 +414,61 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
 rt_err_t rt_mq_control(rt_mq_t mq, rt_uint8_t cmd, void *arg);
 #endif
 
+/*
+ * wait queue interface
+ */
+void rt_wqueue_init(rt_wqueue_t *queue);
+void rt_wqueue_add(rt_wqueue_t *queue, struct rt_wqueue_node *node);
+void rt_wqueue_remove(struct rt_wqueue_node *node);
+rt_err_t rt_wqueue_wait(rt_wqueue_t *queue, rt_uint32_t key, rt_int32_t timeout);
+void rt_wqueue_wakeup(rt_wqueue_t *queue, rt_uint32_t key);
+void rt_poll_add(rt_wqueue_t *queue, struct rt_pollreq *req);
+
+/*@}*/
+
+#ifdef RT_USING_WORKQUEUE
+/**
+ * @addtogroup Thread
+ */
+
+/*@{*/
+
+/*
+ * workqueue interface
+ */
+rt_err_t rt_workqueue_init(rt_workqueue_t queue,
+                           const char    *name,
+                           void          *stack_start,
+                           rt_uint32_t    stack_size,
+                           rt_uint8_t     priority);
+rt_err_t rt_workqueue_detach(rt_workqueue_t queue);
+#ifdef RT_USING_HEAP
+rt_workqueue_t rt_workqueue_create(const char *name,
+                                   rt_uint32_t stack_size,
+                                   rt_uint8_t  priority);
+rt_err_t rt_workqueue_destroy(rt_workqueue_t queue);
+#endif
+rt_workqueue_t rt_workqueue_get(rt_uint8_t priority);
+
+void rt_work_init(struct rt_work *work,
+                  void (*work_func)(struct rt_work *work, void *work_data),
+                  void *work_data);
+void rt_delayed_work_init(struct rt_delayed_work *work,
+                          void (*work_func)(struct rt_work *work, void *work_data),
+                          void *work_data);
+
+rt_err_t rt_workqueue_dowork(rt_workqueue_t queue, struct rt_work *work);
+rt_err_t rt_workqueue_submit_delayed(rt_workqueue_t          queue,
+                                     struct rt_delayed_work *work,
+                                     rt_tick_t               ticks);
+rt_err_t rt_workqueue_cancel_work(rt_workqueue_t queue, struct rt_work *work);
+rt_err_t rt_workqueue_cancel_work_sync(rt_workqueue_t queue, struct rt_work *work);
+rt_err_t rt_workqueue_flush(rt_workqueue_t queue);
+
+void rt_system_workqueue_init(void);
+
 /*@}*/
+#endif
 
 #ifdef RT_USING_DEVICE
 /**
@@ -390,6 +507,9 @@ rt_size_t rt_device_write(rt_device_t dev,
                           const void *buffer,
                           rt_size_t   size);
 rt_err_t  rt_device_control(rt_device_t dev, rt_uint8_t cmd, void *arg);
+#ifdef RT_USING_POLL
+int       rt_device_poll   (rt_device_t dev, struct rt_pollreq *req);
+#endif
 
 /*@}*/
 #endif
@@ -0,0 +1,225 @@
+/*
+ * File      : memory.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-18     Bernard      first version
+ */
+
+/*
+ * The memory routines for Cortex-M3/M4, which is enabled by RT_USING_ARCH_MEMORY.
+ *
+ * The aligned block is copied by LDM/STM. When source and destination have
+ * different alignment, the source is read by the unaligned LDR which is
+ * supported by ARMv7-M for normal memory, and the destination is always
+ * written by aligned STR.
+ */
+
+#include <rtthread.h>
+
+#ifdef RT_USING_ARCH_MEMORY
+
+#if !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+      defined(__TARGET_ARCH_7_M) || defined(__TARGET_ARCH_7E_M) || \
+      (defined(__ICCARM__) && (__CORE__ == __ARM7M__ || __CORE__ == __ARM7EM__)))
+#error "the architecture optimized memory routines only support Cortex-M3/M4."
+#endif
+
+#if defined(__CC_ARM) || defined(__ICCARM__)
+#define LOAD_UNALIGNED(p)       (*(__packed rt_uint32_t *)(p))
+#else
+struct _unaligned_word
+{
+    rt_uint32_t word;
+} __attribute__((packed));
+#define LOAD_UNALIGNED(p)       (((const struct _unaligned_word *)(p))->word)
+#endif
+
+#define WORD_UNALIGNED(p)       ((rt_uint32_t)(p) & 0x03)
+
+/* copy the blocks of 16 bytes, both of source and destination are aligned */
+rt_inline void _copy_aligned(rt_uint32_t **dst, const rt_uint32_t **src, rt_uint32_t blocks)
+{
+#if defined(__GNUC__) && !defined(__CC_ARM)
+    rt_uint32_t *d = *dst;
+    const rt_uint32_t *s = *src;
+
+    __asm__ __volatile__(
+        "1: ldmia %1!, {r3, r4, r5, r12} \n"
+        "   subs  %2, %2, #1             \n"
+        "   stmia %0!, {r3, r4, r5, r12} \n"
+        "   bne   1b                     \n"
+        : "+r" (d), "+r" (s), "+r" (blocks)
+        :
+        : "r3", "r4", "r5", "r12", "cc", "memory");
+
+    *dst = d;
+    *src = s;
+#else
+    /* the compiler merges the loads and stores into LDM/STM */
+    rt_uint32_t *d = *dst;
+    const rt_uint32_t *s = *src;
+    rt_uint32_t w0, w1, w2, w3;
+
+    while (blocks --)
+    {
+        w0 = s[0]; w1 = s[1]; w2 = s[2]; w3 = s[3];
+        d[0] = w0; d[1] = w1; d[2] = w2; d[3] = w3;
+        s += 4; d += 4;
+    }
+
+    *dst = d;
+    *src = s;
+#endif
+}
+
+void *rt_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+    rt_uint8_t *d = (rt_uint8_t *)dst;
+    const rt_uint8_t *s = (const rt_uint8_t *)src;
+
+    if (count >= 16)
+    {
+        /* align the destination */
+        while (WORD_UNALIGNED(d))
+        {
+            *d++ = *s++;
+            count --;
+        }
+
+        if (!WORD_UNALIGNED(s))
+        {
+            rt_uint32_t *ad = (rt_uint32_t *)d;
+            const rt_uint32_t *as = (const rt_uint32_t *)s;
+
+            if (count >= 16)
+            {
+                _copy_aligned(&ad, &as, count >> 4);
+                count &= 0x0f;
+            }
+            while (count >= 4)
+            {
+                *ad++ = *as++;
+                count -= 4;
+            }
+
+            d = (rt_uint8_t *)ad;
+            s = (const rt_uint8_t *)as;
+        }
+        else
+        {
+            rt_uint32_t *ad = (rt_uint32_t *)d;
+
+            while (count >= 16)
+            {
+                ad[0] = LOAD_UNALIGNED(s);
+                ad[1] = LOAD_UNALIGNED(s + 4);
+                ad[2] = LOAD_UNALIGNED(s + 8);
+                ad[3] = LOAD_UNALIGNED(s + 12);
+                ad += 4; s += 16;
+                count -= 16;
+            }
+            while (count >= 4)
+            {
+                *ad++ = LOAD_UNALIGNED(s);
+                s += 4;
+                count -= 4;
+            }
+
+            d = (rt_uint8_t *)ad;
+        }
+    }
+
+    while (count --)
+        *d++ = *s++;
+
+    return dst;
+}
+
+void *rt_memset(void *s, int c, rt_ubase_t count)
+{
+    rt_uint8_t *m = (rt_uint8_t *)s;
+    rt_uint8_t v = c & 0xff;
+
+    if (count >= 16)
+    {
+        rt_uint32_t *am;
+        rt_uint32_t w;
+
+        while (WORD_UNALIGNED(m))
+        {
+            *m++ = v;
+            count --;
+        }
+
+        w = v | (v << 8);
+        w |= w << 16;
+        am = (rt_uint32_t *)m;
+        while (count >= 16)
+        {
+            am[0] = w; am[1] = w; am[2] = w; am[3] = w;
+            am += 4;
+            count -= 16;
+        }
+        while (count >= 4)
+        {
+            *am++ = w;
+            count -= 4;
+        }
+        m = (rt_uint8_t *)am;
+    }
+
+    while (count --)
+        *m++ = v;
+
+    return s;
+}
+
+void *rt_memmove(void *dest, const void *src, rt_ubase_t n)
+{
+    rt_uint8_t *d = (rt_uint8_t *)dest;
+    const rt_uint8_t *s = (const rt_uint8_t *)src;
+
+    /* the forward copy is safe when destination is not inside of source */
+    if (d <= s || d >= s + n)
+        return rt_memcpy(dest, src, n);
+
+    d += n;
+    s += n;
+    if (n >= 16)
+    {
+        while (WORD_UNALIGNED(d))
+        {
+            *--d = *--s;
+            n --;
+        }
+
+        /* read the whole word before write, so the overlapped word is safe */
+        while (n >= 4)
+        {
+            d -= 4; s -= 4;
+            *(rt_uint32_t *)d = LOAD_UNALIGNED(s);
+            n -= 4;
+        }
+    }
+
+    while (n --)
+        *--d = *--s;
+
+    return dest;
+}
+
+#if !defined(RT_USING_NEWLIB) && defined(RT_USING_MINILIBC) && defined(__GNUC__)
+#include <sys/types.h>
+void *memcpy(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memcpy")));
+void *memset(void *s, int c, size_t n) __attribute__((weak, alias("rt_memset")));
+void *memmove(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memmove")));
+#endif
+
+#endif /* RT_USING_ARCH_MEMORY */
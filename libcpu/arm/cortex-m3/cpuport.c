@@ -14,8 +14,10 @@
  * 2011-06-17   onelife     Merge all of the C source code into cpuport.c
  * 2012-12-23   aozima      stack addr align to 8byte.
  * 2012-12-29   Bernard     Add exception hook.
+ * 2013-06-18   Bernard     Add cycle counter of DWT.
  */
 
+#include <rthw.h>
 #include <rtthread.h>
 
 struct exception_stack_frame
@@ -105,6 +107,33 @@ void rt_hw_exception_install(rt_err_t (*exception_handle)(void* context))
 	rt_exception_hook = exception_handle;
 }
 
+#ifdef RT_USING_IRQPROF
+/* the cycle counter of DWT */
+#define DEMCR           (*(volatile rt_uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA    (1UL << 24)
+#define DWT_CTRL        (*(volatile rt_uint32_t *)0xE0001000)
+#define DWT_CYCCNTENA   (1UL << 0)
+#define DWT_CYCCNT      (*(volatile rt_uint32_t *)0xE0001004)
+
+/**
+ * This function enables the cycle counter of DWT.
+ */
+void rt_hw_cycle_init(void)
+{
+	DEMCR |= DEMCR_TRCENA;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CYCCNTENA;
+}
+
+/**
+ * This function returns the cycles of CPU.
+ */
+rt_uint32_t rt_hw_cycle_get(void)
+{
+	return DWT_CYCCNT;
+}
+#endif
+
 /*
  * fault exception handler
  */
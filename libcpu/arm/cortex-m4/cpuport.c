@@ -16,8 +16,11 @@
  * 2012-12-11     lgnq         fixed the coding style.
  * 2012-12-23     aozima       stack addr align to 8byte.
  * 2012-12-29     Bernard      Add exception hook.
+ * 2013-06-18     Bernard      Add cycle counter of DWT.
+ * 2013-06-23     Bernard      lazy FPU context switch.
  */
 
+#include <rthw.h>
 #include <rtthread.h>
 
 #define USE_FPU   /* ARMCC */ (  (defined ( __CC_ARM ) && defined ( __TARGET_FPU_VFP )) \
@@ -42,27 +45,10 @@ struct exception_stack_frame
     rt_uint32_t pc;
     rt_uint32_t psr;
 
-#if USE_FPU
-    /* FPU register */
-    rt_uint32_t S0;
-    rt_uint32_t S1;
-    rt_uint32_t S2;
-    rt_uint32_t S3;
-    rt_uint32_t S4;
-    rt_uint32_t S5;
-    rt_uint32_t S6;
-    rt_uint32_t S7;
-    rt_uint32_t S8;
-    rt_uint32_t S9;
-    rt_uint32_t S10;
-    rt_uint32_t S11;
-    rt_uint32_t S12;
-    rt_uint32_t S13;
-    rt_uint32_t S14;
-    rt_uint32_t S15;
-    rt_uint32_t FPSCR;
-    rt_uint32_t NO_NAME;
-#endif
+    /*
+     * S0 ~ S15 and FPSCR are stacked above the basic frame by hardware only
+     * if the thread has FP context, which is lazily stacked on exception.
+     */
 };
 
 struct stack_frame
@@ -78,23 +64,11 @@ struct stack_frame
     rt_uint32_t r11;
 
 #if USE_FPU
-    /* FPU register s16 ~ s31 */
-    rt_uint32_t s16;
-    rt_uint32_t s17;
-    rt_uint32_t s18;
-    rt_uint32_t s19;
-    rt_uint32_t s20;
-    rt_uint32_t s21;
-    rt_uint32_t s22;
-    rt_uint32_t s23;
-    rt_uint32_t s24;
-    rt_uint32_t s25;
-    rt_uint32_t s26;
-    rt_uint32_t s27;
-    rt_uint32_t s28;
-    rt_uint32_t s29;
-    rt_uint32_t s30;
-    rt_uint32_t s31;
+    /*
+     * EXC_RETURN of thread, bit 4 is cleared if the thread has FP context,
+     * then s16 ~ s31 are saved above it.
+     */
+    rt_uint32_t exc_return;
 #endif
 
     struct exception_stack_frame exception_stack_frame;
@@ -130,6 +104,11 @@ rt_uint8_t *rt_hw_stack_init(void       *tentry,
     stack_frame->exception_stack_frame.pc  = (unsigned long)tentry;    /* entry point, pc */
     stack_frame->exception_stack_frame.psr = 0x01000000L;              /* PSR */
 
+#if USE_FPU
+    /* return to thread mode with PSP, the thread starts without FP context */
+    stack_frame->exc_return = 0xFFFFFFFDL;
+#endif
+
     /* return task's current stack address */
     return stk;
 }
@@ -144,6 +123,33 @@ void rt_hw_exception_install(rt_err_t (*exception_handle)(void* context))
 	rt_exception_hook = exception_handle;
 }
 
+#ifdef RT_USING_IRQPROF
+/* the cycle counter of DWT */
+#define DEMCR           (*(volatile rt_uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA    (1UL << 24)
+#define DWT_CTRL        (*(volatile rt_uint32_t *)0xE0001000)
+#define DWT_CYCCNTENA   (1UL << 0)
+#define DWT_CYCCNT      (*(volatile rt_uint32_t *)0xE0001004)
+
+/**
+ * This function enables the cycle counter of DWT.
+ */
+void rt_hw_cycle_init(void)
+{
+	DEMCR |= DEMCR_TRCENA;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CYCCNTENA;
+}
+
+/**
+ * This function returns the cycles of CPU.
+ */
+rt_uint32_t rt_hw_cycle_get(void)
+{
+	return DWT_CYCCNT;
+}
+#endif
+
 void rt_hw_hard_fault_exception(struct exception_stack_frame *exception_stack)
 {
 	extern long list_thread(void);
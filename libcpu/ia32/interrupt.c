@@ -9,6 +9,7 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2013-06-18     Bernard      add cycle counter
  */
 
 #include <rtthread.h>
@@ -102,7 +103,7 @@ void rt_hw_interrupt_install(int vector, rt_isr_handler_t new_handler, rt_isr_ha
 	}
 }
 
-rt_base_t rt_hw_interrupt_disable(void)
+rt_base_t (rt_hw_interrupt_disable)(void)
 {
 	rt_base_t level;
 
@@ -110,9 +111,24 @@ rt_base_t rt_hw_interrupt_disable(void)
 	return level;
 }
 
-void rt_hw_interrupt_enable(rt_base_t level)
+void (rt_hw_interrupt_enable)(rt_base_t level)
 {
 	__asm__ __volatile__("pushl %0 ; popfl": :"g" (level):"memory", "cc");
 }
 
+#ifdef RT_USING_IRQPROF
+/* the time stamp counter is always running */
+void rt_hw_cycle_init(void)
+{
+}
+
+rt_uint32_t rt_hw_cycle_get(void)
+{
+	rt_uint32_t low, high;
+
+	__asm__ __volatile__("rdtsc":"=a" (low), "=d" (high));
+	return low;
+}
+#endif
+
 /*@}*/
@@ -0,0 +1,96 @@
+/*
+ * File      : memory.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-01-18     Bernard      first version
+ */
+
+/*
+ * The memory routines for IA32, which is enabled by RT_USING_ARCH_MEMORY.
+ *
+ * The string instructions are used: rep movsl/stosl for the words and
+ * movsb/stosb for the remainder. SSE is not used, because the SSE registers
+ * are not saved in thread context.
+ */
+
+#include <rtthread.h>
+
+#ifdef RT_USING_ARCH_MEMORY
+
+void *rt_memcpy(void *dst, const void *src, rt_ubase_t count)
+{
+    int d0, d1, d2;
+
+    __asm__ __volatile__(
+        "rep ; movsl      \n"
+        "movl %4, %%ecx   \n"
+        "andl $3, %%ecx   \n"
+        "rep ; movsb      \n"
+        : "=&c" (d0), "=&D" (d1), "=&S" (d2)
+        : "0" (count >> 2), "g" (count), "1" (dst), "2" (src)
+        : "memory");
+
+    return dst;
+}
+
+void *rt_memset(void *s, int c, rt_ubase_t count)
+{
+    int d0, d1;
+    rt_uint32_t w;
+
+    w = c & 0xff;
+    w |= w << 8;
+    w |= w << 16;
+
+    __asm__ __volatile__(
+        "rep ; stosl      \n"
+        "movl %3, %%ecx   \n"
+        "andl $3, %%ecx   \n"
+        "rep ; stosb      \n"
+        : "=&c" (d0), "=&D" (d1)
+        : "a" (w), "g" (count), "0" (count >> 2), "1" (s)
+        : "memory");
+
+    return s;
+}
+
+void *rt_memmove(void *dest, const void *src, rt_ubase_t n)
+{
+    int d0, d1, d2;
+
+    /* the forward copy is safe when destination is not inside of source */
+    if ((char *)dest <= (char *)src || (char *)dest >= (char *)src + n)
+        return rt_memcpy(dest, src, n);
+
+    /* copy the remainder bytes backward from the last byte, then the words */
+    __asm__ __volatile__(
+        "std              \n"
+        "rep ; movsb      \n"
+        "subl $3, %%esi   \n"
+        "subl $3, %%edi   \n"
+        "movl %6, %%ecx   \n"
+        "rep ; movsl      \n"
+        "cld              \n"
+        : "=&c" (d0), "=&S" (d1), "=&D" (d2)
+        : "0" (n & 3), "1" (n - 1 + (const char *)src), "2" (n - 1 + (char *)dest),
+          "g" (n >> 2)
+        : "memory");
+
+    return dest;
+}
+
+#if !defined(RT_USING_NEWLIB) && defined(RT_USING_MINILIBC) && defined(__GNUC__)
+#include <sys/types.h>
+void *memcpy(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memcpy")));
+void *memset(void *s, int c, size_t n) __attribute__((weak, alias("rt_memset")));
+void *memmove(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memmove")));
+#endif
+
+#endif /* RT_USING_ARCH_MEMORY */
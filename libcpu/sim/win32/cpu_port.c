@@ -18,6 +18,7 @@
 #include  <windows.h>
 #include  <mmsystem.h>
 #include  <stdio.h>
+#include  <intrin.h>
 #include  "cpu_port.h"
 
 /*
@@ -228,6 +229,28 @@ void rt_hw_interrupt_enable(rt_base_t level)
 
 } /*** rt_hw_interrupt_enable ***/
 
+#ifdef RT_USING_IRQPROF
+/*
+*********************************************************************************************************
+*                                            rt_hw_cycle_get()
+* Description : get the cycle counter, the time stamp counter of CPU is used as ia32. The
+*               performance counter of Windows runs at a few MHz, which is not cycles.
+* Argument(s) : void
+* Return(s)   : rt_uint32_t
+* Caller(s)   : interrupt profiler
+* Note(s)     : none
+*********************************************************************************************************
+*/
+void rt_hw_cycle_init(void)
+{
+}
+
+rt_uint32_t rt_hw_cycle_get(void)
+{
+    return (rt_uint32_t)__rdtsc();
+} /*** rt_hw_cycle_get ***/
+#endif
+
 /*
 *********************************************************************************************************
 *                                            rt_hw_context_switch_interrupt()
@@ -14,6 +14,7 @@
  * 2012-10-20     Bernard      add device check in register function, 
  *                             provided by Rob <rdent@iinet.net.au>
  * 2012-12-25     Bernard      return RT_EOK if the device interface not exist.
+ * 2013-06-10     Bernard      add rt_device_poll.
  */
 
 #include <rtthread.h>
@@ -41,6 +42,9 @@ rt_err_t rt_device_register(rt_device_t dev,
 
     rt_object_init(&(dev->parent), RT_Object_Class_Device, name);
     dev->flag = flags;
+#ifdef RT_USING_POLL
+    rt_wqueue_init(&(dev->wait_queue));
+#endif
 
     return RT_EOK;
 }
@@ -355,6 +359,33 @@ rt_err_t rt_device_control(rt_device_t dev, rt_uint8_t cmd, void *arg)
 }
 RTM_EXPORT(rt_device_control);
 
+#ifdef RT_USING_POLL
+/**
+ * This function will get the ready events of device, and add the poll request
+ * on the wait queue of device. The driver wakes up the wait queue with the
+ * events when the device becomes ready.
+ *
+ * @param dev the pointer of device driver structure
+ * @param req the poll request, RT_NULL for checking the events only
+ *
+ * @return the ready events
+ */
+int rt_device_poll(rt_device_t dev, struct rt_pollreq *req)
+{
+    RT_ASSERT(dev != RT_NULL);
+
+    /* call device poll interface */
+    if (dev->poll != RT_NULL)
+    {
+        return dev->poll(dev, req);
+    }
+
+    /* the device without poll interface never blocks */
+    return POLLIN | POLLOUT;
+}
+RTM_EXPORT(rt_device_poll);
+#endif
+
 /**
  * This function will set the indication callback function when device receives
  * data.
@@ -0,0 +1,409 @@
+/*
+ * File      : heaptrace.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-25     Bernard      the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_HEAP_TRACE
+
+#ifndef RT_USING_HEAP
+#error "heap trace needs RT_USING_HEAP"
+#endif
+
+/*
+ * The heap backends (small memory, slab and memheap as heap) tag each
+ * allocation of rt_malloc, rt_realloc and rt_calloc with the caller address
+ * and the owning thread, which are kept in a hash table of RT_HEAP_TRACE_SLOTS
+ * items. The allocations which don't fit in the table are only counted.
+ *
+ * Each allocation has a sequence number, a snapshot is the sequence number
+ * when it's taken. The allocations which are made between two snapshots and
+ * are still live are the suspected leaks. The memory block which is resized
+ * by rt_realloc keeps the sequence number of its first allocation.
+ *
+ * The caller address could be resolved by addr2line or the map file.
+ */
+
+struct rt_heap_trace_item
+{
+    void        *ptr;                                   /**< allocated memory */
+    rt_size_t    size;                                  /**< size of memory */
+    void        *caller;                                /**< caller address */
+    rt_uint32_t  seq;                                   /**< sequence number */
+    char         thread[RT_NAME_MAX];                   /**< owning thread */
+};
+
+struct rt_heap_trace_site
+{
+    void        *caller;                                /**< caller address */
+    rt_uint32_t  count;                                 /**< live allocations */
+    rt_uint32_t  bytes;                                 /**< live bytes */
+    char         thread[RT_NAME_MAX];                   /**< owning thread, "*" if many */
+};
+
+/* the free blocks histogram of 16, 32, ... 32K and larger bytes */
+#define HEAP_TRACE_HISTOGRAM    12
+
+struct rt_heap_trace_free
+{
+    rt_uint32_t  count;
+    rt_uint32_t  bytes;
+    rt_uint32_t  largest;
+    rt_uint32_t  histogram[HEAP_TRACE_HISTOGRAM];
+};
+
+static struct rt_heap_trace_item _trace_table[RT_HEAP_TRACE_SLOTS];
+static rt_uint32_t _trace_count;
+static rt_uint32_t _trace_untracked;
+static rt_uint32_t _trace_seq;
+static rt_uint32_t _trace_snapshot[2];
+
+static struct rt_heap_trace_site _trace_sites[RT_HEAP_TRACE_SITES];
+
+#define _trace_hash(ptr)        (((rt_ubase_t)(ptr) >> 3) % RT_HEAP_TRACE_SLOTS)
+
+/* find the item of ptr, or the empty item to insert it */
+static int _trace_lookup(void *ptr)
+{
+    int index, probe;
+
+    index = _trace_hash(ptr);
+    for (probe = 0; probe < RT_HEAP_TRACE_SLOTS; probe ++)
+    {
+        if (_trace_table[index].ptr == ptr || _trace_table[index].ptr == RT_NULL)
+            return index;
+
+        index = (index + 1) % RT_HEAP_TRACE_SLOTS;
+    }
+
+    return -1;
+}
+
+/* tag an allocation, the allocation which is tagged again keeps its sequence */
+static void _trace_tag(void *ptr, rt_size_t size, void *caller, rt_uint32_t seq)
+{
+    rt_thread_t thread;
+    const char *name;
+    int index;
+
+    thread = rt_thread_self();
+    if (rt_interrupt_get_nest() != 0)
+        name = "isr";
+    else if (thread == RT_NULL)
+        name = "-";
+    else
+        name = thread->name;
+
+    index = _trace_lookup(ptr);
+    if (index < 0)
+    {
+        /* the table is full */
+        _trace_untracked ++;
+
+        return;
+    }
+
+    if (_trace_table[index].ptr == RT_NULL)
+    {
+        _trace_count ++;
+        _trace_table[index].seq = seq != 0 ? seq : ++ _trace_seq;
+    }
+
+    _trace_table[index].ptr    = ptr;
+    _trace_table[index].size   = size;
+    _trace_table[index].caller = caller;
+    rt_strncpy(_trace_table[index].thread, name, RT_NAME_MAX);
+}
+
+/* remove the tag of an allocation, it returns the sequence or 0 */
+static rt_uint32_t _trace_untag(void *ptr)
+{
+    int index, next, home, probe;
+    rt_uint32_t seq;
+
+    index = _trace_lookup(ptr);
+    if (index < 0 || _trace_table[index].ptr == RT_NULL)
+    {
+        /* it's not tracked */
+        return 0;
+    }
+    _trace_count --;
+    seq = _trace_table[index].seq;
+
+    /* move the items after it back, so the probing is not broken */
+    next = index;
+    for (probe = 0; probe < RT_HEAP_TRACE_SLOTS; probe ++)
+    {
+        next = (next + 1) % RT_HEAP_TRACE_SLOTS;
+        if (_trace_table[next].ptr == RT_NULL)
+            break;
+
+        home = _trace_hash(_trace_table[next].ptr);
+        /* the item is between its home and the hole, it stays */
+        if (index <= next ? (index < home && home <= next) : (index < home || home <= next))
+            continue;
+
+        _trace_table[index] = _trace_table[next];
+        index = next;
+    }
+    _trace_table[index].ptr = RT_NULL;
+
+    return seq;
+}
+
+/**
+ * @addtogroup MM
+ */
+
+/*@{*/
+
+/**
+ * This function will tag an allocation with its caller and the current
+ * thread. It's invoked by heap backends, and the allocation which is
+ * tagged again is updated with its sequence number kept.
+ *
+ * @param ptr the allocated memory
+ * @param size the size of memory
+ * @param caller the caller address of allocation
+ */
+void rt_heap_trace_alloc(void *ptr, rt_size_t size, void *caller)
+{
+    register rt_base_t level;
+
+    if (ptr == RT_NULL)
+        return;
+
+    level = rt_hw_interrupt_disable();
+    _trace_tag(ptr, size, caller, 0);
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will move the tag of a resized allocation to the new memory
+ * block, which keeps the sequence number of the old one. It's invoked by
+ * heap backends before the old memory block is released.
+ *
+ * @param old the memory block before resized
+ * @param ptr the memory block after resized
+ * @param size the new size of memory
+ * @param caller the caller address of rt_realloc
+ */
+void rt_heap_trace_realloc(void *old, void *ptr, rt_size_t size, void *caller)
+{
+    register rt_base_t level;
+    rt_uint32_t seq;
+
+    level = rt_hw_interrupt_disable();
+    seq = 0;
+    if (old != RT_NULL && old != ptr)
+        seq = _trace_untag(old);
+    if (ptr != RT_NULL)
+    {
+        /* the new memory block may be tagged by rt_malloc already */
+        if (seq != 0)
+            _trace_untag(ptr);
+        _trace_tag(ptr, size, caller, seq);
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will remove the tag of a released allocation.
+ *
+ * @param ptr the released memory
+ */
+void rt_heap_trace_free(void *ptr)
+{
+    register rt_base_t level;
+
+    if (ptr == RT_NULL)
+        return;
+
+    level = rt_hw_interrupt_disable();
+    _trace_untag(ptr);
+    rt_hw_interrupt_enable(level);
+}
+
+/*@}*/
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+/* aggregate the live allocations of sequence in (begin, end] by caller */
+static int _heap_trace_sites(rt_uint32_t begin, rt_uint32_t end,
+                             struct rt_heap_trace_site *others)
+{
+    struct rt_heap_trace_item *item;
+    struct rt_heap_trace_site *site, temp;
+    int index, sites, i;
+
+    sites = 0;
+    rt_memset(others, 0, sizeof(struct rt_heap_trace_site));
+
+    rt_enter_critical();
+    for (index = 0; index < RT_HEAP_TRACE_SLOTS; index ++)
+    {
+        item = &_trace_table[index];
+        if (item->ptr == RT_NULL || item->seq <= begin || item->seq > end)
+            continue;
+
+        for (i = 0; i < sites; i ++)
+        {
+            if (_trace_sites[i].caller == item->caller)
+                break;
+        }
+
+        if (i == sites)
+        {
+            if (sites == RT_HEAP_TRACE_SITES)
+            {
+                others->count ++;
+                others->bytes += item->size;
+                continue;
+            }
+
+            site = &_trace_sites[sites ++];
+            site->caller = item->caller;
+            site->count  = 0;
+            site->bytes  = 0;
+            rt_strncpy(site->thread, item->thread, RT_NAME_MAX);
+        }
+        else
+        {
+            site = &_trace_sites[i];
+            if (rt_strncmp(site->thread, item->thread, RT_NAME_MAX) != 0)
+                rt_strncpy(site->thread, "*", RT_NAME_MAX);
+        }
+
+        site->count ++;
+        site->bytes += item->size;
+    }
+    rt_exit_critical();
+
+    /* sort the sites by live bytes */
+    for (index = 1; index < sites; index ++)
+    {
+        temp = _trace_sites[index];
+        for (i = index; i > 0 && _trace_sites[i - 1].bytes < temp.bytes; i --)
+            _trace_sites[i] = _trace_sites[i - 1];
+        _trace_sites[i] = temp;
+    }
+
+    return sites;
+}
+
+static void _heap_trace_list(rt_uint32_t begin, rt_uint32_t end)
+{
+    struct rt_heap_trace_site others;
+    int index, sites;
+
+    sites = _heap_trace_sites(begin, end, &others);
+
+    rt_kprintf("  caller    thread   count   bytes\n");
+    rt_kprintf("---------- -------- ------ --------\n");
+    for (index = 0; index < sites; index ++)
+    {
+        rt_kprintf("0x%08x %-8.*s %6d %8d\n", _trace_sites[index].caller,
+                   RT_NAME_MAX, _trace_sites[index].thread,
+                   _trace_sites[index].count, _trace_sites[index].bytes);
+    }
+    if (others.count != 0)
+        rt_kprintf("others              %6d %8d\n", others.count, others.bytes);
+}
+
+static void _heap_trace_walk(void *ptr, rt_size_t size, void *parameter)
+{
+    struct rt_heap_trace_free *info;
+    int index;
+
+    info = (struct rt_heap_trace_free *)parameter;
+
+    info->count ++;
+    info->bytes += size;
+    if (size > info->largest)
+        info->largest = size;
+
+    for (index = 0; index < HEAP_TRACE_HISTOGRAM - 1; index ++)
+    {
+        if (size < (32UL << index))
+            break;
+    }
+    info->histogram[index] ++;
+}
+
+long heap_trace(void)
+{
+    struct rt_heap_trace_free info;
+    int index;
+
+    rt_kprintf("tracked %d allocations, %d untracked\n", _trace_count, _trace_untracked);
+    _heap_trace_list(0, 0xffffffff);
+
+    /* the heap is locked in walking, nothing is printed in it */
+    rt_memset(&info, 0, sizeof(info));
+    rt_system_heap_walk_free(_heap_trace_walk, &info);
+
+    rt_kprintf("\nfree blocks: %d, free bytes: %d, largest: %d\n",
+               info.count, info.bytes, info.largest);
+    for (index = 0; index < HEAP_TRACE_HISTOGRAM; index ++)
+    {
+        if (info.histogram[index] == 0)
+            continue;
+
+        if (index == HEAP_TRACE_HISTOGRAM - 1)
+            rt_kprintf("%6d+      : %d\n", 16UL << index, info.histogram[index]);
+        else
+            rt_kprintf("%6d-%-6d: %d\n", index == 0 ? 0 : 16UL << index,
+                       (32UL << index) - 1, info.histogram[index]);
+    }
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(heap_trace, list live heap bytes by caller and free blocks)
+
+long heap_snapshot(void)
+{
+    register rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    _trace_snapshot[0] = _trace_snapshot[1];
+    _trace_snapshot[1] = _trace_seq;
+    rt_hw_interrupt_enable(level);
+
+    rt_kprintf("snapshot at allocation %d, last one at %d\n",
+               _trace_snapshot[1], _trace_snapshot[0]);
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(heap_snapshot, take a heap snapshot for heap_leak)
+
+long heap_leak(void)
+{
+    if (_trace_snapshot[1] == _trace_snapshot[0])
+    {
+        rt_kprintf("take two snapshots by heap_snapshot at first\n");
+
+        return -1;
+    }
+
+    rt_kprintf("live allocations between allocation %d and %d:\n",
+               _trace_snapshot[0], _trace_snapshot[1]);
+    _heap_trace_list(_trace_snapshot[0], _trace_snapshot[1]);
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(heap_leak, list live allocations between last two snapshots)
+#endif
+
+#endif
@@ -12,6 +12,7 @@
  * 2006-03-23     Bernard      the first version
  * 2010-11-10     Bernard      add cleanup callback function in thread exit.
  * 2012-12-29     Bernard      fix compiling warning.
+ * 2013-06-24     Bernard      release thread stack to stack pool.
  */
 
 #include <rthw.h>
@@ -126,6 +127,10 @@ void rt_thread_idle_excute(void)
         if (thread->flags & RT_OBJECT_FLAG_MODULE)
             rt_module_free((rt_module_t)thread->module_id, thread->stack_addr);
         else
+#endif
+#ifdef RT_USING_STACK_POOL
+        /* release thread's stack to stack pool, or to heap */
+        if (rt_stack_pool_free(thread->stack_addr, thread->stack_size) != RT_EOK)
 #endif
         /* release thread's stack */
         RT_KERNEL_FREE(thread->stack_addr);
@@ -35,6 +35,10 @@
  * 2010-10-26     yi.qiu       add module support in rt_mp_delete and rt_mq_delete
  * 2010-11-10     Bernard      add IPC reset command implementation.
  * 2011-12-18     Bernard      add more parameter checking in message queue
+ * 2013-06-19     Bernard      add transitive priority inheritance and priority
+ *                             ceiling of mutex
+ * 2013-06-20     Bernard      add priority index of suspend list
+ * 2013-06-22     Bernard      add waiting for any of IPC objects
  */
 
 #include <rtthread.h>
@@ -52,6 +56,163 @@ extern void (*rt_object_put_hook)(struct rt_object *object);
 
 /*@{*/
 
+#ifdef RT_USING_IPC_PRIO_QUEUE
+extern const rt_uint8_t rt_lowest_bitmap[];
+
+#define RT_IPC_INDEX(object, member)    (&((object)->member))
+
+/* the lowest set bit of a non-zero value */
+rt_inline rt_uint8_t _ipc_lowest_bit(rt_uint32_t value)
+{
+    if (value & 0xff)
+        return rt_lowest_bitmap[value & 0xff];
+    if (value & 0xff00)
+        return rt_lowest_bitmap[(value >> 8) & 0xff] + 8;
+    if (value & 0xff0000)
+        return rt_lowest_bitmap[(value >> 16) & 0xff] + 16;
+
+    return rt_lowest_bitmap[(value >> 24) & 0xff] + 24;
+}
+
+/* the highest waiting priority which is lower than the priority, or -1 */
+static int _ipc_index_next(struct rt_ipc_prio_index *index, rt_uint8_t priority)
+{
+    rt_uint32_t mask;
+#if RT_THREAD_PRIORITY_MAX > 32
+    rt_uint8_t number;
+
+    number = priority >> 3;
+    mask = index->priority_table[number] & ~((2UL << (priority & 0x07)) - 1) & 0xff;
+    if (mask != 0)
+        return (number << 3) + rt_lowest_bitmap[mask];
+
+    mask = index->priority_group & ~((2UL << number) - 1);
+    if (mask == 0)
+        return -1;
+    number = _ipc_lowest_bit(mask);
+
+    return (number << 3) + rt_lowest_bitmap[index->priority_table[number]];
+#else
+    mask = index->priority_group & ~((2UL << priority) - 1);
+    if (mask == 0)
+        return -1;
+
+    return _ipc_lowest_bit(mask);
+#endif
+}
+
+/* the priority group of index, which has its first thread recorded */
+rt_inline rt_uint8_t _ipc_index_group(rt_uint8_t priority)
+{
+#if RT_THREAD_PRIORITY_MAX > 32
+    return priority >> 3;
+#else
+    return priority;
+#endif
+}
+
+static void _ipc_index_init(struct rt_ipc_prio_index *index, rt_list_t *list)
+{
+    rt_memset(index, 0, sizeof(struct rt_ipc_prio_index));
+    index->list = list;
+}
+
+static void _ipc_index_insert(struct rt_ipc_prio_index *index,
+                              struct rt_thread         *thread)
+{
+    struct rt_thread *sthread;
+    rt_uint8_t priority, group;
+    int next;
+
+    priority = thread->current_priority;
+    group = _ipc_index_group(priority);
+
+    /* append to the threads of same priority, which is before the first
+     * thread of next waiting priority */
+    next = _ipc_index_next(index, priority);
+    if (next < 0)
+        rt_list_insert_before(index->list, &(thread->tlist));
+    else
+    {
+        /* the threads of higher priority in the same group are skipped */
+        sthread = index->first[_ipc_index_group(next)];
+        while (sthread->suspend_priority <= priority)
+            sthread = rt_list_entry(sthread->tlist.next, struct rt_thread, tlist);
+
+        rt_list_insert_before(&(sthread->tlist), &(thread->tlist));
+    }
+
+    if (index->first[group] == RT_NULL ||
+        priority < index->first[group]->suspend_priority)
+        index->first[group] = thread;
+
+#if RT_THREAD_PRIORITY_MAX > 32
+    index->priority_table[priority >> 3] |= 1 << (priority & 0x07);
+    index->priority_group |= 1UL << (priority >> 3);
+#else
+    index->priority_group |= 1UL << priority;
+#endif
+
+    thread->suspend_index    = index;
+    thread->suspend_priority = priority;
+}
+
+/**
+ * This function will remove a thread from the suspend list it's on, and
+ * update the priority index of list. It's invoked with interrupt disabled.
+ *
+ * @param thread the suspended thread
+ */
+void rt_ipc_list_remove(struct rt_thread *thread)
+{
+    struct rt_ipc_prio_index *index;
+    struct rt_thread *prev, *next;
+    rt_uint8_t priority, group;
+
+    index = thread->suspend_index;
+    if (index != RT_NULL)
+    {
+        priority = thread->suspend_priority;
+        group = _ipc_index_group(priority);
+
+        prev = RT_NULL;
+        if (thread->tlist.prev != index->list)
+            prev = rt_list_entry(thread->tlist.prev, struct rt_thread, tlist);
+        next = RT_NULL;
+        if (thread->tlist.next != index->list)
+            next = rt_list_entry(thread->tlist.next, struct rt_thread, tlist);
+
+        if (index->first[group] == thread)
+        {
+            if (next != RT_NULL && _ipc_index_group(next->suspend_priority) == group)
+                index->first[group] = next;
+            else
+                index->first[group] = RT_NULL;
+        }
+
+        /* the threads of same priority are adjacent in list */
+        if ((prev == RT_NULL || prev->suspend_priority != priority) &&
+            (next == RT_NULL || next->suspend_priority != priority))
+        {
+#if RT_THREAD_PRIORITY_MAX > 32
+            index->priority_table[priority >> 3] &= ~(1 << (priority & 0x07));
+            if (index->priority_table[priority >> 3] == 0)
+                index->priority_group &= ~(1UL << (priority >> 3));
+#else
+            index->priority_group &= ~(1UL << priority);
+#endif
+        }
+    }
+
+    thread->suspend_index = RT_NULL;
+    rt_list_remove(&(thread->tlist));
+}
+#else
+struct rt_ipc_prio_index;
+
+#define RT_IPC_INDEX(object, member)    RT_NULL
+#endif
+
 /**
  * This function will initialize an IPC object
  *
@@ -63,62 +224,88 @@ rt_inline rt_err_t rt_ipc_object_init(struct rt_ipc_object *ipc)
 {
     /* init ipc object */
     rt_list_init(&(ipc->suspend_thread));
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    _ipc_index_init(&(ipc->suspend_index), &(ipc->suspend_thread));
+#endif
+#ifdef RT_USING_WAIT_ANY
+    rt_list_init(&(ipc->wait_list));
+#endif
 
     return RT_EOK;
 }
 
+/**
+ * This function will insert a suspended thread to a specified list in the
+ * order of the IPC object flag.
+ *
+ * @param list the IPC suspended thread list
+ * @param index the priority index of list, RT_NULL for no index
+ * @param thread the thread object to be inserted
+ * @param flag the IPC object flag
+ */
+rt_inline void rt_ipc_list_insert(rt_list_t                *list,
+                                  struct rt_ipc_prio_index *index,
+                                  struct rt_thread         *thread,
+                                  rt_uint8_t                flag)
+{
+    if (flag & RT_IPC_FLAG_PRIO)
+    {
+        struct rt_list_node *n;
+        struct rt_thread *sthread;
+
+#ifdef RT_USING_IPC_PRIO_QUEUE
+        if (index != RT_NULL)
+        {
+            _ipc_index_insert(index, thread);
+
+            return;
+        }
+#endif
+
+        /* find a suitable position */
+        for (n = list->next; n != list; n = n->next)
+        {
+            sthread = rt_list_entry(n, struct rt_thread, tlist);
+
+            /* find out */
+            if (thread->current_priority < sthread->current_priority)
+            {
+                /* insert this thread before the sthread */
+                rt_list_insert_before(&(sthread->tlist), &(thread->tlist));
+
+                return;
+            }
+        }
+    }
+
+    /*
+     * FIFOed list or not found a suitable position,
+     * append to the end of suspend_thread list
+     */
+    rt_list_insert_before(list, &(thread->tlist));
+}
+
 /**
  * This function will suspend a thread to a specified list. IPC object or some
  * double-queue object (mailbox etc.) contains this kind of list.
  *
  * @param list the IPC suspended thread list
+ * @param index the priority index of list, RT_NULL for no index
  * @param thread the thread object to be suspended
  * @param flag the IPC object flag,
  *        which shall be RT_IPC_FLAG_FIFO/RT_IPC_FLAG_PRIO.
  *
  * @return the operation status, RT_EOK on successful
  */
-rt_inline rt_err_t rt_ipc_list_suspend(rt_list_t        *list,
-                                       struct rt_thread *thread,
-                                       rt_uint8_t        flag)
+rt_inline rt_err_t rt_ipc_list_suspend(rt_list_t                *list,
+                                       struct rt_ipc_prio_index *index,
+                                       struct rt_thread         *thread,
+                                       rt_uint8_t                flag)
 {
     /* suspend thread */
     rt_thread_suspend(thread);
 
-    switch (flag)
-    {
-    case RT_IPC_FLAG_FIFO:
-        rt_list_insert_before(list, &(thread->tlist));
-        break;
-
-    case RT_IPC_FLAG_PRIO:
-        {
-            struct rt_list_node *n;
-            struct rt_thread *sthread;
-
-            /* find a suitable position */
-            for (n = list->next; n != list; n = n->next)
-            {
-                sthread = rt_list_entry(n, struct rt_thread, tlist);
-
-                /* find out */
-                if (thread->current_priority < sthread->current_priority)
-                {
-                    /* insert this thread before the sthread */
-                    rt_list_insert_before(&(sthread->tlist), &(thread->tlist));
-                    break;
-                }
-            }
-
-            /*
-             * not found a suitable position,
-             * append to the end of suspend_thread list
-             */
-            if (n == list)
-                rt_list_insert_before(list, &(thread->tlist));
-        }
-        break;
-    }
+    rt_ipc_list_insert(list, index, thread, flag);
 
     return RT_EOK;
 }
@@ -185,6 +372,119 @@ rt_inline rt_err_t rt_ipc_list_resume_all(rt_list_t *list)
     return RT_EOK;
 }
 
+#ifdef RT_USING_WAIT_ANY
+/*
+ * The thread in rt_wait_any is not on any suspend list of objects, so it's
+ * never queued twice by its tlist. A node of the thread is linked on the
+ * wait list of each object instead, and all the nodes are removed at once
+ * when it's resumed by one of the objects.
+ */
+#ifndef RT_WAIT_ANY_MAX
+#define RT_WAIT_ANY_MAX         8
+#endif
+
+struct rt_ipc_wait_node
+{
+    rt_list_t           list;                   /* node of the wait list of object */
+    struct rt_ipc_wait *wait;
+};
+
+struct rt_ipc_wait
+{
+    struct rt_thread       *thread;             /* the waiting thread */
+    rt_int32_t              fired;              /* the object resumed thread, -1 for none */
+    rt_uint32_t             count;
+    struct rt_ipc_wait_node nodes[RT_WAIT_ANY_MAX];
+};
+
+static void _ipc_wait_unlink(struct rt_ipc_wait *wait)
+{
+    rt_uint32_t index;
+
+    for (index = 0; index < wait->count; index ++)
+        rt_list_remove(&(wait->nodes[index].list));
+
+    wait->thread->ipc_wait = RT_NULL;
+}
+
+/*
+ * This function will resume all threads waiting for any of objects on the
+ * object. It's invoked with interrupt disabled when the object becomes ready
+ * and no suspended thread takes it, or the object is detached.
+ *
+ * @return RT_TRUE if there is any thread resumed
+ */
+static rt_bool_t _ipc_wait_wakeup(struct rt_ipc_object *ipc, rt_err_t error)
+{
+    struct rt_ipc_wait_node *node;
+    struct rt_ipc_wait *wait;
+
+    if (rt_list_isempty(&(ipc->wait_list)))
+        return RT_FALSE;
+
+    while (!rt_list_isempty(&(ipc->wait_list)))
+    {
+        node = rt_list_entry(ipc->wait_list.next, struct rt_ipc_wait_node, list);
+        wait = node->wait;
+
+        /* remove the thread from the wait lists of all objects */
+        wait->fired = node - wait->nodes;
+        _ipc_wait_unlink(wait);
+
+        RT_DEBUG_LOG(RT_DEBUG_IPC, ("resume waiting thread:%s\n", wait->thread->name));
+
+        /* the thread may have been resumed by timeout and not run yet */
+        if (wait->thread->stat == RT_THREAD_SUSPEND)
+        {
+            wait->thread->error = error;
+            rt_thread_resume(wait->thread);
+        }
+    }
+
+    return RT_TRUE;
+}
+
+/**
+ * This function will resume all threads waiting for any of objects on the
+ * object with error code -RT_ERROR.
+ *
+ * @param ipc the IPC object
+ */
+rt_inline void rt_ipc_wait_resume_all(struct rt_ipc_object *ipc)
+{
+    register rt_ubase_t temp;
+
+    temp = rt_hw_interrupt_disable();
+    _ipc_wait_wakeup(ipc, -RT_ERROR);
+    rt_hw_interrupt_enable(temp);
+}
+
+/**
+ * This function will remove a thread from the wait lists of objects if it's
+ * waiting in rt_wait_any. It's invoked when thread is detached or deleted.
+ *
+ * @param thread the thread
+ */
+void rt_ipc_wait_remove(struct rt_thread *thread)
+{
+    register rt_ubase_t temp;
+
+    temp = rt_hw_interrupt_disable();
+    if (thread->ipc_wait != RT_NULL)
+        _ipc_wait_unlink(thread->ipc_wait);
+    rt_hw_interrupt_enable(temp);
+}
+#else
+rt_inline rt_bool_t _ipc_wait_wakeup(struct rt_ipc_object *ipc, rt_err_t error)
+{
+    return RT_FALSE;
+}
+
+rt_inline void rt_ipc_wait_resume_all(struct rt_ipc_object *ipc)
+{
+}
+#endif
+
 #ifdef RT_USING_SEMAPHORE
 /**
  * This function will initialize a semaphore and put it under control of
@@ -235,6 +535,7 @@ rt_err_t rt_sem_detach(rt_sem_t sem)
 
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(sem->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(sem->parent));
 
     /* detach semaphore object */
     rt_object_detach(&(sem->parent.parent));
@@ -296,6 +597,7 @@ rt_err_t rt_sem_delete(rt_sem_t sem)
 
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(sem->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(sem->parent));
 
     /* delete semaphore object */
     rt_object_delete(&(sem->parent.parent));
@@ -365,6 +667,7 @@ rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
 
             /* suspend thread */
             rt_ipc_list_suspend(&(sem->parent.suspend_thread),
+                                RT_IPC_INDEX(&(sem->parent), suspend_index),
                                 thread,
                                 sem->parent.parent.flag);
 
@@ -445,8 +748,14 @@ rt_err_t rt_sem_release(rt_sem_t sem)
         need_schedule = RT_TRUE;
     }
     else
+    {
         sem->value ++; /* increase value */
 
+        /* resume the threads waiting for any of objects */
+        if (_ipc_wait_wakeup(&(sem->parent), RT_EOK) == RT_TRUE)
+            need_schedule = RT_TRUE;
+    }
+
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
@@ -483,6 +792,7 @@ rt_err_t rt_sem_control(rt_sem_t sem, rt_uint8_t cmd, void *arg)
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&sem->parent.suspend_thread);
+        rt_ipc_wait_resume_all(&(sem->parent));
 
         /* set new value */
         sem->value = (rt_uint16_t)value;
@@ -501,6 +811,190 @@ RTM_EXPORT(rt_sem_control);
 #endif /* end of RT_USING_SEMAPHORE */
 
 #ifdef RT_USING_MUTEX
+/*
+ * The priority of a mutex owner is the highest one of its base priority, the
+ * ceilings of the held priority ceiling mutexes and the priorities of threads
+ * waiting for the held mutexes. When the owner is waiting for another mutex,
+ * its priority is inherited by the owner of that mutex, and so on along the
+ * blocking chain.
+ *
+ * The base priority of a thread is kept in the original_priority of every
+ * mutex it holds.
+ *
+ * The ceiling_priority of a mutex is RT_MUTEX_CEILING_NONE until it's set by
+ * rt_mutex_control, which is out of the range of priority.
+ */
+
+#define RT_MUTEX_CEILING_NONE   0xffff
+
+/* the maximal length of blocking chain to be propagated */
+#ifndef RT_MUTEX_CHAIN_MAX
+#define RT_MUTEX_CHAIN_MAX      16
+#endif
+
+/* the priority ceiling of mutex, RT_MUTEX_CEILING_NONE for no ceiling */
+rt_inline rt_uint16_t _mutex_ceiling(struct rt_mutex *mutex)
+{
+    if (mutex->parent.parent.flag & RT_IPC_FLAG_CEILING)
+        return mutex->ceiling_priority;
+
+    return RT_MUTEX_CEILING_NONE;
+}
+
+static rt_uint8_t _mutex_base_priority(struct rt_thread *thread)
+{
+    struct rt_mutex *mutex;
+
+    /* the thread holding no mutex is not boosted */
+    if (rt_list_isempty(&(thread->taken_mutex_list)))
+        return thread->current_priority;
+
+    mutex = rt_list_entry(thread->taken_mutex_list.next, struct rt_mutex, taken_list);
+
+    return mutex->original_priority;
+}
+
+static rt_uint8_t _mutex_priority(struct rt_thread *thread, rt_uint8_t priority)
+{
+    struct rt_list_node *node, *wnode;
+    struct rt_mutex *mutex;
+    struct rt_thread *waiter;
+
+    for (node = thread->taken_mutex_list.next;
+         node != &(thread->taken_mutex_list);
+         node = node->next)
+    {
+        mutex = rt_list_entry(node, struct rt_mutex, taken_list);
+
+        if (_mutex_ceiling(mutex) < priority)
+            priority = (rt_uint8_t)_mutex_ceiling(mutex);
+
+        for (wnode = mutex->parent.suspend_thread.next;
+             wnode != &(mutex->parent.suspend_thread);
+             wnode = wnode->next)
+        {
+            waiter = rt_list_entry(wnode, struct rt_thread, tlist);
+            if (waiter->current_priority < priority)
+                priority = waiter->current_priority;
+
+            /* the first one of priority ordered list is the highest */
+            if (mutex->parent.parent.flag & RT_IPC_FLAG_PRIO)
+                break;
+        }
+    }
+
+    return priority;
+}
+
+static void _mutex_set_priority(struct rt_thread *thread, rt_uint8_t priority)
+{
+    struct rt_mutex *mutex;
+
+    rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+
+    /* keep the order of priority waiting list */
+    mutex = thread->pending_mutex;
+    if (mutex != RT_NULL && thread->stat == RT_THREAD_SUSPEND &&
+        (mutex->parent.parent.flag & RT_IPC_FLAG_PRIO))
+    {
+#ifdef RT_USING_IPC_PRIO_QUEUE
+        rt_ipc_list_remove(thread);
+#else
+        rt_list_remove(&(thread->tlist));
+#endif
+        rt_ipc_list_insert(&(mutex->parent.suspend_thread),
+                           RT_IPC_INDEX(&(mutex->parent), suspend_index),
+                           thread,
+                           mutex->parent.parent.flag);
+    }
+}
+
+/*
+ * This function will recompute the priority of a thread and propagate the
+ * change along the blocking chain. It's invoked with interrupt disabled.
+ */
+static void _mutex_update_priority(struct rt_thread *thread, rt_uint8_t base)
+{
+    rt_uint8_t priority;
+    int depth;
+
+    for (depth = 0; depth < RT_MUTEX_CHAIN_MAX; depth ++)
+    {
+        priority = _mutex_priority(thread, base);
+        if (priority == thread->current_priority)
+            break;
+
+        _mutex_set_priority(thread, priority);
+
+        /* the owner of mutex which this thread is waiting for */
+        if (thread->pending_mutex == RT_NULL ||
+            thread->stat != RT_THREAD_SUSPEND ||
+            thread->pending_mutex->owner == RT_NULL)
+            break;
+        thread = thread->pending_mutex->owner;
+        base = _mutex_base_priority(thread);
+    }
+}
+
+/**
+ * This function will clear the mutex which a thread is waiting for, when it's
+ * woken up by timeout or rt_thread_resume, and the owner of mutex doesn't
+ * inherit from it any more. It's invoked with interrupt disabled, after the
+ * thread is removed from the suspend list.
+ *
+ * @param thread the woken up thread
+ */
+void rt_mutex_pending_remove(struct rt_thread *thread)
+{
+    struct rt_mutex *mutex;
+
+    mutex = thread->pending_mutex;
+    if (mutex == RT_NULL)
+        return;
+
+    thread->pending_mutex = RT_NULL;
+    if (mutex->owner != RT_NULL)
+        _mutex_update_priority(mutex->owner, _mutex_base_priority(mutex->owner));
+}
+
+/* set the new owner of mutex, it's invoked with interrupt disabled */
+static void _mutex_set_owner(struct rt_mutex *mutex, struct rt_thread *thread)
+{
+    mutex->owner             = thread;
+    mutex->original_priority = _mutex_base_priority(thread);
+    mutex->hold ++;
+
+    rt_list_insert_before(&(thread->taken_mutex_list), &(mutex->taken_list));
+}
+
+/* remove the mutex from its owner and waiters before it's detached */
+static void _mutex_drop(struct rt_mutex *mutex)
+{
+    register rt_base_t temp;
+    struct rt_list_node *node;
+    struct rt_thread *owner;
+
+    temp = rt_hw_interrupt_disable();
+
+    for (node = mutex->parent.suspend_thread.next;
+         node != &(mutex->parent.suspend_thread);
+         node = node->next)
+    {
+        rt_list_entry(node, struct rt_thread, tlist)->pending_mutex = RT_NULL;
+    }
+
+    owner = mutex->owner;
+    if (owner != RT_NULL)
+    {
+        rt_list_remove(&(mutex->taken_list));
+        mutex->owner = RT_NULL;
+
+        _mutex_update_priority(owner, mutex->original_priority);
+    }
+
+    rt_hw_interrupt_enable(temp);
+}
+
 /**
  * This function will initialize a mutex and put it under control of resource
  * management.
@@ -525,6 +1019,8 @@ rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
     mutex->owner = RT_NULL;
     mutex->original_priority = 0xFF;
     mutex->hold  = 0;
+    mutex->ceiling_priority = RT_MUTEX_CEILING_NONE;
+    rt_list_init(&(mutex->taken_list));
 
     /* set flag */
     mutex->parent.parent.flag = flag;
@@ -546,6 +1042,9 @@ rt_err_t rt_mutex_detach(rt_mutex_t mutex)
 {
     RT_ASSERT(mutex != RT_NULL);
 
+    /* restore the priority of owner */
+    _mutex_drop(mutex);
+
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(mutex->parent.suspend_thread));
 
@@ -585,6 +1084,8 @@ rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
     mutex->owner              = RT_NULL;
     mutex->original_priority  = 0xFF;
     mutex->hold               = 0;
+    mutex->ceiling_priority   = RT_MUTEX_CEILING_NONE;
+    rt_list_init(&(mutex->taken_list));
 
     /* set flag */
     mutex->parent.parent.flag = flag;
@@ -608,6 +1109,9 @@ rt_err_t rt_mutex_delete(rt_mutex_t mutex)
 
     RT_ASSERT(mutex != RT_NULL);
 
+    /* restore the priority of owner */
+    _mutex_drop(mutex);
+
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(mutex->parent.suspend_thread));
 
@@ -660,6 +1164,18 @@ rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
     }
     else
     {
+        /* the thread shall not be higher than the ceiling */
+        if (_mutex_ceiling(mutex) != RT_MUTEX_CEILING_NONE &&
+            _mutex_base_priority(thread) < _mutex_ceiling(mutex))
+        {
+            thread->error = -RT_ERROR;
+
+            /* enable interrupt */
+            rt_hw_interrupt_enable(temp);
+
+            return -RT_ERROR;
+        }
+
         /* The value of mutex is 1 in initial status. Therefore, if the
          * value is great than 0, it indicates the mutex is avaible.
          */
@@ -669,9 +1185,17 @@ rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
             mutex->value --;
 
             /* set mutex owner and original priority */
-            mutex->owner             = thread;
-            mutex->original_priority = thread->current_priority;
-            mutex->hold ++;
+            _mutex_set_owner(mutex, thread);
+
+            /* raise to the ceiling immediately, no inheritance is needed */
+            if (_mutex_ceiling(mutex) < thread->current_priority)
+            {
+                rt_uint8_t priority = (rt_uint8_t)_mutex_ceiling(mutex);
+
+                rt_thread_control(thread,
+                                  RT_THREAD_CTRL_CHANGE_PRIORITY,
+                                  &priority);
+            }
         }
         else
         {
@@ -692,20 +1216,17 @@ rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
                 RT_DEBUG_LOG(RT_DEBUG_IPC, ("mutex_take: suspend thread: %s\n",
                                             thread->name));
 
-                /* change the owner thread priority of mutex */
-                if (thread->current_priority < mutex->owner->current_priority)
-                {
-                    /* change the owner thread priority */
-                    rt_thread_control(mutex->owner,
-                                      RT_THREAD_CTRL_CHANGE_PRIORITY,
-                                      &thread->current_priority);
-                }
-
                 /* suspend current thread */
+                thread->pending_mutex = mutex;
                 rt_ipc_list_suspend(&(mutex->parent.suspend_thread),
+                                    RT_IPC_INDEX(&(mutex->parent), suspend_index),
                                     thread,
                                     mutex->parent.parent.flag);
 
+                /* change the owner thread priority along the blocking chain */
+                _mutex_update_priority(mutex->owner,
+                                       _mutex_base_priority(mutex->owner));
+
                 /* has waiting time, start thread timer */
                 if (time > 0)
                 {
@@ -726,17 +1247,20 @@ rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
                 /* do schedule */
                 rt_schedule();
 
+                /* disable interrupt */
+                temp = rt_hw_interrupt_disable();
+
+                /* the pending mutex is cleared by timeout or resume */
                 if (thread->error != RT_EOK)
                 {
+                    /* enable interrupt */
+                    rt_hw_interrupt_enable(temp);
+
                     /* return error */
                     return thread->error;
                 }
-                else
-                {
-                    /* the mutex is taken successfully. */
-                    /* disable interrupt */
-                    temp = rt_hw_interrupt_disable();
-                }
+
+                /* the mutex is taken successfully. */
             }
         }
     }
@@ -794,13 +1318,12 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
     /* if no hold */
     if (mutex->hold == 0)
     {
-        /* change the owner thread to original priority */
-        if (mutex->original_priority != mutex->owner->current_priority)
-        {
-            rt_thread_control(mutex->owner,
-                              RT_THREAD_CTRL_CHANGE_PRIORITY,
-                              &(mutex->original_priority));
-        }
+        /*
+         * change the owner thread to the priority inherited from the other
+         * held mutexes, or the original priority
+         */
+        rt_list_remove(&(mutex->taken_list));
+        _mutex_update_priority(thread, mutex->original_priority);
 
         /* wakeup suspended thread */
         if (!rt_list_isempty(&mutex->parent.suspend_thread))
@@ -814,13 +1337,15 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
                                         thread->name));
 
             /* set new owner and priority */
-            mutex->owner             = thread;
-            mutex->original_priority = thread->current_priority;
-            mutex->hold ++;
+            thread->pending_mutex = RT_NULL;
+            _mutex_set_owner(mutex, thread);
 
             /* resume thread */
             rt_ipc_list_resume(&(mutex->parent.suspend_thread));
 
+            /* the new owner inherits from the remaining waiters */
+            _mutex_update_priority(thread, mutex->original_priority);
+
             need_schedule = RT_TRUE;
         }
         else
@@ -849,13 +1374,39 @@ RTM_EXPORT(rt_mutex_release);
  * This function can get or set some extra attributions of a mutex object.
  *
  * @param mutex the mutex object
- * @param cmd the execution command
+ * @param cmd the execution command, RT_IPC_CMD_SET_CEILING for setting the
+ *        priority ceiling of a RT_IPC_FLAG_CEILING mutex.
  * @param arg the execution argument
  *
  * @return the error code
  */
 rt_err_t rt_mutex_control(rt_mutex_t mutex, rt_uint8_t cmd, void *arg)
 {
+    register rt_base_t temp;
+    rt_uint16_t priority;
+
+    RT_ASSERT(mutex != RT_NULL);
+
+    if (cmd == RT_IPC_CMD_SET_CEILING)
+    {
+        /* compare in a wider type, the priority may be up to 255 */
+        priority = *(rt_uint8_t *)arg;
+        if (priority >= RT_THREAD_PRIORITY_MAX)
+            return -RT_ERROR;
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        mutex->ceiling_priority = priority;
+        if (mutex->owner != RT_NULL)
+            _mutex_update_priority(mutex->owner, mutex->original_priority);
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        return RT_EOK;
+    }
+
     return -RT_ERROR;
 }
 RTM_EXPORT(rt_mutex_control);
@@ -906,6 +1457,7 @@ rt_err_t rt_event_detach(rt_event_t event)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(event->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(event->parent));
 
     /* detach event object */
     rt_object_detach(&(event->parent.parent));
@@ -963,6 +1515,7 @@ rt_err_t rt_event_delete(rt_event_t event)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(event->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(event->parent));
 
     /* delete event object */
     rt_object_delete(&(event->parent.parent));
@@ -1052,6 +1605,10 @@ rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set)
         }
     }
 
+    /* resume the threads waiting for any of objects */
+    if (event->set != 0 && _ipc_wait_wakeup(&(event->parent), RT_EOK) == RT_TRUE)
+        need_schedule = RT_TRUE;
+
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
 
@@ -1138,6 +1695,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
 
         /* put thread to suspended thread list */
         rt_ipc_list_suspend(&(event->parent.suspend_thread),
+                            RT_IPC_INDEX(&(event->parent), suspend_index),
                             thread,
                             event->parent.parent.flag);
 
@@ -1200,6 +1758,7 @@ rt_err_t rt_event_control(rt_event_t event, rt_uint8_t cmd, void *arg)
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&event->parent.suspend_thread);
+        rt_ipc_wait_resume_all(&(event->parent));
 
         /* init event set */
         event->set = 0;
@@ -1256,6 +1815,9 @@ rt_err_t rt_mb_init(rt_mailbox_t mb,
 
     /* init an additional list of sender suspend thread */
     rt_list_init(&(mb->suspend_sender_thread));
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    _ipc_index_init(&(mb->suspend_sender_index), &(mb->suspend_sender_thread));
+#endif
 
     return RT_EOK;
 }
@@ -1275,6 +1837,7 @@ rt_err_t rt_mb_detach(rt_mailbox_t mb)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(mb->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(mb->parent));
     /* also resume all mailbox private suspended thread */
     rt_ipc_list_resume_all(&(mb->suspend_sender_thread));
 
@@ -1328,6 +1891,9 @@ rt_mailbox_t rt_mb_create(const char *name, rt_size_t size, rt_uint8_t flag)
 
     /* init an additional list of sender suspend thread */
     rt_list_init(&(mb->suspend_sender_thread));
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    _ipc_index_init(&(mb->suspend_sender_index), &(mb->suspend_sender_thread));
+#endif
 
     return mb;
 }
@@ -1349,6 +1915,7 @@ rt_err_t rt_mb_delete(rt_mailbox_t mb)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(mb->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(mb->parent));
 
     /* also resume all mailbox private suspended thread */
     rt_ipc_list_resume_all(&(mb->suspend_sender_thread));
@@ -1428,6 +1995,7 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
         RT_DEBUG_NOT_IN_INTERRUPT;
         /* suspend current thread */
         rt_ipc_list_suspend(&(mb->suspend_sender_thread),
+                            RT_IPC_INDEX(mb, suspend_sender_index),
                             thread,
                             mb->parent.parent.flag);
 
@@ -1495,6 +2063,17 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
         return RT_EOK;
     }
 
+    /* resume the threads waiting for any of objects */
+    if (_ipc_wait_wakeup(&(mb->parent), RT_EOK) == RT_TRUE)
+    {
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        rt_schedule();
+
+        return RT_EOK;
+    }
+
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
@@ -1575,6 +2154,7 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
         RT_DEBUG_NOT_IN_INTERRUPT;
         /* suspend current thread */
         rt_ipc_list_suspend(&(mb->parent.suspend_thread),
+                            RT_IPC_INDEX(&(mb->parent), suspend_index),
                             thread,
                             mb->parent.parent.flag);
 
@@ -1675,6 +2255,7 @@ rt_err_t rt_mb_control(rt_mailbox_t mb, rt_uint8_t cmd, void *arg)
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&(mb->parent.suspend_thread));
+        rt_ipc_wait_resume_all(&(mb->parent));
         /* also resume all mailbox private suspended thread */
         rt_ipc_list_resume_all(&(mb->suspend_sender_thread));
 
@@ -1779,6 +2360,7 @@ rt_err_t rt_mq_detach(rt_mq_t mq)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&mq->parent.suspend_thread);
+    rt_ipc_wait_resume_all(&(mq->parent));
 
     /* detach message queue object */
     rt_object_detach(&(mq->parent.parent));
@@ -1872,6 +2454,7 @@ rt_err_t rt_mq_delete(rt_mq_t mq)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(mq->parent.suspend_thread));
+    rt_ipc_wait_resume_all(&(mq->parent));
 
 #if defined(RT_USING_MODULE) && defined(RT_USING_SLAB)
     /* the mq object belongs to an application module */
@@ -1971,6 +2554,17 @@ rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
         return RT_EOK;
     }
 
+    /* resume the threads waiting for any of objects */
+    if (_ipc_wait_wakeup(&(mq->parent), RT_EOK) == RT_TRUE)
+    {
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        rt_schedule();
+
+        return RT_EOK;
+    }
+
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
@@ -2053,6 +2647,17 @@ rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
         return RT_EOK;
     }
 
+    /* resume the threads waiting for any of objects */
+    if (_ipc_wait_wakeup(&(mq->parent), RT_EOK) == RT_TRUE)
+    {
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        rt_schedule();
+
+        return RT_EOK;
+    }
+
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
@@ -2124,6 +2729,7 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
 
         /* suspend current thread */
         rt_ipc_list_suspend(&(mq->parent.suspend_thread),
+                            RT_IPC_INDEX(&(mq->parent), suspend_index),
                             thread,
                             mq->parent.parent.flag);
 
@@ -2225,6 +2831,7 @@ rt_err_t rt_mq_control(rt_mq_t mq, rt_uint8_t cmd, void *arg)
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&mq->parent.suspend_thread);
+        rt_ipc_wait_resume_all(&(mq->parent));
 
         /* release all message in the queue */
         while (mq->msg_queue_head != RT_NULL)
@@ -2259,4 +2866,183 @@ rt_err_t rt_mq_control(rt_mq_t mq, rt_uint8_t cmd, void *arg)
 RTM_EXPORT(rt_mq_control);
 #endif /* end of RT_USING_MESSAGEQUEUE */
 
+#ifdef RT_USING_WAIT_ANY
+static rt_bool_t _ipc_ready(rt_object_t object)
+{
+    switch (object->type & ~RT_Object_Class_Static)
+    {
+#ifdef RT_USING_SEMAPHORE
+    case RT_Object_Class_Semaphore:
+        return ((rt_sem_t)object)->value > 0;
+#endif
+#ifdef RT_USING_EVENT
+    case RT_Object_Class_Event:
+        return ((rt_event_t)object)->set != 0;
+#endif
+#ifdef RT_USING_MAILBOX
+    case RT_Object_Class_MailBox:
+        return ((rt_mailbox_t)object)->entry > 0;
+#endif
+#ifdef RT_USING_MESSAGEQUEUE
+    case RT_Object_Class_MessageQueue:
+        return ((rt_mq_t)object)->entry > 0;
+#endif
+    default:
+        return RT_FALSE;
+    }
+}
+
+static rt_bool_t _ipc_waitable(rt_object_t object)
+{
+    switch (object->type & ~RT_Object_Class_Static)
+    {
+    case RT_Object_Class_Semaphore:
+    case RT_Object_Class_Event:
+    case RT_Object_Class_MailBox:
+    case RT_Object_Class_MessageQueue:
+        return RT_TRUE;
+    default:
+        return RT_FALSE;
+    }
+}
+
+/**
+ * This function will wait until any of the IPC objects is ready, that is, a
+ * semaphore is available, an event is set, or a mailbox or message queue is
+ * not empty. It doesn't take the ready object, and the caller shall take it
+ * by the non-blocking operation of object, such as rt_sem_trytake. If it's
+ * taken by other thread before, wait again.
+ *
+ * The suspended threads of an object takes it before the threads waiting for
+ * any of objects.
+ *
+ * @param objects the semaphores, events, mailboxes or message queues
+ * @param count the number of objects, which is up to RT_WAIT_ANY_MAX
+ * @param timeout the waiting time
+ *
+ * @return the index of the ready object, -RT_ETIMEOUT on timeout, -RT_ERROR
+ *         if an object is detached or not supported.
+ */
+rt_int32_t rt_wait_any(rt_object_t objects[], rt_uint32_t count, rt_int32_t timeout)
+{
+    struct rt_ipc_wait wait;
+    struct rt_thread *thread;
+    register rt_ubase_t temp;
+    rt_uint32_t index, tick_delta;
+
+    /* parameter check */
+    RT_ASSERT(objects != RT_NULL);
+    RT_ASSERT(count > 0 && count <= RT_WAIT_ANY_MAX);
+
+    for (index = 0; index < count; index ++)
+    {
+        RT_ASSERT(objects[index] != RT_NULL);
+        if (_ipc_waitable(objects[index]) == RT_FALSE)
+            return -RT_ERROR;
+    }
+
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
+
+    wait.thread = thread;
+    wait.count = count;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    wait.fired = -1;
+    while (1)
+    {
+        /* the object resumed thread is checked at first */
+        if (wait.fired >= 0 && _ipc_ready(objects[wait.fired]))
+        {
+            rt_hw_interrupt_enable(temp);
+
+            return wait.fired;
+        }
+
+        for (index = 0; index < count; index ++)
+        {
+            if (_ipc_ready(objects[index]))
+            {
+                rt_hw_interrupt_enable(temp);
+
+                return index;
+            }
+        }
+
+        /* no waiting, return timeout */
+        if (timeout == 0)
+        {
+            rt_hw_interrupt_enable(temp);
+
+            return -RT_ETIMEOUT;
+        }
+
+        RT_DEBUG_NOT_IN_INTERRUPT;
+
+        /* reset error number in thread */
+        thread->error = RT_EOK;
+        wait.fired = -1;
+
+        /* suspend current thread and link it on the wait list of objects */
+        rt_thread_suspend(thread);
+        for (index = 0; index < count; index ++)
+        {
+            wait.nodes[index].wait = &wait;
+            rt_list_insert_before(&(((struct rt_ipc_object *)objects[index])->wait_list),
+                                  &(wait.nodes[index].list));
+        }
+        thread->ipc_wait = &wait;
+
+        /* has waiting time, start thread timer */
+        if (timeout > 0)
+        {
+            /* get the start tick of timer */
+            tick_delta = rt_tick_get();
+
+            /* reset the timeout of thread timer and start it */
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        /* re-schedule */
+        rt_schedule();
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        /* remove from the wait lists, if it's resumed by timeout or others */
+        if (thread->ipc_wait != RT_NULL)
+            _ipc_wait_unlink(&wait);
+
+        /* resume from suspend state */
+        if (thread->error != RT_EOK)
+        {
+            rt_hw_interrupt_enable(temp);
+
+            /* return error */
+            return thread->error;
+        }
+
+        /* if it's not waiting forever and then re-calculate timeout tick */
+        if (timeout > 0)
+        {
+            tick_delta = rt_tick_get() - tick_delta;
+            timeout -= tick_delta;
+            if (timeout < 0)
+                timeout = 0;
+        }
+    }
+}
+RTM_EXPORT(rt_wait_any);
+#endif /* end of RT_USING_WAIT_ANY */
+
 /*@}*/
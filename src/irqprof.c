@@ -0,0 +1,219 @@
+/*
+ * File      : irqprof.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-18     Bernard      the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_IRQPROF
+
+/*
+ * The interrupt masked section is from the outermost rt_hw_interrupt_disable
+ * to the matched rt_hw_interrupt_enable, and the scheduler locked section is
+ * from the outermost rt_enter_critical to the matched rt_exit_critical. The
+ * sections are timed by the cycle counter of CPU, and the worst sections of
+ * each pair of callers are kept.
+ */
+
+/* the number of worst sections to be kept */
+#ifndef RT_IRQPROF_WORST
+#define RT_IRQPROF_WORST        8
+#endif
+
+struct rt_irqprof_section
+{
+    void       *begin_caller;           /* who disables interrupt or locks */
+    void       *end_caller;             /* who enables interrupt or unlocks */
+    rt_uint32_t cycles;                 /* the worst cycles */
+    rt_uint32_t count;                  /* the times of the worst one is hit */
+};
+
+struct rt_irqprof
+{
+    rt_uint32_t nest;
+    rt_uint32_t stamp;
+    void       *caller;
+
+    struct rt_irqprof_section worst[RT_IRQPROF_WORST];
+};
+
+static struct rt_irqprof _irq_prof;
+static struct rt_irqprof _lock_prof;
+static rt_uint8_t _cycle_inited = 0;
+
+static void _prof_record(struct rt_irqprof *prof, void *end_caller, rt_uint32_t cycles)
+{
+    struct rt_irqprof_section *section, *least;
+    int index;
+
+    least = &(prof->worst[0]);
+    for (index = 0; index < RT_IRQPROF_WORST; index ++)
+    {
+        section = &(prof->worst[index]);
+        if (section->begin_caller == prof->caller && section->end_caller == end_caller)
+        {
+            /* the same code path, keep the worst */
+            if (cycles > section->cycles)
+            {
+                section->cycles = cycles;
+                section->count = 1;
+            }
+            else if (cycles == section->cycles)
+            {
+                section->count ++;
+            }
+
+            return;
+        }
+
+        if (section->cycles < least->cycles)
+            least = section;
+    }
+
+    if (cycles > least->cycles)
+    {
+        least->begin_caller = prof->caller;
+        least->end_caller = end_caller;
+        least->cycles = cycles;
+        least->count = 1;
+    }
+}
+
+/**
+ * This function disables interrupt and starts timing when interrupt is
+ * disabled at the first time. It's invoked by rt_hw_interrupt_disable().
+ *
+ * @return the interrupt level before disabled
+ */
+rt_base_t rt_irqprof_disable(void)
+{
+    rt_base_t level;
+
+    level = (rt_hw_interrupt_disable)();
+
+    if (_irq_prof.nest ++ == 0)
+    {
+        if (_cycle_inited == 0)
+        {
+            rt_hw_cycle_init();
+            _cycle_inited = 1;
+        }
+
+        _irq_prof.caller = RT_IRQPROF_CALLER();
+        _irq_prof.stamp = rt_hw_cycle_get();
+    }
+
+    return level;
+}
+RTM_EXPORT(rt_irqprof_disable);
+
+/**
+ * This function stops timing when the outermost section is ended and
+ * restores the interrupt level. It's invoked by rt_hw_interrupt_enable().
+ *
+ * @param level the interrupt level to be restored
+ */
+void rt_irqprof_enable(rt_base_t level)
+{
+    rt_uint32_t cycles;
+
+    if (_irq_prof.nest > 0 && -- _irq_prof.nest == 0)
+    {
+        cycles = rt_hw_cycle_get() - _irq_prof.stamp;
+        _prof_record(&_irq_prof, RT_IRQPROF_CALLER(), cycles);
+    }
+
+    (rt_hw_interrupt_enable)(level);
+}
+RTM_EXPORT(rt_irqprof_enable);
+
+/*
+ * The following functions are invoked by the scheduler with interrupt
+ * disabled when the scheduler is locked and unlocked at the outermost.
+ */
+void rt_irqprof_lock(void *caller)
+{
+    _lock_prof.caller = caller;
+    _lock_prof.stamp = rt_hw_cycle_get();
+    _lock_prof.nest = 1;
+}
+
+void rt_irqprof_unlock(void *caller)
+{
+    if (_lock_prof.nest == 0)
+        return;
+    _lock_prof.nest = 0;
+
+    _prof_record(&_lock_prof, caller, rt_hw_cycle_get() - _lock_prof.stamp);
+}
+
+/**
+ * This function clears the worst sections.
+ */
+void rt_irqprof_reset(void)
+{
+    rt_base_t level;
+
+    level = (rt_hw_interrupt_disable)();
+    rt_memset(_irq_prof.worst, 0, sizeof(_irq_prof.worst));
+    rt_memset(_lock_prof.worst, 0, sizeof(_lock_prof.worst));
+    (rt_hw_interrupt_enable)(level);
+}
+RTM_EXPORT(rt_irqprof_reset);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static void _prof_show(struct rt_irqprof *prof, const char *title)
+{
+    struct rt_irqprof_section worst[RT_IRQPROF_WORST], section;
+    rt_base_t level;
+    int i, j;
+
+    /* take a snapshot, the printing is not measured */
+    level = (rt_hw_interrupt_disable)();
+    rt_memcpy(worst, prof->worst, sizeof(worst));
+    (rt_hw_interrupt_enable)(level);
+
+    /* sort by cycles */
+    for (i = 1; i < RT_IRQPROF_WORST; i ++)
+    {
+        section = worst[i];
+        for (j = i; j > 0 && worst[j - 1].cycles < section.cycles; j --)
+            worst[j] = worst[j - 1];
+        worst[j] = section;
+    }
+
+    rt_kprintf("%s\n", title);
+    rt_kprintf("  cycles    count    begin      end\n");
+    rt_kprintf("---------- -------- ---------- ----------\n");
+    for (i = 0; i < RT_IRQPROF_WORST && worst[i].cycles != 0; i ++)
+    {
+        rt_kprintf("%10d %8d 0x%08x 0x%08x\n", worst[i].cycles, worst[i].count,
+                   worst[i].begin_caller, worst[i].end_caller);
+    }
+}
+
+long irqprof(void)
+{
+    _prof_show(&_irq_prof, "interrupt disabled:");
+    rt_kprintf("\n");
+    _prof_show(&_lock_prof, "scheduler locked:");
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(irqprof, show the worst interrupt disabled and scheduler locked sections)
+FINSH_FUNCTION_EXPORT_ALIAS(rt_irqprof_reset, irqprof_reset, reset interrupt profiler)
+#endif
+
+#endif /* RT_USING_IRQPROF */
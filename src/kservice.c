@@ -18,6 +18,8 @@
  * 2012-07-18     Arda         add the alignment display for signed integer
  * 2012-11-23     Bernard      fix IAR compiler error. 
  * 2012-12-22     Bernard      fix rt_kprintf issue, which found by Grissiom.
+ * 2013-01-18     Bernard      copy unaligned memory by word with shift-merge and
+ *                             support architecture optimized memory routines.
  */
 
 #include <rtthread.h>
@@ -111,6 +113,20 @@ int *_rt_errno(void)
 }
 RTM_EXPORT(_rt_errno);
 
+#define RT_WORD_MASK            (sizeof(rt_uint32_t) - 1)
+#define RT_UNALIGNED(X)         ((rt_ubase_t)(X) & RT_WORD_MASK)
+
+#if !defined(RT_USING_ARCH_MEMORY) && !defined(RT_TINY_SIZE)
+/* merge two aligned words into the word starting at byte offset of first one */
+#if defined(__BIG_ENDIAN__) || defined(__ARMEB__) || defined(__MIPSEB__) || \
+    (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__))
+#define RT_WORD_MERGE(w0, w1, lshift, rshift)   (((w0) << (lshift)) | ((w1) >> (rshift)))
+#else
+#define RT_WORD_MERGE(w0, w1, lshift, rshift)   (((w0) >> (lshift)) | ((w1) << (rshift)))
+#endif
+#endif
+
+#ifndef RT_USING_ARCH_MEMORY
 /**
  * This function will set the content of memory to specified value
  *
@@ -130,68 +146,54 @@ void *rt_memset(void *s, int c, rt_ubase_t count)
 
     return s;
 #else
-#define LBLOCKSIZE      (sizeof(rt_int32_t))
-#define UNALIGNED(X)    ((rt_int32_t)X & (LBLOCKSIZE - 1))
-#define TOO_SMALL(LEN)  ((LEN) < LBLOCKSIZE)
-
-    int i;
-    char *m = (char *)s;
+    rt_uint8_t *m = (rt_uint8_t *)s;
     rt_uint32_t buffer;
     rt_uint32_t *aligned_addr;
-    rt_uint32_t d = c & 0xff;
+    rt_uint8_t d = c & 0xff;
 
-    if (!TOO_SMALL(count) && !UNALIGNED(s))
+    if (count >= sizeof(rt_uint32_t) * 4)
     {
-        /* If we get this far, we know that n is large and m is word-aligned. */
-        aligned_addr = (rt_uint32_t *)s;
+        /* set the head bytes until the address is word-aligned */
+        while (RT_UNALIGNED(m))
+        {
+            *m++ = d;
+            count --;
+        }
+        aligned_addr = (rt_uint32_t *)m;
 
         /* Store D into each char sized location in BUFFER so that
          * we can set large blocks quickly.
          */
-        if (LBLOCKSIZE == 4)
-        {
-            buffer = (d << 8) | d;
-            buffer |= (buffer << 16);
-        }
-        else
-        {
-            buffer = 0;
-            for (i = 0; i < LBLOCKSIZE; i ++)
-                buffer = (buffer << 8) | d;
-        }
+        buffer = (d << 8) | d;
+        buffer |= (buffer << 16);
 
-        while (count >= LBLOCKSIZE * 4)
+        while (count >= sizeof(rt_uint32_t) * 4)
         {
             *aligned_addr++ = buffer;
             *aligned_addr++ = buffer;
             *aligned_addr++ = buffer;
             *aligned_addr++ = buffer;
-            count -= 4 * LBLOCKSIZE;
+            count -= sizeof(rt_uint32_t) * 4;
         }
 
-        while (count >= LBLOCKSIZE)
+        while (count >= sizeof(rt_uint32_t))
         {
             *aligned_addr++ = buffer;
-            count -= LBLOCKSIZE;
+            count -= sizeof(rt_uint32_t);
         }
 
         /* Pick up the remainder with a bytewise loop. */
-        m = (char *)aligned_addr;
+        m = (rt_uint8_t *)aligned_addr;
     }
 
     while (count--)
     {
-        *m++ = (char)d;
+        *m++ = d;
     }
 
     return s;
-
-#undef LBLOCKSIZE
-#undef UNALIGNED
-#undef TOO_SMALL
 #endif
 }
-RTM_EXPORT(rt_memset);
 
 /**
  * This function will copy memory content from source address to destination
@@ -213,60 +215,83 @@ void *rt_memcpy(void *dst, const void *src, rt_ubase_t count)
 
     return dst;
 #else
+    rt_uint8_t *dst_ptr = (rt_uint8_t *)dst;
+    const rt_uint8_t *src_ptr = (const rt_uint8_t *)src;
+    rt_uint32_t *aligned_dst;
+    const rt_uint32_t *aligned_src;
 
-#define UNALIGNED(X, Y)                                               \
-                        (((rt_int32_t)X & (sizeof(rt_int32_t) - 1)) | \
-                         ((rt_int32_t)Y & (sizeof(rt_int32_t) - 1)))
-#define BIGBLOCKSIZE    (sizeof(rt_int32_t) << 2)
-#define LITTLEBLOCKSIZE (sizeof(rt_int32_t))
-#define TOO_SMALL(LEN)  ((LEN) < BIGBLOCKSIZE)
-
-    char *dst_ptr = (char *)dst;
-    char *src_ptr = (char *)src;
-    rt_int32_t *aligned_dst;
-    rt_int32_t *aligned_src;
-    int len = count;
-
-    /* If the size is small, or either SRC or DST is unaligned,
-    then punt into the byte copy loop.  This should be rare. */
-    if (!TOO_SMALL(len) && !UNALIGNED(src_ptr, dst_ptr))
+    if (count >= sizeof(rt_uint32_t) * 4)
     {
-        aligned_dst = (rt_int32_t *)dst_ptr;
-        aligned_src = (rt_int32_t *)src_ptr;
-
-        /* Copy 4X long words at a time if possible. */
-        while (len >= BIGBLOCKSIZE)
+        /* copy the head bytes until the destination is word-aligned */
+        while (RT_UNALIGNED(dst_ptr))
         {
-            *aligned_dst++ = *aligned_src++;
-            *aligned_dst++ = *aligned_src++;
-            *aligned_dst++ = *aligned_src++;
-            *aligned_dst++ = *aligned_src++;
-            len -= BIGBLOCKSIZE;
+            *dst_ptr++ = *src_ptr++;
+            count --;
         }
+        aligned_dst = (rt_uint32_t *)dst_ptr;
 
-        /* Copy one long word at a time if possible. */
-        while (len >= LITTLEBLOCKSIZE)
+        if (!RT_UNALIGNED(src_ptr))
         {
-            *aligned_dst++ = *aligned_src++;
-            len -= LITTLEBLOCKSIZE;
+            aligned_src = (const rt_uint32_t *)src_ptr;
+
+            /* Copy 4X long words at a time if possible. */
+            while (count >= sizeof(rt_uint32_t) * 4)
+            {
+                *aligned_dst++ = *aligned_src++;
+                *aligned_dst++ = *aligned_src++;
+                *aligned_dst++ = *aligned_src++;
+                *aligned_dst++ = *aligned_src++;
+                count -= sizeof(rt_uint32_t) * 4;
+            }
+
+            /* Copy one long word at a time if possible. */
+            while (count >= sizeof(rt_uint32_t))
+            {
+                *aligned_dst++ = *aligned_src++;
+                count -= sizeof(rt_uint32_t);
+            }
+
+            src_ptr = (const rt_uint8_t *)aligned_src;
+        }
+        else
+        {
+            rt_uint32_t w0, w1;
+            int offset, lshift, rshift;
+
+            /*
+             * The source is not aligned with destination, read the aligned
+             * words of source and merge two of them into one destination
+             * word. The aligned word which contains a valid byte is always
+             * accessible.
+             */
+            offset = RT_UNALIGNED(src_ptr);
+            lshift = offset << 3;
+            rshift = 32 - lshift;
+            aligned_src = (const rt_uint32_t *)(src_ptr - offset);
+
+            w0 = *aligned_src++;
+            while (count >= sizeof(rt_uint32_t))
+            {
+                w1 = *aligned_src++;
+                *aligned_dst++ = RT_WORD_MERGE(w0, w1, lshift, rshift);
+                w0 = w1;
+                count -= sizeof(rt_uint32_t);
+            }
+
+            /* the last loaded word is not used up */
+            src_ptr = (const rt_uint8_t *)(aligned_src - 1) + offset;
         }
 
         /* Pick up any residual with a byte copier. */
-        dst_ptr = (char *)aligned_dst;
-        src_ptr = (char *)aligned_src;
+        dst_ptr = (rt_uint8_t *)aligned_dst;
     }
 
-    while (len--)
+    while (count--)
         *dst_ptr++ = *src_ptr++;
 
     return dst;
-#undef UNALIGNED
-#undef BIGBLOCKSIZE
-#undef LITTLEBLOCKSIZE
-#undef TOO_SMALL
 #endif
 }
-RTM_EXPORT(rt_memcpy);
 
 /**
  * This function will move memory content from source address to destination
@@ -287,17 +312,40 @@ void *rt_memmove(void *dest, const void *src, rt_ubase_t n)
         tmp += n;
         s += n;
 
+#ifndef RT_TINY_SIZE
+        /* copy words backward if both ends can be word-aligned together */
+        if (n >= sizeof(rt_uint32_t) * 4 && RT_UNALIGNED(tmp) == RT_UNALIGNED(s))
+        {
+            while (RT_UNALIGNED(tmp))
+            {
+                *(--tmp) = *(--s);
+                n --;
+            }
+
+            while (n >= sizeof(rt_uint32_t))
+            {
+                tmp -= sizeof(rt_uint32_t);
+                s   -= sizeof(rt_uint32_t);
+                *(rt_uint32_t *)tmp = *(rt_uint32_t *)s;
+                n -= sizeof(rt_uint32_t);
+            }
+        }
+#endif
+
         while (n--)
             *(--tmp) = *(--s);
     }
     else
     {
-        while (n--)
-            *tmp++ = *s++;
+        /* the forward copy never overwrites the source not copied yet */
+        rt_memcpy(dest, src, n);
     }
 
     return dest;
 }
+#endif /* RT_USING_ARCH_MEMORY */
+RTM_EXPORT(rt_memset);
+RTM_EXPORT(rt_memcpy);
 RTM_EXPORT(rt_memmove);
 
 /**
@@ -314,7 +362,24 @@ rt_int32_t rt_memcmp(const void *cs, const void *ct, rt_ubase_t count)
     const unsigned char *su1, *su2;
     int res = 0;
 
-    for (su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+    su1 = cs;
+    su2 = ct;
+
+#ifndef RT_TINY_SIZE
+    /* skip the equal words, the different word is compared bytewise */
+    if (!RT_UNALIGNED(su1) && !RT_UNALIGNED(su2))
+    {
+        while (count >= sizeof(rt_uint32_t) &&
+               *(const rt_uint32_t *)su1 == *(const rt_uint32_t *)su2)
+        {
+            su1 += sizeof(rt_uint32_t);
+            su2 += sizeof(rt_uint32_t);
+            count -= sizeof(rt_uint32_t);
+        }
+    }
+#endif
+
+    for (; 0 < count; ++su1, ++su2, count--)
         if ((res = *su1 - *su2) != 0)
             break;
 
@@ -1186,9 +1251,12 @@ RTM_EXPORT(rt_free_align);
 
 #if !defined (RT_USING_NEWLIB) && defined (RT_USING_MINILIBC) && defined (__GNUC__)
 #include <sys/types.h>
+#ifndef RT_USING_ARCH_MEMORY
+/* the architecture optimized memory routines provide the aliases by itself */
 void *memcpy(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memcpy")));
 void *memset(void *s, int c, size_t n) __attribute__((weak, alias("rt_memset")));
 void *memmove(void *dest, const void *src, size_t n) __attribute__((weak, alias("rt_memmove")));
+#endif
 int   memcmp(const void *s1, const void *s2, size_t n) __attribute__((weak, alias("rt_memcmp")));
 
 size_t strlen(const char *s) __attribute__((weak, alias("rt_strlen")));
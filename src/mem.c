@@ -14,6 +14,7 @@
  *                             fix memory check in rt_realloc function
  * 2010-07-13     Bernard      fix RT_ALIGN issue found by kuronca
  * 2010-10-14     Bernard      fix rt_realloc issue when realloc a NULL pointer.
+ * 2013-06-25     Bernard      tag allocations for heap trace.
  */
 
 /*
@@ -352,6 +353,7 @@ void *rt_malloc(rt_size_t size)
 
             RT_OBJECT_HOOK_CALL(rt_malloc_hook,
                                 (((void *)((rt_uint8_t *)mem + SIZEOF_STRUCT_MEM)), size));
+            RT_HEAP_TRACE_ALLOC((rt_uint8_t *)mem + SIZEOF_STRUCT_MEM, size);
 
             /* return the memory data except mem struct */
             return (rt_uint8_t *)mem + SIZEOF_STRUCT_MEM;
@@ -392,7 +394,12 @@ void *rt_realloc(void *rmem, rt_size_t newsize)
 
     /* allocate a new memory block */
     if (rmem == RT_NULL)
-        return rt_malloc(newsize);
+    {
+        nmem = rt_malloc(newsize);
+        RT_HEAP_TRACE_ALLOC(nmem, newsize);
+
+        return nmem;
+    }
 
     rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
 
@@ -439,6 +446,7 @@ void *rt_realloc(void *rmem, rt_size_t newsize)
         plug_holes(mem2);
 
         rt_sem_release(&heap_sem);
+        RT_HEAP_TRACE_ALLOC(rmem, newsize);
 
         return rmem;
     }
@@ -449,6 +457,7 @@ void *rt_realloc(void *rmem, rt_size_t newsize)
     if (nmem != RT_NULL) /* check memory */
     {
         rt_memcpy(nmem, rmem, size < newsize ? size : newsize); 
+        RT_HEAP_TRACE_REALLOC(rmem, nmem, newsize);
         rt_free(rmem);
     }
 
@@ -479,7 +488,10 @@ void *rt_calloc(rt_size_t count, rt_size_t size)
 
     /* zero the memory */
     if (p)
+    {
         rt_memset(p, 0, count * size);
+        RT_HEAP_TRACE_ALLOC(p, count * size);
+    }
 
     return p;
 }
@@ -504,6 +516,7 @@ void rt_free(void *rmem)
               (rt_uint8_t *)rmem < (rt_uint8_t *)heap_end);
 
     RT_OBJECT_HOOK_CALL(rt_free_hook, (rmem));
+    RT_HEAP_TRACE_FREE(rmem);
 
     if ((rt_uint8_t *)rmem < (rt_uint8_t *)heap_ptr ||
         (rt_uint8_t *)rmem >= (rt_uint8_t *)heap_end)
@@ -548,6 +561,31 @@ void rt_free(void *rmem)
 }
 RTM_EXPORT(rt_free);
 
+#ifdef RT_USING_HEAP_TRACE
+/**
+ * This function will walk the free blocks of system heap.
+ *
+ * @param walk the function invoked for each free block, the heap is locked
+ *        in it.
+ * @param parameter the parameter of walk function
+ */
+void rt_system_heap_walk_free(void (*walk)(void *ptr, rt_size_t size, void *parameter),
+                              void *parameter)
+{
+    struct heap_mem *mem;
+    rt_size_t ptr;
+
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+    for (ptr = 0; ptr < mem_size_aligned; ptr = mem->next)
+    {
+        mem = (struct heap_mem *)&heap_ptr[ptr];
+        if (!mem->used)
+            walk((rt_uint8_t *)mem + SIZEOF_STRUCT_MEM, mem->next - ptr - SIZEOF_STRUCT_MEM, parameter);
+    }
+    rt_sem_release(&heap_sem);
+}
+#endif
+
 #ifdef RT_MEM_STATS
 void rt_memory_info(rt_uint32_t *total,
                     rt_uint32_t *used,
@@ -15,6 +15,8 @@
  *                             change mutex lock to semaphore lock.
  * 2013-04-10     Bernard      add rt_memheap_realloc function.
  * 2013-05-24     Bernard      fix the rt_memheap_realloc issue.
+ * 2013-06-25     Bernard      tag allocations for heap trace.
+ * 2013-06-26     Bernard      add memory heap attributes and rt_malloc_attr.
  */
 
 #include <rthw.h>
@@ -61,6 +63,8 @@ rt_err_t rt_memheap_init(struct rt_memheap *memheap,
     memheap->pool_size      = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
     memheap->available_size = memheap->pool_size - (2 * RT_MEMHEAP_SIZE);
     memheap->max_used_size  = memheap->pool_size - memheap->available_size;
+    memheap->attr           = 0;
+    memheap->fail_count     = 0;
 
     /* initialize the free list header */
     item            = &(memheap->free_header);
@@ -388,6 +392,26 @@ void *rt_memheap_realloc(struct rt_memheap* heap, void* ptr, rt_size_t newsize)
 }
 RTM_EXPORT(rt_memheap_realloc);
 
+/**
+ * This function will set the attributes of memory heap, which are used to
+ * choose the memory heap in rt_malloc_attr.
+ *
+ * @param heap the memory heap
+ * @param attr the attributes, RT_MEMHEAP_ATTR_FAST, RT_MEMHEAP_ATTR_DMA,
+ *        RT_MEMHEAP_ATTR_CACHEABLE or RT_MEMHEAP_ATTR_EXTERNAL
+ *
+ * @return RT_EOK
+ */
+rt_err_t rt_memheap_set_attr(struct rt_memheap *heap, rt_uint32_t attr)
+{
+    RT_ASSERT(heap != RT_NULL);
+
+    heap->attr = attr & RT_MEMHEAP_ATTR_MASK;
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_memheap_set_attr);
+
 void rt_memheap_free(void *ptr)
 {
     rt_err_t result;
@@ -491,14 +515,20 @@ void rt_system_heap_init(void *begin_addr, void *end_addr)
                     "heap",
                     begin_addr,
                     (rt_uint32_t)end_addr - (rt_uint32_t)begin_addr);
+    _heap.attr = RT_SYSTEM_HEAP_ATTR;
 }
 
-void *rt_malloc(rt_size_t size)
+/*
+ * Allocate the memory from the memory heaps which have all of attributes,
+ * the system heap is tried at first, then the others in registered order.
+ */
+static void *_memheap_malloc(rt_size_t size, rt_uint32_t attr)
 {
-    void* ptr;
+    void* ptr = RT_NULL;
 
     /* try to allocate in system heap */
-    ptr = rt_memheap_alloc(&_heap, size);
+    if ((_heap.attr & attr) == attr)
+        ptr = rt_memheap_alloc(&_heap, size);
     if (ptr == RT_NULL)
     {
         struct rt_object *object;
@@ -517,7 +547,7 @@ void *rt_malloc(rt_size_t size)
             heap   = (struct rt_memheap *)object;
 
             /* not allocate in the default system heap */
-            if (heap == &_heap)
+            if (heap == &_heap || (heap->attr & attr) != attr)
                 continue;
 
             ptr = rt_memheap_alloc(heap, size);
@@ -528,10 +558,155 @@ void *rt_malloc(rt_size_t size)
 
     return ptr;
 }
+
+/*
+ * count the failed allocation in the memory heaps which have been tried, the
+ * miss of a memory heap which is made up by another one is not counted.
+ */
+static void _memheap_count_fail(rt_uint32_t attr)
+{
+    struct rt_list_node *node;
+    struct rt_memheap *heap;
+    struct rt_object_information *information;
+    extern struct rt_object_information rt_object_container[];
+
+    information = &rt_object_container[RT_Object_Class_MemHeap];
+    for (node  = information->object_list.next;
+         node != &(information->object_list);
+         node  = node->next)
+    {
+        heap = (struct rt_memheap *)rt_list_entry(node, struct rt_object, list);
+        if ((heap->attr & attr) == attr)
+            heap->fail_count ++;
+    }
+}
+
+static void *_memheap_malloc_attr(rt_size_t size, rt_uint32_t flags)
+{
+    void *ptr;
+    rt_uint32_t attr;
+
+    attr = flags & RT_MEMHEAP_ATTR_MASK;
+    ptr = _memheap_malloc(size, attr);
+    if (ptr == RT_NULL && (flags & RT_MALLOC_ATTR_PREFER) && attr != 0)
+    {
+        /* the attributes are preferred, try any memory heap */
+        attr = 0;
+        ptr = _memheap_malloc(size, attr);
+    }
+
+    if (ptr == RT_NULL)
+        _memheap_count_fail(attr);
+
+    return ptr;
+}
+
+/*
+ * the default malloc policy: the stacks are preferred in fast memory, the
+ * network buffers are preferred in DMA-capable memory, the DMA buffers must
+ * be in DMA-capable memory, and the GUI buffers are preferred in external
+ * memory.
+ *
+ * The network buffers fall back to the other memory heaps when DMA-capable
+ * memory is used up, since lwIP allocates all of its memory by mem_malloc.
+ * The DMA buffers are never placed in other memory heaps, the allocation
+ * fails when the DMA-capable memory heaps are used up. The driver which
+ * transfers the network buffers by DMA directly should set a policy which
+ * requires DMA-capable memory for RT_MALLOC_USAGE_NET.
+ */
+static rt_uint32_t _malloc_default_policy(rt_uint32_t usage, rt_size_t size)
+{
+    switch (usage)
+    {
+    case RT_MALLOC_USAGE_STACK:
+        return RT_MEMHEAP_ATTR_FAST | RT_MALLOC_ATTR_PREFER;
+
+    case RT_MALLOC_USAGE_NET:
+        return RT_MEMHEAP_ATTR_DMA | RT_MALLOC_ATTR_PREFER;
+
+    case RT_MALLOC_USAGE_DMA:
+        return RT_MEMHEAP_ATTR_DMA;
+
+    case RT_MALLOC_USAGE_GUI:
+        return RT_MEMHEAP_ATTR_EXTERNAL | RT_MALLOC_ATTR_PREFER;
+
+    default:
+        return 0;
+    }
+}
+
+static rt_uint32_t (*_malloc_policy)(rt_uint32_t usage, rt_size_t size) = _malloc_default_policy;
+
+void *rt_malloc(rt_size_t size)
+{
+    void *ptr;
+
+    ptr = _memheap_malloc_attr(size, 0);
+    RT_HEAP_TRACE_ALLOC(ptr, size);
+
+    return ptr;
+}
 RTM_EXPORT(rt_malloc);
 
+/**
+ * This function will allocate a memory block from the memory heaps which
+ * have the attributes.
+ *
+ * @param size the size of memory block
+ * @param flags the attributes of memory heap, and RT_MALLOC_ATTR_PREFER if
+ *        the memory block could be allocated from other memory heaps when
+ *        these ones are used up.
+ *
+ * @return the allocated memory block or RT_NULL
+ */
+void *rt_malloc_attr(rt_size_t size, rt_uint32_t flags)
+{
+    void *ptr;
+
+    ptr = _memheap_malloc_attr(size, flags);
+    RT_HEAP_TRACE_ALLOC(ptr, size);
+
+    return ptr;
+}
+RTM_EXPORT(rt_malloc_attr);
+
+/**
+ * This function will allocate a memory block for the usage, which is mapped
+ * to the attributes of memory heap by the malloc policy.
+ *
+ * @param size the size of memory block
+ * @param usage the usage of memory, such as RT_MALLOC_USAGE_STACK
+ *
+ * @return the allocated memory block or RT_NULL. With the default policy,
+ *         RT_MALLOC_USAGE_DMA returns RT_NULL when there is no DMA-capable
+ *         memory left.
+ */
+void *rt_malloc_usage(rt_size_t size, rt_uint32_t usage)
+{
+    void *ptr;
+
+    ptr = _memheap_malloc_attr(size, _malloc_policy(usage, size));
+    RT_HEAP_TRACE_ALLOC(ptr, size);
+
+    return ptr;
+}
+RTM_EXPORT(rt_malloc_usage);
+
+/**
+ * This function will set the malloc policy, which maps the usage and size of
+ * memory to the flags of rt_malloc_attr.
+ *
+ * @param policy the malloc policy, RT_NULL to restore the default one
+ */
+void rt_malloc_set_policy(rt_uint32_t (*policy)(rt_uint32_t usage, rt_size_t size))
+{
+    _malloc_policy = policy != RT_NULL ? policy : _malloc_default_policy;
+}
+RTM_EXPORT(rt_malloc_set_policy);
+
 void rt_free(void *rmem)
 {
+    RT_HEAP_TRACE_FREE(rmem);
     rt_memheap_free(rmem);
 }
 RTM_EXPORT(rt_free);
@@ -541,7 +716,13 @@ void *rt_realloc(void *rmem, rt_size_t newsize)
 	void *new_ptr;
     struct rt_memheap_item *header_ptr;
 
-	if (rmem == RT_NULL) return rt_malloc(newsize);
+	if (rmem == RT_NULL)
+	{
+		new_ptr = rt_malloc(newsize);
+		RT_HEAP_TRACE_ALLOC(new_ptr, newsize);
+
+		return new_ptr;
+	}
 
     /* get old memory item */
     header_ptr = (struct rt_memheap_item *)((rt_uint8_t *)rmem - RT_MEMHEAP_SIZE);
@@ -559,8 +740,16 @@ void *rt_realloc(void *rmem, rt_size_t newsize)
 			oldsize = MEMITEM_SIZE(header_ptr);
 			if (newsize > oldsize) rt_memcpy(new_ptr, rmem, oldsize);
 			else rt_memcpy(new_ptr, rmem, newsize);
+
+			RT_HEAP_TRACE_REALLOC(rmem, new_ptr, newsize);
+			rt_free(rmem);
 		}
 	}
+	else
+	{
+		/* the old block is released in rt_memheap_realloc if it's moved */
+		RT_HEAP_TRACE_REALLOC(rmem, new_ptr, newsize);
+	}
 
 	return new_ptr;
 }
@@ -577,12 +766,48 @@ void *rt_calloc(rt_size_t count, rt_size_t size)
     {
         /* clean memory */
         rt_memset(ptr, 0, total_size);
+        RT_HEAP_TRACE_ALLOC(ptr, total_size);
     }
 
     return ptr;
 }
 RTM_EXPORT(rt_calloc);
 
+#ifdef RT_USING_HEAP_TRACE
+/**
+ * This function will walk the free blocks of all memory heaps.
+ *
+ * @param walk the function invoked for each free block, the memory heap is
+ *        locked in it.
+ * @param parameter the parameter of walk function
+ */
+void rt_system_heap_walk_free(void (*walk)(void *ptr, rt_size_t size, void *parameter),
+                              void *parameter)
+{
+    struct rt_object_information *information;
+    struct rt_memheap_item *item;
+    struct rt_list_node *node;
+    struct rt_memheap *heap;
+
+    information = rt_object_get_information(RT_Object_Class_MemHeap);
+    for (node  = information->object_list.next;
+         node != &(information->object_list);
+         node  = node->next)
+    {
+        heap = (struct rt_memheap *)rt_list_entry(node, struct rt_object, list);
+
+        rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+        for (item  = heap->free_list->next_free;
+             item != heap->free_list;
+             item  = item->next_free)
+        {
+            walk((rt_uint8_t *)item + RT_MEMHEAP_SIZE, MEMITEM_SIZE(item), parameter);
+        }
+        rt_sem_release(&(heap->lock));
+    }
+}
+#endif
+
 #endif
 
 #endif
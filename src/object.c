@@ -15,6 +15,7 @@
  * 2006-08-03     Bernard      add hook support
  * 2007-01-28     Bernard      rename RT_OBJECT_Class_Static to RT_Object_Class_Static
  * 2010-10-26     yi.qiu       add module support in rt_object_allocate and rt_object_free
+ * 2013-06-24     Bernard      allocate objects from object pool.
  */
 
 #include <rtthread.h>
@@ -281,6 +282,14 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
     information = &rt_object_container[type];
 #endif
 
+#ifdef RT_USING_OBJECT_POOL
+    /* the objects of application module are not pooled */
+    if (information == &rt_object_container[type])
+        object = (struct rt_object *)rt_object_pool_alloc(type);
+    else
+        object = RT_NULL;
+    if (object == RT_NULL)
+#endif
     object = (struct rt_object *)RT_KERNEL_MALLOC(information->object_size);
     if (object == RT_NULL)
     {
@@ -352,6 +361,10 @@ void rt_object_delete(rt_object_t object)
     else
 #endif
 
+#ifdef RT_USING_OBJECT_POOL
+    /* release it to the pool of class, or to heap if it's not from pool */
+    if (rt_object_pool_free((enum rt_object_class_type)object->type, object) != RT_EOK)
+#endif
     /* free the memory of object */
     RT_KERNEL_FREE(object);
 }
@@ -0,0 +1,445 @@
+/*
+ * File      : objpool.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-24     Bernard      the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#if defined(RT_USING_OBJECT_POOL) || defined(RT_USING_STACK_POOL)
+
+#if !defined(RT_USING_HEAP) || !defined(RT_USING_MEMPOOL)
+#error "object pool and stack pool need RT_USING_HEAP and RT_USING_MEMPOOL"
+#endif
+
+/*
+ * A pool is a list of chunks, each chunk is a memory pool of fixed size
+ * blocks allocated from heap. The first chunk is allocated with the
+ * configured count of blocks, and the pool grows by RT_OBJECT_POOL_GROW
+ * blocks when all of chunks are used up. The chunks are never released, so
+ * the kernel objects and thread stacks, which are created and deleted
+ * frequently, don't fragment the heap.
+ *
+ * If the pool can't grow, the block is allocated from heap and it's released
+ * to heap later, which is told by the address range of chunks.
+ */
+
+struct rt_pool_chunk
+{
+    rt_list_t          list;                            /**< node of chunk list */
+    struct rt_mempool  mp;                              /**< memory pool of chunk */
+};
+
+struct rt_pool
+{
+    const char           *name;                         /**< name of memory pools */
+    rt_size_t             block_size;                   /**< size of block */
+    rt_size_t             init_count;                   /**< count of blocks pre-allocated */
+
+    rt_list_t             chunk_list;                   /**< chunks of pool */
+    struct rt_pool_chunk *hint;                         /**< the chunk used recently */
+};
+
+static struct rt_pool_chunk *_pool_grow(struct rt_pool *pool, rt_size_t count)
+{
+    struct rt_pool_chunk *chunk;
+    register rt_base_t level;
+    rt_size_t size;
+
+    if (count == 0)
+        return RT_NULL;
+
+    size = (RT_ALIGN(pool->block_size, RT_ALIGN_SIZE) + sizeof(rt_uint8_t *)) * count;
+    chunk = (struct rt_pool_chunk *)RT_KERNEL_MALLOC(
+                RT_ALIGN(sizeof(struct rt_pool_chunk), RT_ALIGN_SIZE) + size);
+    if (chunk == RT_NULL)
+        return RT_NULL;
+
+    rt_mp_init(&(chunk->mp), pool->name,
+               (rt_uint8_t *)chunk + RT_ALIGN(sizeof(struct rt_pool_chunk), RT_ALIGN_SIZE),
+               size, pool->block_size);
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_after(&(pool->chunk_list), &(chunk->list));
+    pool->hint = chunk;
+    rt_hw_interrupt_enable(level);
+
+    return chunk;
+}
+
+static void *_pool_alloc(struct rt_pool *pool)
+{
+    struct rt_pool_chunk *chunk;
+    struct rt_list_node *node;
+    void *block;
+
+    /* try the chunk used recently at first */
+    chunk = pool->hint;
+    if (chunk != RT_NULL)
+    {
+        block = rt_mp_alloc(&(chunk->mp), 0);
+        if (block != RT_NULL)
+            return block;
+    }
+
+    /* the chunks are never removed, and the new one is inserted atomically */
+    for (node = pool->chunk_list.next; node != &(pool->chunk_list); node = node->next)
+    {
+        chunk = rt_list_entry(node, struct rt_pool_chunk, list);
+
+        block = rt_mp_alloc(&(chunk->mp), 0);
+        if (block != RT_NULL)
+        {
+            pool->hint = chunk;
+
+            return block;
+        }
+    }
+
+    chunk = _pool_grow(pool, rt_list_isempty(&(pool->chunk_list)) && pool->init_count > 0 ?
+                       pool->init_count : RT_OBJECT_POOL_GROW);
+    if (chunk != RT_NULL)
+    {
+        block = rt_mp_alloc(&(chunk->mp), 0);
+        if (block != RT_NULL)
+            return block;
+    }
+
+    /* the pool can't grow, allocate it from heap */
+    return RT_KERNEL_MALLOC(pool->block_size);
+}
+
+static rt_bool_t _pool_chunk_owns(struct rt_pool_chunk *chunk, void *block)
+{
+    return (rt_uint8_t *)block >= (rt_uint8_t *)chunk->mp.start_address &&
+           (rt_uint8_t *)block < (rt_uint8_t *)chunk->mp.start_address + chunk->mp.size;
+}
+
+static rt_err_t _pool_free(struct rt_pool *pool, void *block)
+{
+    struct rt_pool_chunk *chunk;
+    struct rt_list_node *node;
+
+    chunk = pool->hint;
+    if (chunk == RT_NULL || !_pool_chunk_owns(chunk, block))
+    {
+        for (node = pool->chunk_list.next; node != &(pool->chunk_list); node = node->next)
+        {
+            chunk = rt_list_entry(node, struct rt_pool_chunk, list);
+            if (_pool_chunk_owns(chunk, block))
+                break;
+        }
+
+        /* the block is not allocated from this pool */
+        if (node == &(pool->chunk_list))
+            return -RT_ERROR;
+    }
+
+    rt_mp_free(block);
+    /* the next allocation takes the block just released */
+    pool->hint = chunk;
+
+    return RT_EOK;
+}
+
+/* the state of pools, they're used after the blocks are pre-allocated */
+#define RT_POOL_STATE_NONE      0
+#define RT_POOL_STATE_INITING   1
+#define RT_POOL_STATE_READY     2
+
+static void _pool_init(struct rt_pool *pool, const char *name,
+                       rt_size_t block_size, rt_size_t init_count)
+{
+    pool->name       = name;
+    pool->block_size = block_size;
+    pool->init_count = init_count;
+    pool->hint       = RT_NULL;
+    rt_list_init(&(pool->chunk_list));
+}
+
+#ifdef RT_USING_OBJECT_POOL
+static struct rt_pool _object_pool[RT_Object_Class_Unknown];
+static rt_uint8_t _object_pool_state = RT_POOL_STATE_NONE;
+
+static const struct
+{
+    enum rt_object_class_type type;
+    const char               *name;
+    rt_size_t                 count;
+} _object_pool_config[] =
+{
+    {RT_Object_Class_Thread,        "pthread",  RT_OBJECT_POOL_THREAD},
+#ifdef RT_USING_SEMAPHORE
+    {RT_Object_Class_Semaphore,     "psem",     RT_OBJECT_POOL_SEMAPHORE},
+#endif
+#ifdef RT_USING_MUTEX
+    {RT_Object_Class_Mutex,         "pmutex",   RT_OBJECT_POOL_MUTEX},
+#endif
+#ifdef RT_USING_EVENT
+    {RT_Object_Class_Event,         "pevent",   RT_OBJECT_POOL_EVENT},
+#endif
+#ifdef RT_USING_MAILBOX
+    {RT_Object_Class_MailBox,       "pmb",      RT_OBJECT_POOL_MAILBOX},
+#endif
+#ifdef RT_USING_MESSAGEQUEUE
+    {RT_Object_Class_MessageQueue,  "pmq",      RT_OBJECT_POOL_MESSAGEQUEUE},
+#endif
+    {RT_Object_Class_Timer,         "ptimer",   RT_OBJECT_POOL_TIMER},
+};
+
+/**
+ * @addtogroup KernelObject
+ */
+
+/*@{*/
+
+/**
+ * This function will allocate the memory of a kernel object from the pool
+ * of its class.
+ *
+ * @param type the type of object
+ *
+ * @return the memory of object, or RT_NULL if the class of object has no
+ *         pool or there is no memory.
+ */
+void *rt_object_pool_alloc(enum rt_object_class_type type)
+{
+    if (_object_pool_state != RT_POOL_STATE_READY)
+    {
+        rt_system_object_pool_init();
+
+        /* it's being initialized by other thread, use heap */
+        if (_object_pool_state != RT_POOL_STATE_READY)
+            return RT_NULL;
+    }
+
+    /* the class of object is not pooled */
+    if (_object_pool[type].block_size == 0)
+        return RT_NULL;
+
+    return _pool_alloc(&_object_pool[type]);
+}
+
+/**
+ * This function will release the memory of a kernel object to the pool of
+ * its class.
+ *
+ * @param type the type of object
+ * @param object the memory of object
+ *
+ * @return RT_EOK on released, -RT_ERROR if it's not allocated from pool.
+ */
+rt_err_t rt_object_pool_free(enum rt_object_class_type type, void *object)
+{
+    if (_object_pool_state != RT_POOL_STATE_READY ||
+        _object_pool[type].block_size == 0)
+        return -RT_ERROR;
+
+    return _pool_free(&_object_pool[type], object);
+}
+
+/*@}*/
+#endif
+
+#ifdef RT_USING_STACK_POOL
+static struct rt_pool _stack_pool[RT_STACK_POOL_BUCKETS];
+static rt_uint8_t _stack_pool_state = RT_POOL_STATE_NONE;
+
+rt_inline int _stack_pool_bucket(rt_uint32_t size)
+{
+    int index;
+
+    for (index = 0; index < RT_STACK_POOL_BUCKETS; index ++)
+    {
+        if (size <= (RT_STACK_POOL_MIN << index))
+            return index;
+    }
+
+    return -1;
+}
+
+/**
+ * @addtogroup Thread
+ */
+
+/*@{*/
+
+/**
+ * This function will allocate a thread stack from the stack pool, the size
+ * is rounded up to the size of bucket.
+ *
+ * @param size the size of stack, it returns the size of allocated stack.
+ *
+ * @return the stack, or RT_NULL if the size is larger than the biggest
+ *         bucket or there is no memory.
+ */
+void *rt_stack_pool_alloc(rt_uint32_t *size)
+{
+    int index;
+
+    RT_ASSERT(size != RT_NULL);
+
+    if (_stack_pool_state != RT_POOL_STATE_READY)
+    {
+        rt_system_object_pool_init();
+
+        /* it's being initialized by other thread, use heap */
+        if (_stack_pool_state != RT_POOL_STATE_READY)
+            return RT_NULL;
+    }
+
+    index = _stack_pool_bucket(*size);
+    if (index < 0)
+        return RT_NULL;
+
+    *size = RT_STACK_POOL_MIN << index;
+
+    return _pool_alloc(&_stack_pool[index]);
+}
+
+/**
+ * This function will release a thread stack to the stack pool.
+ *
+ * @param stack the stack of thread
+ * @param size the size of stack
+ *
+ * @return RT_EOK on released, -RT_ERROR if it's not allocated from pool.
+ */
+rt_err_t rt_stack_pool_free(void *stack, rt_uint32_t size)
+{
+    int index;
+
+    if (_stack_pool_state != RT_POOL_STATE_READY)
+        return -RT_ERROR;
+
+    index = _stack_pool_bucket(size);
+    if (index < 0 || (RT_STACK_POOL_MIN << index) != size)
+        return -RT_ERROR;
+
+    return _pool_free(&_stack_pool[index], stack);
+}
+
+/*@}*/
+#endif
+
+/**
+ * @ingroup SystemInit
+ *
+ * This function will initialize the object pools and stack pools, and
+ * pre-allocate the configured count of blocks for them. It's invoked on
+ * the first allocation if it's not invoked after heap initialization. The
+ * pools are used after the blocks are pre-allocated, the allocations before
+ * it are made from heap.
+ */
+void rt_system_object_pool_init(void)
+{
+    register rt_base_t level;
+    int index;
+
+#ifdef RT_USING_OBJECT_POOL
+    level = rt_hw_interrupt_disable();
+    if (_object_pool_state == RT_POOL_STATE_NONE)
+    {
+        _object_pool_state = RT_POOL_STATE_INITING;
+        rt_hw_interrupt_enable(level);
+
+        for (index = 0; index < sizeof(_object_pool_config) / sizeof(_object_pool_config[0]); index ++)
+        {
+            struct rt_pool *pool;
+
+            pool = &_object_pool[_object_pool_config[index].type];
+            _pool_init(pool, _object_pool_config[index].name,
+                       rt_object_get_information(_object_pool_config[index].type)->object_size,
+                       _object_pool_config[index].count);
+            _pool_grow(pool, pool->init_count);
+        }
+
+        level = rt_hw_interrupt_disable();
+        _object_pool_state = RT_POOL_STATE_READY;
+    }
+    rt_hw_interrupt_enable(level);
+#endif
+
+#ifdef RT_USING_STACK_POOL
+    level = rt_hw_interrupt_disable();
+    if (_stack_pool_state == RT_POOL_STATE_NONE)
+    {
+        _stack_pool_state = RT_POOL_STATE_INITING;
+        rt_hw_interrupt_enable(level);
+
+        for (index = 0; index < RT_STACK_POOL_BUCKETS; index ++)
+        {
+            _pool_init(&_stack_pool[index], "pstack",
+                       RT_STACK_POOL_MIN << index, RT_STACK_POOL_COUNT);
+            _pool_grow(&_stack_pool[index], _stack_pool[index].init_count);
+        }
+
+        level = rt_hw_interrupt_disable();
+        _stack_pool_state = RT_POOL_STATE_READY;
+    }
+    rt_hw_interrupt_enable(level);
+#endif
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static void _list_pool(struct rt_pool *pool)
+{
+    struct rt_pool_chunk *chunk;
+    struct rt_list_node *node;
+    rt_uint32_t chunks, total, free;
+
+    chunks = total = free = 0;
+    for (node = pool->chunk_list.next; node != &(pool->chunk_list); node = node->next)
+    {
+        chunk = rt_list_entry(node, struct rt_pool_chunk, list);
+
+        chunks ++;
+        total += chunk->mp.block_total_count;
+        free  += chunk->mp.block_free_count;
+    }
+
+    rt_kprintf("%-8.*s %5d %6d %5d %4d\n", RT_NAME_MAX, pool->name,
+               pool->block_size, chunks, total, free);
+}
+
+long list_objpool(void)
+{
+    int index;
+
+    rt_kprintf("  pool   block chunks total free\n");
+    rt_kprintf("-------- ----- ------ ----- ----\n");
+
+    rt_enter_critical();
+#ifdef RT_USING_OBJECT_POOL
+    for (index = 0; index < sizeof(_object_pool_config) / sizeof(_object_pool_config[0]); index ++)
+    {
+        if (_object_pool[_object_pool_config[index].type].block_size != 0)
+            _list_pool(&_object_pool[_object_pool_config[index].type]);
+    }
+#endif
+#ifdef RT_USING_STACK_POOL
+    for (index = 0; index < RT_STACK_POOL_BUCKETS; index ++)
+    {
+        if (_stack_pool[index].block_size != 0)
+            _list_pool(&_stack_pool[index]);
+    }
+#endif
+    rt_exit_critical();
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(list_objpool, list object pools and stack pools)
+#endif
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ * File      : schedstat.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-16     Bernard      the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_SCHEDSTAT
+
+/*
+ * The latency from a thread being inserted into the ready queue, or being
+ * preempted, to switching in is recorded in the log2 histograms of thread and
+ * of priority band. The bucket n holds the latency in [2^(n-1), 2^n) units of
+ * statistics clock, the bucket 0 holds the latency of 0.
+ */
+
+/* the priorities in one band is 1 << RT_SCHEDSTAT_BAND_SHIFT */
+#ifndef RT_SCHEDSTAT_BAND_SHIFT
+#define RT_SCHEDSTAT_BAND_SHIFT     3
+#endif
+#define RT_SCHEDSTAT_BANDS          \
+    ((RT_THREAD_PRIORITY_MAX + (1 << RT_SCHEDSTAT_BAND_SHIFT) - 1) >> RT_SCHEDSTAT_BAND_SHIFT)
+
+struct rt_schedstat_lock
+{
+    rt_uint32_t stamp;                      /* the time of locking scheduler */
+    rt_uint8_t  locked;
+    rt_uint32_t count;                      /* the number of locked sections */
+    rt_uint32_t max;                        /* the longest locked section */
+    rt_uint32_t histogram[RT_SCHEDSTAT_BUCKETS];
+};
+
+static struct rt_schedstat _band_stat[RT_SCHEDSTAT_BANDS];
+static struct rt_schedstat_lock _lock_stat;
+
+static rt_uint32_t (*_stat_clock)(void) = RT_NULL;
+static rt_uint32_t _stat_frequency = RT_TICK_PER_SECOND;
+
+rt_inline rt_uint32_t _stat_now(void)
+{
+    if (_stat_clock != RT_NULL)
+        return _stat_clock();
+
+    return rt_tick_get();
+}
+
+rt_inline int _stat_bucket(rt_uint32_t value)
+{
+    int bucket;
+
+    for (bucket = 0; value != 0 && bucket < RT_SCHEDSTAT_BUCKETS - 1; bucket ++)
+        value >>= 1;
+
+    return bucket;
+}
+
+static void _stat_record(struct rt_schedstat *stat, rt_uint32_t latency)
+{
+    stat->count ++;
+    if (latency > stat->latency_max)
+        stat->latency_max = latency;
+    stat->histogram[_stat_bucket(latency)] ++;
+}
+
+/**
+ * This function sets the clock of scheduling statistics. The clock should
+ * be a free running counter with a resolution much finer than OS tick, such
+ * as the cycle counter or a hardware timer. The OS tick is used by default.
+ *
+ * @param clock the function to read the clock, RT_NULL for OS tick
+ * @param frequency the frequency of clock in Hz
+ */
+void rt_schedstat_set_clock(rt_uint32_t (*clock)(void), rt_uint32_t frequency)
+{
+    rt_base_t level;
+
+    RT_ASSERT(clock == RT_NULL || frequency > 0);
+
+    level = rt_hw_interrupt_disable();
+    _stat_clock = clock;
+    _stat_frequency = (clock != RT_NULL) ? frequency : RT_TICK_PER_SECOND;
+    rt_hw_interrupt_enable(level);
+
+    /* the recorded time is in the units of old clock */
+    rt_schedstat_reset();
+}
+RTM_EXPORT(rt_schedstat_set_clock);
+
+/**
+ * This function clears the statistics of all threads and priority bands.
+ */
+void rt_schedstat_reset(void)
+{
+    rt_base_t level;
+    rt_uint32_t now;
+    struct rt_list_node *node;
+    struct rt_thread *thread;
+    struct rt_object_information *information;
+
+    information = rt_object_get_information(RT_Object_Class_Thread);
+
+    level = rt_hw_interrupt_disable();
+    now = _stat_now();
+
+    rt_memset(_band_stat, 0, sizeof(_band_stat));
+    _lock_stat.count = 0;
+    _lock_stat.max = 0;
+    rt_memset(_lock_stat.histogram, 0, sizeof(_lock_stat.histogram));
+    _lock_stat.stamp = now;
+
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        thread = rt_list_entry(node, struct rt_thread, list);
+
+        rt_memset(&(thread->schedstat), 0, sizeof(thread->schedstat));
+        thread->schedstat.ready_stamp = now;
+    }
+    rt_hw_interrupt_enable(level);
+}
+RTM_EXPORT(rt_schedstat_reset);
+
+/*
+ * The following functions are invoked by scheduler with interrupt disabled.
+ */
+
+void rt_schedstat_ready(struct rt_thread *thread)
+{
+    /* the thread changing priority is in the ready queue already */
+    if (thread->stat != RT_THREAD_READY)
+        thread->schedstat.ready_stamp = _stat_now();
+}
+
+void rt_schedstat_switch(struct rt_thread *from, struct rt_thread *to)
+{
+    rt_uint32_t now, latency;
+
+    now = _stat_now();
+
+    /* the preempted thread is waiting in the ready queue */
+    if (from != RT_NULL && from->stat == RT_THREAD_READY)
+        from->schedstat.ready_stamp = now;
+
+    latency = now - to->schedstat.ready_stamp;
+    _stat_record(&(to->schedstat), latency);
+    _stat_record(&_band_stat[to->current_priority >> RT_SCHEDSTAT_BAND_SHIFT], latency);
+}
+
+void rt_schedstat_lock(void)
+{
+    _lock_stat.stamp = _stat_now();
+    _lock_stat.locked = 1;
+}
+
+void rt_schedstat_unlock(void)
+{
+    rt_uint32_t duration;
+
+    if (_lock_stat.locked == 0)
+        return;
+    _lock_stat.locked = 0;
+
+    duration = _stat_now() - _lock_stat.stamp;
+    _lock_stat.count ++;
+    if (duration > _lock_stat.max)
+        _lock_stat.max = duration;
+    _lock_stat.histogram[_stat_bucket(duration)] ++;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+/* convert the time in units of clock to microsecond */
+static rt_uint32_t _stat_usec(rt_uint32_t value)
+{
+    if (_stat_frequency >= 1000000)
+        return value / (_stat_frequency / 1000000);
+
+    return value * (1000000 / _stat_frequency);
+}
+
+static void _stat_show_histogram(const rt_uint32_t *histogram)
+{
+    int bucket, last;
+
+    for (last = RT_SCHEDSTAT_BUCKETS - 1; last > 0 && histogram[last] == 0; last --) ;
+    for (bucket = 0; bucket <= last; bucket ++)
+        rt_kprintf(" %d", histogram[bucket]);
+    rt_kprintf("\n");
+}
+
+long schedstat(void)
+{
+    int band;
+    struct rt_list_node *node;
+    struct rt_thread *thread;
+    struct rt_object_information *information;
+
+    rt_kprintf("clock: %d Hz, bucket n: [2^(n-1), 2^n) clocks\n", _stat_frequency);
+    rt_kprintf("scheduler locked: %d times, max %d us, histogram",
+               _lock_stat.count, _stat_usec(_lock_stat.max));
+    _stat_show_histogram(_lock_stat.histogram);
+
+    rt_kprintf("\n band  priority    count  max(us)  histogram\n");
+    rt_kprintf("----- ---------- -------- -------- ----------\n");
+    for (band = 0; band < RT_SCHEDSTAT_BANDS; band ++)
+    {
+        if (_band_stat[band].count == 0)
+            continue;
+
+        rt_kprintf("%5d %4d - %-3d %8d %8d ", band,
+                   band << RT_SCHEDSTAT_BAND_SHIFT,
+                   ((band + 1) << RT_SCHEDSTAT_BAND_SHIFT) - 1,
+                   _band_stat[band].count,
+                   _stat_usec(_band_stat[band].latency_max));
+        _stat_show_histogram(_band_stat[band].histogram);
+    }
+
+    rt_kprintf("\n thread  pri    count  max(us)  histogram\n");
+    rt_kprintf("-------- ---- -------- -------- ----------\n");
+    information = rt_object_get_information(RT_Object_Class_Thread);
+    rt_enter_critical();
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        thread = rt_list_entry(node, struct rt_thread, list);
+
+        rt_kprintf("%-8.*s %4d %8d %8d ", RT_NAME_MAX, thread->name,
+                   thread->current_priority,
+                   thread->schedstat.count,
+                   _stat_usec(thread->schedstat.latency_max));
+        _stat_show_histogram(thread->schedstat.histogram);
+    }
+    rt_exit_critical();
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(schedstat, show scheduling latency statistics)
+FINSH_FUNCTION_EXPORT_ALIAS(rt_schedstat_reset, schedstat_reset, reset scheduling statistics)
+#endif
+
+#endif /* RT_USING_SCHEDSTAT */
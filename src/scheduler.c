@@ -24,6 +24,8 @@
  *                             issue found by kuronca
  * 2010-12-13     Bernard      add defunct list initialization even if not use heap.
  * 2011-05-10     Bernard      clean scheduler debug log.
+ * 2013-06-16     Bernard      add scheduling statistics.
+ * 2013-06-18     Bernard      add scheduler locked section profiling.
  */
 
 #include <rtthread.h>
@@ -201,6 +203,10 @@ void rt_system_scheduler_start(void)
 
     rt_current_thread = to_thread;
 
+#ifdef RT_USING_SCHEDSTAT
+    rt_schedstat_switch(RT_NULL, to_thread);
+#endif
+
     /* switch to new thread */
     rt_hw_context_switch_to((rt_uint32_t)&to_thread->sp);
 
@@ -274,6 +280,10 @@ void rt_schedule(void)
 
             RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (from_thread, to_thread));
 
+#ifdef RT_USING_SCHEDSTAT
+            rt_schedstat_switch(from_thread, to_thread);
+#endif
+
             /* switch to new thread */
             RT_DEBUG_LOG(RT_DEBUG_SCHEDULER,
                          ("[%d]switch to priority#%d thread:%s\n",
@@ -320,6 +330,11 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
 
+#ifdef RT_USING_SCHEDSTAT
+    /* record the time of being ready */
+    rt_schedstat_ready(thread);
+#endif
+
     /* change stat */
     thread->stat = RT_THREAD_READY;
 
@@ -412,6 +427,15 @@ void rt_enter_critical(void)
      */
     rt_scheduler_lock_nest ++;
 
+#ifdef RT_USING_SCHEDSTAT
+    if (rt_scheduler_lock_nest == 1)
+        rt_schedstat_lock();
+#endif
+#ifdef RT_USING_IRQPROF
+    if (rt_scheduler_lock_nest == 1)
+        rt_irqprof_lock(RT_IRQPROF_CALLER());
+#endif
+
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
 }
@@ -431,6 +455,12 @@ void rt_exit_critical(void)
     if (rt_scheduler_lock_nest <= 0)
     {
         rt_scheduler_lock_nest = 0;
+#ifdef RT_USING_SCHEDSTAT
+        rt_schedstat_unlock();
+#endif
+#ifdef RT_USING_IRQPROF
+        rt_irqprof_unlock(RT_IRQPROF_CALLER());
+#endif
         /* enable interrupt */
         rt_hw_interrupt_enable(level);
 
@@ -13,6 +13,7 @@
  * 2010-07-13     Bernard      fix RT_ALIGN issue found by kuronca
  * 2010-10-23     yi.qiu       add module memory allocator
  * 2010-12-18     yi.qiu       fix zone release bug
+ * 2013-06-25     Bernard      tag allocations for heap trace.
  */
 
 /*
@@ -664,6 +665,7 @@ done:
     rt_sem_release(&heap_sem);
 
     RT_OBJECT_HOOK_CALL(rt_malloc_hook, ((char *)chunk, size));
+    RT_HEAP_TRACE_ALLOC(chunk, size);
 
     return chunk;
 
@@ -689,7 +691,12 @@ void *rt_realloc(void *ptr, rt_size_t size)
     struct memusage *kup;
 
     if (ptr == RT_NULL)
-        return rt_malloc(size);
+    {
+        nptr = rt_malloc(size);
+        RT_HEAP_TRACE_ALLOC(nptr, size);
+
+        return nptr;
+    }
     if (size == 0)
     {
         rt_free(ptr);
@@ -715,6 +722,7 @@ void *rt_realloc(void *ptr, rt_size_t size)
         if ((nptr = rt_malloc(size)) == RT_NULL)
             return RT_NULL;
         rt_memcpy(nptr, ptr, size > osize ? osize : size);
+        RT_HEAP_TRACE_REALLOC(ptr, nptr, size);
         rt_free(ptr);
 
         return nptr;
@@ -738,6 +746,7 @@ void *rt_realloc(void *ptr, rt_size_t size)
             return RT_NULL;
 
         rt_memcpy(nptr, ptr, size > z->z_chunksize ? z->z_chunksize : size);
+        RT_HEAP_TRACE_REALLOC(ptr, nptr, size);
         rt_free(ptr);
 
         return nptr;
@@ -768,7 +777,10 @@ void *rt_calloc(rt_size_t count, rt_size_t size)
 
     /* zero the memory */
     if (p)
+    {
         rt_memset(p, 0, count * size);
+        RT_HEAP_TRACE_ALLOC(p, count * size);
+    }
 
     return p;
 }
@@ -791,6 +803,7 @@ void rt_free(void *ptr)
         return ;
 
     RT_OBJECT_HOOK_CALL(rt_free_hook, (ptr));
+    RT_HEAP_TRACE_FREE(ptr);
 
 #ifdef RT_USING_MODULE
     if(rt_module_self() != RT_NULL)
@@ -925,6 +938,27 @@ void rt_free(void *ptr)
 }
 RTM_EXPORT(rt_free);
 
+#ifdef RT_USING_HEAP_TRACE
+/**
+ * This function will walk the free pages of system heap, the free chunks in
+ * zones are not walked, which are only used by the allocations of same size.
+ *
+ * @param walk the function invoked for each free block, the heap is locked
+ *        in it.
+ * @param parameter the parameter of walk function
+ */
+void rt_system_heap_walk_free(void (*walk)(void *ptr, rt_size_t size, void *parameter),
+                              void *parameter)
+{
+    struct rt_page_head *b;
+
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+    for (b = rt_page_list; b != RT_NULL; b = b->next)
+        walk(b, b->page * RT_MM_PAGE_SIZE, parameter);
+    rt_sem_release(&heap_sem);
+}
+#endif
+
 #ifdef RT_MEM_STATS
 void rt_memory_info(rt_uint32_t *total,
                     rt_uint32_t *used,
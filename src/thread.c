@@ -25,6 +25,12 @@
  *                             thread preempted, which reported by Jiaxing Lee.
  * 2011-09-08     Bernard      fixed the scheduling issue in rt_thread_startup.
  * 2012-12-29     Bernard      fixed compiling warning.
+ * 2013-06-16     Bernard      initialize scheduling statistics.
+ * 2013-06-19     Bernard      initialize the mutex list of thread.
+ * 2013-06-20     Bernard      remove thread from the priority index of IPC.
+ * 2013-06-22     Bernard      remove thread from the wait lists of rt_wait_any.
+ * 2013-06-24     Bernard      allocate thread stack from stack pool.
+ * 2013-06-26     Bernard      allocate thread stack by the malloc policy.
  */
 
 #include <rtthread.h>
@@ -114,6 +120,22 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->cleanup   = 0;
     thread->user_data = 0;
 
+#ifdef RT_USING_MUTEX
+    rt_list_init(&(thread->taken_mutex_list));
+    thread->pending_mutex = RT_NULL;
+#endif
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    thread->suspend_index = RT_NULL;
+    thread->suspend_priority = priority;
+#endif
+#ifdef RT_USING_WAIT_ANY
+    thread->ipc_wait = RT_NULL;
+#endif
+
+#ifdef RT_USING_SCHEDSTAT
+    rt_memset(&(thread->schedstat), 0, sizeof(thread->schedstat));
+#endif
+
     /* init thread timer */
     rt_timer_init(&(thread->thread_timer),
                   thread->name,
@@ -240,6 +262,28 @@ rt_err_t rt_thread_detach(rt_thread_t thread)
     /* thread check */
     RT_ASSERT(thread != RT_NULL);
 
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    /* remove from the suspend list of IPC object */
+    lock = rt_hw_interrupt_disable();
+    if (thread->suspend_index != RT_NULL)
+        rt_ipc_list_remove(thread);
+    rt_hw_interrupt_enable(lock);
+#endif
+#ifdef RT_USING_MUTEX
+    lock = rt_hw_interrupt_disable();
+    if (thread->pending_mutex != RT_NULL)
+    {
+        /* the owner of mutex doesn't inherit from it any more */
+        rt_list_remove(&(thread->tlist));
+        rt_mutex_pending_remove(thread);
+    }
+    rt_hw_interrupt_enable(lock);
+#endif
+#ifdef RT_USING_WAIT_ANY
+    /* remove from the wait lists of rt_wait_any */
+    rt_ipc_wait_remove(thread);
+#endif
+
     /* remove from schedule */
     rt_schedule_remove_thread(thread);
 
@@ -298,7 +342,20 @@ rt_thread_t rt_thread_create(const char *name,
     if (thread == RT_NULL)
         return RT_NULL;
 
+#ifdef RT_USING_STACK_POOL
+    /* the stack size is rounded up to the size of bucket */
+    if (stack_size <= RT_STACK_POOL_MAX && !(thread->flags & RT_OBJECT_FLAG_MODULE))
+        stack_start = rt_stack_pool_alloc(&stack_size);
+    else
+        stack_start = RT_NULL;
+    if (stack_start == RT_NULL)
+#endif
+#ifdef RT_USING_MEMHEAP_AS_HEAP
+    /* the stack is placed in the memory heap chosen by malloc policy */
+    stack_start = rt_malloc_usage(stack_size, RT_MALLOC_USAGE_STACK);
+#else
     stack_start = (void *)RT_KERNEL_MALLOC(stack_size);
+#endif
     if (stack_start == RT_NULL)
     {
         /* allocate stack failure */
@@ -335,6 +392,28 @@ rt_err_t rt_thread_delete(rt_thread_t thread)
     /* thread check */
     RT_ASSERT(thread != RT_NULL);
 
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    /* remove from the suspend list of IPC object */
+    lock = rt_hw_interrupt_disable();
+    if (thread->suspend_index != RT_NULL)
+        rt_ipc_list_remove(thread);
+    rt_hw_interrupt_enable(lock);
+#endif
+#ifdef RT_USING_MUTEX
+    lock = rt_hw_interrupt_disable();
+    if (thread->pending_mutex != RT_NULL)
+    {
+        /* the owner of mutex doesn't inherit from it any more */
+        rt_list_remove(&(thread->tlist));
+        rt_mutex_pending_remove(thread);
+    }
+    rt_hw_interrupt_enable(lock);
+#endif
+#ifdef RT_USING_WAIT_ANY
+    /* remove from the wait lists of rt_wait_any */
+    rt_ipc_wait_remove(thread);
+#endif
+
     /* remove from schedule */
     rt_schedule_remove_thread(thread);
 
@@ -601,7 +680,14 @@ rt_err_t rt_thread_resume(rt_thread_t thread)
     temp = rt_hw_interrupt_disable();
 
     /* remove from suspend list */
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    rt_ipc_list_remove(thread);
+#else
     rt_list_remove(&(thread->tlist));
+#endif
+#ifdef RT_USING_MUTEX
+    rt_mutex_pending_remove(thread);
+#endif
 
     /* remove thread timer */
     rt_list_remove(&(thread->thread_timer.list));
@@ -627,6 +713,7 @@ RTM_EXPORT(rt_thread_resume);
  */
 void rt_thread_timeout(void *parameter)
 {
+    register rt_base_t temp;
     struct rt_thread *thread;
 
     thread = (struct rt_thread *)parameter;
@@ -639,7 +726,17 @@ void rt_thread_timeout(void *parameter)
     thread->error = -RT_ETIMEOUT;
 
     /* remove from suspend list */
+    temp = rt_hw_interrupt_disable();
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    rt_ipc_list_remove(thread);
+#else
     rt_list_remove(&(thread->tlist));
+#endif
+#ifdef RT_USING_MUTEX
+    /* the owner of mutex doesn't inherit from it any more */
+    rt_mutex_pending_remove(thread);
+#endif
+    rt_hw_interrupt_enable(temp);
 
     /* insert to schedule ready list */
     rt_schedule_insert_thread(thread);
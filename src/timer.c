@@ -18,6 +18,7 @@
  * 2010-05-12     Bernard      fix the timer check bug.
  * 2010-11-02     Charlie      re-implement tick overflow issue
  * 2012-12-15     Bernard      fix the next timeout issue in soft timer
+ * 2013-06-21     Bernard      check soft timer in system workqueue
  */
 
 #include <rtthread.h>
@@ -37,10 +38,16 @@ static rt_list_t rt_timer_list = RT_LIST_OBJECT_INIT(rt_timer_list);
 
 /* soft timer list */
 static rt_list_t rt_soft_timer_list;
+#ifdef RT_USING_WORKQUEUE
+/* the soft timer is checked in the system workqueue */
+static struct rt_delayed_work timer_work;
+static rt_workqueue_t timer_workqueue;
+#else
 static struct rt_thread timer_thread;
 ALIGN(RT_ALIGN_SIZE)
 static rt_uint8_t timer_thread_stack[RT_TIMER_THREAD_STACK_SIZE];
 #endif
+#endif
 
 #ifdef RT_USING_HOOK
 extern void (*rt_object_take_hook)(struct rt_object *object);
@@ -227,6 +234,39 @@ rt_err_t rt_timer_delete(rt_timer_t timer)
 RTM_EXPORT(rt_timer_delete);
 #endif
 
+/* insert timer to timer list in the order of timeout tick */
+static void _rt_timer_insert(rt_list_t *timer_list, rt_timer_t timer)
+{
+    struct rt_timer *t;
+    rt_list_t *n;
+
+    for (n = timer_list->next; n != timer_list; n = n->next)
+    {
+        t = rt_list_entry(n, struct rt_timer, list);
+
+        /*
+         * It supposes that the new tick shall less than the half duration of
+         * tick max. And if we have two timers that timeout at the same time,
+         * it's prefered that the timer inserted early get called early.
+         */
+        if ((t->timeout_tick - timer->timeout_tick) == 0)
+        {
+            rt_list_insert_after(n, &(timer->list));
+            break;
+        }
+        else if ((t->timeout_tick - timer->timeout_tick) < RT_TICK_MAX / 2)
+        {
+            rt_list_insert_before(n, &(timer->list));
+            break;
+        }
+    }
+    /* no found suitable position in timer list */
+    if (n == timer_list)
+    {
+        rt_list_insert_before(n, &(timer->list));
+    }
+}
+
 /**
  * This function will start the timer
  *
@@ -236,9 +276,8 @@ RTM_EXPORT(rt_timer_delete);
  */
 rt_err_t rt_timer_start(rt_timer_t timer)
 {
-    struct rt_timer *t;
     register rt_base_t level;
-    rt_list_t *n, *timer_list;
+    rt_list_t *timer_list;
 
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
@@ -270,31 +309,7 @@ rt_err_t rt_timer_start(rt_timer_t timer)
         timer_list = &rt_timer_list;
     }
 
-    for (n = timer_list->next; n != timer_list; n = n->next)
-    {
-        t = rt_list_entry(n, struct rt_timer, list);
-
-        /*
-         * It supposes that the new tick shall less than the half duration of
-         * tick max. And if we have two timers that timeout at the same time,
-         * it's prefered that the timer inserted early get called early.
-         */
-        if ((t->timeout_tick - timer->timeout_tick) == 0)
-        {
-            rt_list_insert_after(n, &(timer->list));
-            break;
-        }
-        else if ((t->timeout_tick - timer->timeout_tick) < RT_TICK_MAX / 2)
-        {
-            rt_list_insert_before(n, &(timer->list));
-            break;
-        }
-    }
-    /* no found suitable position in timer list */
-    if (n == timer_list)
-    {
-        rt_list_insert_before(n, &(timer->list));
-    }
+    _rt_timer_insert(timer_list, timer);
 
     timer->parent.flag |= RT_TIMER_FLAG_ACTIVATED;
 
@@ -304,6 +319,10 @@ rt_err_t rt_timer_start(rt_timer_t timer)
 #ifdef RT_USING_TIMER_SOFT
     if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
     {
+#ifdef RT_USING_WORKQUEUE
+        /* check soft timer at once for the new timeout */
+        rt_workqueue_dowork(timer_workqueue, &(timer_work.work));
+#else
         /* check whether timer thread is ready */
         if (timer_thread.stat != RT_THREAD_READY)
         {
@@ -311,6 +330,7 @@ rt_err_t rt_timer_start(rt_timer_t timer)
             rt_thread_resume(&timer_thread);
             rt_schedule();
         }
+#endif
     }
 #endif
 
@@ -472,6 +492,9 @@ rt_tick_t rt_timer_next_timeout_tick(void)
 void rt_soft_timer_check(void)
 {
     rt_tick_t current_tick;
+#ifdef RT_USING_WORKQUEUE
+    register rt_base_t level;
+#endif
     rt_list_t *n;
     struct rt_timer *t;
 
@@ -508,9 +531,25 @@ void rt_soft_timer_check(void)
             if ((t->parent.flag & RT_TIMER_FLAG_PERIODIC) &&
                 (t->parent.flag & RT_TIMER_FLAG_ACTIVATED))
             {
+#ifdef RT_USING_WORKQUEUE
+                /*
+                 * rearm it from the last timeout tick rather than the current
+                 * tick, so the period doesn't drift with the delayed work.
+                 * The periods which have been missed are skipped.
+                 */
+                t->timeout_tick += t->init_tick;
+                while (t->init_tick != 0 &&
+                       (current_tick - t->timeout_tick) < RT_TICK_MAX / 2)
+                    t->timeout_tick += t->init_tick;
+
+                level = rt_hw_interrupt_disable();
+                _rt_timer_insert(&rt_soft_timer_list, t);
+                rt_hw_interrupt_enable(level);
+#else
                 /* start it */
                 t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
                 rt_timer_start(t);
+#endif
             }
             else
             {
@@ -524,6 +563,33 @@ void rt_soft_timer_check(void)
     RT_DEBUG_LOG(RT_DEBUG_TIMER, ("software timer check leave\n"));
 }
 
+#ifdef RT_USING_WORKQUEUE
+/* soft timer work, it's submitted again for the next timeout */
+static void rt_soft_timer_work(struct rt_work *work, void *work_data)
+{
+    rt_tick_t next_timeout, current_tick;
+
+    /* lock scheduler */
+    rt_enter_critical();
+    /* check software timer */
+    rt_soft_timer_check();
+    /* unlock scheduler */
+    rt_exit_critical();
+
+    /* get the next timeout tick */
+    next_timeout = rt_timer_list_next_timeout(&rt_soft_timer_list);
+    if (next_timeout != RT_TICK_MAX)
+    {
+        /* get the delta timeout tick, 0 for timeout already */
+        current_tick = rt_tick_get();
+        next_timeout = next_timeout - current_tick;
+        if (next_timeout >= RT_TICK_MAX / 2)
+            next_timeout = 0;
+
+        rt_workqueue_submit_delayed(timer_workqueue, &timer_work, next_timeout);
+    }
+}
+#else
 /* system timer thread entry */
 static void rt_thread_timer_entry(void *parameter)
 {
@@ -563,6 +629,7 @@ static void rt_thread_timer_entry(void *parameter)
     }
 }
 #endif
+#endif
 
 /**
  * @ingroup SystemInit
@@ -586,6 +653,12 @@ void rt_system_timer_thread_init(void)
 #ifdef RT_USING_TIMER_SOFT
     rt_list_init(&rt_soft_timer_list);
 
+#ifdef RT_USING_WORKQUEUE
+    /* check software timer in system workqueue */
+    timer_workqueue = rt_workqueue_get(RT_SYSTEM_WORKQUEUE_PRIO);
+    RT_ASSERT(timer_workqueue != RT_NULL);
+    rt_delayed_work_init(&timer_work, rt_soft_timer_work, RT_NULL);
+#else
     /* start software timer thread */
     rt_thread_init(&timer_thread,
                    "timer",
@@ -599,6 +672,9 @@ void rt_system_timer_thread_init(void)
     /* startup */
     rt_thread_startup(&timer_thread);
 #endif
+#elif defined(RT_USING_WORKQUEUE)
+    rt_system_workqueue_init();
+#endif
 }
 
 /*@}*/
@@ -0,0 +1,185 @@
+/*
+ * File      : waitqueue.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-10     Bernard      the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+/**
+ * @addtogroup IPC
+ */
+
+/*@{*/
+
+/**
+ * This function will initialize a wait queue.
+ *
+ * @param queue the wait queue
+ */
+void rt_wqueue_init(rt_wqueue_t *queue)
+{
+    RT_ASSERT(queue != RT_NULL);
+
+    rt_list_init(&(queue->waiting_list));
+}
+RTM_EXPORT(rt_wqueue_init);
+
+/**
+ * This function will add a node on the wait queue. The node stays on the
+ * queue until it is removed, and its thread is resumed by each wakeup which
+ * is accepted by the wakeup function of node.
+ *
+ * @param queue the wait queue
+ * @param node the node to be added
+ */
+void rt_wqueue_add(rt_wqueue_t *queue, struct rt_wqueue_node *node)
+{
+    register rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&(queue->waiting_list), &(node->list));
+    rt_hw_interrupt_enable(level);
+}
+RTM_EXPORT(rt_wqueue_add);
+
+/**
+ * This function will remove a node from its wait queue.
+ *
+ * @param node the node to be removed
+ */
+void rt_wqueue_remove(struct rt_wqueue_node *node)
+{
+    register rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    rt_list_remove(&(node->list));
+    rt_hw_interrupt_enable(level);
+}
+RTM_EXPORT(rt_wqueue_remove);
+
+/**
+ * This function will wake up the threads waiting on the wait queue for the
+ * events. It can be invoked in ISR.
+ *
+ * @param queue the wait queue
+ * @param key the events happened, 0 for any events
+ */
+void rt_wqueue_wakeup(rt_wqueue_t *queue, rt_uint32_t key)
+{
+    register rt_base_t level;
+    register rt_bool_t need_schedule;
+    struct rt_wqueue_node *node;
+    struct rt_list_node *list;
+
+    need_schedule = RT_FALSE;
+
+    level = rt_hw_interrupt_disable();
+    for (list = queue->waiting_list.next; list != &(queue->waiting_list);
+         list = list->next)
+    {
+        node = rt_list_entry(list, struct rt_wqueue_node, list);
+
+        if (node->wakeup != RT_NULL)
+        {
+            if (node->wakeup(node, key) != 0)
+                continue;
+        }
+        else if (key != 0 && node->key != 0 && !(node->key & key))
+        {
+            continue;
+        }
+
+        /* the thread may have been resumed by the former wakeup */
+        if (node->thread->stat == RT_THREAD_SUSPEND)
+        {
+            rt_thread_resume(node->thread);
+            need_schedule = RT_TRUE;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (need_schedule == RT_TRUE)
+        rt_schedule();
+}
+RTM_EXPORT(rt_wqueue_wakeup);
+
+/**
+ * This function will suspend current thread on the wait queue until the
+ * events are waked up or timeout.
+ *
+ * @param queue the wait queue
+ * @param key the events to wait for, 0 for any events
+ * @param timeout the waiting time
+ *
+ * @return the error code, RT_EOK on being woken up.
+ */
+rt_err_t rt_wqueue_wait(rt_wqueue_t *queue, rt_uint32_t key, rt_int32_t timeout)
+{
+    register rt_base_t level;
+    struct rt_wqueue_node node;
+    rt_thread_t thread;
+
+    if (timeout == 0)
+        return -RT_ETIMEOUT;
+
+    /* current context checking */
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    thread = rt_thread_self();
+
+    node.thread = thread;
+    node.wakeup = RT_NULL;
+    node.key    = key;
+
+    level = rt_hw_interrupt_disable();
+    /* reset thread error number */
+    thread->error = RT_EOK;
+
+    rt_thread_suspend(thread);
+    rt_list_insert_before(&(queue->waiting_list), &(node.list));
+
+    /* start timer */
+    if (timeout > 0)
+    {
+        rt_timer_control(&(thread->thread_timer),
+                         RT_TIMER_CTRL_SET_TIME,
+                         &timeout);
+        rt_timer_start(&(thread->thread_timer));
+    }
+    rt_hw_interrupt_enable(level);
+
+    rt_schedule();
+
+    level = rt_hw_interrupt_disable();
+    rt_list_remove(&(node.list));
+    rt_hw_interrupt_enable(level);
+
+    return thread->error;
+}
+RTM_EXPORT(rt_wqueue_wait);
+
+/**
+ * This function will add the poll request on the wait queue, it's invoked by
+ * the poll operation of objects.
+ *
+ * @param queue the wait queue of object
+ * @param req the poll request, RT_NULL for checking the events only
+ */
+void rt_poll_add(rt_wqueue_t *queue, struct rt_pollreq *req)
+{
+    if (req != RT_NULL && req->proc != RT_NULL && queue != RT_NULL)
+        req->proc(queue, req);
+}
+RTM_EXPORT(rt_poll_add);
+
+/*@}*/
@@ -0,0 +1,673 @@
+/*
+ * File      : workqueue.c
+ * This file is part of RT-Thread RTOS
+ * COPYRIGHT (C) 2013, RT-Thread Development Team
+ *
+ * The license and distribution terms for this file may be
+ * found in the file LICENSE in this distribution or at
+ * http://www.rt-thread.org/license/LICENSE
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2013-06-21     Bernard      the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_WORKQUEUE
+
+/*
+ * The works are done one by one in the worker thread of a workqueue. The
+ * delayed work is submitted to its queue by a hard timer. The workqueues of
+ * rt_workqueue_get are shared by the users of same priority, so the drivers
+ * and services do not need their own threads.
+ */
+
+/* the works to wait for the works before them */
+struct rt_work_barrier
+{
+    struct rt_work work;
+    rt_thread_t    thread;
+};
+
+static rt_list_t _shared_list = RT_LIST_OBJECT_INIT(_shared_list);
+
+static struct rt_workqueue _system_workqueue;
+ALIGN(RT_ALIGN_SIZE)
+static rt_uint8_t _system_workqueue_stack[RT_SYSTEM_WORKQUEUE_STACK_SIZE];
+static rt_uint8_t _system_workqueue_inited = 0;
+
+static void _workqueue_thread_entry(void *parameter)
+{
+    register rt_base_t level;
+    struct rt_workqueue *queue;
+    struct rt_work *work;
+
+    queue = (struct rt_workqueue *)parameter;
+
+    while (1)
+    {
+        /* disable interrupt */
+        level = rt_hw_interrupt_disable();
+
+        if (rt_list_isempty(&(queue->work_list)))
+        {
+            /* no work, suspend self until a work is submitted */
+            queue->waiting = 1;
+            rt_thread_suspend(rt_thread_self());
+
+            /* enable interrupt */
+            rt_hw_interrupt_enable(level);
+
+            rt_schedule();
+            continue;
+        }
+
+        /* take the first work */
+        work = rt_list_entry(queue->work_list.next, struct rt_work, list);
+        rt_list_remove(&(work->list));
+        work->flags &= ~RT_WORK_STATE_PENDING;
+        queue->work_current = work;
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(level);
+
+        /* do work */
+        work->work_func(work, work->work_data);
+
+        /* the work may be freed in the work function */
+        level = rt_hw_interrupt_disable();
+        queue->work_current = RT_NULL;
+        rt_hw_interrupt_enable(level);
+    }
+}
+
+/*
+ * This function will insert a work to the work list, and wake up the worker
+ * thread. It's invoked with interrupt disabled.
+ */
+static rt_bool_t _workqueue_insert(struct rt_workqueue *queue,
+                                   struct rt_work      *work,
+                                   rt_bool_t            head)
+{
+    if (head == RT_TRUE)
+        rt_list_insert_after(&(queue->work_list), &(work->list));
+    else
+        rt_list_insert_before(&(queue->work_list), &(work->list));
+    work->flags |= RT_WORK_STATE_PENDING;
+    work->workqueue = queue;
+
+    if (queue->waiting)
+    {
+        queue->waiting = 0;
+        rt_thread_resume(&(queue->thread));
+
+        return RT_TRUE;
+    }
+
+    return RT_FALSE;
+}
+
+static void _workqueue_barrier_func(struct rt_work *work, void *work_data)
+{
+    struct rt_work_barrier *barrier;
+
+    barrier = (struct rt_work_barrier *)work_data;
+    rt_thread_resume(barrier->thread);
+}
+
+/* wait for the current work, or all of the pending works to be done */
+static rt_err_t _workqueue_wait(struct rt_workqueue *queue, rt_bool_t head)
+{
+    register rt_base_t level;
+    struct rt_work_barrier barrier;
+
+    /* the worker can not wait for itself */
+    if (rt_thread_self() == &(queue->thread))
+        return -RT_EBUSY;
+
+    rt_work_init(&(barrier.work), _workqueue_barrier_func, &barrier);
+    barrier.thread = rt_thread_self();
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    _workqueue_insert(queue, &(barrier.work), head);
+    rt_thread_suspend(barrier.thread);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    rt_schedule();
+
+    return RT_EOK;
+}
+
+static void _delayed_work_timeout(void *parameter)
+{
+    register rt_base_t level;
+    struct rt_delayed_work *work;
+    rt_bool_t need_schedule;
+
+    work = (struct rt_delayed_work *)parameter;
+    need_schedule = RT_FALSE;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (work->work.flags & RT_WORK_STATE_SUBMITTING)
+    {
+        work->work.flags &= ~RT_WORK_STATE_SUBMITTING;
+        need_schedule = _workqueue_insert(work->work.workqueue, &(work->work), RT_FALSE);
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    if (need_schedule == RT_TRUE)
+        rt_schedule();
+}
+
+/**
+ * This function will initialize a workqueue and startup its worker thread.
+ *
+ * @param queue the workqueue
+ * @param name the name of worker thread
+ * @param stack_start the start address of worker thread stack
+ * @param stack_size the size of worker thread stack
+ * @param priority the priority of worker thread
+ *
+ * @return the operation status, RT_EOK on OK, -RT_ERROR on error
+ */
+rt_err_t rt_workqueue_init(rt_workqueue_t queue,
+                           const char    *name,
+                           void          *stack_start,
+                           rt_uint32_t    stack_size,
+                           rt_uint8_t     priority)
+{
+    rt_err_t result;
+
+    RT_ASSERT(queue != RT_NULL);
+
+    rt_list_init(&(queue->work_list));
+    queue->work_current = RT_NULL;
+    queue->waiting = 0;
+    queue->shared  = 0;
+    rt_list_init(&(queue->list));
+
+    result = rt_thread_init(&(queue->thread), name, _workqueue_thread_entry,
+                            queue, stack_start, stack_size, priority, 10);
+    if (result != RT_EOK)
+        return result;
+
+    return rt_thread_startup(&(queue->thread));
+}
+RTM_EXPORT(rt_workqueue_init);
+
+/**
+ * This function will detach a workqueue. The pending works are cancelled,
+ * and it shall not be invoked when a work is being done.
+ *
+ * @param queue the workqueue
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY if a work is being
+ * done.
+ */
+rt_err_t rt_workqueue_detach(rt_workqueue_t queue)
+{
+    register rt_base_t level;
+    struct rt_work *work;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(queue != &_system_workqueue);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (queue->work_current != RT_NULL)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EBUSY;
+    }
+
+    while (!rt_list_isempty(&(queue->work_list)))
+    {
+        work = rt_list_entry(queue->work_list.next, struct rt_work, list);
+        rt_list_remove(&(work->list));
+        work->flags &= ~RT_WORK_STATE_PENDING;
+    }
+    rt_list_remove(&(queue->list));
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return rt_thread_detach(&(queue->thread));
+}
+RTM_EXPORT(rt_workqueue_detach);
+
+#ifdef RT_USING_HEAP
+/**
+ * This function will create a workqueue, the workqueue and the stack of
+ * worker thread are allocated from heap.
+ *
+ * @param name the name of worker thread
+ * @param stack_size the size of worker thread stack
+ * @param priority the priority of worker thread
+ *
+ * @return the created workqueue, RT_NULL on error
+ */
+rt_workqueue_t rt_workqueue_create(const char *name,
+                                   rt_uint32_t stack_size,
+                                   rt_uint8_t  priority)
+{
+    struct rt_workqueue *queue;
+    rt_uint32_t size;
+
+    size = RT_ALIGN(sizeof(struct rt_workqueue), RT_ALIGN_SIZE);
+    queue = (struct rt_workqueue *)rt_malloc(size + stack_size);
+    if (queue == RT_NULL)
+        return RT_NULL;
+
+    if (rt_workqueue_init(queue, name, (rt_uint8_t *)queue + size,
+                          stack_size, priority) != RT_EOK)
+    {
+        rt_free(queue);
+
+        return RT_NULL;
+    }
+
+    return queue;
+}
+RTM_EXPORT(rt_workqueue_create);
+
+/**
+ * This function will destroy a workqueue created by rt_workqueue_create.
+ *
+ * @param queue the workqueue
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY if a work is being
+ * done.
+ */
+rt_err_t rt_workqueue_destroy(rt_workqueue_t queue)
+{
+    rt_err_t result;
+
+    result = rt_workqueue_detach(queue);
+    if (result != RT_EOK)
+        return result;
+
+    rt_free(queue);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_workqueue_destroy);
+#endif
+
+static rt_workqueue_t _workqueue_find(rt_uint8_t priority)
+{
+    register rt_base_t level;
+    struct rt_list_node *node;
+    struct rt_workqueue *queue;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    for (node = _shared_list.next; node != &_shared_list; node = node->next)
+    {
+        queue = rt_list_entry(node, struct rt_workqueue, list);
+        if (queue->thread.init_priority == priority)
+        {
+            rt_hw_interrupt_enable(level);
+
+            return queue;
+        }
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return RT_NULL;
+}
+
+/**
+ * This function will get the shared workqueue of a priority, the workqueue
+ * is created if there is no one of this priority.
+ *
+ * @param priority the priority of worker thread
+ *
+ * @return the shared workqueue, RT_NULL on error
+ */
+rt_workqueue_t rt_workqueue_get(rt_uint8_t priority)
+{
+    struct rt_workqueue *queue;
+#ifdef RT_USING_HEAP
+    struct rt_workqueue *other;
+    register rt_base_t level;
+    char name[RT_NAME_MAX];
+#endif
+
+    if (priority == RT_SYSTEM_WORKQUEUE_PRIO)
+        rt_system_workqueue_init();
+
+    queue = _workqueue_find(priority);
+#ifdef RT_USING_HEAP
+    if (queue == RT_NULL)
+    {
+        rt_snprintf(name, sizeof(name), "wq%d", priority);
+        queue = rt_workqueue_create(name, RT_SYSTEM_WORKQUEUE_STACK_SIZE, priority);
+        if (queue == RT_NULL)
+            return RT_NULL;
+
+        /* it may be created by others at the same time */
+        other = _workqueue_find(priority);
+        if (other != RT_NULL)
+        {
+            rt_workqueue_destroy(queue);
+
+            return other;
+        }
+
+        level = rt_hw_interrupt_disable();
+        queue->shared = 1;
+        rt_list_insert_before(&_shared_list, &(queue->list));
+        rt_hw_interrupt_enable(level);
+    }
+#endif
+
+    return queue;
+}
+RTM_EXPORT(rt_workqueue_get);
+
+/**
+ * This function will initialize a work.
+ *
+ * @param work the work
+ * @param work_func the work function
+ * @param work_data the parameter of work function
+ */
+void rt_work_init(struct rt_work *work,
+                  void (*work_func)(struct rt_work *work, void *work_data),
+                  void *work_data)
+{
+    RT_ASSERT(work != RT_NULL);
+
+    rt_list_init(&(work->list));
+    work->work_func = work_func;
+    work->work_data = work_data;
+    work->flags     = 0;
+    work->type      = 0;
+    work->workqueue = RT_NULL;
+}
+RTM_EXPORT(rt_work_init);
+
+/**
+ * This function will initialize a delayed work.
+ *
+ * @param work the delayed work
+ * @param work_func the work function
+ * @param work_data the parameter of work function
+ */
+void rt_delayed_work_init(struct rt_delayed_work *work,
+                          void (*work_func)(struct rt_work *work, void *work_data),
+                          void *work_data)
+{
+    RT_ASSERT(work != RT_NULL);
+
+    rt_work_init(&(work->work), work_func, work_data);
+    work->work.type = RT_WORK_TYPE_DELAYED;
+
+    rt_timer_init(&(work->timer), "work", _delayed_work_timeout, work,
+                  0, RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+}
+RTM_EXPORT(rt_delayed_work_init);
+
+/**
+ * This function will submit a work to a workqueue, and the work will be done
+ * in the worker thread. It can be invoked in interrupt. The waiting delayed
+ * work is submitted at once.
+ *
+ * @param queue the workqueue
+ * @param work the work
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY if the work is
+ * pending already.
+ */
+rt_err_t rt_workqueue_dowork(rt_workqueue_t queue, struct rt_work *work)
+{
+    register rt_base_t level;
+    rt_bool_t need_schedule;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(work != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (work->flags & RT_WORK_STATE_SUBMITTING)
+    {
+        rt_timer_stop(&(((struct rt_delayed_work *)work)->timer));
+        work->flags &= ~RT_WORK_STATE_SUBMITTING;
+    }
+
+    if (work->flags & RT_WORK_STATE_PENDING)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EBUSY;
+    }
+
+    need_schedule = _workqueue_insert(queue, work, RT_FALSE);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    if (need_schedule == RT_TRUE)
+        rt_schedule();
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_workqueue_dowork);
+
+/**
+ * This function will submit a delayed work to a workqueue after the delay.
+ * If the work is waiting already, the delay is restarted.
+ *
+ * @param queue the workqueue
+ * @param work the delayed work
+ * @param ticks the delay in OS ticks, 0 for submitting at once
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY if the work is
+ * pending already.
+ */
+rt_err_t rt_workqueue_submit_delayed(rt_workqueue_t          queue,
+                                     struct rt_delayed_work *work,
+                                     rt_tick_t               ticks)
+{
+    register rt_base_t level;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(work != RT_NULL);
+    RT_ASSERT(work->work.type & RT_WORK_TYPE_DELAYED);
+
+    if (ticks == 0)
+        return rt_workqueue_dowork(queue, &(work->work));
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (work->work.flags & RT_WORK_STATE_PENDING)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return -RT_EBUSY;
+    }
+
+    if (work->work.flags & RT_WORK_STATE_SUBMITTING)
+        rt_timer_stop(&(work->timer));
+
+    work->work.workqueue = queue;
+    work->work.flags |= RT_WORK_STATE_SUBMITTING;
+    rt_timer_control(&(work->timer), RT_TIMER_CTRL_SET_TIME, &ticks);
+    rt_timer_start(&(work->timer));
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_workqueue_submit_delayed);
+
+/**
+ * This function will cancel a pending or waiting delayed work.
+ *
+ * @param queue the workqueue
+ * @param work the work
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY if the work is being
+ * done.
+ */
+rt_err_t rt_workqueue_cancel_work(rt_workqueue_t queue, struct rt_work *work)
+{
+    register rt_base_t level;
+    rt_err_t result;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(work != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (work->flags & RT_WORK_STATE_SUBMITTING)
+    {
+        rt_timer_stop(&(((struct rt_delayed_work *)work)->timer));
+        work->flags &= ~RT_WORK_STATE_SUBMITTING;
+    }
+
+    if (work->flags & RT_WORK_STATE_PENDING)
+    {
+        rt_list_remove(&(work->list));
+        work->flags &= ~RT_WORK_STATE_PENDING;
+    }
+
+    result = (queue->work_current == work) ? -RT_EBUSY : RT_EOK;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return result;
+}
+RTM_EXPORT(rt_workqueue_cancel_work);
+
+/**
+ * This function will cancel a work, and wait for it to be done if it's being
+ * done. It shall not be invoked in interrupt or in the worker thread.
+ *
+ * @param queue the workqueue
+ * @param work the work
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY on invoked in the
+ * worker thread and the work is being done.
+ */
+rt_err_t rt_workqueue_cancel_work_sync(rt_workqueue_t queue, struct rt_work *work)
+{
+    rt_err_t result;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    /* the work may submit itself again */
+    while ((result = rt_workqueue_cancel_work(queue, work)) == -RT_EBUSY)
+    {
+        if (_workqueue_wait(queue, RT_TRUE) != RT_EOK)
+            break;
+    }
+
+    return result;
+}
+RTM_EXPORT(rt_workqueue_cancel_work_sync);
+
+/**
+ * This function will wait for all of the works submitted to a workqueue to
+ * be done. It shall not be invoked in interrupt or in the worker thread.
+ *
+ * @param queue the workqueue
+ *
+ * @return the operation status, RT_EOK on OK, -RT_EBUSY on invoked in the
+ * worker thread.
+ */
+rt_err_t rt_workqueue_flush(rt_workqueue_t queue)
+{
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    RT_ASSERT(queue != RT_NULL);
+
+    return _workqueue_wait(queue, RT_FALSE);
+}
+RTM_EXPORT(rt_workqueue_flush);
+
+/**
+ * @ingroup SystemInit
+ *
+ * This function will initialize the system workqueue, which is the shared
+ * workqueue of RT_SYSTEM_WORKQUEUE_PRIO.
+ */
+void rt_system_workqueue_init(void)
+{
+    register rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (_system_workqueue_inited)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+    _system_workqueue_inited = 1;
+    rt_hw_interrupt_enable(level);
+
+    rt_workqueue_init(&_system_workqueue,
+                      "syswq",
+                      &_system_workqueue_stack[0],
+                      sizeof(_system_workqueue_stack),
+                      RT_SYSTEM_WORKQUEUE_PRIO);
+
+    level = rt_hw_interrupt_disable();
+    _system_workqueue.shared = 1;
+    rt_list_insert_before(&_shared_list, &(_system_workqueue.list));
+    rt_hw_interrupt_enable(level);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+long list_workqueue(void)
+{
+    struct rt_list_node *node, *wnode;
+    struct rt_workqueue *queue;
+    rt_uint32_t count;
+
+    rt_kprintf(" thread  pri  pending  state\n");
+    rt_kprintf("-------- ---- -------- -------\n");
+
+    rt_enter_critical();
+    for (node = _shared_list.next; node != &_shared_list; node = node->next)
+    {
+        queue = rt_list_entry(node, struct rt_workqueue, list);
+
+        count = 0;
+        for (wnode = queue->work_list.next; wnode != &(queue->work_list); wnode = wnode->next)
+            count ++;
+
+        rt_kprintf("%-8.*s %4d %8d %s\n", RT_NAME_MAX, queue->thread.name,
+                   queue->thread.init_priority, count,
+                   queue->work_current != RT_NULL ? "working" : "idle");
+    }
+    rt_exit_critical();
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(list_workqueue, list shared workqueues)
+#endif
+
+#endif /* RT_USING_WORKQUEUE */